@@ -1,4 +1,5 @@
 #include "AModel.h"
+#include "GlbFile.h"
 
 AModel::AModel(ID3D11Device* ldevice, const std::string& file)
 {
@@ -18,43 +19,91 @@ void AModel::initBuffers(ID3D11Device* device)
 
 void AModel::importModel(const std::string& pFile)
 {
-	// Create an instance of the Importer class
-	Assimp::Importer importer;
-	// And have it read the given file with some example postprocessing
-	// Usually - if speed is not the most important aspect for you - you'll
-	// probably to request more postprocessing than we do in this example.
-	const aiScene* scene = importer.ReadFile(pFile,
-		aiProcess_CalcTangentSpace |
-		aiProcess_Triangulate |
-		aiProcess_JoinIdenticalVertices |
-		aiProcess_SortByPType|
-		aiProcess_MakeLeftHanded|
-		aiProcess_FlipUVs);
-	// If the import failed, report it
-	/*if (!scene)
+	// Every AModel of the same file contents on this device draws from one pair of buffers.
+	ContentKey key;
+	bool shareable = hashFile(pFile, key);
+	key.variant = getMeshContentVariant(device, meshLoaderAModel, modelImportFlags);
+	sharedBuffers = shareable ? getSharedMeshBuffers().find(key) : nullptr;
+	if (sharedBuffers)
 	{
-		DoTheErrorLogging(importer.GetErrorString());
-		return false;
-	}*/
-	// Now we can access the file's contents.
-	//modelProcessing(scene);#
+		sharedBuffers->adopt(vertexBuffer, indexBuffer);
+		vertexCount = sharedBuffers->vertexCount;
+		indexCount = sharedBuffers->indexCount;
+		submeshes = sharedBuffers->submeshes;
+		return;
+	}
+
+	loadModel(pFile);
+	if (shareable && vertexBuffer && indexBuffer)
+	{
+		sharedBuffers = std::make_shared<SharedMeshBuffers>(vertexBuffer, indexBuffer, vertexCount, indexCount);
+		sharedBuffers->submeshes = submeshes;
+		getSharedMeshBuffers().insert(key, sharedBuffers);
+	}
+}
+
+void AModel::loadModel(const std::string& pFile)
+{
+	static_assert(sizeof(ModelVertex) == sizeof(VertexType), "ModelVertex must match the VertexType layout");
+
+	// Binary glTF is read natively. Streams already in the upload layout go to the GPU straight from the mapped file.
+	if (isGlbFilename(pFile))
+	{
+		GlbFile glb;
+		std::string error;
+		if (glb.open(pFile, error))
+		{
+			if (glb.getVertexCount() > 0 && glb.getIndexCount() > 0)
+			{
+				vertexCount = (int)glb.getVertexCount();
+				indexCount = (int)glb.getIndexCount();
+				submeshes = glb.getSubmeshes();
+				createBuffers(glb.getVertices(), glb.getIndices());
+			}
+			return;
+		}
+	}
+
+	// A valid cache holds the final streams, so they go straight from the mapped file to the GPU.
+	MeshCacheFile cache;
+	if (openModelCache(pFile, cache))
+	{
+		const MeshCacheHeader& header = cache.getHeader();
+		vertexCount = (int)header.vertexCount;
+		indexCount = (int)header.indexCount;
+		submeshes.assign(cache.getSubmeshes(), cache.getSubmeshes() + header.submeshCount);
+		createBuffers(cache.getVertexData(), cache.getIndexData());
+		return;
+	}
 
-	if (scene)
+	// Otherwise the same assimp import the background loads use, which writes the cache for next time.
+	// A failed import leaves the model empty.
+	ModelArrays arrays;
+	std::string error;
+	if (!importModelArrays(pFile, arrays, error) || arrays.vertices.empty() || arrays.indices.empty())
 	{
-		processNode(scene->mRootNode, scene);
+		return;
 	}
+	vertexCount = (int)arrays.vertices.size();
+	indexCount = (int)arrays.indices.size();
+	submeshes = std::move(arrays.submeshes);
+	createBuffers(arrays.vertices.data(), arrays.indices.data());
+}
 
+// Create the static vertex and index buffers from vertexCount vertices and indexCount indices.
+void AModel::createBuffers(const void* vertexSource, const uint32_t* indexSource)
+{
 	// Set up the description of the static vertex buffer.
 	D3D11_BUFFER_DESC vertexBufferDesc, indexBufferDesc;
 	D3D11_SUBRESOURCE_DATA vertexData, indexData;
 	vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-	vertexBufferDesc.ByteWidth = sizeof(VertexType)* (int)vertices.size();
+	vertexBufferDesc.ByteWidth = sizeof(VertexType)* vertexCount;
 	vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 	vertexBufferDesc.CPUAccessFlags = 0;
 	vertexBufferDesc.MiscFlags = 0;
 	vertexBufferDesc.StructureByteStride = 0;
 	// Give the subresource structure a pointer to the vertex data.
-	vertexData.pSysMem = vertices.data();
+	vertexData.pSysMem = vertexSource;
 	vertexData.SysMemPitch = 0;
 	vertexData.SysMemSlicePitch = 0;
 	// Now create the vertex buffer.
@@ -62,29 +111,17 @@ void AModel::importModel(const std::string& pFile)
 
 	// Set up the description of the static index buffer.
 	indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-	indexBufferDesc.ByteWidth = sizeof(unsigned long)* (int)indices.size();
+	indexBufferDesc.ByteWidth = sizeof(uint32_t)* indexCount;
 	indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
 	indexBufferDesc.CPUAccessFlags = 0;
 	indexBufferDesc.MiscFlags = 0;
 	indexBufferDesc.StructureByteStride = 0;
 	// Give the subresource structure a pointer to the index data.
-	indexData.pSysMem = indices.data();
+	indexData.pSysMem = indexSource;
 	indexData.SysMemPitch = 0;
 	indexData.SysMemSlicePitch = 0;
 	// Create the index buffer.
 	device->CreateBuffer(&indexBufferDesc, &indexData, &indexBuffer);
-
-	// Release the arrays now that the vertex and index buffers have been created and loaded.
-	//delete vertices;
-	//vertices = 0;
-
-	//delete indices;
-	//indices = 0;
-	vertexCount = (int)vertices.size();
-	indexCount = (int)indices.size();
-
-	//vertices.clear();
-	//indices.clear();
 }
 
 void AModel::modelProcessing(const aiScene* scene)
@@ -189,87 +226,6 @@ void AModel::processScene(const aiScene* scene)
 {
 
 }
-void AModel::processNode(const aiNode* node, const aiScene* scene)
-{
-	for (UINT i = 0; i < node->mNumMeshes; i++)
-	{
-		aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-		//meshes.push_back(this->processMesh(mesh, scene));
-		processMesh(mesh, scene);
-	}
-
-	for (UINT i = 0; i < node->mNumChildren; i++)
-	{
-		this->processNode(node->mChildren[i], scene);
-	}
-}
-void AModel::processMesh(const aiMesh* mesh, const aiScene* scene)
-{
-	/*for (UINT i = 0; i < mesh->mNumVertices; i++)
-	{
-		VERTEX vertex;
-
-		vertex.X = mesh->mVertices[i].x;
-		vertex.Y = mesh->mVertices[i].y;
-		vertex.Z = mesh->mVertices[i].z;
-
-		if (mesh->mTextureCoords[0])
-		{
-			vertex.texcoord.x = (float)mesh->mTextureCoords[0][i].x;
-			vertex.texcoord.y = (float)mesh->mTextureCoords[0][i].y;
-		}
-
-		vertices.push_back(vertex);
-	}
-
-	for (UINT i = 0; i < mesh->mNumFaces; i++)
-	{
-		aiFace face = mesh->mFaces[i];
-
-		for (UINT j = 0; j < face.mNumIndices; j++)
-			indices.push_back(face.mIndices[j]);
-	}*/
-
-	//---------------------------------
-
-	for (UINT i = 0; i < mesh->mNumVertices; i++)
-	{
-		XMFLOAT3 vert;
-		XMFLOAT2 text;
-		XMFLOAT3 norm;
-
-		vert.x = mesh->mVertices[i].x;
-		vert.y = mesh->mVertices[i].y;
-		vert.z = mesh->mVertices[i].z;
-
-		if (mesh->HasTextureCoords(0))
-		{
-			text.x = (float)mesh->mTextureCoords[0][i].x;
-			text.y = (float)mesh->mTextureCoords[0][i].y;
-		}
-
-		if (mesh->HasNormals())
-		{
-			norm.x = mesh->mNormals[i].x;
-			norm.y = mesh->mNormals[i].y;
-			norm.z = mesh->mNormals[i].z;
-		}
-
-		VertexType vertex;
-		vertex.position = vert;
-		vertex.texture = text;
-		vertex.normal = norm;
-		vertices.push_back(vertex);
-	}
-
-	for (UINT i = 0; i < mesh->mNumFaces; i++)
-	{
-		aiFace face = mesh->mFaces[i];
-
-		for (UINT j = 0; j < face.mNumIndices; j++)
-			indices.push_back(face.mIndices[j]);
-	}
-}
 
 //vector<Texture> ModelLoader::loadMaterialTextures(aiMaterial * mat, aiTextureType type, string typeName, const aiScene * scene)
 //{
@@ -0,0 +1,108 @@
+// Asset IO system
+// Assimp file system over MappedFile, so models load from asset packs.
+#include "AssetIOSystem.h"
+#include "AssetPack.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+AssetIOStream::AssetIOStream(MappedFile* lfile)
+{
+	file = lfile;
+	position = 0;
+}
+
+AssetIOStream::~AssetIOStream()
+{
+	delete file;
+}
+
+size_t AssetIOStream::Read(void* buffer, size_t size, size_t count)
+{
+	if (size == 0)
+	{
+		return 0;
+	}
+	// Whole items only, like fread.
+	count = std::min(count, (file->getSize() - position) / size);
+	if (count > 0)
+	{
+		memcpy(buffer, file->getData() + position, size * count);
+		position += size * count;
+	}
+	return count;
+}
+
+size_t AssetIOStream::Write(const void*, size_t, size_t)
+{
+	return 0;
+}
+
+aiReturn AssetIOStream::Seek(size_t offset, aiOrigin origin)
+{
+	// Offsets from the current position or the end may be negative, wrapped into a size_t.
+	size_t target = offset;
+	if (origin == aiOrigin_CUR)
+	{
+		target = position + offset;
+	}
+	else if (origin == aiOrigin_END)
+	{
+		target = file->getSize() + offset;
+	}
+	if (target > file->getSize())
+	{
+		return aiReturn_FAILURE;
+	}
+	position = target;
+	return aiReturn_SUCCESS;
+}
+
+size_t AssetIOStream::Tell() const
+{
+	return position;
+}
+
+size_t AssetIOStream::FileSize() const
+{
+	return file->getSize();
+}
+
+void AssetIOStream::Flush()
+{
+}
+
+bool AssetIOSystem::Exists(const char* filename) const
+{
+	std::error_code error;
+	return findPackedFile(filename) || std::filesystem::is_regular_file(filename, error);
+}
+
+char AssetIOSystem::getOsSeparator() const
+{
+#ifdef _WIN32
+	return '\\';
+#else
+	return '/';
+#endif
+}
+
+Assimp::IOStream* AssetIOSystem::Open(const char* filename, const char* mode)
+{
+	if (strchr(mode, 'w') || strchr(mode, 'a') || strchr(mode, '+'))
+	{
+		return nullptr;
+	}
+	MappedFile* file = new MappedFile();
+	if (!file->open(filename))
+	{
+		delete file;
+		return nullptr;
+	}
+	return new AssetIOStream(file);
+}
+
+void AssetIOSystem::Close(Assimp::IOStream* stream)
+{
+	delete stream;
+}
@@ -0,0 +1,48 @@
+/**
+* \class Asset IO System
+*
+* \brief Assimp file system that opens files through MappedFile
+*
+* Set on an importer with SetIOHandler so models, and any files they reference such as OBJ materials, load from
+* mounted asset packs as well as the disk. Streams read straight from the mapping.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _ASSETIOSYSTEM_H_
+#define _ASSETIOSYSTEM_H_
+
+#include "MappedFile.h"
+#include "assimp/IOStream.hpp"
+#include "assimp/IOSystem.hpp"
+
+class AssetIOStream : public Assimp::IOStream
+{
+public:
+	/// Takes an open file.
+	AssetIOStream(MappedFile* lfile);
+	~AssetIOStream();
+
+	size_t Read(void* buffer, size_t size, size_t count) override;
+	size_t Write(const void* buffer, size_t size, size_t count) override;
+	aiReturn Seek(size_t offset, aiOrigin origin) override;
+	size_t Tell() const override;
+	size_t FileSize() const override;
+	void Flush() override;
+
+private:
+	MappedFile* file;
+	size_t position;
+};
+
+class AssetIOSystem : public Assimp::IOSystem
+{
+public:
+	bool Exists(const char* filename) const override;
+	char getOsSeparator() const override;
+	/// Read-only. Returns nullptr for any write mode.
+	Assimp::IOStream* Open(const char* filename, const char* mode = "rb") override;
+	void Close(Assimp::IOStream* stream) override;
+};
+
+#endif
@@ -0,0 +1,608 @@
+// Asset pack
+// Reads, mounts and builds single-file asset packs with per-block LZ4 compression.
+#include "AssetPack.h"
+#include "ContentHash.h"
+#include "Lz4Block.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+static const uint64_t dataAlignment = 16;
+static const uint64_t minBlocksPerThread = 2;	// Entries with fewer blocks than this per thread use fewer threads
+
+static uint64_t alignOffset(uint64_t offset)
+{
+	return (offset + dataAlignment - 1) & ~(dataAlignment - 1);
+}
+
+static uint64_t getBlockCount(uint64_t size, uint64_t blockSize)
+{
+	return (size + blockSize - 1) / blockSize;
+}
+
+// Run function(item) for every item, with threads taking the next unclaimed item. The calling thread is one of them.
+template <typename Function>
+static void forEachItem(uint64_t itemCount, int threadCount, Function function)
+{
+	if (threadCount <= 0)
+	{
+		threadCount = (int)std::thread::hardware_concurrency();
+	}
+	threadCount = (int)std::min<uint64_t>(std::max(threadCount, 1), std::max<uint64_t>(itemCount, 1));
+
+	std::atomic<uint64_t> nextItem(0);
+	auto work = [&]()
+	{
+		for (uint64_t item = nextItem++; item < itemCount; item = nextItem++)
+		{
+			function(item);
+		}
+	};
+	std::vector<std::thread> threads;
+	for (int i = 1; i < threadCount; i++)
+	{
+		threads.emplace_back(work);
+	}
+	work();
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+}
+
+std::string normaliseAssetPath(const std::string& path)
+{
+	std::vector<std::string> segments;
+	std::string segment;
+	for (size_t i = 0; i <= path.size(); i++)
+	{
+		char c = i < path.size() ? path[i] : '/';
+		if (c != '/' && c != '\\')
+		{
+			segment += (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+			continue;
+		}
+		if (segment == "..")
+		{
+			if (!segments.empty() && segments.back() != "..")
+			{
+				segments.pop_back();
+			}
+			else
+			{
+				segments.push_back(segment);
+			}
+		}
+		else if (!segment.empty() && segment != ".")
+		{
+			segments.push_back(segment);
+		}
+		segment.clear();
+	}
+
+	// Absolute paths keep their leading slash, so they never match relative names.
+	std::string normalised = (!path.empty() && (path[0] == '/' || path[0] == '\\')) ? "/" : "";
+	for (size_t i = 0; i < segments.size(); i++)
+	{
+		normalised += (i ? "/" : "") + segments[i];
+	}
+	return normalised;
+}
+
+AssetPack::AssetPack()
+{
+	header = nullptr;
+	entries = nullptr;
+	names = nullptr;
+}
+
+bool AssetPack::open(const std::string& filename)
+{
+	close();
+	if (!file.openOnDisk(filename) || file.getSize() < sizeof(AssetPackHeader))
+	{
+		close();
+		return false;
+	}
+
+	// Check everything lookups and reads rely on once, so they need no checks of their own.
+	const unsigned char* data = file.getData();
+	uint64_t size = file.getSize();
+	const AssetPackHeader* candidate = (const AssetPackHeader*)data;
+	bool valid = memcmp(candidate->magic, assetPackMagic, sizeof(assetPackMagic)) == 0 && candidate->version == assetPackVersion
+		&& candidate->blockSize > 0 && candidate->indexOffset % alignof(AssetPackEntry) == 0
+		&& candidate->indexOffset <= size && candidate->entryCount <= (size - candidate->indexOffset) / sizeof(AssetPackEntry)
+		&& candidate->namesOffset <= size && candidate->namesSize <= size - candidate->namesOffset;
+	if (!valid)
+	{
+		close();
+		return false;
+	}
+
+	const AssetPackEntry* candidateEntries = (const AssetPackEntry*)(data + candidate->indexOffset);
+	for (uint32_t i = 0; i < candidate->entryCount; i++)
+	{
+		const AssetPackEntry& entry = candidateEntries[i];
+		bool entryValid = entry.offset <= size && entry.storedSize <= size - entry.offset
+			&& entry.nameOffset <= candidate->namesSize && entry.nameLength <= candidate->namesSize - entry.nameOffset
+			&& (i == 0 || candidateEntries[i - 1].nameHash <= entry.nameHash);
+		if (entry.compression == assetPackStored)
+		{
+			entryValid = entryValid && entry.storedSize == entry.size;
+		}
+		else if (entry.compression == assetPackLz4)
+		{
+			entryValid = entryValid && (getBlockCount(entry.size, candidate->blockSize) + 1) * sizeof(uint64_t) <= entry.storedSize;
+		}
+		else
+		{
+			entryValid = false;
+		}
+		if (!entryValid)
+		{
+			close();
+			return false;
+		}
+	}
+
+	header = candidate;
+	entries = candidateEntries;
+	names = (const char*)data + candidate->namesOffset;
+	return true;
+}
+
+void AssetPack::close()
+{
+	file.close();
+	header = nullptr;
+	entries = nullptr;
+	names = nullptr;
+}
+
+int AssetPack::find(const std::string& name) const
+{
+	if (!header)
+	{
+		return -1;
+	}
+	uint64_t hash = hashContent(name.data(), name.size());
+	const AssetPackEntry* end = entries + header->entryCount;
+	const AssetPackEntry* entry = std::lower_bound(entries, end, hash, [](const AssetPackEntry& a, uint64_t b) { return a.nameHash < b; });
+	for (; entry != end && entry->nameHash == hash; ++entry)
+	{
+		if (entry->nameLength == name.size() && memcmp(names + entry->nameOffset, name.data(), name.size()) == 0)
+		{
+			return (int)(entry - entries);
+		}
+	}
+	return -1;
+}
+
+std::string AssetPack::getName(uint32_t index) const
+{
+	return std::string(names + entries[index].nameOffset, entries[index].nameLength);
+}
+
+const unsigned char* AssetPack::getStoredData(uint32_t index) const
+{
+	return entries[index].compression == assetPackStored ? file.getData() + entries[index].offset : nullptr;
+}
+
+bool AssetPack::read(uint32_t index, unsigned char* destination, int threadCount) const
+{
+	const AssetPackEntry& entry = entries[index];
+	const unsigned char* stored = file.getData() + entry.offset;
+	if (entry.compression == assetPackStored)
+	{
+		if (entry.size > 0)
+		{
+			memcpy(destination, stored, entry.size);
+		}
+		return true;
+	}
+
+	uint64_t blockSize = header->blockSize;
+	uint64_t blockCount = getBlockCount(entry.size, blockSize);
+	uint64_t tableSize = (blockCount + 1) * sizeof(uint64_t);
+	std::atomic<bool> valid(true);
+	auto readBlock = [&](uint64_t block)
+	{
+		uint64_t begin, end;
+		memcpy(&begin, stored + block * sizeof(uint64_t), sizeof(begin));
+		memcpy(&end, stored + (block + 1) * sizeof(uint64_t), sizeof(end));
+		uint64_t outBegin = block * blockSize;
+		uint64_t outSize = std::min(blockSize, entry.size - outBegin);
+		if (begin < tableSize || begin > end || end > entry.storedSize)
+		{
+			valid = false;
+		}
+		else if (end - begin == outSize)
+		{
+			memcpy(destination + outBegin, stored + begin, outSize);
+		}
+		else if (!decompressLz4(stored + begin, end - begin, destination + outBegin, outSize))
+		{
+			valid = false;
+		}
+	};
+
+	if (threadCount <= 0)
+	{
+		threadCount = (int)std::thread::hardware_concurrency();
+	}
+	threadCount = (int)std::min<uint64_t>(std::max(threadCount, 1), std::max<uint64_t>(blockCount / minBlocksPerThread, 1));
+	forEachItem(blockCount, threadCount, readBlock);
+	return valid;
+}
+
+// A mounted pack, and the decompressed entries that are still open.
+struct MountedPack
+{
+	std::string mountPoint;
+	AssetPack pack;
+	std::mutex openMutex;
+	std::map<uint32_t, std::weak_ptr<std::vector<unsigned char>>> openEntries;
+};
+
+static std::mutex mountMutex;
+static std::vector<std::shared_ptr<MountedPack>> mountedPacks;	// Latest first
+
+bool mountAssetPack(const std::string& packFilename, const std::string& mountPoint)
+{
+	std::shared_ptr<MountedPack> mounted = std::make_shared<MountedPack>();
+	mounted->mountPoint = normaliseAssetPath(mountPoint);
+	if (!mounted->pack.open(packFilename))
+	{
+		return false;
+	}
+	std::lock_guard<std::mutex> lock(mountMutex);
+	mountedPacks.insert(mountedPacks.begin(), mounted);
+	return true;
+}
+
+void unmountAssetPacks()
+{
+	// Files still open from a pack keep it mapped until they close.
+	std::lock_guard<std::mutex> lock(mountMutex);
+	mountedPacks.clear();
+}
+
+static std::shared_ptr<MountedPack> findMountedFile(const std::string& filename, int& index)
+{
+	std::vector<std::shared_ptr<MountedPack>> packs;
+	{
+		std::lock_guard<std::mutex> lock(mountMutex);
+		if (mountedPacks.empty())
+		{
+			return nullptr;
+		}
+		packs = mountedPacks;
+	}
+
+	std::string path = normaliseAssetPath(filename);
+	for (const std::shared_ptr<MountedPack>& mounted : packs)
+	{
+		const std::string& mountPoint = mounted->mountPoint;
+		if (mountPoint.empty())
+		{
+			index = mounted->pack.find(path);
+		}
+		else if (path.size() > mountPoint.size() && path.compare(0, mountPoint.size(), mountPoint) == 0 && path[mountPoint.size()] == '/')
+		{
+			index = mounted->pack.find(path.substr(mountPoint.size() + 1));
+		}
+		else
+		{
+			continue;
+		}
+		if (index >= 0)
+		{
+			return mounted;
+		}
+	}
+	return nullptr;
+}
+
+bool findPackedFile(const std::string& filename, AssetPackEntry* entry)
+{
+	int index;
+	std::shared_ptr<MountedPack> mounted = findMountedFile(filename, index);
+	if (!mounted)
+	{
+		return false;
+	}
+	if (entry)
+	{
+		*entry = mounted->pack.getEntry(index);
+	}
+	return true;
+}
+
+bool openPackedFile(const std::string& filename, const unsigned char*& data, size_t& size, std::shared_ptr<const void>& holder)
+{
+	int index;
+	std::shared_ptr<MountedPack> mounted = findMountedFile(filename, index);
+	if (!mounted)
+	{
+		return false;
+	}
+	const AssetPackEntry& entry = mounted->pack.getEntry(index);
+	if (entry.size > SIZE_MAX)
+	{
+		return false;
+	}
+
+	// Stored entries are read in place, and keep the pack mapped while open.
+	const unsigned char* stored = mounted->pack.getStoredData(index);
+	if (stored)
+	{
+		data = stored;
+		size = (size_t)entry.size;
+		holder = mounted;
+		return true;
+	}
+
+	std::shared_ptr<std::vector<unsigned char>> bytes;
+	{
+		std::lock_guard<std::mutex> lock(mounted->openMutex);
+		bytes = mounted->openEntries[index].lock();
+	}
+	if (!bytes)
+	{
+		// Two threads opening the same entry at once may both decompress it, but only the first copy is kept.
+		bytes = std::make_shared<std::vector<unsigned char>>((size_t)entry.size);
+		if (!mounted->pack.read(index, bytes->data()))
+		{
+			return false;
+		}
+		std::lock_guard<std::mutex> lock(mounted->openMutex);
+		std::weak_ptr<std::vector<unsigned char>>& open = mounted->openEntries[index];
+		std::shared_ptr<std::vector<unsigned char>> first = open.lock();
+		if (first)
+		{
+			bytes = first;
+		}
+		else
+		{
+			open = bytes;
+		}
+	}
+	data = bytes->data();
+	size = bytes->size();
+	holder = bytes;
+	return true;
+}
+
+bool listAssetPackFiles(const std::string& root, const std::string& directory, std::vector<AssetPackSource>& sources)
+{
+	std::error_code error;
+	std::filesystem::recursive_directory_iterator it(directory, error), end;
+	if (error)
+	{
+		return false;
+	}
+	for (; it != end; it.increment(error))
+	{
+		if (error)
+		{
+			return false;
+		}
+		if (it->is_regular_file(error))
+		{
+			std::filesystem::path relative = std::filesystem::relative(it->path(), root, error);
+			if (error)
+			{
+				return false;
+			}
+			sources.push_back({ relative.generic_string(), it->path().string() });
+		}
+	}
+	return true;
+}
+
+// One source, read and compressed ready to write.
+struct PackedSource
+{
+	AssetPackEntry entry = {};
+	std::string name;
+	std::vector<unsigned char> stored;		// Empty for stored entries, which are copied from the file as they are written
+	bool failed = false;
+};
+
+// Compress an entry into blocks, preceded by their offset table. Returns false if it does not save enough.
+static bool compressEntry(const unsigned char* data, uint64_t size, const AssetPackSettings& settings, std::vector<unsigned char>& stored)
+{
+	uint64_t blockCount = getBlockCount(size, settings.blockSize);
+	std::vector<uint64_t> offsets(blockCount + 1);
+	stored.assign((size_t)((blockCount + 1) * sizeof(uint64_t)), 0);
+	std::vector<unsigned char> block(getLz4Bound(settings.blockSize));
+	for (uint64_t i = 0; i < blockCount; i++)
+	{
+		offsets[i] = stored.size();
+		uint64_t blockBegin = i * settings.blockSize;
+		size_t blockSize = (size_t)std::min<uint64_t>(settings.blockSize, size - blockBegin);
+		size_t compressed = compressLz4(data + blockBegin, blockSize, block.data(), block.size());
+		if (compressed)
+		{
+			stored.insert(stored.end(), block.begin(), block.begin() + compressed);
+		}
+		else
+		{
+			stored.insert(stored.end(), data + blockBegin, data + blockBegin + blockSize);
+		}
+	}
+	offsets[blockCount] = stored.size();
+	memcpy(stored.data(), offsets.data(), offsets.size() * sizeof(uint64_t));
+
+	if ((double)stored.size() > (double)size * (1.0 - settings.minSaving))
+	{
+		stored.clear();
+		stored.shrink_to_fit();
+		return false;
+	}
+	return true;
+}
+
+bool buildAssetPack(const std::string& packFilename, const std::vector<AssetPackSource>& sources, std::string& error,
+	const AssetPackSettings& settings, AssetPackStats* stats)
+{
+	if (settings.blockSize == 0)
+	{
+		error = "Block size must not be zero";
+		return false;
+	}
+
+	// Read, hash and compress the sources in parallel. Sources are read from disk, never from mounted packs.
+	std::vector<PackedSource> packed(sources.size());
+	forEachItem(sources.size(), settings.threadCount, [&](uint64_t i)
+	{
+		PackedSource& source = packed[i];
+		source.name = normaliseAssetPath(sources[i].name);
+		MappedFile file;
+		std::error_code timeError;
+		std::filesystem::file_time_type time = std::filesystem::last_write_time(sources[i].filename, timeError);
+		if (timeError || !file.openOnDisk(sources[i].filename))
+		{
+			source.failed = true;
+			return;
+		}
+		source.entry.nameHash = hashContent(source.name.data(), source.name.size());
+		source.entry.size = file.getSize();
+		source.entry.contentHash = hashContent(file.getData(), file.getSize());
+		source.entry.modifiedTime = (int64_t)time.time_since_epoch().count();
+		source.entry.compression = file.getSize() > 0 && compressEntry(file.getData(), file.getSize(), settings, source.stored) ? assetPackLz4 : assetPackStored;
+		source.entry.storedSize = source.entry.compression == assetPackLz4 ? source.stored.size() : source.entry.size;
+	});
+
+	std::map<std::string, size_t> namesSeen;
+	for (size_t i = 0; i < packed.size(); i++)
+	{
+		if (packed[i].failed)
+		{
+			error = "Could not read " + sources[i].filename;
+			return false;
+		}
+		if (packed[i].name.empty() || !namesSeen.insert({ packed[i].name, i }).second)
+		{
+			error = "Invalid or repeated name " + sources[i].name;
+			return false;
+		}
+	}
+
+	// Index order is by name hash, then name, so equal hashes are next to each other for lookups.
+	std::vector<size_t> order(packed.size());
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), [&](size_t a, size_t b)
+	{
+		if (packed[a].entry.nameHash != packed[b].entry.nameHash)
+			return packed[a].entry.nameHash < packed[b].entry.nameHash;
+		return packed[a].name < packed[b].name;
+	});
+
+	std::string tempFilename = packFilename + ".tmp";
+	std::ofstream out(tempFilename, std::ios::binary | std::ios::trunc);
+	AssetPackHeader header = {};
+	memcpy(header.magic, assetPackMagic, sizeof(assetPackMagic));
+	header.version = assetPackVersion;
+	header.entryCount = (uint32_t)packed.size();
+	header.blockSize = settings.blockSize;
+	out.write((const char*)&header, sizeof(header));
+
+	// Entry data in source order, so files listed together are read together. Identical contents are written once.
+	AssetPackStats totals;
+	uint64_t offset = sizeof(header);
+	std::map<ContentKey, const AssetPackEntry*> written;
+	std::vector<AssetPackEntry> index;
+	index.reserve(packed.size());
+	std::string names;
+	static const char padding[dataAlignment] = {};
+	for (size_t i = 0; i < packed.size() && out; i++)
+	{
+		AssetPackEntry& entry = packed[i].entry;
+		entry.nameOffset = (uint32_t)names.size();
+		entry.nameLength = (uint32_t)packed[i].name.size();
+		names += packed[i].name;
+		totals.files++;
+		totals.sourceBytes += entry.size;
+
+		ContentKey key;
+		key.hash = entry.contentHash;
+		key.size = entry.size;
+		auto found = written.find(key);
+		if (found != written.end())
+		{
+			entry.offset = found->second->offset;
+			entry.storedSize = found->second->storedSize;
+			entry.compression = found->second->compression;
+			totals.duplicateFiles++;
+			continue;
+		}
+
+		uint64_t aligned = alignOffset(offset);
+		out.write(padding, (std::streamsize)(aligned - offset));
+		entry.offset = aligned;
+		if (entry.compression == assetPackLz4)
+		{
+			out.write((const char*)packed[i].stored.data(), (std::streamsize)packed[i].stored.size());
+			packed[i].stored = std::vector<unsigned char>();
+			totals.compressedFiles++;
+		}
+		else
+		{
+			MappedFile file;
+			if (!file.openOnDisk(sources[i].filename) || file.getSize() != entry.size)
+			{
+				error = "Could not reread " + sources[i].filename;
+				out.close();
+				std::error_code ignored;
+				std::filesystem::remove(tempFilename, ignored);
+				return false;
+			}
+			out.write((const char*)file.getData(), (std::streamsize)file.getSize());
+		}
+		offset = aligned + entry.storedSize;
+		totals.storedBytes += entry.storedSize;
+		written[key] = &entry;
+	}
+
+	header.namesOffset = offset;
+	header.namesSize = names.size();
+	out.write(names.data(), (std::streamsize)names.size());
+	offset += names.size();
+	header.indexOffset = alignOffset(offset);
+	out.write(padding, (std::streamsize)(header.indexOffset - offset));
+	for (size_t i : order)
+	{
+		out.write((const char*)&packed[i].entry, sizeof(AssetPackEntry));
+	}
+	out.seekp(0);
+	out.write((const char*)&header, sizeof(header));
+	out.close();
+
+	std::error_code fileError;
+	if (!out)
+	{
+		error = "Could not write " + tempFilename;
+		std::filesystem::remove(tempFilename, fileError);
+		return false;
+	}
+	std::filesystem::rename(tempFilename, packFilename, fileError);
+	if (fileError)
+	{
+		error = "Could not replace " + packFilename;
+		return false;
+	}
+	if (stats)
+	{
+		*stats = totals;
+	}
+	return true;
+}
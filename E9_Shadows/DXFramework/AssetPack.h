@@ -0,0 +1,151 @@
+/**
+* \brief Platform-neutral asset pack: many files in one, with a sorted hash index and LZ4-compressed entries
+*
+* Startup opens and maps one file instead of opening every loose file. The pack holds the entries' data, 16-byte
+* aligned, then a name table, then an index sorted by name hash, so a lookup is a binary search of the mapping.
+* Names are relative paths, normalised to lower case with forward slashes and no "." or ".." segments, so lookups
+* match Windows paths however they are spelt.
+* Entries are split into blocks that compress independently with LZ4. Entries that do not shrink by at least
+* AssetPackSettings::minSaving are stored as they are, and read in place from the mapping with no copy. Files with
+* identical contents are stored once.
+*
+* Mounted packs are searched by MappedFile::open before the disk, so every loader built on it reads packed files
+* unchanged. Compressed entries are decompressed on the thread that opens them, which for asynchronous loads is a
+* load queue worker, with the blocks of large entries spread over more threads. An entry opened again while still
+* open shares the first copy. Each entry also records its file's size, modification time and XXH64, so cache checks
+* and content hashing never need to decompress it.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _ASSETPACK_H_
+#define _ASSETPACK_H_
+
+#include "MappedFile.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+const char assetPackMagic[4] = { 'D', 'X', 'P', 'K' };
+const uint32_t assetPackVersion = 1;
+const uint32_t assetPackStored = 0;		///< Entry compression modes
+const uint32_t assetPackLz4 = 1;
+
+struct AssetPackHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t entryCount;
+	uint32_t blockSize;			///< Uncompressed bytes per LZ4 block
+	uint64_t indexOffset;		///< entryCount AssetPackEntry, sorted by nameHash
+	uint64_t namesOffset;
+	uint64_t namesSize;
+};
+static_assert(sizeof(AssetPackHeader) == 40, "AssetPackHeader is 40 bytes");
+
+/// LZ4 entries start with blockCount + 1 offsets, relative to the entry, of each block and the end. Blocks whose
+/// stored size equals their uncompressed size did not compress and are stored as they are.
+struct AssetPackEntry
+{
+	uint64_t nameHash;			///< XXH64 of the normalised name
+	uint64_t offset;
+	uint64_t storedSize;
+	uint64_t size;				///< Uncompressed
+	uint64_t contentHash;		///< XXH64 of the uncompressed bytes, as hashFile gives
+	int64_t modifiedTime;		///< The source file's, as std::filesystem::last_write_time gives
+	uint32_t nameOffset;		///< Into the name table
+	uint32_t nameLength;
+	uint32_t compression;
+	uint32_t reserved;
+};
+static_assert(sizeof(AssetPackEntry) == 64, "AssetPackEntry is 64 bytes");
+
+/// Lower case, forward slashes, with "." segments dropped and ".." resolved against the segment before it.
+std::string normaliseAssetPath(const std::string& path);
+
+class AssetPack
+{
+public:
+	AssetPack();
+
+	AssetPack(const AssetPack&) = delete;
+	AssetPack& operator=(const AssetPack&) = delete;
+
+	/// Maps the pack and checks its index. Returns false if it is missing or malformed.
+	bool open(const std::string& filename);
+	void close();
+	bool isOpen() const { return header != nullptr; }
+
+	/// Index of the entry with a name, as normaliseAssetPath gives it, or -1.
+	int find(const std::string& name) const;
+	uint32_t getEntryCount() const { return header ? header->entryCount : 0; }
+	const AssetPackEntry& getEntry(uint32_t index) const { return entries[index]; }
+	std::string getName(uint32_t index) const;
+
+	/// The entry's bytes in the mapping if it is stored uncompressed, otherwise nullptr.
+	const unsigned char* getStoredData(uint32_t index) const;
+
+	/** \brief Reads an entry, decompressing it if needed
+	* @param destination receives getEntry(index).size bytes
+	* @param threadCount threads for entries of several blocks. 0 uses one per hardware thread
+	* @return false if the entry's data is corrupt
+	*/
+	bool read(uint32_t index, unsigned char* destination, int threadCount = 0) const;
+
+private:
+	MappedFile file;
+	const AssetPackHeader* header;
+	const AssetPackEntry* entries;
+	const char* names;
+};
+
+/** \brief Mounts a pack so MappedFile finds its files
+* @param mountPoint the directory its names are relative to. "" is the working directory
+* @return false if the pack cannot be opened. Packs mounted later are searched first
+*/
+bool mountAssetPack(const std::string& packFilename, const std::string& mountPoint = "");
+void unmountAssetPacks();
+
+/// Looks a file up in the mounted packs. entry receives its sizes, time and hash.
+bool findPackedFile(const std::string& filename, AssetPackEntry* entry = nullptr);
+
+/** \brief Opens a file from the mounted packs, for MappedFile
+* @param holder keeps the bytes alive. Stored entries point into the pack, compressed ones into a decompressed copy
+* shared with every other open of the same entry
+*/
+bool openPackedFile(const std::string& filename, const unsigned char*& data, size_t& size, std::shared_ptr<const void>& holder);
+
+struct AssetPackSource
+{
+	std::string name;			///< Path in the pack, relative to where it will be mounted
+	std::string filename;		///< Where to read it from
+};
+
+struct AssetPackSettings
+{
+	uint32_t blockSize = 256 * 1024;	///< Blocks decompress independently, so large entries can use several threads
+	float minSaving = 0.1f;				///< Entries saving less than this fraction are stored uncompressed
+	int threadCount = 0;				///< Compression threads. 0 uses one per hardware thread
+};
+
+/// Build totals, for profiling.
+struct AssetPackStats
+{
+	uint64_t files = 0;
+	uint64_t sourceBytes = 0;
+	uint64_t storedBytes = 0;		///< Entry data after compression and deduplication
+	uint64_t compressedFiles = 0;
+	uint64_t duplicateFiles = 0;
+};
+
+/// Adds every file under directory to sources, named by its path relative to root.
+bool listAssetPackFiles(const std::string& root, const std::string& directory, std::vector<AssetPackSource>& sources);
+
+/** \brief Writes a pack of the sources
+* @return false, with the reason in error, if a source cannot be read or the pack cannot be written
+*/
+bool buildAssetPack(const std::string& packFilename, const std::vector<AssetPackSource>& sources, std::string& error,
+	const AssetPackSettings& settings = AssetPackSettings(), AssetPackStats* stats = nullptr);
+
+#endif
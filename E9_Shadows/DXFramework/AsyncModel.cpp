@@ -0,0 +1,158 @@
+// Async model
+// Draws a bounds-sized box until the background import is delivered.
+#include "AsyncModel.h"
+
+AsyncModel::AsyncModel(ID3D11Device* ldevice, ModelLoadQueue* lqueue, const std::string& filename)
+{
+	device = ldevice;
+	queue = lqueue;
+
+	if (!readMeshCacheBounds(getModelCacheFilename(filename), boundsMin, boundsMax))
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			boundsMin[axis] = -1.0f;
+			boundsMax[axis] = 1.0f;
+		}
+	}
+	initBuffers(device);
+
+	handle = queue->load(filename, this);
+}
+
+AsyncModel::~AsyncModel()
+{
+	if (handle)
+	{
+		queue->cancel(handle);
+	}
+}
+
+// Placeholder box. For each face the in-plane axes a and b satisfy a x b = normal, and the corners go (-a, -b), (-a, +b), (+a, +b), (+a, -b).
+// In D3D's left-handed space that order is counter-clockwise seen from outside, which the rasterizer state (FrontCounterClockwise) keeps.
+void AsyncModel::initBuffers(ID3D11Device* device)
+{
+	static const int faceAxes[6][3] = { { 0, 1, 2 }, { 0, 2, 1 }, { 1, 2, 0 }, { 1, 0, 2 }, { 2, 0, 1 }, { 2, 1, 0 } };
+	static const float cornerSigns[4][2] = { { -1.0f, -1.0f }, { -1.0f, 1.0f }, { 1.0f, 1.0f }, { 1.0f, -1.0f } };
+
+	float center[3], half[3];
+	for (int axis = 0; axis < 3; axis++)
+	{
+		center[axis] = (boundsMin[axis] + boundsMax[axis]) * 0.5f;
+		half[axis] = (boundsMax[axis] - boundsMin[axis]) * 0.5f;
+	}
+
+	ModelVertex vertices[24];
+	uint32_t indices[36];
+	for (int face = 0; face < 6; face++)
+	{
+		int normalAxis = faceAxes[face][0];
+		int a = faceAxes[face][1];
+		int b = faceAxes[face][2];
+		float side = (face % 2 == 0) ? 1.0f : -1.0f;
+
+		for (int corner = 0; corner < 4; corner++)
+		{
+			ModelVertex& vertex = vertices[face * 4 + corner];
+			float sa = cornerSigns[corner][0];
+			float sb = cornerSigns[corner][1];
+			vertex.position[normalAxis] = center[normalAxis] + side * half[normalAxis];
+			vertex.position[a] = center[a] + sa * half[a];
+			vertex.position[b] = center[b] + sb * half[b];
+			vertex.texture[0] = sb * 0.5f + 0.5f;
+			vertex.texture[1] = sa * 0.5f + 0.5f;
+			vertex.normal[0] = vertex.normal[1] = vertex.normal[2] = 0.0f;
+			vertex.normal[normalAxis] = side;
+		}
+
+		uint32_t base = face * 4;
+		uint32_t* faceIndices = indices + face * 6;
+		faceIndices[0] = base;
+		faceIndices[1] = base + 1;
+		faceIndices[2] = base + 2;
+		faceIndices[3] = base;
+		faceIndices[4] = base + 2;
+		faceIndices[5] = base + 3;
+	}
+
+	vertexCount = 24;
+	indexCount = 36;
+	createBuffers(vertices, indices);
+}
+
+void AsyncModel::modelLoaded(ModelHandle, ModelArrays& arrays)
+{
+	handle = 0;
+	if (arrays.vertices.empty() || arrays.indices.empty())
+	{
+		failed = true;
+		error = "Model has no geometry";
+		return;
+	}
+
+	// Called between frames by the queue, so the placeholder is not in use.
+	static_assert(sizeof(ModelVertex) == sizeof(VertexType), "ModelVertex must match the VertexType layout");
+	releaseBuffers();
+	vertexCount = (int)arrays.vertices.size();
+	indexCount = (int)arrays.indices.size();
+	createBuffers(arrays.vertices.data(), arrays.indices.data());
+	submeshes = std::move(arrays.submeshes);
+	loaded = true;
+}
+
+void AsyncModel::modelFailed(ModelHandle, const std::string& lerror)
+{
+	handle = 0;
+	failed = true;
+	error = lerror;
+}
+
+// Create the static vertex and index buffers from vertexCount vertices and indexCount indices.
+void AsyncModel::createBuffers(const void* vertexSource, const uint32_t* indexSource)
+{
+	D3D11_BUFFER_DESC vertexBufferDesc, indexBufferDesc;
+	D3D11_SUBRESOURCE_DATA vertexData, indexData;
+
+	// Set up the description of the static vertex buffer.
+	vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
+	vertexBufferDesc.ByteWidth = sizeof(VertexType)* vertexCount;
+	vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	vertexBufferDesc.CPUAccessFlags = 0;
+	vertexBufferDesc.MiscFlags = 0;
+	vertexBufferDesc.StructureByteStride = 0;
+	// Give the subresource structure a pointer to the vertex data.
+	vertexData.pSysMem = vertexSource;
+	vertexData.SysMemPitch = 0;
+	vertexData.SysMemSlicePitch = 0;
+	// Now create the vertex buffer.
+	device->CreateBuffer(&vertexBufferDesc, &vertexData, &vertexBuffer);
+
+	// Set up the description of the static index buffer.
+	indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
+	indexBufferDesc.ByteWidth = sizeof(uint32_t)* indexCount;
+	indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+	indexBufferDesc.CPUAccessFlags = 0;
+	indexBufferDesc.MiscFlags = 0;
+	indexBufferDesc.StructureByteStride = 0;
+	// Give the subresource structure a pointer to the index data.
+	indexData.pSysMem = indexSource;
+	indexData.SysMemPitch = 0;
+	indexData.SysMemSlicePitch = 0;
+	// Create the index buffer.
+	device->CreateBuffer(&indexBufferDesc, &indexData, &indexBuffer);
+}
+
+void AsyncModel::releaseBuffers()
+{
+	if (indexBuffer)
+	{
+		indexBuffer->Release();
+		indexBuffer = 0;
+	}
+
+	if (vertexBuffer)
+	{
+		vertexBuffer->Release();
+		vertexBuffer = 0;
+	}
+}
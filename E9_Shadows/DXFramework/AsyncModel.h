@@ -0,0 +1,60 @@
+/**
+* \class Async Model
+*
+* \brief Model mesh that loads in the background and draws a placeholder box until it is ready
+*
+* The constructor queues the file on a ModelLoadQueue and returns immediately. Until the import finishes, the mesh
+* draws a box sized to the bounds stored in the file's mesh cache, or a unit cube if there is none.
+* The real buffers replace the box when the queue's update() delivers the model, which the application calls once
+* per frame, so the swap always happens between frames. If the import fails the box stays and the error is kept.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _ASYNCMODEL_H_
+#define _ASYNCMODEL_H_
+
+#include "BaseMesh.h"
+#include "ModelLoadQueue.h"
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+class AsyncModel : public BaseMesh, public ModelUploadSink
+{
+public:
+	/** \brief Builds the placeholder and queues the model file
+	* @param device is the renderer device, used again when the model arrives
+	* @param queue must outlive the model
+	* @param filename is any file loadModelArrays accepts
+	*/
+	AsyncModel(ID3D11Device* device, ModelLoadQueue* queue, const std::string& filename);
+	/// Cancels the load if it has not been delivered yet.
+	~AsyncModel();
+
+	bool isLoaded() const { return loaded; }
+	bool hasFailed() const { return failed; }
+	const std::string& getError() const { return error; }
+	const std::vector<MeshCacheSubmesh>& getSubmeshes() const { return submeshes; }	///< Empty until loaded
+
+	void modelLoaded(ModelHandle handle, ModelArrays& arrays) override;
+	void modelFailed(ModelHandle handle, const std::string& error) override;
+
+protected:
+	/// Builds the placeholder box from boundsMin and boundsMax.
+	void initBuffers(ID3D11Device* device);
+	void createBuffers(const void* vertexSource, const uint32_t* indexSource);
+	void releaseBuffers();
+
+	ID3D11Device* device;
+	ModelLoadQueue* queue;
+	ModelHandle handle;
+	float boundsMin[3], boundsMax[3];
+	std::vector<MeshCacheSubmesh> submeshes;
+	bool loaded = false;
+	bool failed = false;
+	std::string error;
+};
+
+#endif
@@ -84,6 +84,9 @@ bool BaseApplication::frame()
 
 	timer->frame();
 
+	// Create any textures decoded since the last frame
+	textureMgr->updateTextures();
+
 	handleInput(timer->getTime());
 
 	ImGui_ImplDX11_NewFrame();
@@ -2,6 +2,7 @@
 // Base class for shader object. Handles loading in shader files (vertex, pixel, domain, hull and geometry).
 // Handle render/sending to GPU for processing.
 #include "baseshader.h"
+#include "MappedFile.h"
 
 // Store pointer to render device and handle to window.
 BaseShader::BaseShader(ID3D11Device* device, HWND lhwnd)
@@ -10,6 +11,22 @@ BaseShader::BaseShader(ID3D11Device* device, HWND lhwnd)
 	hwnd = hwnd;
 }
 
+// Like D3DReadFileToBlob, but through MappedFile, so compiled shaders can come from a mounted asset pack.
+static HRESULT readShaderFile(const wchar_t* filename, ID3DBlob** blob)
+{
+	MappedFile file;
+	if (!file.open(filename))
+	{
+		return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+	}
+	HRESULT result = D3DCreateBlob(file.getSize(), blob);
+	if (SUCCEEDED(result) && file.getSize() > 0)
+	{
+		memcpy((*blob)->GetBufferPointer(), file.getData(), file.getSize());
+	}
+	return result;
+}
+
 // Release resources (if used).
 BaseShader::~BaseShader()
 {
@@ -85,7 +102,7 @@ void BaseShader::loadVertexShader(const wchar_t* filename)
 	}
 	
 	// Reads compiled shader into buffer (bytecode).
-	HRESULT result = D3DReadFileToBlob(filename, &vertexShaderBuffer);
+	HRESULT result = readShaderFile(filename, &vertexShaderBuffer);
 	if (result != S_OK)
 	{
 		MessageBox(NULL, filename, L"File ERROR", MB_OK);
@@ -149,7 +166,7 @@ void BaseShader::loadTextureVertexShader(const wchar_t* filename)
 	}
 
 	// Reads compiled shader into buffer (bytecode).
-	HRESULT result = D3DReadFileToBlob(filename, &vertexShaderBuffer);
+	HRESULT result = readShaderFile(filename, &vertexShaderBuffer);
 	if (result != S_OK)
 	{
 		MessageBox(NULL, filename, L"File ERROR", MB_OK);
@@ -212,7 +229,7 @@ void BaseShader::loadColourVertexShader(const wchar_t* filename)
 	}
 
 	// Reads compiled shader into buffer (bytecode).
-	HRESULT result = D3DReadFileToBlob(filename, &vertexShaderBuffer);
+	HRESULT result = readShaderFile(filename, &vertexShaderBuffer);
 	if (result != S_OK)
 	{
 		MessageBox(NULL, filename, L"File ERROR", MB_OK);
@@ -240,6 +257,69 @@ void BaseShader::loadColourVertexShader(const wchar_t* filename)
 	vertexShaderBuffer = 0;
 }
 
+void BaseShader::loadCompactTerrainVertexShader(const wchar_t* filename)
+{
+	ID3DBlob* vertexShaderBuffer;
+	
+	unsigned int numElements;
+
+	vertexShaderBuffer = 0;
+
+	// check file extension for correct loading function.
+	std::wstring fn(filename);
+	std::string::size_type idx;
+	std::wstring extension;
+
+	idx = fn.rfind('.');
+
+	if (idx != std::string::npos)
+	{
+		extension = fn.substr(idx + 1);
+	}
+	else
+	{
+		// No extension found
+		MessageBox(hwnd, L"Error finding vertex shader file", L"ERROR", MB_OK);
+		exit(0);
+	}
+
+	// Load the texture in.
+	if (extension != L"cso")
+	{
+		MessageBox(hwnd, L"Incorrect vertex shader file type", L"ERROR", MB_OK);
+		exit(0);
+	}
+
+	// Reads compiled shader into buffer (bytecode).
+	HRESULT result = readShaderFile(filename, &vertexShaderBuffer);
+	if (result != S_OK)
+	{
+		MessageBox(NULL, filename, L"File ERROR", MB_OK);
+		exit(0);
+	}
+
+	// Create the vertex shader from the buffer.
+	renderer->CreateVertexShader(vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), NULL, &vertexShader);
+
+	// Create the vertex input layout description.
+	// This setup needs to match CompactTerrainVertex. Position and texture coordinates come from SV_VertexID.
+
+	D3D11_INPUT_ELEMENT_DESC polygonLayout[] = {
+		{ "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "HEIGHT", 0, DXGI_FORMAT_R16_UNORM, 0, 4, D3D11_INPUT_PER_VERTEX_DATA, 0 }
+	};
+
+	// Get a count of the elements in the layout.
+	numElements = sizeof(polygonLayout) / sizeof(polygonLayout[0]);
+
+	// Create the vertex input layout.
+	renderer->CreateInputLayout(polygonLayout, numElements, vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), &layout);
+
+	// Release the vertex shader buffer and pixel shader buffer since they are no longer needed.
+	vertexShaderBuffer->Release();
+	vertexShaderBuffer = 0;
+}
+
 
 
 // Given pre-compiled file, load and create pixel shader.
@@ -273,7 +353,7 @@ void BaseShader::loadPixelShader(const wchar_t* filename)
 	}
 
 	// Reads compiled shader into buffer (bytecode).
-	HRESULT result = D3DReadFileToBlob(filename, &pixelShaderBuffer);
+	HRESULT result = readShaderFile(filename, &pixelShaderBuffer);
 	if (result != S_OK)
 	{
 		MessageBox(NULL, filename, L"File not found", MB_OK);
@@ -317,7 +397,7 @@ void BaseShader::loadHullShader(const wchar_t* filename)
 	}
 
 	// Reads compiled shader into buffer (bytecode).
-	HRESULT result = D3DReadFileToBlob(filename, &hullShaderBuffer);
+	HRESULT result = readShaderFile(filename, &hullShaderBuffer);
 	if (result != S_OK)
 	{
 		MessageBox(NULL, filename, L"File not found", MB_OK);
@@ -361,7 +441,7 @@ void BaseShader::loadDomainShader(const wchar_t* filename)
 	}
 
 	// Reads compiled shader into buffer (bytecode).
-	HRESULT result = D3DReadFileToBlob(filename, &domainShaderBuffer);
+	HRESULT result = readShaderFile(filename, &domainShaderBuffer);
 	if (result != S_OK)
 	{
 		MessageBox(NULL, filename, L"File not found", MB_OK);
@@ -405,7 +485,7 @@ void BaseShader::loadGeometryShader(const wchar_t* filename)
 	}
 
 	// Reads compiled shader into buffer (bytecode).
-	HRESULT result = D3DReadFileToBlob(filename, &geometryShaderBuffer);
+	HRESULT result = readShaderFile(filename, &geometryShaderBuffer);
 	if (result != S_OK)
 	{
 		MessageBox(NULL, filename, L"File not found", MB_OK);
@@ -449,7 +529,7 @@ void BaseShader::loadComputeShader(const wchar_t* filename)
 	}
 
 	// Reads compiled shader into buffer (bytecode).
-	HRESULT result = D3DReadFileToBlob(filename, &computeShaderBuffer);
+	HRESULT result = readShaderFile(filename, &computeShaderBuffer);
 	if (result != S_OK)
 	{
 		MessageBox(NULL, filename, L"File not found", MB_OK);
@@ -463,6 +543,12 @@ void BaseShader::loadComputeShader(const wchar_t* filename)
 
 // De/Activate shader stages and send shaders to GPU.
 void BaseShader::render(ID3D11DeviceContext* deviceContext, int indexCount)
+{
+	renderRange(deviceContext, indexCount, 0, 0);
+}
+
+// As render, but draws only part of the index buffer. Used for meshes drawn in pieces, such as terrain chunks.
+void BaseShader::renderRange(ID3D11DeviceContext* deviceContext, int indexCount, int startIndex, int baseVertex)
 {
 	// Set the vertex input layout.
 	deviceContext->IASetInputLayout(layout);
@@ -495,7 +581,7 @@ void BaseShader::render(ID3D11DeviceContext* deviceContext, int indexCount)
 	}
 
 	// Render the triangle.
-	deviceContext->DrawIndexed(indexCount, 0, 0);
+	deviceContext->DrawIndexed(indexCount, startIndex, baseVertex);
 }
 
 // Dispatch the compute shader.
@@ -54,6 +54,10 @@ public:
 	* Sets shader stages and draws the indexed data
 	*/
 	virtual void render(ID3D11DeviceContext* deviceContext, int vertexCount);
+	/** \Brief render a sub-range of the bound index buffer
+	* Sets shader stages and draws indexCount indices from startIndex, offset by baseVertex
+	*/
+	void renderRange(ID3D11DeviceContext* deviceContext, int indexCount, int startIndex, int baseVertex);
 	void compute(ID3D11DeviceContext* dc, int x, int y, int z);
 
 protected:
@@ -61,6 +65,7 @@ protected:
 	void loadVertexShader(const wchar_t* filename);		///< Load Vertex shader, for stand position, tex, normal geomtry
 	void loadColourVertexShader(const wchar_t* filename);		///< Load Vertex shader, pre-made for position and colour only
 	void loadTextureVertexShader(const wchar_t* filename);		///< Load Vertex shader, pre-made for position and tex only
+	void loadCompactTerrainVertexShader(const wchar_t* filename);	///< Load Vertex shader, pre-made for CompactTerrainVertex (normal and height only)
 	void loadHullShader(const wchar_t* filename);		///< Load Hull shader
 	void loadDomainShader(const wchar_t* filename);		///< Load Domain shader
 	void loadGeometryShader(const wchar_t* filename);	///< Load Geometry shader
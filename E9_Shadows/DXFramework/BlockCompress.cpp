@@ -0,0 +1,517 @@
+// Block compress
+// BC1, BC3 and BC5 encoders. Endpoint fitting is shared, the palette searches have SIMD kernels.
+#include "BlockCompress.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BLOCK_COMPRESS_SSE2
+#endif
+
+// One 4x4 block in structure-of-arrays form. Every value is a whole number, so the float sums below are exact.
+struct ColorBlock
+{
+	alignas(16) float r[16];
+	alignas(16) float g[16];
+	alignas(16) float b[16];
+	alignas(16) float a[16];
+};
+
+// Palette searches write the nearest entry for each pixel and return the summed squared error.
+typedef float (*ColorSearch)(const ColorBlock& block, const float palette[4][3], unsigned char indices[16]);
+typedef float (*ChannelSearch)(const float values[16], const float palette[8], unsigned char indices[16]);
+
+struct SearchKernels
+{
+	ColorSearch color;
+	ChannelSearch channel;
+};
+
+static float colorSearchScalar(const ColorBlock& block, const float palette[4][3], unsigned char indices[16])
+{
+	float error = 0.0f;
+	for (int i = 0; i < 16; i++)
+	{
+		float best = 0.0f;
+		int bestIndex = 0;
+		for (int c = 0; c < 4; c++)
+		{
+			float dr = block.r[i] - palette[c][0];
+			float dg = block.g[i] - palette[c][1];
+			float db = block.b[i] - palette[c][2];
+			float distance = dr * dr + dg * dg + db * db;
+			if (c == 0 || distance < best)
+			{
+				best = distance;
+				bestIndex = c;
+			}
+		}
+		indices[i] = (unsigned char)bestIndex;
+		error += best;
+	}
+	return error;
+}
+
+static float channelSearchScalar(const float values[16], const float palette[8], unsigned char indices[16])
+{
+	float error = 0.0f;
+	for (int i = 0; i < 16; i++)
+	{
+		float best = 0.0f;
+		int bestIndex = 0;
+		for (int c = 0; c < 8; c++)
+		{
+			float d = values[i] - palette[c];
+			float distance = d * d;
+			if (c == 0 || distance < best)
+			{
+				best = distance;
+				bestIndex = c;
+			}
+		}
+		indices[i] = (unsigned char)bestIndex;
+		error += best;
+	}
+	return error;
+}
+
+#if defined(BLOCK_COMPRESS_SSE2)
+// Keep the lanes of candidate where it is strictly closer, so ties go to the lower index as in the scalar search.
+static inline void selectCloser(__m128 distance, int index, __m128& best, __m128i& bestIndex)
+{
+	__m128 closer = _mm_cmplt_ps(distance, best);
+	best = _mm_min_ps(distance, best);
+	__m128i mask = _mm_castps_si128(closer);
+	bestIndex = _mm_or_si128(_mm_and_si128(mask, _mm_set1_epi32(index)), _mm_andnot_si128(mask, bestIndex));
+}
+
+static inline void storeIndices(__m128i bestIndex, unsigned char* indices)
+{
+	alignas(16) int lanes[4];
+	_mm_store_si128((__m128i*)lanes, bestIndex);
+	for (int lane = 0; lane < 4; lane++)
+	{
+		indices[lane] = (unsigned char)lanes[lane];
+	}
+}
+
+static inline float sumLanes(__m128 errors)
+{
+	alignas(16) float lanes[4];
+	_mm_store_ps(lanes, errors);
+	return ((lanes[0] + lanes[1]) + lanes[2]) + lanes[3];
+}
+
+static float colorSearchSSE2(const ColorBlock& block, const float palette[4][3], unsigned char indices[16])
+{
+	__m128 errors = _mm_setzero_ps();
+	for (int i = 0; i < 16; i += 4)
+	{
+		__m128 r = _mm_load_ps(block.r + i);
+		__m128 g = _mm_load_ps(block.g + i);
+		__m128 b = _mm_load_ps(block.b + i);
+		__m128 best = _mm_set1_ps(INFINITY);
+		__m128i bestIndex = _mm_setzero_si128();
+		for (int c = 0; c < 4; c++)
+		{
+			__m128 dr = _mm_sub_ps(r, _mm_set1_ps(palette[c][0]));
+			__m128 dg = _mm_sub_ps(g, _mm_set1_ps(palette[c][1]));
+			__m128 db = _mm_sub_ps(b, _mm_set1_ps(palette[c][2]));
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+			selectCloser(distance, c, best, bestIndex);
+		}
+		storeIndices(bestIndex, indices + i);
+		errors = _mm_add_ps(errors, best);
+	}
+	return sumLanes(errors);
+}
+
+static float channelSearchSSE2(const float values[16], const float palette[8], unsigned char indices[16])
+{
+	__m128 errors = _mm_setzero_ps();
+	for (int i = 0; i < 16; i += 4)
+	{
+		__m128 v = _mm_loadu_ps(values + i);
+		__m128 best = _mm_set1_ps(INFINITY);
+		__m128i bestIndex = _mm_setzero_si128();
+		for (int c = 0; c < 8; c++)
+		{
+			__m128 d = _mm_sub_ps(v, _mm_set1_ps(palette[c]));
+			selectCloser(_mm_mul_ps(d, d), c, best, bestIndex);
+		}
+		storeIndices(bestIndex, indices + i);
+		errors = _mm_add_ps(errors, best);
+	}
+	return sumLanes(errors);
+}
+#endif
+
+static const SearchKernels scalarKernels = { colorSearchScalar, channelSearchScalar };
+#if defined(BLOCK_COMPRESS_SSE2)
+static const SearchKernels simdKernels = { colorSearchSSE2, channelSearchSSE2 };
+#else
+static const SearchKernels simdKernels = scalarKernels;
+#endif
+
+// 5:6:5 packing with rounding, and the bit-replicating expansion decoders use.
+static uint16_t packColor(const float rgb[3])
+{
+	int r = (int)(std::min(std::max(rgb[0], 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f);
+	int g = (int)(std::min(std::max(rgb[1], 0.0f), 255.0f) * 63.0f / 255.0f + 0.5f);
+	int b = (int)(std::min(std::max(rgb[2], 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f);
+	return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void unpackColor(uint16_t color, int rgb[3])
+{
+	int r = color >> 11, g = (color >> 5) & 63, b = color & 31;
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+// Four-colour mode palette: the endpoints, then the points a third and two thirds of the way between them.
+static void buildColorPalette(uint16_t color0, uint16_t color1, float palette[4][3])
+{
+	int a[3], b[3];
+	unpackColor(color0, a);
+	unpackColor(color1, b);
+	for (int c = 0; c < 3; c++)
+	{
+		palette[0][c] = (float)a[c];
+		palette[1][c] = (float)b[c];
+		palette[2][c] = (float)((2 * a[c] + b[c]) / 3);
+		palette[3][c] = (float)((a[c] + 2 * b[c]) / 3);
+	}
+}
+
+static void writeColorBlock(uint16_t color0, uint16_t color1, const unsigned char indices[16], unsigned char* out)
+{
+	// Four-colour mode needs color0 > color1. Swapping the endpoints swaps indices 0-1 and 2-3.
+	bool swap = color0 < color1;
+	uint32_t bits = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		uint32_t index = (color0 == color1) ? 0 : (swap ? indices[i] ^ 1 : indices[i]);
+		bits |= index << (i * 2);
+	}
+	if (swap)
+	{
+		std::swap(color0, color1);
+	}
+	out[0] = (unsigned char)(color0 & 0xFF);
+	out[1] = (unsigned char)(color0 >> 8);
+	out[2] = (unsigned char)(color1 & 0xFF);
+	out[3] = (unsigned char)(color1 >> 8);
+	for (int i = 0; i < 4; i++)
+	{
+		out[4 + i] = (unsigned char)(bits >> (i * 8));
+	}
+}
+
+static void encodeColorBlock(const ColorBlock& block, const SearchKernels& kernels, unsigned char* out)
+{
+	// Principal axis of the block's colours, by power iteration on the covariance matrix.
+	float mean[3] = { 0.0f, 0.0f, 0.0f };
+	float low[3] = { 255.0f, 255.0f, 255.0f }, high[3] = { 0.0f, 0.0f, 0.0f };
+	const float* channels[3] = { block.r, block.g, block.b };
+	for (int c = 0; c < 3; c++)
+	{
+		for (int i = 0; i < 16; i++)
+		{
+			mean[c] += channels[c][i];
+			low[c] = std::min(low[c], channels[c][i]);
+			high[c] = std::max(high[c], channels[c][i]);
+		}
+		mean[c] /= 16.0f;
+	}
+
+	float covariance[6] = {};
+	for (int i = 0; i < 16; i++)
+	{
+		float d[3] = { block.r[i] - mean[0], block.g[i] - mean[1], block.b[i] - mean[2] };
+		covariance[0] += d[0] * d[0];
+		covariance[1] += d[0] * d[1];
+		covariance[2] += d[0] * d[2];
+		covariance[3] += d[1] * d[1];
+		covariance[4] += d[1] * d[2];
+		covariance[5] += d[2] * d[2];
+	}
+
+	float axis[3] = { high[0] - low[0], high[1] - low[1], high[2] - low[2] };
+	for (int iteration = 0; iteration < 8; iteration++)
+	{
+		float next[3] = {
+			covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+			covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+			covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2] };
+		float length = std::max(std::max(std::fabs(next[0]), std::fabs(next[1])), std::fabs(next[2]));
+		if (length < 1e-6f)
+		{
+			break;
+		}
+		for (int c = 0; c < 3; c++)
+		{
+			axis[c] = next[c] / length;
+		}
+	}
+
+	// Endpoints at the extreme projections onto the axis. A solid block leaves both at the mean.
+	float axisLengthSq = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+	float minT = 0.0f, maxT = 0.0f;
+	if (axisLengthSq > 0.0f)
+	{
+		for (int i = 0; i < 16; i++)
+		{
+			float t = ((block.r[i] - mean[0]) * axis[0] + (block.g[i] - mean[1]) * axis[1] + (block.b[i] - mean[2]) * axis[2]) / axisLengthSq;
+			minT = std::min(minT, t);
+			maxT = std::max(maxT, t);
+		}
+	}
+	float endpoint0[3], endpoint1[3];
+	for (int c = 0; c < 3; c++)
+	{
+		endpoint0[c] = mean[c] + axis[c] * maxT;
+		endpoint1[c] = mean[c] + axis[c] * minT;
+	}
+
+	float palette[4][3];
+	unsigned char indices[16], candidate[16];
+	uint16_t color0 = packColor(endpoint0), color1 = packColor(endpoint1);
+	buildColorPalette(color0, color1, palette);
+	float error = kernels.color(block, palette, indices);
+
+	// Least-squares endpoints for the chosen indices, kept while they lower the error.
+	static const float weight0[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+	for (int pass = 0; pass < 2 && error > 0.0f; pass++)
+	{
+		float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+		float ax[3] = {}, bx[3] = {};
+		for (int i = 0; i < 16; i++)
+		{
+			float w0 = weight0[indices[i]], w1 = 1.0f - w0;
+			aa += w0 * w0;
+			ab += w0 * w1;
+			bb += w1 * w1;
+			for (int c = 0; c < 3; c++)
+			{
+				ax[c] += w0 * channels[c][i];
+				bx[c] += w1 * channels[c][i];
+			}
+		}
+		float determinant = aa * bb - ab * ab;
+		if (std::fabs(determinant) < 1e-6f)
+		{
+			break;
+		}
+		for (int c = 0; c < 3; c++)
+		{
+			endpoint0[c] = (ax[c] * bb - bx[c] * ab) / determinant;
+			endpoint1[c] = (bx[c] * aa - ax[c] * ab) / determinant;
+		}
+
+		uint16_t refined0 = packColor(endpoint0), refined1 = packColor(endpoint1);
+		if (refined0 == color0 && refined1 == color1)
+		{
+			break;
+		}
+		buildColorPalette(refined0, refined1, palette);
+		float refinedError = kernels.color(block, palette, candidate);
+		if (refinedError >= error)
+		{
+			break;
+		}
+		error = refinedError;
+		color0 = refined0;
+		color1 = refined1;
+		std::copy(candidate, candidate + 16, indices);
+	}
+
+	writeColorBlock(color0, color1, indices, out);
+}
+
+// BC4 palettes. a0 > a1 interpolates six values between them, otherwise four plus 0 and 255.
+static void buildChannelPalette(int a0, int a1, float palette[8])
+{
+	palette[0] = (float)a0;
+	palette[1] = (float)a1;
+	if (a0 > a1)
+	{
+		for (int i = 1; i <= 6; i++)
+		{
+			palette[1 + i] = (float)(((7 - i) * a0 + i * a1) / 7);
+		}
+	}
+	else
+	{
+		for (int i = 1; i <= 4; i++)
+		{
+			palette[1 + i] = (float)(((5 - i) * a0 + i * a1) / 5);
+		}
+		palette[6] = 0.0f;
+		palette[7] = 255.0f;
+	}
+}
+
+static void encodeChannelBlock(const float values[16], const SearchKernels& kernels, unsigned char* out)
+{
+	float low = 255.0f, high = 0.0f, innerLow = 255.0f, innerHigh = 0.0f;
+	for (int i = 0; i < 16; i++)
+	{
+		low = std::min(low, values[i]);
+		high = std::max(high, values[i]);
+		if (values[i] > 0.0f && values[i] < 255.0f)
+		{
+			innerLow = std::min(innerLow, values[i]);
+			innerHigh = std::max(innerHigh, values[i]);
+		}
+	}
+
+	float palette[8];
+	unsigned char indices[16], candidate[16];
+	int a0 = (int)high, a1 = (int)low;
+	buildChannelPalette(a0, a1, palette);
+	float error = kernels.channel(values, palette, indices);
+
+	// Blocks touching 0 or 255 may do better spending the interpolated values on the rest.
+	if ((low == 0.0f || high == 255.0f) && innerLow <= innerHigh && error > 0.0f)
+	{
+		buildChannelPalette((int)innerLow, (int)innerHigh, palette);
+		float sixError = kernels.channel(values, palette, candidate);
+		if (sixError < error)
+		{
+			a0 = (int)innerLow;
+			a1 = (int)innerHigh;
+			std::copy(candidate, candidate + 16, indices);
+		}
+	}
+
+	out[0] = (unsigned char)a0;
+	out[1] = (unsigned char)a1;
+	uint64_t bits = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		bits |= (uint64_t)indices[i] << (i * 3);
+	}
+	for (int i = 0; i < 6; i++)
+	{
+		out[2 + i] = (unsigned char)(bits >> (i * 8));
+	}
+}
+
+size_t getBlockSize(uint32_t format)
+{
+	switch (format)
+	{
+	case blockFormatBC1: return 8;
+	case blockFormatBC3: return 16;
+	case blockFormatBC5: return 16;
+	default: return 0;
+	}
+}
+
+size_t getCompressedSize(int width, int height, uint32_t format)
+{
+	size_t blocksX = (size_t)std::max((width + 3) / 4, 1);
+	size_t blocksY = (size_t)std::max((height + 3) / 4, 1);
+	return blocksX * blocksY * getBlockSize(format);
+}
+
+// Encode one row of blocks. Pixels past the right and bottom edges repeat the last column and row.
+static void compressBlockRow(const unsigned char* rgba, int width, int height, uint32_t format, int blockY, unsigned char* out, const SearchKernels& kernels)
+{
+	size_t blockSize = getBlockSize(format);
+	int blocksX = std::max((width + 3) / 4, 1);
+	ColorBlock block;
+	for (int blockX = 0; blockX < blocksX; blockX++)
+	{
+		for (int i = 0; i < 16; i++)
+		{
+			int x = std::min(blockX * 4 + (i & 3), width - 1);
+			int y = std::min(blockY * 4 + (i >> 2), height - 1);
+			const unsigned char* pixel = rgba + ((size_t)y * width + x) * 4;
+			block.r[i] = pixel[0];
+			block.g[i] = pixel[1];
+			block.b[i] = pixel[2];
+			block.a[i] = pixel[3];
+		}
+
+		unsigned char* destination = out + ((size_t)blockY * blocksX + blockX) * blockSize;
+		if (format == blockFormatBC1)
+		{
+			encodeColorBlock(block, kernels, destination);
+		}
+		else if (format == blockFormatBC3)
+		{
+			encodeChannelBlock(block.a, kernels, destination);
+			encodeColorBlock(block, kernels, destination + 8);
+		}
+		else
+		{
+			encodeChannelBlock(block.r, kernels, destination);
+			encodeChannelBlock(block.g, kernels, destination + 8);
+		}
+	}
+}
+
+bool compressImage(const unsigned char* rgba, int width, int height, uint32_t format, unsigned char* out, int threadCount)
+{
+	if (getBlockSize(format) == 0 || width <= 0 || height <= 0)
+	{
+		return false;
+	}
+
+	int blocksY = (height + 3) / 4;
+	if (threadCount <= 0)
+	{
+		threadCount = (int)std::thread::hardware_concurrency();
+	}
+	threadCount = std::min(std::max(threadCount, 1), blocksY);
+
+	// Threads take the next unclaimed block row until none are left. The calling thread is one of them.
+	std::atomic<int> nextRow(0);
+	auto work = [&]()
+	{
+		for (int blockY = nextRow++; blockY < blocksY; blockY = nextRow++)
+		{
+			compressBlockRow(rgba, width, height, format, blockY, out, simdKernels);
+		}
+	};
+	std::vector<std::thread> threads;
+	for (int i = 1; i < threadCount; i++)
+	{
+		threads.emplace_back(work);
+	}
+	work();
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	return true;
+}
+
+bool compressImageScalar(const unsigned char* rgba, int width, int height, uint32_t format, unsigned char* out)
+{
+	if (getBlockSize(format) == 0 || width <= 0 || height <= 0)
+	{
+		return false;
+	}
+	for (int blockY = 0; blockY < (height + 3) / 4; blockY++)
+	{
+		compressBlockRow(rgba, width, height, format, blockY, out, scalarKernels);
+	}
+	return true;
+}
+
+const char* getBlockCompressKernelName()
+{
+#if defined(BLOCK_COMPRESS_SSE2)
+	return "SSE2";
+#else
+	return "Scalar";
+#endif
+}
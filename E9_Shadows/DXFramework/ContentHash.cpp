@@ -0,0 +1,176 @@
+// Content hash
+// Streaming XXH64 for keying assets by their bytes.
+#include "ContentHash.h"
+#include "AssetPack.h"
+#include <cstring>
+
+static const uint64_t prime1 = 0x9E3779B185EBCA87ull;
+static const uint64_t prime2 = 0xC2B2AE3D27D4EB4Full;
+static const uint64_t prime3 = 0x165667B19E3779F9ull;
+static const uint64_t prime4 = 0x85EBCA77C2B2AE63ull;
+static const uint64_t prime5 = 0x27D4EB2F165667C5ull;
+
+static inline uint64_t rotateLeft(uint64_t value, int bits)
+{
+	return (value << bits) | (value >> (64 - bits));
+}
+
+// Little-endian reads, safe at any alignment.
+static inline uint64_t read64(const unsigned char* p)
+{
+	uint64_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+static inline uint32_t read32(const unsigned char* p)
+{
+	uint32_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+static inline uint64_t mixLane(uint64_t lane, uint64_t input)
+{
+	lane += input * prime2;
+	lane = rotateLeft(lane, 31);
+	return lane * prime1;
+}
+
+static inline uint64_t mergeRound(uint64_t hash, uint64_t lane)
+{
+	hash ^= mixLane(0, lane);
+	return hash * prime1 + prime4;
+}
+
+// Consume whole 32-byte stripes, one 8-byte word per lane. Returns the bytes used.
+static size_t consumeStripes(uint64_t lanes[4], const unsigned char* data, size_t size)
+{
+	uint64_t v0 = lanes[0], v1 = lanes[1], v2 = lanes[2], v3 = lanes[3];
+	const unsigned char* p = data;
+	const unsigned char* end = data + (size & ~(size_t)31);
+	for (; p < end; p += 32)
+	{
+		v0 = mixLane(v0, read64(p));
+		v1 = mixLane(v1, read64(p + 8));
+		v2 = mixLane(v2, read64(p + 16));
+		v3 = mixLane(v3, read64(p + 24));
+	}
+	lanes[0] = v0;
+	lanes[1] = v1;
+	lanes[2] = v2;
+	lanes[3] = v3;
+	return (size_t)(p - data);
+}
+
+ContentHasher::ContentHasher(uint64_t lseed)
+{
+	seed = lseed;
+	lanes[0] = seed + prime1 + prime2;
+	lanes[1] = seed + prime2;
+	lanes[2] = seed;
+	lanes[3] = seed - prime1;
+}
+
+void ContentHasher::update(const void* data, size_t size)
+{
+	// Empty files come with no data pointer, and memcpy must not be given one even for 0 bytes.
+	if (size == 0)
+	{
+		return;
+	}
+	const unsigned char* p = (const unsigned char*)data;
+	total += size;
+
+	// Top up a partial stripe left by the last call first.
+	if (pendingSize > 0)
+	{
+		size_t take = (size < 32 - pendingSize) ? size : 32 - pendingSize;
+		memcpy(pending + pendingSize, p, take);
+		pendingSize += take;
+		p += take;
+		size -= take;
+		if (pendingSize < 32)
+		{
+			return;
+		}
+		consumeStripes(lanes, pending, 32);
+		pendingSize = 0;
+	}
+
+	size_t used = consumeStripes(lanes, p, size);
+	memcpy(pending, p + used, size - used);
+	pendingSize = size - used;
+}
+
+uint64_t ContentHasher::finish() const
+{
+	uint64_t hash;
+	if (total >= 32)
+	{
+		hash = rotateLeft(lanes[0], 1) + rotateLeft(lanes[1], 7) + rotateLeft(lanes[2], 12) + rotateLeft(lanes[3], 18);
+		for (int lane = 0; lane < 4; lane++)
+		{
+			hash = mergeRound(hash, lanes[lane]);
+		}
+	}
+	else
+	{
+		hash = seed + prime5;
+	}
+	hash += total;
+
+	const unsigned char* p = pending;
+	const unsigned char* end = pending + pendingSize;
+	for (; p + 8 <= end; p += 8)
+	{
+		hash ^= mixLane(0, read64(p));
+		hash = rotateLeft(hash, 27) * prime1 + prime4;
+	}
+	if (p + 4 <= end)
+	{
+		hash ^= (uint64_t)read32(p) * prime1;
+		hash = rotateLeft(hash, 23) * prime2 + prime3;
+		p += 4;
+	}
+	for (; p < end; p++)
+	{
+		hash ^= *p * prime5;
+		hash = rotateLeft(hash, 11) * prime1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= prime2;
+	hash ^= hash >> 29;
+	hash *= prime3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+uint64_t hashContent(const void* data, size_t size, uint64_t seed)
+{
+	ContentHasher hasher(seed);
+	hasher.update(data, size);
+	return hasher.finish();
+}
+
+bool hashFile(const std::string& filename, ContentKey& key)
+{
+	// Packed files were hashed when the pack was built.
+	AssetPackEntry packed;
+	if (findPackedFile(filename, &packed))
+	{
+		key.hash = packed.contentHash;
+		key.size = packed.size;
+		return true;
+	}
+
+	MappedFile file;
+	if (!file.open(filename))
+	{
+		return false;
+	}
+	key.hash = hashContent(file.getData(), file.getSize());
+	key.size = file.getSize();
+	return true;
+}
@@ -0,0 +1,66 @@
+/**
+* \brief Platform-neutral content hashing for asset deduplication
+*
+* Hashes bytes with the 64-bit xxHash algorithm (XXH64), which runs at memory speed on 64-bit CPUs and whose
+* results match the reference implementation, so hashes can be checked with the xxhsum tool.
+* ContentHasher takes the bytes in pieces of any size and gives the same hash as hashing them in one go.
+* A ContentKey adds the byte count and a variant to the hash, so the same bytes decoded two ways (for a different
+* device or different import settings) stay apart.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _CONTENTHASH_H_
+#define _CONTENTHASH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// Identifies an asset by its contents. Two files with the same bytes have equal keys, whatever their paths.
+struct ContentKey
+{
+	uint64_t hash = 0;
+	uint64_t size = 0;
+	uint64_t variant = 0;	///< Separates different decodes of the same bytes
+
+	bool operator==(const ContentKey& other) const { return hash == other.hash && size == other.size && variant == other.variant; }
+	bool operator!=(const ContentKey& other) const { return !(*this == other); }
+	bool operator<(const ContentKey& other) const
+	{
+		if (hash != other.hash)
+			return hash < other.hash;
+		if (size != other.size)
+			return size < other.size;
+		return variant < other.variant;
+	}
+};
+
+/// Streaming XXH64.
+class ContentHasher
+{
+public:
+	ContentHasher(uint64_t seed = 0);
+
+	void update(const void* data, size_t size);
+	uint64_t finish() const;				///< Hash of everything so far. More data can still be added
+	uint64_t getSize() const { return total; }
+
+private:
+	uint64_t seed;
+	uint64_t lanes[4];
+	unsigned char pending[32];				///< Bytes short of a full 32-byte stripe
+	size_t pendingSize = 0;
+	uint64_t total = 0;
+};
+
+/// XXH64 of a block of memory.
+uint64_t hashContent(const void* data, size_t size, uint64_t seed = 0);
+
+/** \brief Hashes a whole file through a memory mapping
+* @param key receives the hash and size. The variant is left as it is
+* @return false if the file cannot be opened
+*/
+bool hashFile(const std::string& filename, ContentKey& key);
+
+#endif
@@ -0,0 +1,49 @@
+// CPU features
+// Detects AVX2 once with cpuid, including the operating system's support for the wider registers.
+#include "CpuFeatures.h"
+#include <atomic>
+#if defined(_MSC_VER) && defined(CPU_AVX2_KERNELS)
+#include <intrin.h>
+#endif
+
+static bool detectAvx2()
+{
+#if defined(_MSC_VER) && defined(CPU_AVX2_KERNELS)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+	{
+		return false;
+	}
+
+	// AVX needs OSXSAVE, and the OS must save the XMM and YMM state on a context switch.
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+	{
+		return false;
+	}
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#elif defined(CPU_AVX2_KERNELS)
+	// Checks the OS saves the YMM state too.
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") != 0;
+#else
+	return false;
+#endif
+}
+
+static std::atomic<bool> avx2Enabled{ true };
+
+bool useAvx2Kernels()
+{
+	static const bool supported = detectAvx2();
+	return supported && avx2Enabled;
+}
+
+void setAvx2KernelsEnabled(bool enabled)
+{
+	avx2Enabled = enabled;
+}
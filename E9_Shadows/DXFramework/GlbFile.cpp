@@ -0,0 +1,642 @@
+// Glb file
+// Maps binary glTF, validates accessors and builds vertex and index streams, in place where the layout allows.
+#include "GlbFile.h"
+#include <algorithm>
+#include <cctype>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <string_view>
+
+namespace
+{
+	const uint32_t glbMagic = 0x46546C67;		// "glTF"
+	const uint32_t glbJsonChunk = 0x4E4F534A;	// "JSON"
+	const uint32_t glbBinChunk = 0x004E4942;	// "BIN\0"
+	const int maxJsonDepth = 64;
+
+	/// Minimal JSON document. Strings are views into the mapped file and keep their escapes.
+	struct JsonValue
+	{
+		char type = 'n';			///< n(ull), b(ool), d(number), s(tring), a(rray), o(bject)
+		double number = 0.0;
+		bool boolean = false;
+		std::string_view text;
+		std::vector<JsonValue> items;
+		std::vector<std::pair<std::string_view, JsonValue>> members;
+
+		const JsonValue* get(std::string_view key) const
+		{
+			for (const auto& member : members)
+			{
+				if (member.first == key)
+					return &member.second;
+			}
+			return nullptr;
+		}
+
+		const JsonValue* at(uint64_t index) const
+		{
+			return (type == 'a' && index < items.size()) ? &items[(size_t)index] : nullptr;
+		}
+	};
+
+	class JsonReader
+	{
+	public:
+		JsonReader(const char* begin, const char* end) : p(begin), end(end) {}
+
+		bool parseDocument(JsonValue& value)
+		{
+			return parse(value, 0) && skipSpace() == end;
+		}
+
+	private:
+		const char* skipSpace()
+		{
+			while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+				p++;
+			return p;
+		}
+
+		bool literal(const char* word)
+		{
+			size_t length = strlen(word);
+			if ((size_t)(end - p) < length || memcmp(p, word, length) != 0)
+				return false;
+			p += length;
+			return true;
+		}
+
+		bool parseString(std::string_view& text)
+		{
+			const char* start = ++p;
+			while (p < end && *p != '"')
+			{
+				if (*p == '\\')
+					p++;
+				p++;
+			}
+			if (p >= end)
+				return false;
+			text = std::string_view(start, p - start);
+			p++;
+			return true;
+		}
+
+		bool parse(JsonValue& value, int depth)
+		{
+			if (depth > maxJsonDepth || skipSpace() == end)
+				return false;
+
+			char c = *p;
+			if (c == '{')
+			{
+				value.type = 'o';
+				p++;
+				if (skipSpace() < end && *p == '}')
+				{
+					p++;
+					return true;
+				}
+				while (true)
+				{
+					std::string_view key;
+					if (skipSpace() == end || *p != '"' || !parseString(key) || skipSpace() == end || *p++ != ':')
+						return false;
+					value.members.emplace_back(key, JsonValue());
+					if (!parse(value.members.back().second, depth + 1) || skipSpace() == end)
+						return false;
+					if (*p == '}')
+					{
+						p++;
+						return true;
+					}
+					if (*p++ != ',')
+						return false;
+				}
+			}
+			if (c == '[')
+			{
+				value.type = 'a';
+				p++;
+				if (skipSpace() < end && *p == ']')
+				{
+					p++;
+					return true;
+				}
+				while (true)
+				{
+					value.items.emplace_back();
+					if (!parse(value.items.back(), depth + 1) || skipSpace() == end)
+						return false;
+					if (*p == ']')
+					{
+						p++;
+						return true;
+					}
+					if (*p++ != ',')
+						return false;
+				}
+			}
+			if (c == '"')
+			{
+				value.type = 's';
+				return parseString(value.text);
+			}
+			if (c == 't' || c == 'f')
+			{
+				value.type = 'b';
+				value.boolean = (c == 't');
+				return literal(value.boolean ? "true" : "false");
+			}
+			if (c == 'n')
+			{
+				value.type = 'n';
+				return literal("null");
+			}
+
+			// Numbers are parsed from a bounded copy, as strtod needs a terminator.
+			const char* start = p;
+			while (p < end && (isdigit((unsigned char)*p) || *p == '-' || *p == '+' || *p == '.' || *p == 'e' || *p == 'E'))
+				p++;
+			if (p == start || p - start > 63)
+				return false;
+			char number[64];
+			memcpy(number, start, p - start);
+			number[p - start] = '\0';
+			char* parsedEnd;
+			value.type = 'd';
+			value.number = strtod(number, &parsedEnd);
+			return parsedEnd == number + (p - start);
+		}
+
+		const char* p;
+		const char* end;
+	};
+
+	// Reads a non-negative integer member. Missing members take the fallback, anything else non-integral fails.
+	bool getIndex(const JsonValue& object, std::string_view key, uint64_t& out, bool required, uint64_t fallback = 0)
+	{
+		const JsonValue* value = object.get(key);
+		if (!value)
+		{
+			out = fallback;
+			return !required;
+		}
+		if (value->type != 'd' || value->number < 0.0 || value->number > 9007199254740992.0 || value->number != std::floor(value->number))
+			return false;
+		out = (uint64_t)value->number;
+		return true;
+	}
+
+	/// A validated accessor: every element lies inside the binary chunk.
+	struct Accessor
+	{
+		const unsigned char* data = nullptr;
+		uint32_t count = 0;
+		uint32_t stride = 0;
+		uint32_t componentType = 0;
+		int components = 0;
+		bool normalized = false;
+		uint64_t viewIndex = 0;
+		uint64_t offsetInView = 0;
+	};
+
+	int getComponentSize(uint64_t componentType)
+	{
+		switch (componentType)
+		{
+		case 5120: case 5121: return 1;
+		case 5122: case 5123: return 2;
+		case 5125: case 5126: return 4;
+		default: return 0;
+		}
+	}
+
+	int getComponentCount(std::string_view type)
+	{
+		if (type == "SCALAR") return 1;
+		if (type == "VEC2") return 2;
+		if (type == "VEC3") return 3;
+		if (type == "VEC4") return 4;
+		return 0;
+	}
+
+	bool readAccessor(const JsonValue& document, const unsigned char* bin, uint64_t binSize, uint64_t index, Accessor& accessor, std::string& error)
+	{
+		const JsonValue* accessors = document.get("accessors");
+		const JsonValue* bufferViews = document.get("bufferViews");
+		const JsonValue* buffers = document.get("buffers");
+		const JsonValue* json = accessors ? accessors->at(index) : nullptr;
+		if (!json || json->type != 'o')
+		{
+			error = "Missing accessor " + std::to_string(index);
+			return false;
+		}
+
+		uint64_t viewIndex, byteOffset, componentType, count;
+		const JsonValue* type = json->get("type");
+		if (!getIndex(*json, "bufferView", viewIndex, true) || !getIndex(*json, "byteOffset", byteOffset, false)
+			|| !getIndex(*json, "componentType", componentType, true) || !getIndex(*json, "count", count, true)
+			|| !type || type->type != 's' || json->get("sparse") || count > UINT32_MAX)
+		{
+			error = "Unsupported or malformed accessor " + std::to_string(index);
+			return false;
+		}
+		accessor.components = getComponentCount(type->text);
+		int componentSize = getComponentSize(componentType);
+		if (accessor.components == 0 || componentSize == 0)
+		{
+			error = "Unsupported accessor type in accessor " + std::to_string(index);
+			return false;
+		}
+
+		const JsonValue* view = bufferViews ? bufferViews->at(viewIndex) : nullptr;
+		uint64_t bufferIndex, viewOffset, viewLength, viewStride;
+		if (!view || view->type != 'o' || !getIndex(*view, "buffer", bufferIndex, true) || !getIndex(*view, "byteOffset", viewOffset, false)
+			|| !getIndex(*view, "byteLength", viewLength, true) || !getIndex(*view, "byteStride", viewStride, false))
+		{
+			error = "Malformed buffer view " + std::to_string(viewIndex);
+			return false;
+		}
+
+		const JsonValue* buffer = buffers ? buffers->at(bufferIndex) : nullptr;
+		uint64_t bufferLength;
+		if (!buffer || buffer->type != 'o' || buffer->get("uri") || !getIndex(*buffer, "byteLength", bufferLength, true) || bufferIndex != 0 || !bin)
+		{
+			error = "Buffer view " + std::to_string(viewIndex) + " does not use the GLB binary chunk";
+			return false;
+		}
+
+		uint64_t elementSize = (uint64_t)accessor.components * componentSize;
+		uint64_t stride = viewStride ? viewStride : elementSize;
+		uint64_t accessorEnd = (count > 0) ? byteOffset + stride * (count - 1) + elementSize : byteOffset;
+		if (bufferLength > binSize || viewOffset + viewLength > bufferLength || stride < elementSize || accessorEnd > viewLength)
+		{
+			error = "Accessor " + std::to_string(index) + " reads outside its buffer";
+			return false;
+		}
+
+		const JsonValue* normalized = json->get("normalized");
+		accessor.data = bin + viewOffset + byteOffset;
+		accessor.count = (uint32_t)count;
+		accessor.stride = (uint32_t)stride;
+		accessor.componentType = (uint32_t)componentType;
+		accessor.normalized = normalized && normalized->type == 'b' && normalized->boolean;
+		accessor.viewIndex = viewIndex;
+		accessor.offsetInView = byteOffset;
+		return true;
+	}
+
+	float readComponent(const unsigned char* data, uint32_t componentType, bool normalized)
+	{
+		switch (componentType)
+		{
+		case 5126: { float v; memcpy(&v, data, 4); return v; }
+		case 5121: return normalized ? data[0] / 255.0f : (float)data[0];
+		case 5123: { uint16_t v; memcpy(&v, data, 2); return normalized ? v / 65535.0f : (float)v; }
+		case 5120: { int8_t v; memcpy(&v, data, 1); return normalized ? std::max(v / 127.0f, -1.0f) : (float)v; }
+		case 5122: { int16_t v; memcpy(&v, data, 2); return normalized ? std::max(v / 32767.0f, -1.0f) : (float)v; }
+		case 5125: { uint32_t v; memcpy(&v, data, 4); return (float)v; }
+		default: return 0.0f;
+		}
+	}
+
+	uint32_t readIndex(const Accessor& accessor, uint32_t i)
+	{
+		const unsigned char* data = accessor.data + (size_t)i * accessor.stride;
+		switch (accessor.componentType)
+		{
+		case 5121: return data[0];
+		case 5123: { uint16_t v; memcpy(&v, data, 2); return v; }
+		default: { uint32_t v; memcpy(&v, data, 4); return v; }
+		}
+	}
+
+	/// One triangle primitive with its validated accessors.
+	struct Primitive
+	{
+		Accessor position, normal, texCoord, index;
+		bool hasNormal = false, hasTexCoord = false, hasIndices = false;
+		uint32_t materialIndex = 0;
+	};
+}
+
+bool isGlbFilename(const std::string& filename)
+{
+	if (filename.size() < 4)
+	{
+		return false;
+	}
+	std::string extension = filename.substr(filename.size() - 4);
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)tolower(c); });
+	return extension == ".glb";
+}
+
+bool GlbFile::open(const std::string& filename, std::string& error, bool leftHanded)
+{
+	close();
+	if (!file.open(filename))
+	{
+		error = "Could not open " + filename;
+		return false;
+	}
+
+	// 12-byte header, then a JSON chunk and an optional binary chunk.
+	const unsigned char* data = file.getData();
+	size_t size = file.getSize();
+	uint32_t header[3], chunk[2];
+	if (size < 20)
+	{
+		error = "File too small for a GLB header";
+		close();
+		return false;
+	}
+	memcpy(header, data, sizeof(header));
+	memcpy(chunk, data + 12, sizeof(chunk));
+	if (header[0] != glbMagic || header[1] != 2 || header[2] > size || chunk[1] != glbJsonChunk || 20 + (uint64_t)chunk[0] > header[2])
+	{
+		error = "Not a glTF 2.0 binary file";
+		close();
+		return false;
+	}
+	const char* json = (const char*)data + 20;
+	uint64_t binStart = 20 + (uint64_t)chunk[0];
+	const unsigned char* bin = nullptr;
+	uint64_t binSize = 0;
+	if (binStart + 8 <= header[2])
+	{
+		uint32_t binChunk[2];
+		memcpy(binChunk, data + binStart, sizeof(binChunk));
+		if (binChunk[1] == glbBinChunk && binStart + 8 + binChunk[0] <= header[2])
+		{
+			bin = data + binStart + 8;
+			binSize = binChunk[0];
+		}
+	}
+
+	JsonValue document;
+	JsonReader reader(json, json + chunk[0]);
+	if (!reader.parseDocument(document) || document.type != 'o')
+	{
+		error = "Malformed glTF JSON";
+		close();
+		return false;
+	}
+
+	// Gather and validate every triangle primitive before reading any vertex.
+	std::vector<Primitive> primitives;
+	uint64_t totalVertices = 0, totalIndices = 0;
+	const JsonValue* meshes = document.get("meshes");
+	for (size_t m = 0; meshes && m < meshes->items.size(); m++)
+	{
+		const JsonValue* meshPrimitives = meshes->items[m].get("primitives");
+		for (size_t p = 0; meshPrimitives && p < meshPrimitives->items.size(); p++)
+		{
+			const JsonValue& json = meshPrimitives->items[p];
+			const JsonValue* attributes = json.get("attributes");
+			uint64_t mode, material, accessorIndex;
+			if (json.type != 'o' || !attributes || !getIndex(json, "mode", mode, false, 4) || !getIndex(json, "material", material, false))
+			{
+				error = "Malformed primitive in mesh " + std::to_string(m);
+				close();
+				return false;
+			}
+			// Points and lines are skipped, as the triangle list has no place for them.
+			if (mode != 4)
+			{
+				continue;
+			}
+
+			Primitive primitive;
+			primitive.materialIndex = (uint32_t)material;
+			if (!getIndex(*attributes, "POSITION", accessorIndex, true) || !readAccessor(document, bin, binSize, accessorIndex, primitive.position, error))
+			{
+				if (error.empty())
+					error = "Primitive without positions in mesh " + std::to_string(m);
+				close();
+				return false;
+			}
+			primitive.hasNormal = attributes->get("NORMAL") != nullptr;
+			primitive.hasTexCoord = attributes->get("TEXCOORD_0") != nullptr;
+			primitive.hasIndices = json.get("indices") != nullptr;
+			bool valid = primitive.position.components == 3 && primitive.position.componentType == 5126;
+			if (valid && primitive.hasNormal)
+			{
+				valid = getIndex(*attributes, "NORMAL", accessorIndex, true) && readAccessor(document, bin, binSize, accessorIndex, primitive.normal, error)
+					&& primitive.normal.components == 3 && primitive.normal.componentType == 5126 && primitive.normal.count == primitive.position.count;
+			}
+			if (valid && primitive.hasTexCoord)
+			{
+				valid = getIndex(*attributes, "TEXCOORD_0", accessorIndex, true) && readAccessor(document, bin, binSize, accessorIndex, primitive.texCoord, error)
+					&& primitive.texCoord.components == 2 && primitive.texCoord.count == primitive.position.count
+					&& (primitive.texCoord.componentType == 5126 || ((primitive.texCoord.componentType == 5121 || primitive.texCoord.componentType == 5123) && primitive.texCoord.normalized));
+			}
+			if (valid && primitive.hasIndices)
+			{
+				valid = getIndex(json, "indices", accessorIndex, true) && readAccessor(document, bin, binSize, accessorIndex, primitive.index, error)
+					&& primitive.index.components == 1
+					&& (primitive.index.componentType == 5121 || primitive.index.componentType == 5123 || primitive.index.componentType == 5125);
+			}
+			uint32_t primitiveIndices = primitive.hasIndices ? primitive.index.count : primitive.position.count;
+			valid = valid && primitiveIndices % 3 == 0;
+			for (uint32_t i = 0; valid && primitive.hasIndices && i < primitive.index.count; i++)
+			{
+				valid = readIndex(primitive.index, i) < primitive.position.count;
+			}
+			if (!valid)
+			{
+				if (error.empty())
+					error = "Unsupported attribute layout or index out of range in mesh " + std::to_string(m);
+				close();
+				return false;
+			}
+
+			totalVertices += primitive.position.count;
+			totalIndices += primitiveIndices;
+			primitives.push_back(primitive);
+		}
+	}
+	if (primitives.empty() || totalVertices > UINT32_MAX || totalIndices > UINT32_MAX)
+	{
+		error = primitives.empty() ? "No triangle primitives" : "Mesh too large for 32-bit indices";
+		close();
+		return false;
+	}
+	vertexCount = (uint32_t)totalVertices;
+	indexCount = (uint32_t)totalIndices;
+
+	// A single primitive whose streams already match the upload layout is used in place.
+	if (primitives.size() == 1)
+	{
+		const Primitive& primitive = primitives[0];
+		if (primitive.hasIndices && primitive.index.componentType == 5125 && primitive.index.stride == 4 && ((uintptr_t)primitive.index.data & 3) == 0)
+		{
+			indices = (const uint32_t*)primitive.index.data;
+		}
+
+		static_assert(sizeof(ModelVertex) == 32, "ModelVertex is position, texture, normal");
+		if (!leftHanded && primitive.hasNormal && primitive.hasTexCoord && primitive.texCoord.componentType == 5126
+			&& primitive.position.stride == sizeof(ModelVertex) && primitive.normal.viewIndex == primitive.position.viewIndex
+			&& primitive.texCoord.viewIndex == primitive.position.viewIndex
+			&& primitive.texCoord.data == primitive.position.data + 12 && primitive.normal.data == primitive.position.data + 20
+			&& ((uintptr_t)primitive.position.data & 3) == 0)
+		{
+			vertices = (const ModelVertex*)primitive.position.data;
+		}
+	}
+
+	// Otherwise convert in one pass per stream. Missing texture coordinates are zero, missing normals are generated.
+	float zSign = leftHanded ? -1.0f : 1.0f;
+	if (!vertices)
+	{
+		vertexStorage.resize(vertexCount);
+	}
+	if (!indices)
+	{
+		indexStorage.resize(indexCount);
+	}
+	submeshes.resize(primitives.size());
+
+	uint32_t vertexBase = 0, indexBase = 0;
+	for (size_t p = 0; p < primitives.size(); p++)
+	{
+		const Primitive& primitive = primitives[p];
+		uint32_t primitiveIndices = primitive.hasIndices ? primitive.index.count : primitive.position.count;
+
+		if (!indices)
+		{
+			uint32_t* out = indexStorage.data() + indexBase;
+			for (uint32_t i = 0; i < primitiveIndices; i++)
+			{
+				out[i] = vertexBase + (primitive.hasIndices ? readIndex(primitive.index, i) : i);
+			}
+		}
+
+		if (!vertices)
+		{
+			ModelVertex* out = vertexStorage.data() + vertexBase;
+			for (uint32_t i = 0; i < primitive.position.count; i++)
+			{
+				ModelVertex& vertex = out[i];
+				memcpy(vertex.position, primitive.position.data + (size_t)i * primitive.position.stride, sizeof(vertex.position));
+				if (primitive.hasTexCoord)
+				{
+					const unsigned char* uv = primitive.texCoord.data + (size_t)i * primitive.texCoord.stride;
+					int componentSize = getComponentSize(primitive.texCoord.componentType);
+					vertex.texture[0] = readComponent(uv, primitive.texCoord.componentType, true);
+					vertex.texture[1] = readComponent(uv + componentSize, primitive.texCoord.componentType, true);
+				}
+				else
+				{
+					vertex.texture[0] = vertex.texture[1] = 0.0f;
+				}
+				if (primitive.hasNormal)
+				{
+					memcpy(vertex.normal, primitive.normal.data + (size_t)i * primitive.normal.stride, sizeof(vertex.normal));
+				}
+				else
+				{
+					vertex.normal[0] = vertex.normal[1] = vertex.normal[2] = 0.0f;
+				}
+			}
+
+			// Area-weighted face normals, summed per vertex. Done before the mirror, as a mirror also flips cross products.
+			if (!primitive.hasNormal)
+			{
+				for (uint32_t i = 0; i + 2 < primitiveIndices; i += 3)
+				{
+					uint32_t a = primitive.hasIndices ? readIndex(primitive.index, i) : i;
+					uint32_t b = primitive.hasIndices ? readIndex(primitive.index, i + 1) : i + 1;
+					uint32_t c = primitive.hasIndices ? readIndex(primitive.index, i + 2) : i + 2;
+					const float* pa = out[a].position;
+					const float* pb = out[b].position;
+					const float* pc = out[c].position;
+					float e1[3] = { pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2] };
+					float e2[3] = { pc[0] - pa[0], pc[1] - pa[1], pc[2] - pa[2] };
+					float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+					for (uint32_t corner : { a, b, c })
+					{
+						out[corner].normal[0] += n[0];
+						out[corner].normal[1] += n[1];
+						out[corner].normal[2] += n[2];
+					}
+				}
+				for (uint32_t i = 0; i < primitive.position.count; i++)
+				{
+					float* n = out[i].normal;
+					float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+					if (length > 0.0f)
+					{
+						n[0] /= length;
+						n[1] /= length;
+						n[2] /= length;
+					}
+					else
+					{
+						n[1] = 1.0f;
+					}
+				}
+			}
+
+			for (uint32_t i = 0; i < primitive.position.count; i++)
+			{
+				out[i].position[2] *= zSign;
+				out[i].normal[2] *= zSign;
+			}
+		}
+
+		MeshCacheSubmesh& submesh = submeshes[p];
+		submesh = {};
+		submesh.indexStart = indexBase;
+		submesh.indexCount = primitiveIndices;
+		submesh.materialIndex = primitive.materialIndex;
+		const ModelVertex* source = vertices ? vertices : vertexStorage.data();
+		for (int axis = 0; axis < 3; axis++)
+		{
+			submesh.boundsMin[axis] = (primitive.position.count > 0) ? FLT_MAX : 0.0f;
+			submesh.boundsMax[axis] = (primitive.position.count > 0) ? -FLT_MAX : 0.0f;
+		}
+		for (uint32_t i = 0; i < primitive.position.count; i++)
+		{
+			for (int axis = 0; axis < 3; axis++)
+			{
+				submesh.boundsMin[axis] = std::min(submesh.boundsMin[axis], source[vertexBase + i].position[axis]);
+				submesh.boundsMax[axis] = std::max(submesh.boundsMax[axis], source[vertexBase + i].position[axis]);
+			}
+		}
+
+		vertexBase += primitive.position.count;
+		indexBase += primitiveIndices;
+	}
+
+	if (!vertices)
+	{
+		vertices = vertexStorage.data();
+	}
+	if (!indices)
+	{
+		indices = indexStorage.data();
+	}
+	return true;
+}
+
+void GlbFile::close()
+{
+	file.close();
+	std::vector<ModelVertex>().swap(vertexStorage);
+	std::vector<uint32_t>().swap(indexStorage);
+	vertices = nullptr;
+	indices = nullptr;
+	vertexCount = 0;
+	indexCount = 0;
+	submeshes.clear();
+}
+
+void GlbFile::copyTo(ModelArrays& arrays) const
+{
+	arrays.vertices.assign(vertices, vertices + vertexCount);
+	arrays.indices.assign(indices, indices + indexCount);
+	arrays.submeshes = submeshes;
+}
@@ -0,0 +1,186 @@
+// Height tile file
+// Writes and maps tiled 16-bit heightmap pyramids.
+#include "HeightTileFile.h"
+#include "HeightmapCache.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+static const char heightTileMagic[4] = { 'H', 'T', 'P', 'F' };
+
+// Keep every second sample. An odd last sample is always kept so the far edge survives.
+static std::vector<uint16_t> downsampleLevel(const std::vector<uint16_t>& samples, int width, int height, int& outWidth, int& outHeight)
+{
+	outWidth = (width - 1) / 2 + 1 + ((width - 1) % 2);
+	outHeight = (height - 1) / 2 + 1 + ((height - 1) % 2);
+
+	std::vector<uint16_t> result((size_t)outWidth * outHeight);
+	for (int j = 0; j < outHeight; j++)
+	{
+		int sj = std::min(j * 2, height - 1);
+		for (int i = 0; i < outWidth; i++)
+		{
+			int si = std::min(i * 2, width - 1);
+			result[(size_t)j * outWidth + i] = samples[(size_t)sj * width + si];
+		}
+	}
+	return result;
+}
+
+static int getTileCount(int samples, int tileSize)
+{
+	return std::max(1, (samples - 1 + tileSize - 1) / tileSize);
+}
+
+bool writeHeightTilePyramid(const Heightmap& source, const std::string& filename, int tileSize)
+{
+	if (source.width < 2 || source.height < 2 || tileSize < 1)
+	{
+		return false;
+	}
+
+	// Build every level in memory first, so the directory can be written up front.
+	std::vector<std::vector<uint16_t>> levelSamples;
+	std::vector<HeightTileLevel> levels;
+
+	std::vector<uint16_t> samples(source.samples.size());
+	for (size_t i = 0; i < samples.size(); i++)
+	{
+		float value = std::min(std::max(source.samples[i], 0.0f), 1.0f);
+		samples[i] = (uint16_t)(value * 65535.0f + 0.5f);
+	}
+
+	int width = source.width;
+	int height = source.height;
+	while (true)
+	{
+		HeightTileLevel level;
+		level.width = (uint32_t)width;
+		level.height = (uint32_t)height;
+		level.tilesX = (uint32_t)getTileCount(width, tileSize);
+		level.tilesY = (uint32_t)getTileCount(height, tileSize);
+		level.offset = 0;
+		levels.push_back(level);
+		levelSamples.push_back(samples);
+
+		if (level.tilesX == 1 && level.tilesY == 1)
+		{
+			break;
+		}
+		samples = downsampleLevel(levelSamples.back(), width, height, width, height);
+	}
+
+	HeightTileHeader header;
+	memcpy(header.magic, heightTileMagic, sizeof(header.magic));
+	header.version = heightTileVersion;
+	header.width = (uint32_t)source.width;
+	header.height = (uint32_t)source.height;
+	header.tileSize = (uint32_t)tileSize;
+	header.levelCount = (uint32_t)levels.size();
+
+	int tileSamples = tileSize + 1;
+	uint64_t tileBytes = (uint64_t)tileSamples * tileSamples * sizeof(uint16_t);
+	uint64_t offset = sizeof(HeightTileHeader) + levels.size() * sizeof(HeightTileLevel);
+	for (HeightTileLevel& level : levels)
+	{
+		level.offset = offset;
+		offset += (uint64_t)level.tilesX * level.tilesY * tileBytes;
+	}
+
+	std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+	if (!out)
+	{
+		return false;
+	}
+	out.write((const char*)&header, sizeof(header));
+	out.write((const char*)levels.data(), levels.size() * sizeof(HeightTileLevel));
+
+	std::vector<uint16_t> tile((size_t)tileSamples * tileSamples);
+	for (size_t l = 0; l < levels.size(); l++)
+	{
+		const HeightTileLevel& level = levels[l];
+		const std::vector<uint16_t>& src = levelSamples[l];
+		for (uint32_t ty = 0; ty < level.tilesY; ty++)
+		{
+			for (uint32_t tx = 0; tx < level.tilesX; tx++)
+			{
+				for (int j = 0; j < tileSamples; j++)
+				{
+					int sj = std::min((int)(ty * tileSize) + j, (int)level.height - 1);
+					for (int i = 0; i < tileSamples; i++)
+					{
+						int si = std::min((int)(tx * tileSize) + i, (int)level.width - 1);
+						tile[(size_t)j * tileSamples + i] = src[(size_t)sj * level.width + si];
+					}
+				}
+				out.write((const char*)tile.data(), tile.size() * sizeof(uint16_t));
+			}
+		}
+	}
+	return out.good();
+}
+
+bool HeightTileFile::open(const std::string& filename)
+{
+	close();
+	if (!file.open(filename) || file.getSize() < sizeof(HeightTileHeader))
+	{
+		close();
+		return false;
+	}
+
+	const HeightTileHeader* candidate = (const HeightTileHeader*)file.getData();
+	if (memcmp(candidate->magic, heightTileMagic, sizeof(heightTileMagic)) != 0 || candidate->version != heightTileVersion
+		|| candidate->tileSize == 0 || candidate->levelCount == 0)
+	{
+		close();
+		return false;
+	}
+
+	// Reject directories or tiles that run past the end of the file.
+	size_t directoryEnd = sizeof(HeightTileHeader) + (size_t)candidate->levelCount * sizeof(HeightTileLevel);
+	if (directoryEnd > file.getSize())
+	{
+		close();
+		return false;
+	}
+	const HeightTileLevel* candidateLevels = (const HeightTileLevel*)(file.getData() + sizeof(HeightTileHeader));
+	uint64_t tileBytes = (uint64_t)(candidate->tileSize + 1) * (candidate->tileSize + 1) * sizeof(uint16_t);
+	for (uint32_t l = 0; l < candidate->levelCount; l++)
+	{
+		const HeightTileLevel& level = candidateLevels[l];
+		uint64_t end = level.offset + (uint64_t)level.tilesX * level.tilesY * tileBytes;
+		if (level.offset < directoryEnd || end > file.getSize())
+		{
+			close();
+			return false;
+		}
+	}
+
+	header = candidate;
+	levels = candidateLevels;
+	return true;
+}
+
+void HeightTileFile::close()
+{
+	file.close();
+	header = nullptr;
+	levels = nullptr;
+}
+
+const uint16_t* HeightTileFile::getTileData(int level, int tileX, int tileY) const
+{
+	if (!header || level < 0 || level >= (int)header->levelCount)
+	{
+		return nullptr;
+	}
+	const HeightTileLevel& info = levels[level];
+	if (tileX < 0 || tileY < 0 || tileX >= (int)info.tilesX || tileY >= (int)info.tilesY)
+	{
+		return nullptr;
+	}
+	size_t tileIndex = (size_t)tileY * info.tilesX + tileX;
+	return (const uint16_t*)(file.getData() + info.offset + tileIndex * getTileBytes());
+}
@@ -0,0 +1,80 @@
+/**
+* \class Height Tile File
+*
+* \brief Tiled heightmap pyramid stored as 16-bit samples in a single memory-mapped file
+*
+* The file holds a header, one directory entry per pyramid level and then every tile of every level.
+* Level 0 is the full resolution heightmap. Each further level keeps every second sample of the one below,
+* so its samples line up with the vertices of a chunk mesh at twice the spacing.
+* A tile stores (tileSize + 1) samples along each side and shares its last row and column with the next tile,
+* so any tile can be meshed or interpolated on its own. Tiles past the heightmap edge repeat the edge sample.
+* Holds no Direct3D types.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _HEIGHTTILEFILE_H_
+#define _HEIGHTTILEFILE_H_
+
+#include "MappedFile.h"
+#include <cstdint>
+#include <string>
+
+struct Heightmap;
+
+/// File header. All fields are little-endian.
+struct HeightTileHeader
+{
+	char magic[4];			///< "HTPF"
+	uint32_t version;
+	uint32_t width;			///< Level 0 samples along X
+	uint32_t height;		///< Level 0 samples along Z
+	uint32_t tileSize;		///< Cells along each side of a tile
+	uint32_t levelCount;
+};
+
+/// One directory entry per pyramid level, directly after the header.
+struct HeightTileLevel
+{
+	uint32_t width;			///< Samples along X at this level
+	uint32_t height;		///< Samples along Z at this level
+	uint32_t tilesX;
+	uint32_t tilesY;
+	uint64_t offset;		///< Byte offset of the level's first tile. Tiles are stored row-major
+};
+
+static const uint32_t heightTileVersion = 1;
+
+/** \brief Converts a decoded heightmap into a tiled pyramid file
+* Samples are quantised from 0-1 to the full 16-bit range. Levels are added until one tile covers the whole map.
+* @param tileSize is the number of cells along each side of a tile
+* @return false if the file could not be written
+*/
+bool writeHeightTilePyramid(const Heightmap& source, const std::string& filename, int tileSize = 256);
+
+class HeightTileFile
+{
+public:
+	/// Maps a pyramid file and validates its header and directory.
+	bool open(const std::string& filename);
+	void close();
+
+	bool isOpen() const { return header != nullptr; }
+	int getWidth() const { return (int)header->width; }
+	int getHeight() const { return (int)header->height; }
+	int getTileSize() const { return (int)header->tileSize; }
+	int getTileSamples() const { return (int)header->tileSize + 1; }
+	size_t getTileBytes() const { return (size_t)getTileSamples() * getTileSamples() * sizeof(uint16_t); }
+	int getLevelCount() const { return (int)header->levelCount; }
+	const HeightTileLevel& getLevel(int level) const { return levels[level]; }
+
+	/// Returns the mapped samples of a tile, row-major, or nullptr if the tile does not exist. Touching them pages them in.
+	const uint16_t* getTileData(int level, int tileX, int tileY) const;
+
+private:
+	MappedFile file;
+	const HeightTileHeader* header = nullptr;
+	const HeightTileLevel* levels = nullptr;
+};
+
+#endif
@@ -0,0 +1,264 @@
+// Height tile streamer
+// Background paging of pyramid tiles around the camera.
+#include "HeightTileStreamer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+HeightTileStreamer::HeightTileStreamer()
+{
+	memoryBudget = 0;
+	updateCount = 0;
+	running = false;
+}
+
+HeightTileStreamer::~HeightTileStreamer()
+{
+	close();
+}
+
+bool HeightTileStreamer::open(const std::string& filename, size_t budget)
+{
+	close();
+	if (!file.open(filename))
+	{
+		return false;
+	}
+
+	memoryBudget = budget;
+	updateCount = 0;
+	running = true;
+	loader = std::thread(&HeightTileStreamer::loadLoop, this);
+	return true;
+}
+
+void HeightTileStreamer::close()
+{
+	{
+		std::lock_guard<std::mutex> lock(residentMutex);
+		running = false;
+		requests.clear();
+	}
+	requestReady.notify_all();
+	if (loader.joinable())
+	{
+		loader.join();
+	}
+
+	resident.clear();
+	file.close();
+}
+
+uint64_t HeightTileStreamer::makeKey(int level, int tileX, int tileY)
+{
+	return ((uint64_t)level << 48) | ((uint64_t)(uint32_t)tileY << 24) | (uint64_t)(uint32_t)tileX;
+}
+
+void HeightTileStreamer::update(float x, float z, int ringRadius)
+{
+	if (!file.isOpen())
+	{
+		return;
+	}
+
+	int tileSize = file.getTileSize();
+	ringRadius = std::max(ringRadius, 0);
+
+	std::lock_guard<std::mutex> lock(residentMutex);
+	updateCount++;
+	requests.clear();
+
+	// Coarsest level first, nearest tiles first within a level.
+	struct Wanted { uint64_t key; int distance; };
+	std::vector<Wanted> wanted;
+	for (int level = file.getLevelCount() - 1; level >= 0; level--)
+	{
+		const HeightTileLevel& info = file.getLevel(level);
+		float levelScale = 1.0f / (float)(1 << level);
+		int centreX = (int)floorf(x * levelScale / tileSize);
+		int centreY = (int)floorf(z * levelScale / tileSize);
+		centreX = std::min(std::max(centreX, 0), (int)info.tilesX - 1);
+		centreY = std::min(std::max(centreY, 0), (int)info.tilesY - 1);
+
+		wanted.clear();
+		for (int ty = std::max(centreY - ringRadius, 0); ty <= std::min(centreY + ringRadius, (int)info.tilesY - 1); ty++)
+		{
+			for (int tx = std::max(centreX - ringRadius, 0); tx <= std::min(centreX + ringRadius, (int)info.tilesX - 1); tx++)
+			{
+				wanted.push_back({ makeKey(level, tx, ty), std::max(abs(tx - centreX), abs(ty - centreY)) });
+			}
+		}
+		std::stable_sort(wanted.begin(), wanted.end(), [](const Wanted& a, const Wanted& b) { return a.distance < b.distance; });
+
+		for (const Wanted& w : wanted)
+		{
+			auto found = resident.find(w.key);
+			if (found != resident.end())
+			{
+				found->second.lastWanted = updateCount;
+			}
+			else
+			{
+				requests.push_back(w.key);
+			}
+		}
+	}
+
+	if (!requests.empty())
+	{
+		requestReady.notify_one();
+	}
+}
+
+// Evict the least recently wanted tile that the last update did not ask for. Called with the lock held.
+bool HeightTileStreamer::makeRoom()
+{
+	size_t tileBytes = file.getTileBytes();
+	while ((resident.size() + 1) * tileBytes > memoryBudget)
+	{
+		auto victim = resident.end();
+		for (auto it = resident.begin(); it != resident.end(); ++it)
+		{
+			if (it->second.lastWanted != updateCount && (victim == resident.end() || it->second.lastWanted < victim->second.lastWanted))
+			{
+				victim = it;
+			}
+		}
+		if (victim == resident.end())
+		{
+			// Everything resident is still wanted. The budget is too small for the whole request.
+			return false;
+		}
+		resident.erase(victim);
+	}
+	return true;
+}
+
+void HeightTileStreamer::loadLoop()
+{
+	std::unique_lock<std::mutex> lock(residentMutex);
+	while (true)
+	{
+		requestReady.wait(lock, [this] { return !running || !requests.empty(); });
+		if (!running)
+		{
+			break;
+		}
+
+		uint64_t key = requests.front();
+		requests.pop_front();
+		if (resident.count(key))
+		{
+			continue;
+		}
+		if (!makeRoom())
+		{
+			// Later requests are finer or further away, so they would not fit either.
+			requests.clear();
+			continue;
+		}
+		unsigned int requestedIn = updateCount;
+
+		// Copy out of the mapping without holding the lock. This is where the page faults happen.
+		lock.unlock();
+		std::shared_ptr<HeightTile> tile = std::make_shared<HeightTile>();
+		tile->level = (int)(key >> 48);
+		tile->tileY = (int)((key >> 24) & 0xFFFFFF);
+		tile->tileX = (int)(key & 0xFFFFFF);
+		const uint16_t* source = file.getTileData(tile->level, tile->tileX, tile->tileY);
+		if (source)
+		{
+			tile->samples.resize(file.getTileBytes() / sizeof(uint16_t));
+			memcpy(tile->samples.data(), source, file.getTileBytes());
+		}
+		lock.lock();
+
+		if (!source || !running)
+		{
+			continue;
+		}
+		// Another update may have filled the space while the lock was released.
+		if (!makeRoom())
+		{
+			continue;
+		}
+		Resident entry;
+		entry.tile = tile;
+		entry.lastWanted = requestedIn;
+		resident[key] = entry;
+	}
+}
+
+std::shared_ptr<const HeightTile> HeightTileStreamer::getTile(int level, int tileX, int tileY) const
+{
+	std::lock_guard<std::mutex> lock(residentMutex);
+	auto found = resident.find(makeKey(level, tileX, tileY));
+	if (found == resident.end())
+	{
+		return nullptr;
+	}
+	return found->second.tile;
+}
+
+bool HeightTileStreamer::sampleHeight(float x, float z, float& height, int* foundLevel) const
+{
+	if (!file.isOpen())
+	{
+		return false;
+	}
+
+	int tileSize = file.getTileSize();
+	int tileSamples = file.getTileSamples();
+	for (int level = 0; level < file.getLevelCount(); level++)
+	{
+		const HeightTileLevel& info = file.getLevel(level);
+		float levelScale = 1.0f / (float)(1 << level);
+		float lx = std::min(std::max(x * levelScale, 0.0f), (float)(info.width - 1));
+		float lz = std::min(std::max(z * levelScale, 0.0f), (float)(info.height - 1));
+		int tileX = std::min((int)(lx / tileSize), (int)info.tilesX - 1);
+		int tileY = std::min((int)(lz / tileSize), (int)info.tilesY - 1);
+
+		std::shared_ptr<const HeightTile> tile = getTile(level, tileX, tileY);
+		if (!tile)
+		{
+			continue;
+		}
+
+		// Tiles carry their shared far edge, so the bilinear footprint never leaves the tile.
+		float fx = lx - tileX * tileSize;
+		float fz = lz - tileY * tileSize;
+		int i = std::min((int)fx, tileSize - 1);
+		int j = std::min((int)fz, tileSize - 1);
+		float tx = fx - i;
+		float tz = fz - j;
+		const uint16_t* row0 = tile->samples.data() + (size_t)j * tileSamples;
+		const uint16_t* row1 = row0 + tileSamples;
+		float bottom = row0[i] + (row0[i + 1] - row0[i]) * tx;
+		float top = row1[i] + (row1[i + 1] - row1[i]) * tx;
+		height = (bottom + (top - bottom) * tz) / 65535.0f;
+		if (foundLevel)
+		{
+			*foundLevel = level;
+		}
+		return true;
+	}
+	return false;
+}
+
+size_t HeightTileStreamer::getResidentBytes() const
+{
+	std::lock_guard<std::mutex> lock(residentMutex);
+	return file.isOpen() ? resident.size() * file.getTileBytes() : 0;
+}
+
+int HeightTileStreamer::getResidentTileCount() const
+{
+	std::lock_guard<std::mutex> lock(residentMutex);
+	return (int)resident.size();
+}
+
+int HeightTileStreamer::getPendingTileCount() const
+{
+	std::lock_guard<std::mutex> lock(residentMutex);
+	return (int)requests.size();
+}
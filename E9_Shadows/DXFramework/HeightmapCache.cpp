@@ -0,0 +1,91 @@
+// Heightmap cache
+// Decodes each heightmap image once, keyed by path and shared by contents.
+#include "HeightmapCache.h"
+#include "MappedFile.h"
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+std::mutex HeightmapCache::cacheMutex;
+std::map<std::string, std::shared_ptr<const Heightmap>> HeightmapCache::cache;
+ContentCache<const Heightmap> HeightmapCache::contents;
+
+HeightfieldView Heightmap::getView(float scale) const
+{
+	HeightfieldView view;
+	view.samples = samples.data();
+	view.width = width;
+	view.height = height;
+	view.scale = scale;
+	return view;
+}
+
+std::shared_ptr<const Heightmap> HeightmapCache::load(const std::string& filename)
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+
+	auto found = cache.find(filename);
+	if (found != cache.end())
+	{
+		return found->second;
+	}
+
+	MappedFile file;
+	if (!file.open(filename))
+	{
+		return nullptr;
+	}
+
+	// Another path with the same bytes may already be decoded.
+	ContentKey key;
+	key.hash = hashContent(file.getData(), file.getSize());
+	key.size = file.getSize();
+	std::shared_ptr<const Heightmap> heightmap = contents.find(key);
+	if (!heightmap)
+	{
+		heightmap = decode(file.getData(), file.getSize());
+		if (heightmap)
+		{
+			heightmap = contents.insert(key, heightmap);
+		}
+	}
+	if (heightmap)
+	{
+		cache.insert(std::make_pair(filename, heightmap));
+	}
+	return heightmap;
+}
+
+void HeightmapCache::release(const std::string& filename)
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	cache.erase(filename);
+}
+
+void HeightmapCache::clear()
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	cache.clear();
+}
+
+// Read the image as a single 8-bit channel and normalise to 0-1.
+std::shared_ptr<const Heightmap> HeightmapCache::decode(const unsigned char* data, size_t size)
+{
+	int width = 0, height = 0, channels = 0;
+	unsigned char* imageData = (size <= INT32_MAX) ? stbi_load_from_memory(data, (int)size, &width, &height, &channels, 1) : nullptr;
+	if (!imageData)
+	{
+		return nullptr;
+	}
+
+	std::shared_ptr<Heightmap> heightmap = std::make_shared<Heightmap>();
+	heightmap->width = width;
+	heightmap->height = height;
+	heightmap->samples.resize((size_t)width * height);
+	for (size_t i = 0; i < heightmap->samples.size(); ++i)
+	{
+		heightmap->samples[i] = imageData[i] / 255.0f;
+	}
+
+	stbi_image_free(imageData);
+	return heightmap;
+}
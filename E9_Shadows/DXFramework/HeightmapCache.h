@@ -0,0 +1,59 @@
+/**
+* \class Heightmap Cache
+*
+* \brief Decodes heightmap images once and shares the result between meshes
+*
+* Heightmaps are keyed by file path. Repeat loads of the same path return the already decoded samples,
+* so rebuilding or duplicating terrain never touches the image decoder again. A new path is hashed first, and a
+* file with the same contents as a heightmap still in use shares it instead of being decoded again.
+* Holds no Direct3D types.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _HEIGHTMAPCACHE_H_
+#define _HEIGHTMAPCACHE_H_
+
+#include "ContentCache.h"
+#include "TerrainGrid.h"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// Decoded greyscale heightmap, samples normalised to 0-1.
+struct Heightmap
+{
+	int width = 0;
+	int height = 0;
+	std::vector<float> samples;
+
+	/// Returns a view over the samples with the given height scale.
+	HeightfieldView getView(float scale = 1.0f) const;
+};
+
+class HeightmapCache
+{
+public:
+	/** \brief Returns the decoded heightmap for a file, decoding it on first request
+	* @param filename is the path to an image file stb_image can read
+	* @return shared heightmap, or nullptr if the file could not be decoded
+	*/
+	static std::shared_ptr<const Heightmap> load(const std::string& filename);
+
+	/// Drops a cached heightmap. Meshes still holding it keep their copy alive.
+	static void release(const std::string& filename);
+
+	/// Drops every cached heightmap.
+	static void clear();
+
+private:
+	static std::shared_ptr<const Heightmap> decode(const unsigned char* data, size_t size);
+
+	static std::mutex cacheMutex;
+	static std::map<std::string, std::shared_ptr<const Heightmap>> cache;
+	static ContentCache<const Heightmap> contents;
+};
+
+#endif
@@ -0,0 +1,269 @@
+// LZ4 block
+// Greedy LZ4 block compressor and bounds-checked decompressor.
+#include "Lz4Block.h"
+#include <cstdint>
+#include <cstring>
+
+static const size_t minMatch = 4;
+static const size_t lastLiterals = 5;		///< The block always ends with at least this many literals
+static const size_t matchStartLimit = 12;	///< And no match starts within this many bytes of the end
+static const size_t maxOffset = 65535;
+static const int hashBits = 12;			///< 16 KB table, which stays in L1 cache like the reference's
+
+static inline uint32_t read32(const unsigned char* p)
+{
+	uint32_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+static inline uint64_t read64(const unsigned char* p)
+{
+	uint64_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+static inline uint32_t hashSequence(uint32_t sequence)
+{
+	return (sequence * 2654435761u) >> (32 - hashBits);
+}
+
+// Lengths of 15 or more continue in bytes of 255 and a remainder.
+static inline unsigned char* writeLength(unsigned char* op, size_t length)
+{
+	for (; length >= 255; length -= 255)
+	{
+		*op++ = 255;
+	}
+	*op++ = (unsigned char)length;
+	return op;
+}
+
+static inline bool readLength(const unsigned char*& ip, const unsigned char* end, size_t& length)
+{
+	unsigned char next;
+	do
+	{
+		if (ip >= end)
+		{
+			return false;
+		}
+		next = *ip++;
+		length += next;
+	} while (next == 255);
+	return true;
+}
+
+size_t getLz4Bound(size_t size)
+{
+	return size + size / 255 + 16;
+}
+
+// One sequence: literals from anchor up to ip, then a match. Returns nullptr if it does not fit.
+static unsigned char* writeSequence(unsigned char* op, unsigned char* end, const unsigned char* anchor, size_t literals, size_t offset, size_t matchLength)
+{
+	if ((size_t)(end - op) < 1 + literals / 255 + 1 + literals + 2 + matchLength / 255 + 1)
+	{
+		return nullptr;
+	}
+
+	unsigned char* token = op++;
+	*token = (unsigned char)((literals < 15 ? literals : 15) << 4);
+	if (literals >= 15)
+	{
+		op = writeLength(op, literals - 15);
+	}
+	if (literals > 0)
+	{
+		memcpy(op, anchor, literals);
+	}
+	op += literals;
+
+	if (offset > 0)
+	{
+		*op++ = (unsigned char)(offset & 255);
+		*op++ = (unsigned char)(offset >> 8);
+		size_t length = matchLength - minMatch;
+		*token |= (unsigned char)(length < 15 ? length : 15);
+		if (length >= 15)
+		{
+			op = writeLength(op, length - 15);
+		}
+	}
+	return op;
+}
+
+size_t compressLz4(const unsigned char* source, size_t size, unsigned char* destination, size_t capacity)
+{
+	const unsigned char* end = source + size;
+	const unsigned char* anchor = source;
+	unsigned char* op = destination;
+	unsigned char* opEnd = destination + capacity;
+
+	if (size > matchStartLimit && size <= UINT32_MAX)
+	{
+		uint32_t table[1 << hashBits] = {};
+		const unsigned char* matchEnd = end - lastLiterals;
+		const unsigned char* startLimit = end - matchStartLimit;
+		const unsigned char* ip = source + 1;
+
+		while (ip <= startLimit)
+		{
+			// Look for a match, skipping ahead faster the longer the search goes without one.
+			const unsigned char* match;
+			size_t misses = 1 << 6;
+			for (;;)
+			{
+				uint32_t hash = hashSequence(read32(ip));
+				match = source + table[hash];
+				table[hash] = (uint32_t)(ip - source);
+				if (match < ip && (size_t)(ip - match) <= maxOffset && read32(match) == read32(ip))
+				{
+					break;
+				}
+				ip += misses++ >> 6;
+				if (ip > startLimit)
+				{
+					goto finish;
+				}
+			}
+
+			while (ip > anchor && match > source && ip[-1] == match[-1])
+			{
+				ip--;
+				match--;
+			}
+
+			size_t length = minMatch;
+			while (ip + length + 8 <= matchEnd && read64(ip + length) == read64(match + length))
+			{
+				length += 8;
+			}
+			while (ip + length < matchEnd && ip[length] == match[length])
+			{
+				length++;
+			}
+
+			op = writeSequence(op, opEnd, anchor, (size_t)(ip - anchor), (size_t)(ip - match), length);
+			if (!op)
+			{
+				return 0;
+			}
+			ip += length;
+			anchor = ip;
+
+			// Index a position inside the match too, so the next search has more to go on.
+			if (ip <= startLimit)
+			{
+				table[hashSequence(read32(ip - 2))] = (uint32_t)(ip - 2 - source);
+			}
+		}
+	}
+
+finish:
+	op = writeSequence(op, opEnd, anchor, (size_t)(end - anchor), 0, 0);
+	if (!op || (size_t)(op - destination) >= size)
+	{
+		return 0;
+	}
+	return (size_t)(op - destination);
+}
+
+bool decompressLz4(const unsigned char* source, size_t sourceSize, unsigned char* destination, size_t size)
+{
+	const unsigned char* ip = source;
+	const unsigned char* ipEnd = source + sourceSize;
+	unsigned char* op = destination;
+	unsigned char* opEnd = destination + size;
+
+	for (;;)
+	{
+		if (ip >= ipEnd)
+		{
+			return false;
+		}
+		unsigned token = *ip++;
+		size_t literals = token >> 4;
+		size_t length = token & 15;
+
+		// Most sequences are short. Away from the ends of both buffers they copy a fixed 16 literal bytes and 18
+		// match bytes, whatever their real lengths. The match goes 8 bytes at a time, as it may overlap itself.
+		if (literals < 15 && ipEnd - ip >= 18 && opEnd - op >= 32)
+		{
+			memcpy(op, ip, 16);
+			op += literals;
+			ip += literals;
+			size_t offset = ip[0] | ((size_t)ip[1] << 8);
+			if (length < 15 && offset >= 8 && offset <= (size_t)(op - destination))
+			{
+				const unsigned char* match = op - offset;
+				memcpy(op, match, 8);
+				memcpy(op + 8, match + 8, 8);
+				memcpy(op + 16, match + 16, 2);
+				op += length + minMatch;
+				ip += 2;
+				continue;
+			}
+		}
+		else
+		{
+			if (literals == 15 && !readLength(ip, ipEnd, literals))
+			{
+				return false;
+			}
+			if ((size_t)(ipEnd - ip) < literals || (size_t)(opEnd - op) < literals)
+			{
+				return false;
+			}
+			if (literals > 0)
+			{
+				memcpy(op, ip, literals);
+			}
+			op += literals;
+			ip += literals;
+
+			// The last sequence has literals only.
+			if (ip == ipEnd)
+			{
+				return op == opEnd;
+			}
+		}
+
+		if (ipEnd - ip < 2)
+		{
+			return false;
+		}
+		size_t offset = ip[0] | ((size_t)ip[1] << 8);
+		ip += 2;
+		if (length == 15 && !readLength(ip, ipEnd, length))
+		{
+			return false;
+		}
+		length += minMatch;
+		if (offset == 0 || offset > (size_t)(op - destination) || (size_t)(opEnd - op) < length)
+		{
+			return false;
+		}
+
+		// Matches may overlap what they write, repeating a short pattern. Copies of whole 8 bytes are safe once
+		// the offset is at least 8, and may run past the match where the output has room.
+		const unsigned char* match = op - offset;
+		unsigned char* copyEnd = op + length;
+		if (offset >= 8 && (size_t)(opEnd - copyEnd) >= 8)
+		{
+			for (; op < copyEnd; op += 8, match += 8)
+			{
+				memcpy(op, match, 8);
+			}
+			op = copyEnd;
+		}
+		else
+		{
+			while (op < copyEnd)
+			{
+				*op++ = *match++;
+			}
+		}
+	}
+}
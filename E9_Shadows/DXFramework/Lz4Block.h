@@ -0,0 +1,28 @@
+/**
+* \brief Platform-neutral LZ4 block compression
+*
+* Compresses and decompresses single blocks in the standard LZ4 block format, so blocks can be checked against the
+* reference lz4 tool. The compressor is the fast greedy one, with a 4K-entry hash table and the reference skip
+* heuristic, which trades ratio for speed on data that does not compress. Decompression checks every length and
+* offset against both buffers, so corrupt data fails instead of reading or writing out of bounds.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _LZ4BLOCK_H_
+#define _LZ4BLOCK_H_
+
+#include <cstddef>
+
+/// Largest compressed size of a block of size bytes.
+size_t getLz4Bound(size_t size);
+
+/** \brief Compresses one block
+* @return the compressed size, or 0 if it would not be smaller than the input or does not fit in capacity
+*/
+size_t compressLz4(const unsigned char* source, size_t size, unsigned char* destination, size_t capacity);
+
+/// Decompresses one block that expands to exactly size bytes. Returns false if the data is corrupt.
+bool decompressLz4(const unsigned char* source, size_t sourceSize, unsigned char* destination, size_t size);
+
+#endif
@@ -0,0 +1,167 @@
+// Mapped file
+// Read-only file mapping for Windows and POSIX.
+#include "MappedFile.h"
+#include "AssetPack.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+{
+	data = nullptr;
+	size = 0;
+	opened = false;
+#ifdef _WIN32
+	fileHandle = INVALID_HANDLE_VALUE;
+	mappingHandle = nullptr;
+#else
+	fileDescriptor = -1;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const std::string& filename)
+{
+	close();
+	if (openPackedFile(filename, data, size, packedData))
+	{
+		opened = true;
+		return true;
+	}
+	return openOnDisk(filename);
+}
+
+#ifdef _WIN32
+bool MappedFile::open(const wchar_t* filename)
+{
+	int length = WideCharToMultiByte(CP_ACP, 0, filename, -1, nullptr, 0, nullptr, nullptr);
+	if (length <= 0)
+	{
+		close();
+		return false;
+	}
+	std::string narrow((size_t)length, '\0');
+	WideCharToMultiByte(CP_ACP, 0, filename, -1, &narrow[0], length, nullptr, nullptr);
+	narrow.resize((size_t)length - 1);
+	return open(narrow);
+}
+#endif
+
+bool MappedFile::openOnDisk(const std::string& filename)
+{
+	close();
+
+#ifdef _WIN32
+	fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize))
+	{
+		close();
+		return false;
+	}
+	size = (size_t)fileSize.QuadPart;
+	opened = true;
+
+	// Zero-length files cannot be mapped, but are still valid.
+	if (size == 0)
+	{
+		return true;
+	}
+
+	mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mappingHandle)
+	{
+		close();
+		return false;
+	}
+	data = (const unsigned char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+#else
+	fileDescriptor = ::open(filename.c_str(), O_RDONLY);
+	if (fileDescriptor < 0)
+	{
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(fileDescriptor, &info) != 0)
+	{
+		close();
+		return false;
+	}
+	size = (size_t)info.st_size;
+	opened = true;
+
+	if (size == 0)
+	{
+		return true;
+	}
+
+	void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	data = (view == MAP_FAILED) ? nullptr : (const unsigned char*)view;
+#endif
+
+	if (!data)
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::close()
+{
+	// Packed files are not mapped here, only held.
+	if (packedData)
+	{
+		packedData.reset();
+		data = nullptr;
+	}
+
+#ifdef _WIN32
+	if (data)
+	{
+		UnmapViewOfFile(data);
+	}
+	if (mappingHandle)
+	{
+		CloseHandle(mappingHandle);
+		mappingHandle = nullptr;
+	}
+	if (fileHandle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(fileHandle);
+		fileHandle = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (data)
+	{
+		munmap((void*)data, size);
+	}
+	if (fileDescriptor >= 0)
+	{
+		::close(fileDescriptor);
+		fileDescriptor = -1;
+	}
+#endif
+	data = nullptr;
+	size = 0;
+	opened = false;
+}
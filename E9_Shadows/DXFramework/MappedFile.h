@@ -0,0 +1,56 @@
+/**
+* \class Mapped File
+*
+* \brief Read-only memory-mapped view of a whole file
+*
+* Lets loaders read large files in place, with the operating system paging data in on first touch.
+* Uses file mappings on Windows and mmap elsewhere, so code built on it stays platform-neutral.
+* Files in mounted asset packs (see AssetPack.h) are found before the disk, so loaders read packed files unchanged.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _MAPPEDFILE_H_
+#define _MAPPEDFILE_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	/// Maps the file, from a mounted asset pack if one holds it. Returns false if it cannot be opened. An empty file
+	/// opens with no data.
+	bool open(const std::string& filename);
+#ifdef _WIN32
+	bool open(const wchar_t* filename);		///< Converted through the ANSI code page, like narrow file APIs
+#endif
+	/// Maps the file from disk, ignoring asset packs.
+	bool openOnDisk(const std::string& filename);
+	void close();
+
+	bool isOpen() const { return opened; }
+	const unsigned char* getData() const { return data; }
+	size_t getSize() const { return size; }
+
+private:
+	const unsigned char* data;
+	size_t size;
+	bool opened;
+	std::shared_ptr<const void> packedData;	///< Keeps a packed file's bytes alive
+#ifdef _WIN32
+	void* fileHandle;
+	void* mappingHandle;
+#else
+	int fileDescriptor;
+#endif
+};
+
+#endif
@@ -0,0 +1,231 @@
+// Mesh cache
+// Writes and maps binary mesh caches, checking them against their source file.
+#include "MeshCache.h"
+#include "AssetPack.h"
+#include "ContentHash.h"
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+static const char meshCacheMagic[4] = { 'M', 'S', 'H', 'C' };
+
+// Size and modification time are cheap. The hash needs the whole file, so it is only taken when they disagree.
+static bool getSourceStamp(const std::string& filename, uint64_t& size, int64_t& time)
+{
+	// Packs keep the stamp their files had on disk, so caches built from the loose files stay current.
+	AssetPackEntry packed;
+	if (findPackedFile(filename, &packed))
+	{
+		size = packed.size;
+		time = packed.modifiedTime;
+		return true;
+	}
+
+	std::error_code error;
+	size = (uint64_t)std::filesystem::file_size(filename, error);
+	if (error)
+	{
+		return false;
+	}
+	time = (int64_t)std::filesystem::last_write_time(filename, error).time_since_epoch().count();
+	return !error;
+}
+
+static bool hashSourceFile(const std::string& filename, uint64_t& hash)
+{
+	ContentKey key;
+	if (!hashFile(filename, key))
+	{
+		return false;
+	}
+	hash = key.hash;
+	return true;
+}
+
+static uint64_t alignOffset(uint64_t offset)
+{
+	return (offset + 15) & ~(uint64_t)15;
+}
+
+bool writeMeshCache(const std::string& cacheFilename, const std::string& sourceFilename, uint32_t importFlags, const MeshCacheData& data)
+{
+	if (!data.vertices || data.vertexStride < sizeof(float) * 3 || (data.indexCount > 0 && !data.indices)
+		|| (data.submeshCount > 0 && !data.submeshes))
+	{
+		return false;
+	}
+
+	MeshCacheHeader header = {};
+	memcpy(header.magic, meshCacheMagic, sizeof(header.magic));
+	header.version = meshCacheVersion;
+	header.importFlags = importFlags;
+	header.vertexStride = data.vertexStride;
+	if (!getSourceStamp(sourceFilename, header.sourceSize, header.sourceTime) || !hashSourceFile(sourceFilename, header.sourceHash))
+	{
+		return false;
+	}
+	header.vertexCount = data.vertexCount;
+	header.indexCount = data.indexCount;
+	header.submeshCount = data.submeshCount;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		header.boundsMin[axis] = (data.vertexCount > 0) ? FLT_MAX : 0.0f;
+		header.boundsMax[axis] = (data.vertexCount > 0) ? -FLT_MAX : 0.0f;
+	}
+	const unsigned char* vertex = (const unsigned char*)data.vertices;
+	for (uint32_t i = 0; i < data.vertexCount; i++, vertex += data.vertexStride)
+	{
+		float position[3];
+		memcpy(position, vertex, sizeof(position));
+		for (int axis = 0; axis < 3; axis++)
+		{
+			header.boundsMin[axis] = std::min(header.boundsMin[axis], position[axis]);
+			header.boundsMax[axis] = std::max(header.boundsMax[axis], position[axis]);
+		}
+	}
+
+	header.submeshOffset = alignOffset(sizeof(MeshCacheHeader));
+	header.vertexOffset = alignOffset(header.submeshOffset + (uint64_t)data.submeshCount * sizeof(MeshCacheSubmesh));
+	header.indexOffset = alignOffset(header.vertexOffset + (uint64_t)data.vertexCount * data.vertexStride);
+
+	// Unique per writer, so two threads or processes building the same cache never write into one file.
+	size_t writer = std::hash<std::thread::id>()(std::this_thread::get_id());
+	std::string tempFilename = cacheFilename + "." + std::to_string(writer) + "."
+		+ std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + ".tmp";
+	{
+		std::ofstream out(tempFilename, std::ios::binary | std::ios::trunc);
+		if (!out)
+		{
+			return false;
+		}
+
+		const char zeros[16] = {};
+		auto writeAt = [&out, &zeros](uint64_t offset, const void* bytes, uint64_t size)
+		{
+			out.write(zeros, (std::streamsize)(offset - (uint64_t)out.tellp()));
+			out.write((const char*)bytes, (std::streamsize)size);
+		};
+		out.write((const char*)&header, sizeof(header));
+		writeAt(header.submeshOffset, data.submeshes, (uint64_t)data.submeshCount * sizeof(MeshCacheSubmesh));
+		writeAt(header.vertexOffset, data.vertices, (uint64_t)data.vertexCount * data.vertexStride);
+		writeAt(header.indexOffset, data.indices, (uint64_t)data.indexCount * sizeof(uint32_t));
+		if (!out.good())
+		{
+			out.close();
+			std::filesystem::remove(tempFilename);
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempFilename, cacheFilename, error);
+	return !error;
+}
+
+bool readMeshCacheBounds(const std::string& cacheFilename, float boundsMin[3], float boundsMax[3])
+{
+	MappedFile file;
+	if (!file.open(cacheFilename) || file.getSize() < sizeof(MeshCacheHeader))
+	{
+		return false;
+	}
+	const MeshCacheHeader* header = (const MeshCacheHeader*)file.getData();
+	if (memcmp(header->magic, meshCacheMagic, sizeof(meshCacheMagic)) != 0 || header->version != meshCacheVersion)
+	{
+		return false;
+	}
+	memcpy(boundsMin, header->boundsMin, sizeof(header->boundsMin));
+	memcpy(boundsMax, header->boundsMax, sizeof(header->boundsMax));
+	return true;
+}
+
+bool MeshCacheFile::open(const std::string& cacheFilename, const std::string& sourceFilename, uint32_t importFlags, uint32_t vertexStride)
+{
+	close();
+	if (!file.open(cacheFilename) || file.getSize() < sizeof(MeshCacheHeader))
+	{
+		close();
+		return false;
+	}
+
+	const MeshCacheHeader* candidate = (const MeshCacheHeader*)file.getData();
+	if (memcmp(candidate->magic, meshCacheMagic, sizeof(meshCacheMagic)) != 0 || candidate->version != meshCacheVersion
+		|| candidate->importFlags != importFlags || candidate->vertexStride != vertexStride)
+	{
+		close();
+		return false;
+	}
+
+	// Reject misaligned tables and streams, or ones that run past the end of the file.
+	// Written as count <= (size - offset) / stride so that hostile offsets and counts cannot overflow.
+	uint64_t size = file.getSize();
+	bool valid = vertexStride > 0 && candidate->submeshOffset >= sizeof(MeshCacheHeader)
+		&& candidate->submeshOffset % alignof(MeshCacheSubmesh) == 0 && candidate->vertexOffset % alignof(float) == 0
+		&& candidate->indexOffset % alignof(uint32_t) == 0
+		&& candidate->submeshOffset <= size && candidate->submeshCount <= (size - candidate->submeshOffset) / sizeof(MeshCacheSubmesh)
+		&& candidate->vertexOffset <= size && candidate->vertexCount <= (size - candidate->vertexOffset) / vertexStride
+		&& candidate->indexOffset <= size && candidate->indexCount <= (size - candidate->indexOffset) / sizeof(uint32_t);
+	if (!valid)
+	{
+		close();
+		return false;
+	}
+
+	// Every submesh must draw from inside the index stream.
+	const MeshCacheSubmesh* submeshes = (const MeshCacheSubmesh*)(file.getData() + candidate->submeshOffset);
+	for (uint32_t i = 0; i < candidate->submeshCount; i++)
+	{
+		if (submeshes[i].indexStart > candidate->indexCount || submeshes[i].indexCount > candidate->indexCount - submeshes[i].indexStart)
+		{
+			close();
+			return false;
+		}
+	}
+
+	uint64_t sourceSize;
+	int64_t sourceTime;
+	if (!getSourceStamp(sourceFilename, sourceSize, sourceTime) || sourceSize != candidate->sourceSize)
+	{
+		close();
+		return false;
+	}
+	if (sourceTime != candidate->sourceTime)
+	{
+		uint64_t sourceHash;
+		if (!hashSourceFile(sourceFilename, sourceHash) || sourceHash != candidate->sourceHash)
+		{
+			close();
+			return false;
+		}
+	}
+
+	header = candidate;
+	return true;
+}
+
+void MeshCacheFile::close()
+{
+	file.close();
+	header = nullptr;
+}
+
+const void* MeshCacheFile::getVertexData() const
+{
+	return header ? file.getData() + header->vertexOffset : nullptr;
+}
+
+const uint32_t* MeshCacheFile::getIndexData() const
+{
+	return header ? (const uint32_t*)(file.getData() + header->indexOffset) : nullptr;
+}
+
+const MeshCacheSubmesh* MeshCacheFile::getSubmeshes() const
+{
+	return header ? (const MeshCacheSubmesh*)(file.getData() + header->submeshOffset) : nullptr;
+}
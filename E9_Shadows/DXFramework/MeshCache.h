@@ -0,0 +1,102 @@
+/**
+* \class Mesh Cache File
+*
+* \brief Versioned binary container holding final vertex and index streams, memory-mapped for zero-parse loading
+*
+* The file holds a header, the submesh table, then the vertex and index streams, each 16-byte aligned.
+* The streams are stored exactly as they are uploaded, so a loaded cache is handed straight to buffer creation.
+* The header records the source file's size, modification time and content hash, plus the importer flags and the
+* vertex stride. A cache is stale if any of these differ. A changed modification time alone is forgiven
+* if the content hash still matches, so a fresh checkout does not force a re-import.
+* Holds no Direct3D types.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _MESHCACHE_H_
+#define _MESHCACHE_H_
+
+#include "MappedFile.h"
+#include <cstdint>
+#include <string>
+
+/// File header. All fields are little-endian.
+struct MeshCacheHeader
+{
+	char magic[4];			///< "MSHC"
+	uint32_t version;
+	uint32_t importFlags;	///< Importer settings the streams were built with
+	uint32_t vertexStride;
+	uint64_t sourceSize;
+	int64_t sourceTime;		///< Source modification time, in filesystem clock ticks
+	uint64_t sourceHash;	///< XXH64 of the source file contents (see ContentHash.h)
+	uint32_t vertexCount;
+	uint32_t indexCount;	///< 32-bit indices
+	uint32_t submeshCount;
+	uint32_t padding;
+	float boundsMin[3];
+	float boundsMax[3];
+	uint64_t submeshOffset;
+	uint64_t vertexOffset;
+	uint64_t indexOffset;
+};
+
+/// One drawable part of the mesh. Bounds are in model space.
+struct MeshCacheSubmesh
+{
+	uint32_t indexStart;
+	uint32_t indexCount;
+	uint32_t materialIndex;
+	uint32_t padding;
+	float boundsMin[3];
+	float boundsMax[3];
+};
+
+/// Streams to write to a cache. Each vertex must start with a float3 position.
+struct MeshCacheData
+{
+	const void* vertices = nullptr;
+	uint32_t vertexCount = 0;
+	uint32_t vertexStride = 0;
+	const uint32_t* indices = nullptr;
+	uint32_t indexCount = 0;
+	const MeshCacheSubmesh* submeshes = nullptr;
+	uint32_t submeshCount = 0;
+};
+
+static const uint32_t meshCacheVersion = 3;
+
+/** \brief Writes a cache for a source file
+* The file is written under a temporary name unique to the writer and then moved into place, so a crash or
+* a concurrent writer never leaves a torn cache behind.
+* @return false if the source cannot be read or the cache cannot be written
+*/
+bool writeMeshCache(const std::string& cacheFilename, const std::string& sourceFilename, uint32_t importFlags, const MeshCacheData& data);
+
+/** \brief Reads only the overall bounds of a cache, without checking it against its source
+* Cheap enough for the main thread. Bounds of a stale cache are still a good placeholder size.
+* @return false if the cache is missing or malformed
+*/
+bool readMeshCacheBounds(const std::string& cacheFilename, float boundsMin[3], float boundsMax[3]);
+
+class MeshCacheFile
+{
+public:
+	/** \brief Maps a cache and checks it is still valid for its source
+	* @return false if the cache is missing, malformed or stale
+	*/
+	bool open(const std::string& cacheFilename, const std::string& sourceFilename, uint32_t importFlags, uint32_t vertexStride);
+	void close();
+
+	bool isOpen() const { return header != nullptr; }
+	const MeshCacheHeader& getHeader() const { return *header; }
+	const void* getVertexData() const;
+	const uint32_t* getIndexData() const;
+	const MeshCacheSubmesh* getSubmeshes() const;
+
+private:
+	MappedFile file;
+	const MeshCacheHeader* header = nullptr;
+};
+
+#endif
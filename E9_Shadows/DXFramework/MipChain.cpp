@@ -0,0 +1,568 @@
+// Mip chain
+// Box and Kaiser RGBA8 downsampling in linear light, and min/max pyramid reduction, with SIMD row kernels.
+#include "MipChain.h"
+#include "CpuFeatures.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#if defined(CPU_AVX2_KERNELS)
+#include <immintrin.h>
+#define MIP_CHAIN_AVX2
+#endif
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MIP_CHAIN_SSE2
+#endif
+
+static const int encodeTableSize = 16384;
+static const int kaiserTaps = 6;
+static const size_t minRowWorkPerThread = 64 * 1024;	// Pixels. Smaller levels run on the calling thread
+
+// Conversions between 8-bit values and filtered floats. Encoding looks up the float's bucket, so no pow per pixel.
+struct MipTables
+{
+	float srgbToLinear[256];
+	float unormToFloat[256];
+	unsigned char linearToSrgb[encodeTableSize];
+	unsigned char floatToUnorm[encodeTableSize];
+	float kaiser[kaiserTaps];	///< Weights for source texels 2.5, 1.5 and 0.5 either side of the output centre
+};
+
+// Zeroth order modified Bessel function of the first kind, for the Kaiser window.
+static double besselI0(double x)
+{
+	double sum = 1.0, term = 1.0;
+	for (int k = 1; k < 32; k++)
+	{
+		term *= (x / (2.0 * k)) * (x / (2.0 * k));
+		sum += term;
+	}
+	return sum;
+}
+
+static MipTables buildTables()
+{
+	MipTables tables;
+	for (int i = 0; i < 256; i++)
+	{
+		double c = i / 255.0;
+		tables.srgbToLinear[i] = (float)((c <= 0.04045) ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4));
+		tables.unormToFloat[i] = (float)c;
+	}
+	for (int i = 0; i < encodeTableSize; i++)
+	{
+		double linear = (i + 0.5) / encodeTableSize;
+		double srgb = (linear <= 0.0031308) ? linear * 12.92 : 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055;
+		tables.linearToSrgb[i] = (unsigned char)(srgb * 255.0 + 0.5);
+		tables.floatToUnorm[i] = (unsigned char)(linear * 255.0 + 0.5);
+	}
+
+	// Windowed sinc for a 2:1 reduction, three source texels either side, normalised to keep flat areas flat.
+	const double pi = 3.14159265358979323846, beta = 4.0, radius = 3.0;
+	double total = 0.0;
+	double weights[kaiserTaps];
+	for (int k = 0; k < kaiserTaps; k++)
+	{
+		double distance = k - 2.5;
+		double t = distance * 0.5 * pi;
+		double sinc = std::sin(t) / t;
+		double ratio = distance / radius;
+		weights[k] = sinc * besselI0(beta * std::sqrt(1.0 - ratio * ratio)) / besselI0(beta);
+		total += weights[k];
+	}
+	for (int k = 0; k < kaiserTaps; k++)
+	{
+		tables.kaiser[k] = (float)(weights[k] / total);
+	}
+	return tables;
+}
+
+static const MipTables& getTables()
+{
+	static const MipTables tables = buildTables();
+	return tables;
+}
+
+static const int kaiserPadLeft = 2;		// Source pixels the first output's taps reach before the row
+static const int kaiserPadRight = 3;
+static const int bandRows = 16;			// Output rows a thread takes at a time
+
+// Everything the row functions need to know about the level being built.
+struct LevelJob
+{
+	const unsigned char* source;
+	int width, height;
+	unsigned char* destination;
+	int outWidth, outHeight;
+	const float* decode[4];				///< Per-channel 8-bit to float tables
+	const unsigned char* encode[4];		///< Per-channel bucket to 8-bit tables
+	const float* kaiser;
+};
+
+static inline int clampIndex(int i, int count)
+{
+	return (i < 0) ? 0 : ((i >= count) ? count - 1 : i);
+}
+
+// Convert source row y to floats once, so the filters only see contiguous floats. The row is padded with copies of
+// its edge pixels, left before it and right after it.
+static void decodeRow(const LevelJob& job, int y, int left, int right, float* out)
+{
+	const unsigned char* row = job.source + (size_t)y * job.width * 4;
+	for (int x = -left; x < job.width + right; x++)
+	{
+		const unsigned char* p = row + (size_t)clampIndex(x, job.width) * 4;
+		float* pixel = out + (size_t)(x + left) * 4;
+		for (int c = 0; c < 4; c++)
+		{
+			pixel[c] = job.decode[c][p[c]];
+		}
+	}
+}
+
+// Row kernels, working on decoded RGBA float rows.
+typedef void (*BoxRow)(const float* row0, const float* row1, int outWidth, float* out);
+typedef void (*HorizontalRow)(const float* row, const float* weights, int outWidth, float* out);
+typedef void (*VerticalRow)(const float* const* rows, const float* weights, size_t count, float* out);
+typedef void (*EncodeRow)(const LevelJob& job, const float* in, unsigned char* out);
+
+struct MipKernels
+{
+	BoxRow box;
+	HorizontalRow horizontal;
+	VerticalRow vertical;
+	EncodeRow encode;
+};
+
+// Sums each column pair first, then the two columns.
+static void boxRowScalar(const float* row0, const float* row1, int outWidth, float* out)
+{
+	for (int i = 0; i < outWidth * 4; i++)
+	{
+		size_t left = (size_t)(i >> 2) * 8 + (i & 3);
+		float column0 = row0[left] + row1[left];
+		float column1 = row0[left + 4] + row1[left + 4];
+		out[i] = (column0 + column1) * 0.25f;
+	}
+}
+
+// Tap k of output x reads pixel 2x + k of a row padded by kaiserPadLeft.
+static void horizontalRowScalar(const float* row, const float* weights, int outWidth, float* out)
+{
+	for (int i = 0; i < outWidth * 4; i++)
+	{
+		const float* first = row + (size_t)(i >> 2) * 8 + (i & 3);
+		float sum = 0.0f;
+		for (int k = 0; k < kaiserTaps; k++)
+		{
+			float weighted = weights[k] * first[k * 4];
+			sum = sum + weighted;
+		}
+		out[i] = sum;
+	}
+}
+
+static void verticalRowScalar(const float* const* rows, const float* weights, size_t count, float* out)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		float sum = 0.0f;
+		for (int k = 0; k < kaiserTaps; k++)
+		{
+			float weighted = weights[k] * rows[k][i];
+			sum = sum + weighted;
+		}
+		out[i] = sum;
+	}
+}
+
+static void encodeRowScalar(const LevelJob& job, const float* in, unsigned char* out)
+{
+	for (int i = 0; i < job.outWidth * 4; i++)
+	{
+		float bucket = std::min(std::max(in[i] * (float)encodeTableSize, 0.0f), (float)(encodeTableSize - 1));
+		out[i] = job.encode[i & 3][(int)bucket];
+	}
+}
+
+#if defined(MIP_CHAIN_SSE2)
+// Box filter outputs from x onwards, one 4-channel pixel at a time.
+static void boxRowFromSSE2(const float* row0, const float* row1, int outWidth, int x, float* out)
+{
+	const __m128 quarter = _mm_set1_ps(0.25f);
+	for (; x < outWidth; x++)
+	{
+		__m128 column0 = _mm_add_ps(_mm_loadu_ps(row0 + x * 8), _mm_loadu_ps(row1 + x * 8));
+		__m128 column1 = _mm_add_ps(_mm_loadu_ps(row0 + x * 8 + 4), _mm_loadu_ps(row1 + x * 8 + 4));
+		_mm_storeu_ps(out + x * 4, _mm_mul_ps(_mm_add_ps(column0, column1), quarter));
+	}
+}
+
+static void boxRowSSE2(const float* row0, const float* row1, int outWidth, float* out)
+{
+	boxRowFromSSE2(row0, row1, outWidth, 0, out);
+}
+
+static void horizontalRowSSE2(const float* row, const float* weights, int outWidth, float* out)
+{
+	__m128 weight[kaiserTaps];
+	for (int k = 0; k < kaiserTaps; k++)
+	{
+		weight[k] = _mm_set1_ps(weights[k]);
+	}
+	for (int x = 0; x < outWidth; x++)
+	{
+		const float* first = row + (size_t)x * 8;
+		__m128 sum = _mm_setzero_ps();
+		for (int k = 0; k < kaiserTaps; k++)
+		{
+			sum = _mm_add_ps(sum, _mm_mul_ps(weight[k], _mm_loadu_ps(first + k * 4)));
+		}
+		_mm_storeu_ps(out + x * 4, sum);
+	}
+}
+
+// Vertical pass from float i onwards, one pixel at a time.
+static void verticalRowFromSSE2(const float* const* rows, const float* weights, size_t count, size_t i, float* out)
+{
+	for (; i < count; i += 4)
+	{
+		__m128 sum = _mm_setzero_ps();
+		for (int k = 0; k < kaiserTaps; k++)
+		{
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(rows[k] + i)));
+		}
+		_mm_storeu_ps(out + i, sum);
+	}
+}
+
+static void verticalRowSSE2(const float* const* rows, const float* weights, size_t count, float* out)
+{
+	verticalRowFromSSE2(rows, weights, count, 0, out);
+}
+
+static void encodeRowSSE2(const LevelJob& job, const float* in, unsigned char* out)
+{
+	const __m128 scale = _mm_set1_ps((float)encodeTableSize);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 last = _mm_set1_ps((float)(encodeTableSize - 1));
+	alignas(16) int buckets[4];
+	for (int x = 0; x < job.outWidth; x++)
+	{
+		__m128 bucket = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(in + x * 4), scale), zero), last);
+		_mm_store_si128((__m128i*)buckets, _mm_cvttps_epi32(bucket));
+		for (int c = 0; c < 4; c++)
+		{
+			out[x * 4 + c] = job.encode[c][buckets[c]];
+		}
+	}
+}
+#endif
+
+#if defined(MIP_CHAIN_AVX2)
+CPU_TARGET_AVX2 static void boxRowAVX2(const float* row0, const float* row1, int outWidth, float* out)
+{
+	// Two outputs at a time. The lane permutes pair up the first and second columns of each.
+	const __m256 quarter = _mm256_set1_ps(0.25f);
+	int x = 0;
+	for (; x + 2 <= outWidth; x += 2)
+	{
+		__m256 columns01 = _mm256_add_ps(_mm256_loadu_ps(row0 + x * 8), _mm256_loadu_ps(row1 + x * 8));
+		__m256 columns23 = _mm256_add_ps(_mm256_loadu_ps(row0 + x * 8 + 8), _mm256_loadu_ps(row1 + x * 8 + 8));
+		__m256 column0 = _mm256_permute2f128_ps(columns01, columns23, 0x20);
+		__m256 column1 = _mm256_permute2f128_ps(columns01, columns23, 0x31);
+		_mm256_storeu_ps(out + x * 4, _mm256_mul_ps(_mm256_add_ps(column0, column1), quarter));
+	}
+	boxRowFromSSE2(row0, row1, outWidth, x, out);
+}
+
+CPU_TARGET_AVX2 static void verticalRowAVX2(const float* const* rows, const float* weights, size_t count, float* out)
+{
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 sum = _mm256_setzero_ps();
+		for (int k = 0; k < kaiserTaps; k++)
+		{
+			sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(weights[k]), _mm256_loadu_ps(rows[k] + i)));
+		}
+		_mm256_storeu_ps(out + i, sum);
+	}
+	verticalRowFromSSE2(rows, weights, count, i, out);
+}
+#endif
+
+static const MipKernels scalarKernels = { boxRowScalar, horizontalRowScalar, verticalRowScalar, encodeRowScalar };
+#if defined(MIP_CHAIN_SSE2)
+static const MipKernels sse2Kernels = { boxRowSSE2, horizontalRowSSE2, verticalRowSSE2, encodeRowSSE2 };
+#endif
+#if defined(MIP_CHAIN_AVX2)
+static const MipKernels avx2Kernels = { boxRowAVX2, horizontalRowSSE2, verticalRowAVX2, encodeRowSSE2 };
+#endif
+
+// The widest kernels this CPU can run.
+static const MipKernels& getSimdKernels()
+{
+#if defined(MIP_CHAIN_AVX2)
+	if (useAvx2Kernels())
+	{
+		return avx2Kernels;
+	}
+#endif
+#if defined(MIP_CHAIN_SSE2)
+	return sse2Kernels;
+#else
+	return scalarKernels;
+#endif
+}
+
+// Run function(firstRow, endRow, scratch) over bands of output rows shared between threads. Each thread keeps its
+// own scratch buffer from band to band.
+template <typename BandFunction>
+static void forEachBand(int rows, size_t pixelsPerRow, int threadCount, BandFunction function)
+{
+	int bands = (rows + bandRows - 1) / bandRows;
+	if (threadCount <= 0)
+	{
+		threadCount = (int)std::thread::hardware_concurrency();
+	}
+	size_t usefulThreads = std::max<size_t>((size_t)rows * pixelsPerRow / minRowWorkPerThread, 1);
+	threadCount = (int)std::min<size_t>(std::max(threadCount, 1), std::min(usefulThreads, (size_t)bands));
+
+	std::atomic<int> nextBand(0);
+	auto work = [&]()
+	{
+		std::vector<float> scratch;
+		for (int band = nextBand++; band < bands; band = nextBand++)
+		{
+			function(band * bandRows, std::min((band + 1) * bandRows, rows), scratch);
+		}
+	};
+	std::vector<std::thread> threads;
+	for (int i = 1; i < threadCount; i++)
+	{
+		threads.emplace_back(work);
+	}
+	work();
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+}
+
+static void downsample(const unsigned char* source, int width, int height, unsigned char* destination, const MipSettings& settings, const MipKernels& kernels, int threadCount)
+{
+	const MipTables& tables = getTables();
+	LevelJob job;
+	job.source = source;
+	job.width = width;
+	job.height = height;
+	job.destination = destination;
+	job.outWidth = std::max(width / 2, 1);
+	job.outHeight = std::max(height / 2, 1);
+	for (int c = 0; c < 4; c++)
+	{
+		bool srgbChannel = settings.srgb && c < 3;
+		job.decode[c] = srgbChannel ? tables.srgbToLinear : tables.unormToFloat;
+		job.encode[c] = srgbChannel ? tables.linearToSrgb : tables.floatToUnorm;
+	}
+	job.kaiser = tables.kaiser;
+
+	size_t outFloats = (size_t)job.outWidth * 4;
+	if (!settings.kaiser)
+	{
+		// One padding pixel covers the second column of a 1 texel wide level.
+		size_t rowFloats = (size_t)(width + 1) * 4;
+		forEachBand(job.outHeight, width, threadCount, [&](int firstRow, int endRow, std::vector<float>& scratch)
+		{
+			scratch.resize(rowFloats * 2 + outFloats);
+			float* row0 = scratch.data();
+			float* row1 = row0 + rowFloats;
+			float* out = row1 + rowFloats;
+			for (int y = firstRow; y < endRow; y++)
+			{
+				int y1 = clampIndex(y * 2 + 1, height);
+				decodeRow(job, y * 2, 0, 1, row0);
+				decodeRow(job, y1, 0, 1, row1);
+				kernels.box(row0, row1, job.outWidth, out);
+				kernels.encode(job, out, destination + y * outFloats);
+			}
+		});
+		return;
+	}
+
+	// Separable: each band filters the source rows its taps reach horizontally, then filters those vertically.
+	// Neighbouring bands share a few source rows, which costs less than keeping every filtered row of the level.
+	size_t rowFloats = (size_t)(width + kaiserPadLeft + kaiserPadRight) * 4;
+	forEachBand(job.outHeight, (size_t)width * 3, threadCount, [&](int firstRow, int endRow, std::vector<float>& scratch)
+	{
+		int firstSource = firstRow * 2 - kaiserPadLeft;
+		int sourceRows = (endRow - firstRow) * 2 + kaiserPadLeft + kaiserPadRight;
+		scratch.resize(rowFloats + outFloats * (sourceRows + 1));
+		float* decoded = scratch.data();
+		float* filtered = decoded + rowFloats;
+		float* out = filtered + outFloats * sourceRows;
+		for (int r = 0; r < sourceRows; r++)
+		{
+			decodeRow(job, clampIndex(firstSource + r, height), kaiserPadLeft, kaiserPadRight, decoded);
+			kernels.horizontal(decoded, job.kaiser, job.outWidth, filtered + r * outFloats);
+		}
+		for (int y = firstRow; y < endRow; y++)
+		{
+			const float* rows[kaiserTaps];
+			for (int k = 0; k < kaiserTaps; k++)
+			{
+				rows[k] = filtered + (size_t)((y - firstRow) * 2 + k) * outFloats;
+			}
+			kernels.vertical(rows, job.kaiser, outFloats, out);
+			kernels.encode(job, out, destination + y * outFloats);
+		}
+	});
+}
+
+int getMipLevelCount(int width, int height)
+{
+	int levels = 1;
+	while (width > 1 || height > 1)
+	{
+		width = std::max(width / 2, 1);
+		height = std::max(height / 2, 1);
+		levels++;
+	}
+	return levels;
+}
+
+void downsampleRGBA8(const unsigned char* source, int width, int height, unsigned char* destination, const MipSettings& settings)
+{
+	downsample(source, width, height, destination, settings, getSimdKernels(), settings.threadCount);
+}
+
+void downsampleRGBA8Scalar(const unsigned char* source, int width, int height, unsigned char* destination, const MipSettings& settings)
+{
+	downsample(source, width, height, destination, settings, scalarKernels, 1);
+}
+
+void generateMipChain(unsigned char* pixels, const TextureMipLevel* levels, int levelCount, const MipSettings& settings)
+{
+	for (int level = 1; level < levelCount; level++)
+	{
+		const TextureMipLevel& source = levels[level - 1];
+		downsampleRGBA8(pixels + source.offset, source.width, source.height, pixels + levels[level].offset, settings);
+	}
+}
+
+// One output row of the min/max reduction from columns startX onwards.
+static void reduceMinMaxRowScalar(const float* min0, const float* min1, const float* max0, const float* max1, int width, int startX, float* minOut, float* maxOut)
+{
+	for (int x = startX; x < (width + 1) / 2; x++)
+	{
+		int x0 = x * 2, x1 = std::min(x * 2 + 1, width - 1);
+		minOut[x] = std::min(std::min(min0[x0], min0[x1]), std::min(min1[x0], min1[x1]));
+		maxOut[x] = std::max(std::max(max0[x0], max0[x1]), std::max(max1[x0], max1[x1]));
+	}
+}
+
+void reduceMinMaxScalar(const float* minSource, const float* maxSource, int width, int height, float* minDestination, float* maxDestination)
+{
+	int outWidth = (width + 1) / 2;
+	for (int y = 0; y < (height + 1) / 2; y++)
+	{
+		size_t row0 = (size_t)(y * 2) * width;
+		size_t row1 = (size_t)std::min(y * 2 + 1, height - 1) * width;
+		reduceMinMaxRowScalar(minSource + row0, minSource + row1, maxSource + row0, maxSource + row1, width, 0,
+			minDestination + (size_t)y * outWidth, maxDestination + (size_t)y * outWidth);
+	}
+}
+
+#if defined(MIP_CHAIN_AVX2)
+// Min or max of each pair of 8 columns. In-lane shuffles split even and odd columns, the permute puts the four
+// 64-bit halves back in order.
+CPU_TARGET_AVX2 static inline __m256 pairMinAVX2(const float* row)
+{
+	__m256 a = _mm256_loadu_ps(row), b = _mm256_loadu_ps(row + 8);
+	__m256 low = _mm256_min_ps(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+	return _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(low), _MM_SHUFFLE(3, 1, 2, 0)));
+}
+
+CPU_TARGET_AVX2 static inline __m256 pairMaxAVX2(const float* row)
+{
+	__m256 a = _mm256_loadu_ps(row), b = _mm256_loadu_ps(row + 8);
+	__m256 high = _mm256_max_ps(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+	return _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(high), _MM_SHUFFLE(3, 1, 2, 0)));
+}
+
+// Eight outputs at a time while whole pairs remain. Returns the first column left over.
+CPU_TARGET_AVX2 static int reduceMinMaxRowAVX2(const float* min0, const float* min1, const float* max0, const float* max1, int pairs, float* minOut, float* maxOut)
+{
+	int x = 0;
+	for (; x + 8 <= pairs; x += 8)
+	{
+		_mm256_storeu_ps(minOut + x, _mm256_min_ps(pairMinAVX2(min0 + x * 2), pairMinAVX2(min1 + x * 2)));
+		_mm256_storeu_ps(maxOut + x, _mm256_max_ps(pairMaxAVX2(max0 + x * 2), pairMaxAVX2(max1 + x * 2)));
+	}
+	return x;
+}
+#endif
+
+void reduceMinMax(const float* minSource, const float* maxSource, int width, int height, float* minDestination, float* maxDestination)
+{
+	int outWidth = (width + 1) / 2;
+	int pairs = width / 2;		// Outputs with two source columns
+#if defined(MIP_CHAIN_AVX2)
+	bool avx2 = useAvx2Kernels();
+#endif
+	for (int y = 0; y < (height + 1) / 2; y++)
+	{
+		size_t row0 = (size_t)(y * 2) * width;
+		size_t row1 = (size_t)std::min(y * 2 + 1, height - 1) * width;
+		const float* min0 = minSource + row0;
+		const float* min1 = minSource + row1;
+		const float* max0 = maxSource + row0;
+		const float* max1 = maxSource + row1;
+		float* minOut = minDestination + (size_t)y * outWidth;
+		float* maxOut = maxDestination + (size_t)y * outWidth;
+
+		int x = 0;
+#if defined(MIP_CHAIN_AVX2)
+		if (avx2)
+		{
+			x = reduceMinMaxRowAVX2(min0, min1, max0, max1, pairs, minOut, maxOut);
+		}
+#endif
+#if defined(MIP_CHAIN_SSE2)
+		for (; x + 4 <= pairs; x += 4)
+		{
+			__m128 a0 = _mm_loadu_ps(min0 + x * 2), b0 = _mm_loadu_ps(min0 + x * 2 + 4);
+			__m128 a1 = _mm_loadu_ps(min1 + x * 2), b1 = _mm_loadu_ps(min1 + x * 2 + 4);
+			__m128 low0 = _mm_min_ps(_mm_shuffle_ps(a0, b0, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(a0, b0, _MM_SHUFFLE(3, 1, 3, 1)));
+			__m128 low1 = _mm_min_ps(_mm_shuffle_ps(a1, b1, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(a1, b1, _MM_SHUFFLE(3, 1, 3, 1)));
+			_mm_storeu_ps(minOut + x, _mm_min_ps(low0, low1));
+
+			a0 = _mm_loadu_ps(max0 + x * 2), b0 = _mm_loadu_ps(max0 + x * 2 + 4);
+			a1 = _mm_loadu_ps(max1 + x * 2), b1 = _mm_loadu_ps(max1 + x * 2 + 4);
+			__m128 high0 = _mm_max_ps(_mm_shuffle_ps(a0, b0, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(a0, b0, _MM_SHUFFLE(3, 1, 3, 1)));
+			__m128 high1 = _mm_max_ps(_mm_shuffle_ps(a1, b1, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(a1, b1, _MM_SHUFFLE(3, 1, 3, 1)));
+			_mm_storeu_ps(maxOut + x, _mm_max_ps(high0, high1));
+		}
+#endif
+		reduceMinMaxRowScalar(min0, min1, max0, max1, width, x, minOut, maxOut);
+	}
+}
+
+const char* getMipChainKernelName()
+{
+#if defined(MIP_CHAIN_AVX2)
+	if (useAvx2Kernels())
+	{
+		return "AVX2";
+	}
+#endif
+#if defined(MIP_CHAIN_SSE2)
+	return "SSE2";
+#else
+	return "Scalar";
+#endif
+}
@@ -0,0 +1,68 @@
+/**
+* \brief Platform-neutral CPU mip chain generation and min/max pyramid reduction
+*
+* RGBA8 levels are halved with a 2x2 box or a separable Kaiser-windowed sinc. With sRGB on, colour channels are
+* decoded to linear light before filtering and encoded back afterwards, both through lookup tables. Alpha is always
+* filtered linearly.
+* Each source row is decoded to floats once. Pixels are then filtered as one 4-channel vector with SSE2, and the box
+* filter, the Kaiser vertical pass and the min/max reduction handle 8 floats at a time on CPUs with AVX2, chosen at
+* run time through useAvx2Kernels(). The scalar versions perform the
+* same operations in the same order, so every path gives identical results as long as the compiler does not fuse
+* multiplies and adds (MSVC's default /fp:precise does not).
+* Bands of rows of a level are shared between threads. Levels are built in turn, as each one reads the last.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _MIPCHAIN_H_
+#define _MIPCHAIN_H_
+
+#include <cstddef>
+
+/// One level of a mip chain stored in a single buffer.
+struct TextureMipLevel
+{
+	size_t offset;		///< Byte offset of the level in the chain's buffer
+	int width;
+	int height;
+};
+
+/// Filtering options for RGBA8 mip generation.
+struct MipSettings
+{
+	bool generateMips = true;	///< Otherwise only the top level is kept
+	bool srgb = true;			///< Average colour channels in linear light. Turn off for normal maps and other data
+	bool kaiser = false;		///< Kaiser-windowed sinc instead of a 2x2 box. Sharper, at several times the cost
+	int threadCount = 1;		///< Threads sharing each level's rows. 0 uses one per hardware thread
+};
+
+/// Number of levels down to 1x1, each half the size of the last (rounded down, at least 1).
+int getMipLevelCount(int width, int height);
+
+/** \brief Halves an RGBA8 image
+* @param destination receives max(width / 2, 1) x max(height / 2, 1) pixels
+*/
+void downsampleRGBA8(const unsigned char* source, int width, int height, unsigned char* destination, const MipSettings& settings);
+
+/// Reference implementation of downsampleRGBA8 without SIMD, single-threaded.
+void downsampleRGBA8Scalar(const unsigned char* source, int width, int height, unsigned char* destination, const MipSettings& settings);
+
+/** \brief Fills every level after the first from the one before
+* @param pixels holds level 0 and room for the others at their offsets
+* @param levels describes levelCount levels, each half the size of the last
+*/
+void generateMipChain(unsigned char* pixels, const TextureMipLevel* levels, int levelCount, const MipSettings& settings);
+
+/** \brief Merges 2x2 blocks of a min/max pyramid level into the next
+* Blocks hanging over the right or bottom edge merge only the values that exist.
+* @param minDestination and maxDestination receive (width + 1) / 2 x (height + 1) / 2 values
+*/
+void reduceMinMax(const float* minSource, const float* maxSource, int width, int height, float* minDestination, float* maxDestination);
+
+/// Reference implementation of reduceMinMax without SIMD.
+void reduceMinMaxScalar(const float* minSource, const float* maxSource, int width, int height, float* minDestination, float* maxDestination);
+
+/// Name of the widest kernel used on this CPU ("AVX2", "SSE2" or "Scalar").
+const char* getMipChainKernelName();
+
+#endif
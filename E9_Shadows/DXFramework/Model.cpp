@@ -5,8 +5,28 @@
 // load model datat, initialise buffers (with model data) and load texture.
 Model::Model(ID3D11Device* device, ID3D11DeviceContext* deviceContext, const char* filename)
 {
+	// Every Model of the same file contents on this device draws from one pair of buffers.
+	ContentKey key;
+	bool shareable = hashFile(filename, key);
+	key.variant = getMeshContentVariant(device, meshLoaderModel, 0);
+	sharedBuffers = shareable ? getSharedMeshBuffers().find(key) : nullptr;
+	if (sharedBuffers)
+	{
+		sharedBuffers->adopt(vertexBuffer, indexBuffer);
+		vertexCount = sharedBuffers->vertexCount;
+		indexCount = sharedBuffers->indexCount;
+		sourceVertexCount = sharedBuffers->sourceVertexCount;
+		return;
+	}
+
 	loadModel(filename);
 	initBuffers(device);
+	if (shareable && vertexBuffer && indexBuffer)
+	{
+		sharedBuffers = std::make_shared<SharedMeshBuffers>(vertexBuffer, indexBuffer, vertexCount, indexCount);
+		sharedBuffers->sourceVertexCount = sourceVertexCount;
+		getSharedMeshBuffers().insert(key, sharedBuffers);
+	}
 }
 
 // Release resources.
@@ -14,35 +34,17 @@ Model::~Model()
 {
 	// Run parent deconstructor
 	BaseMesh::~BaseMesh();
-
-	if (model)
-	{
-		delete[] model;
-		model = 0;
-	}
 }
 
 
 // Initialise buffers with model data.
 void Model::initBuffers(ID3D11Device* device)
 {
-	VertexType* vertices;
-	unsigned long* indices;
 	D3D11_BUFFER_DESC vertexBufferDesc, indexBufferDesc;
 	D3D11_SUBRESOURCE_DATA vertexData, indexData;
-		
-	vertices = new VertexType[vertexCount];
-	indices = new unsigned long[indexCount];
-	
-	// Load the vertex array and index array with data.
-	for (int i = 0; i<vertexCount; i++)
-	{
-		vertices[i].position = XMFLOAT3(model[i].x, model[i].y, -model[i].z);
-		vertices[i].texture = XMFLOAT2(model[i].tu, model[i].tv);
-		vertices[i].normal = XMFLOAT3(model[i].nx, model[i].ny, -model[i].nz);
 
-		indices[i] = i;
-	}
+	// The loader already wrote left-handed vertices in the VertexType layout, so both arrays upload as they are.
+	static_assert(sizeof(ObjVertex) == sizeof(VertexType), "ObjVertex must match the VertexType layout");
 
 	// Set up the description of the static vertex buffer.
 	vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
@@ -52,7 +54,7 @@ void Model::initBuffers(ID3D11Device* device)
 	vertexBufferDesc.MiscFlags = 0;
 	vertexBufferDesc.StructureByteStride = 0;
 	// Give the subresource structure a pointer to the vertex data.
-	vertexData.pSysMem = vertices;
+	vertexData.pSysMem = vertices.data();
 	vertexData.SysMemPitch = 0;
 	vertexData.SysMemSlicePitch = 0;
 	// Now create the vertex buffer.
@@ -60,24 +62,21 @@ void Model::initBuffers(ID3D11Device* device)
 
 	// Set up the description of the static index buffer.
 	indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-	indexBufferDesc.ByteWidth = sizeof(unsigned long)* indexCount;
+	indexBufferDesc.ByteWidth = sizeof(uint32_t)* indexCount;
 	indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
 	indexBufferDesc.CPUAccessFlags = 0;
 	indexBufferDesc.MiscFlags = 0;
 	indexBufferDesc.StructureByteStride = 0;
 	// Give the subresource structure a pointer to the index data.
-	indexData.pSysMem = indices;
+	indexData.pSysMem = indices.data();
 	indexData.SysMemPitch = 0;
 	indexData.SysMemSlicePitch = 0;
 	// Create the index buffer.
 	device->CreateBuffer(&indexBufferDesc, &indexData, &indexBuffer);
 	
 	// Release the arrays now that the vertex and index buffers have been created and loaded.
-	delete[] vertices;
-	vertices = 0;
-
-	delete[] indices;
-	indices = 0;
+	std::vector<ObjVertex>().swap(vertices);
+	std::vector<uint32_t>().swap(indices);
 }
 
 //// Read model file and parse data.
@@ -221,104 +220,15 @@ void Model::initBuffers(ID3D11Device* device)
 //	faces.clear();
 //}
 
-// Modified from a mulit-threaded version by Mark Ropper (CGT).
+// Memory-map the file and parse it in place. A malformed file leaves the model empty.
 void Model::loadModel(const char* filename)
 {
-	std::vector<XMFLOAT3> verts;
-	std::vector<XMFLOAT3> norms;
-	std::vector<XMFLOAT2> texCs;
-	std::vector<unsigned int> faces;
-
-	FILE* file;// = fopen(filename, "r");
-	errno_t err;
-	err = fopen_s(&file, filename, "r");
-	if(err != 0)
-	//if (file == NULL)
-	{
-		return;
-	}
-
-	while (true)
-	{
-		char lineHeader[128];
-
-		// Read first word of the line
-		int res = fscanf_s(file, "%s", lineHeader, (int)sizeof(lineHeader));
-		if (res == EOF)
-		{
-			break; // exit loop
-		}
-		else // Parse
-		{
-			if (strcmp(lineHeader, "v") == 0) // Vertex
-			{
-				XMFLOAT3 vertex;
-				fscanf_s(file, "%f %f %f\n", &vertex.x, &vertex.y, &vertex.z);
-				verts.push_back(vertex);
-			}
-			else if (strcmp(lineHeader, "vt") == 0) // Tex Coord
-			{
-				XMFLOAT2 uv;
-				fscanf_s(file, "%f %f\n", &uv.x, &uv.y);
-				texCs.push_back(uv);
-			}
-			else if (strcmp(lineHeader, "vn") == 0) // Normal
-			{
-				XMFLOAT3 normal;
-				fscanf_s(file, "%f %f %f\n", &normal.x, &normal.y, &normal.z);
-				norms.push_back(normal);
-			}
-			else if (strcmp(lineHeader, "f") == 0) // Face
-			{
-				unsigned int face[9];
-				int matches = fscanf_s(file, "%d/%d/%d %d/%d/%d %d/%d/%d\n", &face[0], &face[1], &face[2],
-																			&face[3], &face[4], &face[5],
-																			&face[6], &face[7], &face[8]);
-				if (matches != 9)
-				{
-					// Parser error, or not triangle faces
-					return;
-				}
-
-				for (int i = 0; i < 9; i++)
-				{
-					faces.push_back(face[i]);
-				}
-
-
-			}
-		}
-	}
-
-	int vIndex = 0, nIndex = 0, tIndex = 0;
-	int numFaces = (int)faces.size() / 9;
-
-	//// Create the model using the vertex count that was read in.
-	vertexCount = numFaces * 3;
-	model = new ModelType[vertexCount];
-
-	// "Unroll" the loaded obj information into a list of triangles.
-	for (int f = 0; f < (int)faces.size(); f += 3)
-	{
-		model[vIndex].x = verts[(faces[f + 0] - 1)].x;
-		model[vIndex].y = verts[(faces[f + 0] - 1)].y;
-		model[vIndex].z = verts[(faces[f + 0] - 1)].z;
-		model[vIndex].tu = texCs[(faces[f + 1] - 1)].x;
-		model[vIndex].tv = texCs[(faces[f + 1] - 1)].y;
-		model[vIndex].nx = norms[(faces[f + 2] - 1)].x;
-		model[vIndex].ny = norms[(faces[f + 2] - 1)].y;
-		model[vIndex].nz = norms[(faces[f + 2] - 1)].z;
-
-		//increase index count
-		vIndex++;
-
-	}
-	indexCount = vIndex;
-
-
-	verts.clear();
-	norms.clear();
-	texCs.clear();
-	faces.clear();
-
+	ObjMesh mesh;
+	loadObj(filename, mesh);
+
+	// Corners sharing a v/vt/vn triple become one vertex, so the index buffer does real work.
+	weldVertices(mesh.vertices, vertices, indices);
+	sourceVertexCount = (int)mesh.vertices.size();
+	vertexCount = (int)vertices.size();
+	indexCount = (int)indices.size();
 }
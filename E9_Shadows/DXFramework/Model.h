@@ -5,6 +5,7 @@
 *
 * Is treated like a standard mesh object, but loads a basic OBJ file based on provided filename.
 * Future version will update/replace this model loader with something more complete.
+* Models with the same file contents share one set of buffers (see SharedMeshBuffers.h).
 *
 * \author Paul Robertson
 */
@@ -14,21 +15,17 @@
 #define _MODEL_H_
 
 #include "BaseMesh.h"
+#include "ObjLoader.h"
+#include "SharedMeshBuffers.h"
+#include "VertexWeld.h"
 //#include "TokenStream.h"
+#include <memory>
 #include <vector>
-#include <fstream>
 
 using namespace DirectX;
 
 class Model : public BaseMesh
 {
-	struct ModelType
-	{
-		float x, y, z;
-		float tu, tv;
-		float nx, ny, nz;
-	};
-
 public:
 	/** \brief Initialises the mesh and vertex list, but loading in from a file
 	* Provide filename to OBJ object, will be loaded and store like other mesh objects.
@@ -39,11 +36,17 @@ public:
 	Model(ID3D11Device* device, ID3D11DeviceContext* deviceContext, const char* filename);
 	~Model();
 
+	int getSourceVertexCount() const { return sourceVertexCount; }	///< Face corners in the file, before welding
+	int getVertexCount() const { return vertexCount; }				///< Unique vertices after welding
+
 protected:
 	void initBuffers(ID3D11Device* device);
 	void loadModel(const char* filename);
 	
-	ModelType* model;
+	std::vector<ObjVertex> vertices;	///< Welded vertices, released once uploaded
+	std::vector<uint32_t> indices;
+	int sourceVertexCount = 0;
+	std::shared_ptr<SharedMeshBuffers> sharedBuffers;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,178 @@
+// Model arrays
+// Flattens an assimp scene into pre-sized vertex, index and submesh arrays.
+#include "ModelArrays.h"
+#include "AssetIOSystem.h"
+#include "GlbFile.h"
+#include "assimp/Importer.hpp"
+#include "assimp/postprocess.h"
+#include "assimp/scene.h"
+#include <algorithm>
+#include <cfloat>
+
+// Depth-first, in the same order AModel has always visited meshes.
+static void collectMeshes(const aiNode* node, const aiScene* scene, std::vector<const aiMesh*>& meshes)
+{
+	for (unsigned int i = 0; i < node->mNumMeshes; i++)
+	{
+		meshes.push_back(scene->mMeshes[node->mMeshes[i]]);
+	}
+	for (unsigned int i = 0; i < node->mNumChildren; i++)
+	{
+		collectMeshes(node->mChildren[i], scene, meshes);
+	}
+}
+
+bool buildModelArrays(const aiScene* scene, ModelArrays& out)
+{
+	out.vertices.clear();
+	out.indices.clear();
+	out.submeshes.clear();
+	if (!scene || !scene->mRootNode)
+	{
+		return false;
+	}
+
+	std::vector<const aiMesh*> meshes;
+	collectMeshes(scene->mRootNode, scene, meshes);
+
+	// Size everything up front. Triangulated meshes skip the per-face walk.
+	size_t vertexTotal = 0, indexTotal = 0;
+	for (const aiMesh* mesh : meshes)
+	{
+		vertexTotal += mesh->mNumVertices;
+		if (mesh->mPrimitiveTypes == aiPrimitiveType_TRIANGLE)
+		{
+			indexTotal += (size_t)mesh->mNumFaces * 3;
+		}
+		else
+		{
+			for (unsigned int f = 0; f < mesh->mNumFaces; f++)
+			{
+				indexTotal += mesh->mFaces[f].mNumIndices;
+			}
+		}
+	}
+	out.vertices.resize(vertexTotal);
+	out.indices.resize(indexTotal);
+	out.submeshes.resize(meshes.size());
+
+	size_t vertexBase = 0, indexBase = 0;
+	for (size_t m = 0; m < meshes.size(); m++)
+	{
+		const aiMesh* mesh = meshes[m];
+		MeshCacheSubmesh& submesh = out.submeshes[m];
+		submesh = {};
+		submesh.indexStart = (uint32_t)indexBase;
+		submesh.materialIndex = mesh->mMaterialIndex;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			submesh.boundsMin[axis] = (mesh->mNumVertices > 0) ? FLT_MAX : 0.0f;
+			submesh.boundsMax[axis] = (mesh->mNumVertices > 0) ? -FLT_MAX : 0.0f;
+		}
+
+		bool hasTexCoords = mesh->HasTextureCoords(0);
+		bool hasNormals = mesh->HasNormals();
+		for (unsigned int i = 0; i < mesh->mNumVertices; i++)
+		{
+			ModelVertex& vertex = out.vertices[vertexBase + i];
+			const aiVector3D& position = mesh->mVertices[i];
+			vertex.position[0] = position.x;
+			vertex.position[1] = position.y;
+			vertex.position[2] = position.z;
+			vertex.texture[0] = hasTexCoords ? mesh->mTextureCoords[0][i].x : 0.0f;
+			vertex.texture[1] = hasTexCoords ? mesh->mTextureCoords[0][i].y : 0.0f;
+			vertex.normal[0] = hasNormals ? mesh->mNormals[i].x : 0.0f;
+			vertex.normal[1] = hasNormals ? mesh->mNormals[i].y : 0.0f;
+			vertex.normal[2] = hasNormals ? mesh->mNormals[i].z : 0.0f;
+
+			for (int axis = 0; axis < 3; axis++)
+			{
+				submesh.boundsMin[axis] = std::min(submesh.boundsMin[axis], vertex.position[axis]);
+				submesh.boundsMax[axis] = std::max(submesh.boundsMax[axis], vertex.position[axis]);
+			}
+		}
+
+		uint32_t* index = out.indices.data() + indexBase;
+		for (unsigned int f = 0; f < mesh->mNumFaces; f++)
+		{
+			const aiFace& face = mesh->mFaces[f];
+			for (unsigned int j = 0; j < face.mNumIndices; j++)
+			{
+				*index++ = (uint32_t)(vertexBase + face.mIndices[j]);
+			}
+		}
+
+		submesh.indexCount = (uint32_t)(index - (out.indices.data() + indexBase));
+		vertexBase += mesh->mNumVertices;
+		indexBase += submesh.indexCount;
+	}
+	return true;
+}
+
+const unsigned int modelImportFlags = aiProcess_CalcTangentSpace |
+	aiProcess_Triangulate |
+	aiProcess_JoinIdenticalVertices |
+	aiProcess_SortByPType |
+	aiProcess_MakeLeftHanded |
+	aiProcess_FlipUVs;
+
+std::string getModelCacheFilename(const std::string& filename)
+{
+	return filename + ".mshc";
+}
+
+bool openModelCache(const std::string& filename, MeshCacheFile& cache)
+{
+	return cache.open(getModelCacheFilename(filename), filename, modelImportFlags, sizeof(ModelVertex));
+}
+
+bool importModelArrays(const std::string& filename, ModelArrays& out, std::string& error)
+{
+	Assimp::Importer importer;
+	importer.SetIOHandler(new AssetIOSystem());
+	const aiScene* scene = importer.ReadFile(filename, modelImportFlags);
+	if (!buildModelArrays(scene, out))
+	{
+		error = importer.GetErrorString();
+		return false;
+	}
+
+	if (!out.vertices.empty())
+	{
+		MeshCacheData data;
+		data.vertices = out.vertices.data();
+		data.vertexCount = (uint32_t)out.vertices.size();
+		data.vertexStride = sizeof(ModelVertex);
+		data.indices = out.indices.data();
+		data.indexCount = (uint32_t)out.indices.size();
+		data.submeshes = out.submeshes.data();
+		data.submeshCount = (uint32_t)out.submeshes.size();
+		writeMeshCache(getModelCacheFilename(filename), filename, modelImportFlags, data);
+	}
+	return true;
+}
+
+bool loadModelArrays(const std::string& filename, ModelArrays& out, std::string& error)
+{
+	if (isGlbFilename(filename))
+	{
+		GlbFile glb;
+		if (glb.open(filename, error))
+		{
+			glb.copyTo(out);
+			return true;
+		}
+	}
+
+	MeshCacheFile cache;
+	if (openModelCache(filename, cache))
+	{
+		const MeshCacheHeader& header = cache.getHeader();
+		const ModelVertex* vertices = (const ModelVertex*)cache.getVertexData();
+		out.vertices.assign(vertices, vertices + header.vertexCount);
+		out.indices.assign(cache.getIndexData(), cache.getIndexData() + header.indexCount);
+		out.submeshes.assign(cache.getSubmeshes(), cache.getSubmeshes() + header.submeshCount);
+		return true;
+	}
+	return importModelArrays(filename, out, error);
+}
@@ -0,0 +1,168 @@
+// Model load queue
+// Worker threads import models, the main thread delivers them at frame boundaries.
+#include "ModelLoadQueue.h"
+#include <algorithm>
+#include <exception>
+
+ModelLoadQueue::ModelLoadQueue(Importer limporter, int threadCount)
+{
+	importer = limporter;
+	threadCount = std::max(threadCount, 1);
+	for (int i = 0; i < threadCount; i++)
+	{
+		workers.emplace_back(&ModelLoadQueue::workerLoop, this);
+	}
+}
+
+ModelLoadQueue::~ModelLoadQueue()
+{
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		stopping = true;
+		queued.clear();
+	}
+	jobAvailable.notify_all();
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+}
+
+ModelHandle ModelLoadQueue::load(const std::string& filename, ModelUploadSink* sink)
+{
+	std::unique_ptr<Job> job(new Job());
+	job->filename = filename;
+	job->sink = sink;
+
+	std::lock_guard<std::mutex> lock(jobMutex);
+	job->handle = nextHandle++;
+	if (nextHandle == 0)
+	{
+		nextHandle = 1;
+	}
+	ModelHandle handle = job->handle;
+	queued.push_back(job.get());
+	jobs[handle] = std::move(job);
+	jobAvailable.notify_one();
+	return handle;
+}
+
+bool ModelLoadQueue::cancel(ModelHandle handle)
+{
+	std::lock_guard<std::mutex> lock(jobMutex);
+	auto found = jobs.find(handle);
+	if (found == jobs.end() || found->second->cancelled)
+	{
+		return false;
+	}
+
+	// Queued or finished jobs can go now. A running job is only flagged, its worker drops it when done.
+	Job* job = found->second.get();
+	auto queuedJob = std::find(queued.begin(), queued.end(), job);
+	auto finishedJob = std::find(finished.begin(), finished.end(), job);
+	if (queuedJob != queued.end())
+	{
+		queued.erase(queuedJob);
+		jobs.erase(found);
+	}
+	else if (finishedJob != finished.end())
+	{
+		finished.erase(finishedJob);
+		jobs.erase(found);
+	}
+	else
+	{
+		job->cancelled = true;
+	}
+	return true;
+}
+
+int ModelLoadQueue::update(int maxDeliveries)
+{
+	// Take the finished jobs out under the lock, then call sinks without it so they may queue or cancel loads.
+	std::vector<std::unique_ptr<Job>> delivering;
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		size_t count = finished.size();
+		if (maxDeliveries > 0)
+		{
+			count = std::min(count, (size_t)maxDeliveries);
+		}
+		for (size_t i = 0; i < count; i++)
+		{
+			auto found = jobs.find(finished[i]->handle);
+			delivering.push_back(std::move(found->second));
+			jobs.erase(found);
+		}
+		finished.erase(finished.begin(), finished.begin() + count);
+	}
+
+	for (std::unique_ptr<Job>& job : delivering)
+	{
+		if (job->succeeded)
+		{
+			job->sink->modelLoaded(job->handle, job->arrays);
+		}
+		else
+		{
+			job->sink->modelFailed(job->handle, job->error);
+		}
+	}
+	return (int)delivering.size();
+}
+
+int ModelLoadQueue::getPendingCount() const
+{
+	std::lock_guard<std::mutex> lock(jobMutex);
+	return (int)jobs.size();
+}
+
+void ModelLoadQueue::workerLoop()
+{
+	while (true)
+	{
+		Job* job;
+		{
+			std::unique_lock<std::mutex> lock(jobMutex);
+			jobAvailable.wait(lock, [this]() { return stopping || !queued.empty(); });
+			if (stopping)
+			{
+				return;
+			}
+			job = queued.front();
+			queued.pop_front();
+		}
+
+		// The job stays in the map while running, and cancel() only flags it, so the pointer stays valid.
+		bool succeeded = false;
+		std::string error;
+		ModelArrays arrays;
+		try
+		{
+			succeeded = importer(job->filename, arrays, error);
+		}
+		catch (const std::exception& exception)
+		{
+			error = exception.what();
+		}
+		catch (...)
+		{
+			error = "Unknown import error";
+		}
+		if (!succeeded && error.empty())
+		{
+			error = "Could not import " + job->filename;
+		}
+
+		std::lock_guard<std::mutex> lock(jobMutex);
+		if (job->cancelled)
+		{
+			jobs.erase(job->handle);
+			continue;
+		}
+		job->succeeded = succeeded;
+		job->error = error;
+		job->arrays = std::move(arrays);
+		finished.push_back(job);
+	}
+}
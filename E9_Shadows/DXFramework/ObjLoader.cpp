@@ -0,0 +1,400 @@
+// OBJ loader
+// Zero-copy OBJ parsing over a mapped file, split into chunks parsed on worker threads.
+#include "ObjLoader.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+
+namespace
+{
+	struct Float2 { float x, y; };
+	struct Float3 { float x, y, z; };
+
+	// Files below this size per thread are not worth the thread start-up.
+	const size_t minChunkBytes = 1 << 20;
+
+	/// A negative (relative) index, stored as a chunk-local 0-based index until the chunk's offsets are known.
+	struct RelativeIndex
+	{
+		size_t slot;		///< Entry in ObjChunk::corners. slot % 3 gives the attribute: v, vt or vn
+		int64_t local;		///< May be negative when it reaches back into earlier chunks
+	};
+
+	/// One face corner as written in the file. 0 marks a missing vt or vn.
+	struct ObjCorner
+	{
+		uint32_t index[3];
+		int64_t local[3];
+		bool relative[3];
+	};
+
+	/// One newline-aligned slice of the file and everything parsed from it.
+	struct ObjChunk
+	{
+		const char* begin;
+		const char* end;
+		std::vector<Float3> positions;
+		std::vector<Float2> texCoords;
+		std::vector<Float3> normals;
+		std::vector<uint32_t> corners;			///< 1-based v, vt, vn indices, three per corner and three corners per triangle
+		std::vector<RelativeIndex> relative;	///< Corner entries still to be made absolute
+		size_t positionOffset = 0, texCoordOffset = 0, normalOffset = 0, vertexOffset = 0;
+		bool valid = true;
+	};
+
+	inline bool isBlank(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	inline bool isLineEnd(const char* p, const char* end)
+	{
+		return p == end || *p == '\n' || *p == '#';
+	}
+
+	inline const char* skipBlanks(const char* p, const char* end)
+	{
+		while (p < end && isBlank(*p))
+			p++;
+		return p;
+	}
+
+	inline const char* skipLine(const char* p, const char* end)
+	{
+		while (p < end && *p != '\n')
+			p++;
+		return (p < end) ? p + 1 : end;
+	}
+
+	// from_chars rejects a leading '+', which some exporters write.
+	inline bool parseFloat(const char*& p, const char* end, float& value)
+	{
+		p = skipBlanks(p, end);
+		if (p < end && *p == '+')
+			p++;
+		std::from_chars_result result = std::from_chars(p, end, value);
+		if (result.ec != std::errc())
+			return false;
+		p = result.ptr;
+		return true;
+	}
+
+	// Reads an optional extra component, such as the v of a one-component vt.
+	inline void parseOptionalFloat(const char*& p, const char* end, float& value)
+	{
+		const char* start = p;
+		if (!parseFloat(p, end, value))
+		{
+			p = start;
+		}
+	}
+
+	// One index of a corner. Positive indices are absolute, negative ones count back from the last attribute read.
+	inline bool parseIndex(const char*& p, const char* end, size_t localCount, ObjCorner& corner, int attribute)
+	{
+		long long index;
+		std::from_chars_result result = std::from_chars(p, end, index);
+		if (result.ec != std::errc() || index == 0 || index > UINT32_MAX)
+			return false;
+		p = result.ptr;
+
+		corner.relative[attribute] = (index < 0);
+		corner.index[attribute] = (index > 0) ? (uint32_t)index : 0;
+		corner.local[attribute] = (index < 0) ? (int64_t)localCount + index : 0;
+		return true;
+	}
+
+	// v, v/vt, v//vn or v/vt/vn.
+	bool parseCorner(const char*& p, const char* end, const ObjChunk& chunk, ObjCorner& corner)
+	{
+		corner.index[1] = corner.index[2] = 0;
+		corner.relative[1] = corner.relative[2] = false;
+		if (!parseIndex(p, end, chunk.positions.size(), corner, 0))
+			return false;
+
+		if (p < end && *p == '/')
+		{
+			p++;
+			if (p < end && *p != '/' && !isBlank(*p) && !isLineEnd(p, end))
+			{
+				if (!parseIndex(p, end, chunk.texCoords.size(), corner, 1))
+					return false;
+			}
+			if (p < end && *p == '/')
+			{
+				p++;
+				if (!parseIndex(p, end, chunk.normals.size(), corner, 2))
+					return false;
+			}
+		}
+		return isLineEnd(p, end) || isBlank(*p);
+	}
+
+	void pushCorner(ObjChunk& chunk, const ObjCorner& corner)
+	{
+		for (int attribute = 0; attribute < 3; attribute++)
+		{
+			if (corner.relative[attribute])
+			{
+				chunk.relative.push_back({ chunk.corners.size(), corner.local[attribute] });
+			}
+			chunk.corners.push_back(corner.index[attribute]);
+		}
+	}
+
+	// First phase. Parses attributes and face indices of one chunk without needing any other chunk.
+	// Polygons are fan triangulated as they are read.
+	void parseChunk(ObjChunk& chunk)
+	{
+		size_t size = chunk.end - chunk.begin;
+		chunk.positions.reserve(size / 96);
+		chunk.texCoords.reserve(size / 96);
+		chunk.normals.reserve(size / 96);
+		chunk.corners.reserve(size / 10);
+
+		const char* p = chunk.begin;
+		const char* end = chunk.end;
+		bool valid = true;
+
+		while (p < end && valid)
+		{
+			p = skipBlanks(p, end);
+			if (p + 1 >= end)
+				break;
+
+			// Extra components (w, vertex colours, a third texture coordinate) are ignored.
+			if (p[0] == 'v' && isBlank(p[1]))
+			{
+				p += 2;
+				Float3 v;
+				valid = parseFloat(p, end, v.x) && parseFloat(p, end, v.y) && parseFloat(p, end, v.z);
+				chunk.positions.push_back(v);
+			}
+			else if (p[0] == 'v' && p[1] == 't' && p + 2 < end && isBlank(p[2]))
+			{
+				p += 3;
+				Float2 t = { 0.0f, 0.0f };
+				valid = parseFloat(p, end, t.x);
+				parseOptionalFloat(p, end, t.y);
+				chunk.texCoords.push_back(t);
+			}
+			else if (p[0] == 'v' && p[1] == 'n' && p + 2 < end && isBlank(p[2]))
+			{
+				p += 3;
+				Float3 n;
+				valid = parseFloat(p, end, n.x) && parseFloat(p, end, n.y) && parseFloat(p, end, n.z);
+				chunk.normals.push_back(n);
+			}
+			else if (p[0] == 'f' && isBlank(p[1]))
+			{
+				p += 2;
+				ObjCorner first, previous, corner;
+				int cornerCount = 0;
+				while (true)
+				{
+					p = skipBlanks(p, end);
+					if (isLineEnd(p, end))
+						break;
+					valid = parseCorner(p, end, chunk, corner);
+					if (!valid)
+						break;
+
+					if (cornerCount == 0)
+					{
+						first = corner;
+					}
+					else if (cornerCount >= 2)
+					{
+						pushCorner(chunk, first);
+						pushCorner(chunk, previous);
+						pushCorner(chunk, corner);
+					}
+					previous = corner;
+					cornerCount++;
+				}
+				valid = valid && cornerCount >= 3;
+			}
+
+			p = skipLine(p, end);
+		}
+
+		chunk.valid = valid;
+	}
+
+	// Second phase. Every chunk's attributes are in the global arrays, so its corners can be resolved.
+	// Missing texture coordinates become (0, 0). Missing normals become the triangle's face normal.
+	void resolveChunk(ObjChunk& chunk, const std::vector<Float3>& positions, const std::vector<Float2>& texCoords,
+		const std::vector<Float3>& normals, float zSign, ObjVertex* vertices)
+	{
+		const size_t offsets[3] = { chunk.positionOffset, chunk.texCoordOffset, chunk.normalOffset };
+		for (const RelativeIndex& relative : chunk.relative)
+		{
+			int64_t index = (int64_t)offsets[relative.slot % 3] + relative.local;
+			if (index < 0 || index >= UINT32_MAX)
+			{
+				chunk.valid = false;
+				return;
+			}
+			chunk.corners[relative.slot] = (uint32_t)index + 1;
+		}
+
+		ObjVertex* out = vertices + chunk.vertexOffset;
+		const Float2 noTexCoord = { 0.0f, 0.0f };
+		for (size_t i = 0; i < chunk.corners.size(); i += 9)
+		{
+			const uint32_t* triangle = &chunk.corners[i];
+			const Float3* corners[3];
+			bool needsFaceNormal = false;
+			for (int c = 0; c < 3; c++)
+			{
+				size_t v = triangle[c * 3];
+				size_t t = triangle[c * 3 + 1];
+				size_t n = triangle[c * 3 + 2];
+				if (v == 0 || v > positions.size() || t > texCoords.size() || n > normals.size())
+				{
+					chunk.valid = false;
+					return;
+				}
+				corners[c] = &positions[v - 1];
+				needsFaceNormal |= (n == 0);
+			}
+
+			Float3 faceNormal = { 0.0f, 1.0f, 0.0f };
+			if (needsFaceNormal)
+			{
+				Float3 e1 = { corners[1]->x - corners[0]->x, corners[1]->y - corners[0]->y, corners[1]->z - corners[0]->z };
+				Float3 e2 = { corners[2]->x - corners[0]->x, corners[2]->y - corners[0]->y, corners[2]->z - corners[0]->z };
+				Float3 cross = { e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x };
+				float length = std::sqrt(cross.x * cross.x + cross.y * cross.y + cross.z * cross.z);
+				if (length > 0.0f)
+				{
+					faceNormal = { cross.x / length, cross.y / length, cross.z / length };
+				}
+			}
+
+			for (int c = 0; c < 3; c++)
+			{
+				uint32_t t = triangle[c * 3 + 1];
+				uint32_t n = triangle[c * 3 + 2];
+				const Float3& position = *corners[c];
+				const Float2& texCoord = t ? texCoords[t - 1] : noTexCoord;
+				const Float3& normal = n ? normals[n - 1] : faceNormal;
+				*out++ = { { position.x, position.y, position.z * zSign },
+					{ texCoord.x, texCoord.y },
+					{ normal.x, normal.y, normal.z * zSign } };
+			}
+		}
+	}
+
+	// Runs job(i) for every chunk, one thread each. The calling thread takes the first chunk.
+	template <typename Job>
+	void runChunks(std::vector<ObjChunk>& chunks, Job job)
+	{
+		std::vector<std::thread> workers;
+		workers.reserve(chunks.size());
+		for (size_t i = 1; i < chunks.size(); i++)
+		{
+			workers.emplace_back(job, i);
+		}
+		job(0);
+		for (std::thread& worker : workers)
+		{
+			worker.join();
+		}
+	}
+}
+
+bool parseObj(const char* data, size_t size, ObjMesh& mesh, bool leftHanded, unsigned threadCount)
+{
+	mesh.vertices.clear();
+	mesh.positionCount = mesh.texCoordCount = mesh.normalCount = 0;
+
+	if (threadCount == 0)
+	{
+		threadCount = std::thread::hardware_concurrency();
+	}
+	size_t chunkCount = size / minChunkBytes + 1;
+	if (chunkCount > threadCount)
+	{
+		chunkCount = (threadCount > 0) ? threadCount : 1;
+	}
+
+	// Split at line starts, so no chunk sees part of another chunk's line.
+	std::vector<ObjChunk> chunks(chunkCount);
+	const char* end = data + size;
+	const char* begin = data;
+	for (size_t i = 0; i < chunkCount; i++)
+	{
+		const char* split = (i + 1 == chunkCount) ? end : data + size / chunkCount * (i + 1);
+		if (split < begin)
+			split = begin;
+		while (split < end && split > data && split[-1] != '\n')
+			split++;
+		chunks[i].begin = begin;
+		chunks[i].end = split;
+		begin = split;
+	}
+
+	runChunks(chunks, [&chunks](size_t i) { parseChunk(chunks[i]); });
+
+	// Chunk order is file order, so running totals give each chunk its place in the global arrays.
+	size_t vertexCount = 0;
+	for (ObjChunk& chunk : chunks)
+	{
+		if (!chunk.valid)
+		{
+			mesh = ObjMesh{};
+			return false;
+		}
+		chunk.positionOffset = mesh.positionCount;
+		chunk.texCoordOffset = mesh.texCoordCount;
+		chunk.normalOffset = mesh.normalCount;
+		chunk.vertexOffset = vertexCount;
+		mesh.positionCount += chunk.positions.size();
+		mesh.texCoordCount += chunk.texCoords.size();
+		mesh.normalCount += chunk.normals.size();
+		vertexCount += chunk.corners.size() / 3;
+	}
+
+	std::vector<Float3> positions(mesh.positionCount);
+	std::vector<Float2> texCoords(mesh.texCoordCount);
+	std::vector<Float3> normals(mesh.normalCount);
+	runChunks(chunks, [&](size_t i)
+	{
+		ObjChunk& chunk = chunks[i];
+		std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + chunk.positionOffset);
+		std::copy(chunk.texCoords.begin(), chunk.texCoords.end(), texCoords.begin() + chunk.texCoordOffset);
+		std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + chunk.normalOffset);
+		std::vector<Float3>().swap(chunk.positions);
+		std::vector<Float2>().swap(chunk.texCoords);
+		std::vector<Float3>().swap(chunk.normals);
+	});
+
+	mesh.vertices.resize(vertexCount);
+	float zSign = leftHanded ? -1.0f : 1.0f;
+	runChunks(chunks, [&](size_t i) { resolveChunk(chunks[i], positions, texCoords, normals, zSign, mesh.vertices.data()); });
+
+	for (const ObjChunk& chunk : chunks)
+	{
+		if (!chunk.valid)
+		{
+			mesh = ObjMesh{};
+			return false;
+		}
+	}
+	return true;
+}
+
+bool loadObj(const std::string& filename, ObjMesh& mesh, bool leftHanded, unsigned threadCount)
+{
+	MappedFile file;
+	if (!file.open(filename))
+	{
+		mesh = ObjMesh{};
+		return false;
+	}
+	return parseObj((const char*)file.getData(), file.getSize(), mesh, leftHanded, threadCount);
+}
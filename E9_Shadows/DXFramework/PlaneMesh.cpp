@@ -1,8 +1,7 @@
 // plane mesh
-// Quad mesh made of many quads. Default is 100x100
+// Welded grid of shared vertices. Default is 100x100
 #include "PlaneMesh.h"
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
+#include "TerrainNormals.h"
 
 // Flat plane constructor
 PlaneMesh::PlaneMesh(ID3D11Device* device, ID3D11DeviceContext* deviceContext, int lresolution)
@@ -25,7 +24,8 @@ PlaneMesh::PlaneMesh(ID3D11Device* device, ID3D11DeviceContext* deviceContext, c
     useHeightmap = true;
     this->heightmapPath = heightmapPath;
     this->heightScale = lheightScale;
-    if (!loadHeightmap(heightmapPath, heightData, heightmapWidth, heightmapHeight)) {
+    heightmap = HeightmapCache::load(heightmapPath);
+    if (!heightmap) {
         useHeightmap = false;
     }
     initBuffers(device);
@@ -36,105 +36,104 @@ PlaneMesh::~PlaneMesh()
     BaseMesh::~BaseMesh();
 }
 
-bool PlaneMesh::loadHeightmap(const std::string& filename, std::vector<float>& outData, int& outWidth, int& outHeight)
-{
-    int n = 0;
-    unsigned char* imageData = stbi_load(filename.c_str(), &outWidth, &outHeight, &n, 1);
-    if (!imageData) return false;
-
-    outData.resize(outWidth * outHeight);
-    for (int i = 0; i < outWidth * outHeight; ++i)
-        outData[i] = imageData[i] / 255.0f;
-
-    stbi_image_free(imageData);
-    return true;
-}
-
 float PlaneMesh::sampleHeight(float u, float v) const
 {
-    if (!useHeightmap || heightData.empty()) return 0.0f;
-    int x = static_cast<int>(u * (heightmapWidth - 1));
-    int y = static_cast<int>(v * (heightmapHeight - 1));
-    x = (x < 0) ? 0 : ((x >= heightmapWidth) ? heightmapWidth - 1 : x);
-    y = (y < 0) ? 0 : ((y >= heightmapHeight) ? heightmapHeight - 1 : y);
-    return heightData[y * heightmapWidth + x] * heightScale;
+    if (!useHeightmap || !heightmap) return 0.0f;
+    return sampleHeightNearest(heightmap->getView(heightScale), u, v);
 }
 
+// Builds a welded (resolution x resolution) grid, each vertex shared by up to six triangles.
 void PlaneMesh::initBuffers(ID3D11Device* device)
 {
-    VertexType* vertices;
-    unsigned long* indices;
-    int index, i, j;
-    float positionX, positionZ, u, v, increment;
+    static_assert(sizeof(TerrainVertex) == sizeof(VertexType), "TerrainVertex must match VertexType layout");
+
     D3D11_BUFFER_DESC vertexBufferDesc, indexBufferDesc;
     D3D11_SUBRESOURCE_DATA vertexData, indexData;
 
-    vertexCount = (resolution - 1) * (resolution - 1) * 6;
-    indexCount = vertexCount;
-    vertices = new VertexType[vertexCount];
-    indices = new unsigned long[indexCount];
+    // Build at unit scale and keep the raw samples, so later scale changes are a multiply.
+    HeightfieldView view;
+    if (useHeightmap && heightmap)
+    {
+        view = heightmap->getView(1.0f);
+    }
+
+    if (resolution < 2)
+        resolution = 2;
 
-    index = 0;
-    u = 0;
-    v = 0;
-    increment = 1.0f / (resolution - 1);
+    TerrainGrid grid;
+    buildTerrainGrid(resolution, view.samples ? &view : nullptr, grid);
 
-    for (j = 0; j < (resolution - 1); j++)
+    unitHeights.resize(grid.vertices.size());
+    for (size_t i = 0; i < grid.vertices.size(); ++i)
+    {
+        unitHeights[i] = grid.vertices[i].position[1];
+    }
+    vertices.swap(grid.vertices);
+    if (useHeightmap)
     {
-        for (i = 0; i < (resolution - 1); i++)
-        {
-            auto make_vertex = [&](int x, int z, float u, float v) -> VertexType {
-                VertexType vert;
-                vert.position = XMFLOAT3((float)x, 0.0f, (float)z);
-                vert.texture = XMFLOAT2(u, v);
-                vert.normal = XMFLOAT3(0.0f, 1.0f, 0.0f);
-                if (useHeightmap)
-                    vert.position.y = sampleHeight(u, v);
-                return vert;
-                };
-
-            vertices[index] = make_vertex(i, j, u, v);
-            indices[index] = index; index++;
-            vertices[index] = make_vertex(i + 1, j + 1, u + increment, v + increment);
-            indices[index] = index; index++;
-            vertices[index] = make_vertex(i, j + 1, u, v + increment);
-            indices[index] = index; index++;
-
-            vertices[index] = make_vertex(i, j, u, v);
-            indices[index] = index; index++;
-            vertices[index] = make_vertex(i + 1, j, u + increment, v);
-            indices[index] = index; index++;
-            vertices[index] = make_vertex(i + 1, j + 1, u + increment, v + increment);
-            indices[index] = index; index++;
-
-            u += increment;
-        }
-        u = 0;
-        v += increment;
+        applyHeightScale();
     }
 
+    vertexCount = (int)vertices.size();
+    indexCount = (int)grid.getIndexCount();
+    indexFormat = grid.uses16BitIndices() ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+
     vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
     vertexBufferDesc.ByteWidth = sizeof(VertexType) * vertexCount;
     vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
     vertexBufferDesc.CPUAccessFlags = 0;
     vertexBufferDesc.MiscFlags = 0;
     vertexBufferDesc.StructureByteStride = 0;
-    vertexData.pSysMem = vertices;
+    vertexData.pSysMem = vertices.data();
     vertexData.SysMemPitch = 0;
     vertexData.SysMemSlicePitch = 0;
     device->CreateBuffer(&vertexBufferDesc, &vertexData, &vertexBuffer);
 
     indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-    indexBufferDesc.ByteWidth = sizeof(unsigned long) * indexCount;
+    indexBufferDesc.ByteWidth = (UINT)(grid.getIndexStride() * indexCount);
     indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
     indexBufferDesc.CPUAccessFlags = 0;
     indexBufferDesc.MiscFlags = 0;
     indexBufferDesc.StructureByteStride = 0;
-    indexData.pSysMem = indices;
+    indexData.pSysMem = grid.getIndexData();
     indexData.SysMemPitch = 0;
     indexData.SysMemSlicePitch = 0;
     device->CreateBuffer(&indexBufferDesc, &indexData, &indexBuffer);
+}
 
-    delete[] vertices;
-    delete[] indices;
-}
\ No newline at end of file
+// Scale the cached unit heights into the vertex array and derive normals from the result.
+void PlaneMesh::applyHeightScale()
+{
+    std::vector<float> heights(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        heights[i] = unitHeights[i] * heightScale;
+        vertices[i].position[1] = heights[i];
+    }
+
+    // Vertices are one unit apart, so the grid spacing is 1 in both directions.
+    computeTerrainNormals(heights.data(), resolution, resolution, 1.0f, 1.0f, vertices[0].normal, sizeof(TerrainVertex) / sizeof(float));
+}
+
+void PlaneMesh::setHeightScale(ID3D11DeviceContext* deviceContext, float scale)
+{
+    if (scale == heightScale)
+        return;
+
+    heightScale = scale;
+    if (!useHeightmap || vertices.empty())
+        return;
+
+    applyHeightScale();
+    deviceContext->UpdateSubresource(vertexBuffer, 0, nullptr, vertices.data(), 0, 0);
+}
+
+void PlaneMesh::sendData(ID3D11DeviceContext* deviceContext, D3D_PRIMITIVE_TOPOLOGY top)
+{
+    unsigned int stride = sizeof(VertexType);
+    unsigned int offset = 0;
+
+    deviceContext->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
+    deviceContext->IASetIndexBuffer(indexBuffer, indexFormat, 0);
+    deviceContext->IASetPrimitiveTopology(top);
+}
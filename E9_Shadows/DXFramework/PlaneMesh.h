@@ -5,6 +5,8 @@
 *
 * Inherits from Base Mesh, Builds a simple plane with texture coordinates and normals.
 * If a heightmap is provided, the plane's Y positions are displaced accordingly.
+* Heightmaps are shared through HeightmapCache, and the height scale can be changed without rebuilding the mesh.
+* Normals of heightmapped planes are derived from the displaced heights.
 *
 * \author Paul Robertson, extended by Copilot
 */
@@ -13,6 +15,9 @@
 #define _PLANEMESH_H_
 
 #include "BaseMesh.h"
+#include "HeightmapCache.h"
+#include "TerrainGrid.h"
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -24,19 +29,33 @@ public:
     PlaneMesh(ID3D11Device* device, ID3D11DeviceContext* deviceContext, const std::string& heightmapPath, float heightScale, int resolution = 100);
     ~PlaneMesh();
 
+    /// Binds the welded grid. Uses a 16-bit index buffer when the grid fits.
+    void sendData(ID3D11DeviceContext* deviceContext, D3D_PRIMITIVE_TOPOLOGY top = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST) override;
+
+    /** \brief Rescales the heightmap displacement in place
+    * Rewrites vertex heights and normals in the existing vertex buffer. No decoding or buffer reallocation.
+    * @param deviceContext is the renderer device context used for the upload
+    * @param scale is the new height scale
+    */
+    void setHeightScale(ID3D11DeviceContext* deviceContext, float scale);
+    float getHeightScale() const { return heightScale; }
+
 protected:
     void initBuffers(ID3D11Device* device) override;
 
     bool useHeightmap = false;
-    std::vector<float> heightData;
-    int heightmapWidth = 0;
-    int heightmapHeight = 0;
+    std::shared_ptr<const Heightmap> heightmap;
     float heightScale = 1.0f;
     std::string heightmapPath;
 
     int resolution;
-    bool loadHeightmap(const std::string& filename, std::vector<float>& outData, int& outWidth, int& outHeight);
+    DXGI_FORMAT indexFormat = DXGI_FORMAT_R32_UINT;
+
+    std::vector<TerrainVertex> vertices;    ///< CPU copy of the vertex buffer, used for in-place updates
+    std::vector<float> unitHeights;         ///< Per-vertex heightmap samples before scaling
+
     float sampleHeight(float u, float v) const;
+    void applyHeightScale();
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,77 @@
+/**
+* \class Shared Mesh Buffers
+*
+* \brief Vertex and index buffers uploaded once per model file contents and shared by every mesh loaded from them
+*
+* Model and AModel hash their file before loading and look the contents up here, so the same model loaded twice,
+* or under two paths, is parsed and uploaded once. Each mesh adds its own reference to the buffers, which BaseMesh
+* releases as usual, and keeps the entry alive while it exists. The entry's references go with the last mesh.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _SHAREDMESHBUFFERS_H_
+#define _SHAREDMESHBUFFERS_H_
+
+#include <d3d11.h>
+#include "ContentCache.h"
+#include "MeshCache.h"
+#include <vector>
+
+const uint32_t meshLoaderModel = 1;		///< Loader ids for getMeshContentVariant
+const uint32_t meshLoaderAModel = 2;
+
+struct SharedMeshBuffers
+{
+	/// Takes a reference on buffers a mesh has just created.
+	SharedMeshBuffers(ID3D11Buffer* lvertexBuffer, ID3D11Buffer* lindexBuffer, int lvertexCount, int lindexCount)
+	{
+		vertexBuffer = lvertexBuffer;
+		indexBuffer = lindexBuffer;
+		vertexCount = lvertexCount;
+		indexCount = lindexCount;
+		vertexBuffer->AddRef();
+		indexBuffer->AddRef();
+	}
+
+	~SharedMeshBuffers()
+	{
+		vertexBuffer->Release();
+		indexBuffer->Release();
+	}
+
+	SharedMeshBuffers(const SharedMeshBuffers&) = delete;
+	SharedMeshBuffers& operator=(const SharedMeshBuffers&) = delete;
+
+	/// Copies the buffers into a mesh, adding the mesh's own reference to each.
+	void adopt(ID3D11Buffer*& meshVertexBuffer, ID3D11Buffer*& meshIndexBuffer) const
+	{
+		meshVertexBuffer = vertexBuffer;
+		meshIndexBuffer = indexBuffer;
+		vertexBuffer->AddRef();
+		indexBuffer->AddRef();
+	}
+
+	ID3D11Buffer* vertexBuffer;
+	ID3D11Buffer* indexBuffer;
+	int vertexCount;
+	int indexCount;
+	int sourceVertexCount = 0;					///< Model only. Face corners before welding
+	std::vector<MeshCacheSubmesh> submeshes;	///< AModel only
+};
+
+/// Every shared mesh, keyed by file contents. Variants come from getMeshContentVariant.
+inline ContentCache<SharedMeshBuffers>& getSharedMeshBuffers()
+{
+	static ContentCache<SharedMeshBuffers> cache;
+	return cache;
+}
+
+/// Buffers are only shared between meshes on the same device, built by the same loader with the same settings.
+inline uint64_t getMeshContentVariant(ID3D11Device* device, uint32_t loader, uint32_t loaderFlags)
+{
+	uint64_t values[3] = { (uint64_t)(uintptr_t)device, loader, loaderFlags };
+	return hashContent(values, sizeof(values));
+}
+
+#endif
@@ -0,0 +1,97 @@
+// Terrain grid
+// Generates a shared-vertex grid with a real triangle index list.
+#include "TerrainGrid.h"
+
+const void* TerrainGrid::getIndexData() const
+{
+	if (uses16BitIndices())
+	{
+		return indices16.data();
+	}
+	return indices32.data();
+}
+
+float sampleHeightNearest(const HeightfieldView& heights, float u, float v)
+{
+	if (!heights.samples || heights.width <= 0 || heights.height <= 0)
+	{
+		return 0.0f;
+	}
+
+	int x = static_cast<int>(u * (heights.width - 1));
+	int y = static_cast<int>(v * (heights.height - 1));
+	x = (x < 0) ? 0 : ((x >= heights.width) ? heights.width - 1 : x);
+	y = (y < 0) ? 0 : ((y >= heights.height) ? heights.height - 1 : y);
+	return heights.samples[y * heights.width + x] * heights.scale;
+}
+
+// Fill the index list for a (resolution x resolution) vertex grid. Two triangles per cell.
+template <typename IndexType>
+static void buildGridIndices(int resolution, std::vector<IndexType>& indices)
+{
+	int cells = resolution - 1;
+	indices.resize((size_t)cells * cells * 6);
+
+	size_t index = 0;
+	for (int j = 0; j < cells; j++)
+	{
+		for (int i = 0; i < cells; i++)
+		{
+			IndexType bottomLeft = (IndexType)(j * resolution + i);
+			IndexType bottomRight = (IndexType)(bottomLeft + 1);
+			IndexType topLeft = (IndexType)(bottomLeft + resolution);
+			IndexType topRight = (IndexType)(topLeft + 1);
+
+			indices[index++] = bottomLeft;
+			indices[index++] = topRight;
+			indices[index++] = topLeft;
+
+			indices[index++] = bottomLeft;
+			indices[index++] = bottomRight;
+			indices[index++] = topRight;
+		}
+	}
+}
+
+void buildTerrainGrid(int resolution, const HeightfieldView* heights, TerrainGrid& out)
+{
+	if (resolution < 2)
+	{
+		resolution = 2;
+	}
+
+	out.vertices.resize((size_t)resolution * resolution);
+	out.indices16.clear();
+	out.indices32.clear();
+
+	float increment = 1.0f / (resolution - 1);
+	bool useHeights = heights && heights->samples;
+
+	for (int j = 0; j < resolution; j++)
+	{
+		float v = j * increment;
+		for (int i = 0; i < resolution; i++)
+		{
+			float u = i * increment;
+			TerrainVertex& vert = out.vertices[(size_t)j * resolution + i];
+			vert.position[0] = (float)i;
+			vert.position[1] = useHeights ? sampleHeightNearest(*heights, u, v) : 0.0f;
+			vert.position[2] = (float)j;
+			vert.texture[0] = u;
+			vert.texture[1] = v;
+			vert.normal[0] = 0.0f;
+			vert.normal[1] = 1.0f;
+			vert.normal[2] = 0.0f;
+		}
+	}
+
+	// 16-bit indices halve index bandwidth whenever every vertex is addressable.
+	if (out.vertices.size() <= 0xFFFF)
+	{
+		buildGridIndices(resolution, out.indices16);
+	}
+	else
+	{
+		buildGridIndices(resolution, out.indices32);
+	}
+}
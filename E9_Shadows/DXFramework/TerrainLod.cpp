@@ -0,0 +1,332 @@
+// Terrain quadtree
+// Chunk hierarchy, error metric, screen-space LOD selection and skirted chunk meshes.
+#include "TerrainLod.h"
+#include <algorithm>
+#include <cmath>
+
+// Skirts always drop at least this far (unscaled), so flat chunks still hide T-junction gaps.
+static const float minimumSkirtDepth = 0.01f;
+
+void TerrainQuadtree::build(const float* unitHeights, int lresolution, int lleafCells)
+{
+	heights = unitHeights;
+	resolution = lresolution;
+	// Chunk meshes use 16-bit indices, which caps the leaf size.
+	leafCells = std::min(std::max(lleafCells, 1), 128);
+	chunks.clear();
+	levelCount = 0;
+
+	int cells = resolution - 1;
+	if (!heights || cells < 1)
+		return;
+
+	// Smallest power-of-two multiple of the leaf size that covers the grid.
+	int rootSize = leafCells;
+	int rootLevel = 0;
+	while (rootSize < cells)
+	{
+		rootSize *= 2;
+		rootLevel++;
+	}
+	levelCount = rootLevel + 1;
+
+	buildNode(0, 0, rootSize, rootLevel);
+}
+
+// Children are built first, so a parent's error can include theirs and stays monotonic up the tree.
+int TerrainQuadtree::buildNode(int x, int z, int size, int level)
+{
+	int index = (int)chunks.size();
+	chunks.push_back(TerrainChunk());
+
+	TerrainChunk chunk;
+	chunk.x = x;
+	chunk.z = z;
+	chunk.size = size;
+	chunk.step = size / leafCells;
+	chunk.level = level;
+	chunk.children[0] = chunk.children[1] = chunk.children[2] = chunk.children[3] = -1;
+
+	float childError = 0.0f;
+	if (level > 0)
+	{
+		int cells = resolution - 1;
+		int half = size / 2;
+		for (int c = 0; c < 4; c++)
+		{
+			int cx = x + (c & 1) * half;
+			int cz = z + (c >> 1) * half;
+			if (cx < cells && cz < cells)
+			{
+				int child = buildNode(cx, cz, half, level - 1);
+				chunk.children[c] = child;
+				childError = std::max(childError, chunks[child].geometricError);
+			}
+		}
+	}
+
+	// Height range over every full resolution sample the chunk covers.
+	int x1 = std::min(x + size, resolution - 1);
+	int z1 = std::min(z + size, resolution - 1);
+	chunk.minHeight = heights[(size_t)z * resolution + x];
+	chunk.maxHeight = chunk.minHeight;
+	for (int j = z; j <= z1; j++)
+	{
+		const float* row = heights + (size_t)j * resolution;
+		for (int i = x; i <= x1; i++)
+		{
+			chunk.minHeight = std::min(chunk.minHeight, row[i]);
+			chunk.maxHeight = std::max(chunk.maxHeight, row[i]);
+		}
+	}
+
+	chunk.geometricError = (chunk.step > 1) ? std::max(measureError(chunk), childError) : 0.0f;
+	chunks[index] = chunk;
+	return index;
+}
+
+// Sample coordinates along each axis, clipped to the grid. The far edge is always included.
+void TerrainQuadtree::getChunkSamples(const TerrainChunk& chunk, std::vector<int>& xs, std::vector<int>& zs) const
+{
+	int cells = resolution - 1;
+	int x1 = std::min(chunk.x + chunk.size, cells);
+	int z1 = std::min(chunk.z + chunk.size, cells);
+
+	xs.clear();
+	zs.clear();
+	for (int s = chunk.x; s < x1; s += chunk.step)
+		xs.push_back(s);
+	xs.push_back(x1);
+	for (int s = chunk.z; s < z1; s += chunk.step)
+		zs.push_back(s);
+	zs.push_back(z1);
+}
+
+// Largest difference between the full grid and the chunk's triangles, split the same way as the index list.
+float TerrainQuadtree::measureError(const TerrainChunk& chunk) const
+{
+	std::vector<int> xs, zs;
+	getChunkSamples(chunk, xs, zs);
+
+	float error = 0.0f;
+	for (size_t j = 0; j + 1 < zs.size(); j++)
+	{
+		int z0 = zs[j], z1 = zs[j + 1];
+		for (size_t i = 0; i + 1 < xs.size(); i++)
+		{
+			int x0 = xs[i], x1 = xs[i + 1];
+			float bl = heights[(size_t)z0 * resolution + x0];
+			float br = heights[(size_t)z0 * resolution + x1];
+			float tl = heights[(size_t)z1 * resolution + x0];
+			float tr = heights[(size_t)z1 * resolution + x1];
+
+			for (int gz = z0; gz <= z1; gz++)
+			{
+				float fz = (float)(gz - z0) / (z1 - z0);
+				const float* row = heights + (size_t)gz * resolution;
+				for (int gx = x0; gx <= x1; gx++)
+				{
+					float fx = (float)(gx - x0) / (x1 - x0);
+					float interpolated = (fz >= fx)
+						? bl + fx * (tr - tl) + fz * (tl - bl)
+						: bl + fx * (br - bl) + fz * (tr - br);
+					error = std::max(error, std::fabs(row[gx] - interpolated));
+				}
+			}
+		}
+	}
+	return error;
+}
+
+// The gap between two neighbouring chunks is bounded by the sum of their errors. Both sides drop a skirt of twice their own error.
+float TerrainQuadtree::getSkirtDepth(const TerrainChunk& chunk) const
+{
+	return 2.0f * chunk.geometricError + minimumSkirtDepth;
+}
+
+void TerrainQuadtree::select(float cameraX, float cameraY, float cameraZ, const TerrainLodSettings& settings, float heightScale, std::vector<int>& selection) const
+{
+	selection.clear();
+	if (chunks.empty())
+		return;
+
+	// Pixels per world unit of error at unit distance.
+	float projection = settings.viewportHeight / (2.0f * tanf(settings.fieldOfView * 0.5f));
+	float maxPixelError = std::max(settings.maxPixelError, 0.01f);
+	int cells = resolution - 1;
+
+	std::vector<int> stack;
+	stack.push_back(0);
+	while (!stack.empty())
+	{
+		int index = stack.back();
+		stack.pop_back();
+		const TerrainChunk& chunk = chunks[index];
+
+		// Distance from the camera to the chunk's bounding box.
+		float x1 = (float)std::min(chunk.x + chunk.size, cells);
+		float z1 = (float)std::min(chunk.z + chunk.size, cells);
+		float dx = std::max(std::max((float)chunk.x - cameraX, cameraX - x1), 0.0f);
+		float dy = std::max(std::max(chunk.minHeight * heightScale - cameraY, cameraY - chunk.maxHeight * heightScale), 0.0f);
+		float dz = std::max(std::max((float)chunk.z - cameraZ, cameraZ - z1), 0.0f);
+		float distance = std::max(sqrtf(dx * dx + dy * dy + dz * dz), 0.001f);
+
+		float pixelError = chunk.geometricError * heightScale * projection / distance;
+		bool hasChildren = chunk.children[0] >= 0 || chunk.children[1] >= 0 || chunk.children[2] >= 0 || chunk.children[3] >= 0;
+
+		if (pixelError > maxPixelError && hasChildren)
+		{
+			for (int c = 3; c >= 0; c--)
+			{
+				if (chunk.children[c] >= 0)
+					stack.push_back(chunk.children[c]);
+			}
+		}
+		else
+		{
+			selection.push_back(index);
+		}
+	}
+}
+
+int TerrainQuadtree::getChunkVertexCount(int chunkIndex) const
+{
+	std::vector<int> xs, zs;
+	getChunkSamples(chunks[chunkIndex], xs, zs);
+	int cols = (int)xs.size();
+	int rows = (int)zs.size();
+	return cols * rows + 2 * cols + 2 * rows;
+}
+
+// Emit two triangles per border segment joining the surface edge to its dropped skirt copy.
+// Borders are walked so that (edge direction x up) points into the chunk, which keeps the grid's winding.
+static void addSkirtStrip(const std::vector<uint16_t>& edge, const std::vector<uint16_t>& skirt, std::vector<uint16_t>& indices)
+{
+	for (size_t i = 0; i + 1 < edge.size(); i++)
+	{
+		indices.push_back(edge[i]);
+		indices.push_back(skirt[i]);
+		indices.push_back(edge[i + 1]);
+
+		indices.push_back(edge[i + 1]);
+		indices.push_back(skirt[i]);
+		indices.push_back(skirt[i + 1]);
+	}
+}
+
+void TerrainQuadtree::buildChunkMesh(int chunkIndex, const float* scaledHeights, const float* normals, float heightScale, TerrainGrid& out) const
+{
+	const TerrainChunk& chunk = chunks[chunkIndex];
+	std::vector<int> xs, zs;
+	getChunkSamples(chunk, xs, zs);
+	int cols = (int)xs.size();
+	int rows = (int)zs.size();
+
+	out.vertices.clear();
+	out.indices16.clear();
+	out.indices32.clear();
+	out.vertices.reserve((size_t)cols * rows + 2 * cols + 2 * rows);
+
+	float increment = 1.0f / (resolution - 1);
+	auto makeVertex = [&](int gx, int gz, float drop) {
+		size_t sample = (size_t)gz * resolution + gx;
+		TerrainVertex vert;
+		vert.position[0] = (float)gx;
+		vert.position[1] = scaledHeights[sample] - drop;
+		vert.position[2] = (float)gz;
+		vert.texture[0] = gx * increment;
+		vert.texture[1] = gz * increment;
+		vert.normal[0] = normals[sample * 3 + 0];
+		vert.normal[1] = normals[sample * 3 + 1];
+		vert.normal[2] = normals[sample * 3 + 2];
+		return vert;
+	};
+
+	// Surface grid, row-major.
+	for (int j = 0; j < rows; j++)
+	{
+		for (int i = 0; i < cols; i++)
+		{
+			out.vertices.push_back(makeVertex(xs[i], zs[j], 0.0f));
+		}
+	}
+
+	std::vector<uint16_t>& indices = out.indices16;
+	indices.reserve((size_t)(cols - 1) * (rows - 1) * 6 + (size_t)(cols + rows) * 12);
+	for (int j = 0; j < rows - 1; j++)
+	{
+		for (int i = 0; i < cols - 1; i++)
+		{
+			uint16_t bottomLeft = (uint16_t)(j * cols + i);
+			uint16_t bottomRight = (uint16_t)(bottomLeft + 1);
+			uint16_t topLeft = (uint16_t)(bottomLeft + cols);
+			uint16_t topRight = (uint16_t)(topLeft + 1);
+
+			indices.push_back(bottomLeft);
+			indices.push_back(topRight);
+			indices.push_back(topLeft);
+
+			indices.push_back(bottomLeft);
+			indices.push_back(bottomRight);
+			indices.push_back(topRight);
+		}
+	}
+
+	// Skirts along the four borders: near z (+x), far z (-x), near x (-z), far x (+z).
+	float drop = getSkirtDepth(chunk) * heightScale;
+	std::vector<uint16_t> edge, skirt;
+	auto addBorder = [&](int startCol, int startRow, int colStep, int rowStep, int count) {
+		edge.clear();
+		skirt.clear();
+		for (int k = 0; k < count; k++)
+		{
+			int i = startCol + k * colStep;
+			int j = startRow + k * rowStep;
+			edge.push_back((uint16_t)(j * cols + i));
+			skirt.push_back((uint16_t)out.vertices.size());
+			out.vertices.push_back(makeVertex(xs[i], zs[j], drop));
+		}
+		addSkirtStrip(edge, skirt, indices);
+	};
+	addBorder(0, 0, 1, 0, cols);
+	addBorder(cols - 1, rows - 1, -1, 0, cols);
+	addBorder(0, rows - 1, 0, -1, rows);
+	addBorder(cols - 1, 0, 0, 1, rows);
+}
+
+TerrainChunkLayout TerrainQuadtree::getChunkLayout(int chunkIndex) const
+{
+	const TerrainChunk& chunk = chunks[chunkIndex];
+	std::vector<int> xs, zs;
+	getChunkSamples(chunk, xs, zs);
+
+	TerrainChunkLayout layout;
+	layout.originX = chunk.x;
+	layout.originZ = chunk.z;
+	layout.lastX = xs.back();
+	layout.lastZ = zs.back();
+	layout.step = chunk.step;
+	layout.columns = (int)xs.size();
+	layout.rows = (int)zs.size();
+	layout.skirtDepth = getSkirtDepth(chunk);
+	return layout;
+}
+
+// Positions are exact sample coordinates, so each vertex finds its unscaled height directly.
+void TerrainQuadtree::buildCompactChunkMesh(int chunkIndex, const float* unitHeights, const float* normals, std::vector<CompactTerrainVertex>& vertices, std::vector<uint16_t>& indices) const
+{
+	TerrainGrid grid;
+	buildChunkMesh(chunkIndex, unitHeights, normals, 1.0f, grid);
+
+	vertices.resize(grid.vertices.size());
+	for (size_t v = 0; v < grid.vertices.size(); v++)
+	{
+		const TerrainVertex& full = grid.vertices[v];
+		size_t sample = (size_t)full.position[2] * resolution + (size_t)full.position[0];
+		CompactTerrainVertex& compact = vertices[v];
+		packOctahedralNormal(full.normal, compact.normal);
+		compact.height = packUnitHeight(unitHeights[sample]);
+		compact.padding = 0;
+	}
+	indices.swap(grid.indices16);
+}
@@ -0,0 +1,232 @@
+// Terrain mesh
+// Quadtree-chunked terrain. All chunks live in one vertex/index buffer pair and are drawn by range.
+#include "TerrainMesh.h"
+#include "TerrainNormals.h"
+#include <algorithm>
+
+TerrainMesh::TerrainMesh(ID3D11Device* device, ID3D11DeviceContext* deviceContext, const std::string& heightmapPath, float lheightScale, int lresolution, int lleafCells, bool lcompactVertices)
+{
+	compact = lcompactVertices;
+	chunkBuffer = nullptr;
+	heightScale = lheightScale;
+	resolution = (lresolution < 2) ? 2 : lresolution;
+	leafCells = lleafCells;
+	heightmap = HeightmapCache::load(heightmapPath);
+	initBuffers(device);
+}
+
+// Release resources.
+TerrainMesh::~TerrainMesh()
+{
+	if (chunkBuffer)
+	{
+		chunkBuffer->Release();
+		chunkBuffer = nullptr;
+	}
+
+	// Run parent deconstructor
+	BaseMesh::~BaseMesh();
+}
+
+void TerrainMesh::initBuffers(ID3D11Device* device)
+{
+	// Resample the heightmap exactly as PlaneMesh does. A missing heightmap gives a flat terrain.
+	TerrainGrid grid;
+	HeightfieldView view;
+	if (heightmap)
+	{
+		view = heightmap->getView(1.0f);
+	}
+	buildTerrainGrid(resolution, view.samples ? &view : nullptr, grid);
+
+	unitHeights.resize(grid.vertices.size());
+	for (size_t i = 0; i < grid.vertices.size(); ++i)
+	{
+		unitHeights[i] = grid.vertices[i].position[1];
+	}
+	quadtree.build(unitHeights.data(), resolution, leafCells);
+
+	std::vector<float> heights, normals;
+	computeScaledField(heights, normals);
+
+	// Lay out every chunk's vertices and indices back to back.
+	const std::vector<TerrainChunk>& chunks = quadtree.getChunks();
+	chunkRanges.resize(chunks.size());
+	vertices.clear();
+	compactVertices.clear();
+	chunkLayouts.clear();
+	std::vector<uint16_t> indices;
+	TerrainGrid chunkGrid;
+	std::vector<CompactTerrainVertex> chunkVertices;
+	std::vector<uint16_t> chunkIndices;
+	for (size_t c = 0; c < chunks.size(); ++c)
+	{
+		if (compact)
+		{
+			quadtree.buildCompactChunkMesh((int)c, unitHeights.data(), normals.data(), chunkVertices, chunkIndices);
+			chunkLayouts.push_back(quadtree.getChunkLayout((int)c));
+		}
+		else
+		{
+			quadtree.buildChunkMesh((int)c, heights.data(), normals.data(), heightScale, chunkGrid);
+			chunkIndices.swap(chunkGrid.indices16);
+		}
+		chunkRanges[c].baseVertex = compact ? (int)compactVertices.size() : (int)vertices.size();
+		chunkRanges[c].startIndex = (int)indices.size();
+		chunkRanges[c].indexCount = (int)chunkIndices.size();
+		if (compact)
+		{
+			compactVertices.insert(compactVertices.end(), chunkVertices.begin(), chunkVertices.end());
+		}
+		else
+		{
+			vertices.insert(vertices.end(), chunkGrid.vertices.begin(), chunkGrid.vertices.end());
+		}
+		indices.insert(indices.end(), chunkIndices.begin(), chunkIndices.end());
+	}
+	vertexCount = compact ? (int)compactVertices.size() : (int)vertices.size();
+	indexCount = (int)indices.size();
+
+	D3D11_BUFFER_DESC vertexBufferDesc, indexBufferDesc;
+	D3D11_SUBRESOURCE_DATA vertexData, indexData;
+
+	// Set up the description of the static vertex buffer.
+	vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
+	vertexBufferDesc.ByteWidth = getVertexStride() * vertexCount;
+	vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	vertexBufferDesc.CPUAccessFlags = 0;
+	vertexBufferDesc.MiscFlags = 0;
+	vertexBufferDesc.StructureByteStride = 0;
+	vertexData.pSysMem = compact ? (const void*)compactVertices.data() : (const void*)vertices.data();
+	vertexData.SysMemPitch = 0;
+	vertexData.SysMemSlicePitch = 0;
+	device->CreateBuffer(&vertexBufferDesc, &vertexData, &vertexBuffer);
+
+	// Chunk indices are local to the chunk, offset by each draw's base vertex.
+	indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
+	indexBufferDesc.ByteWidth = sizeof(uint16_t) * indexCount;
+	indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+	indexBufferDesc.CPUAccessFlags = 0;
+	indexBufferDesc.MiscFlags = 0;
+	indexBufferDesc.StructureByteStride = 0;
+	indexData.pSysMem = indices.data();
+	indexData.SysMemPitch = 0;
+	indexData.SysMemSlicePitch = 0;
+	device->CreateBuffer(&indexBufferDesc, &indexData, &indexBuffer);
+
+	// Chunk layout constants, rewritten before each compact chunk draw.
+	if (compact)
+	{
+		D3D11_BUFFER_DESC chunkBufferDesc = {};
+		chunkBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+		chunkBufferDesc.ByteWidth = sizeof(ChunkBufferType);
+		chunkBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		chunkBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		device->CreateBuffer(&chunkBufferDesc, nullptr, &chunkBuffer);
+	}
+}
+
+// Scaled heights and their normals over the full grid.
+void TerrainMesh::computeScaledField(std::vector<float>& heights, std::vector<float>& normals) const
+{
+	heights.resize(unitHeights.size());
+	for (size_t i = 0; i < unitHeights.size(); ++i)
+	{
+		heights[i] = unitHeights[i] * heightScale;
+	}
+	normals.resize(unitHeights.size() * 3);
+	computeTerrainNormals(heights.data(), resolution, resolution, 1.0f, 1.0f, normals.data(), 3);
+}
+
+// Regenerate every chunk's vertices at the current height scale. Layout never changes, so the buffer is rewritten in place.
+// Compact heights are unscaled, so only their normals change.
+void TerrainMesh::buildVertices()
+{
+	std::vector<float> heights, normals;
+	computeScaledField(heights, normals);
+
+	TerrainGrid chunkGrid;
+	std::vector<CompactTerrainVertex> chunkVertices;
+	std::vector<uint16_t> chunkIndices;
+	for (size_t c = 0; c < chunkRanges.size(); ++c)
+	{
+		if (compact)
+		{
+			quadtree.buildCompactChunkMesh((int)c, unitHeights.data(), normals.data(), chunkVertices, chunkIndices);
+			std::copy(chunkVertices.begin(), chunkVertices.end(), compactVertices.begin() + chunkRanges[c].baseVertex);
+		}
+		else
+		{
+			quadtree.buildChunkMesh((int)c, heights.data(), normals.data(), heightScale, chunkGrid);
+			std::copy(chunkGrid.vertices.begin(), chunkGrid.vertices.end(), vertices.begin() + chunkRanges[c].baseVertex);
+		}
+	}
+}
+
+void TerrainMesh::setHeightScale(ID3D11DeviceContext* deviceContext, float scale)
+{
+	if (scale == heightScale)
+		return;
+
+	heightScale = scale;
+	buildVertices();
+	const void* data = compact ? (const void*)compactVertices.data() : (const void*)vertices.data();
+	deviceContext->UpdateSubresource(vertexBuffer, 0, nullptr, data, 0, 0);
+}
+
+void TerrainMesh::sendData(ID3D11DeviceContext* deviceContext, D3D_PRIMITIVE_TOPOLOGY top)
+{
+	unsigned int stride = getVertexStride();
+	unsigned int offset = 0;
+
+	deviceContext->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
+	deviceContext->IASetIndexBuffer(indexBuffer, DXGI_FORMAT_R16_UINT, 0);
+	deviceContext->IASetPrimitiveTopology(top);
+}
+
+void TerrainMesh::selectLod(const XMFLOAT3& cameraPosition, const TerrainLodSettings& settings, std::vector<int>& selection) const
+{
+	quadtree.select(cameraPosition.x, cameraPosition.y, cameraPosition.z, settings, heightScale, selection);
+}
+
+void TerrainMesh::render(ID3D11DeviceContext* deviceContext, BaseShader* shader, const std::vector<int>& selection)
+{
+	float texelScale = 1.0f / (resolution - 1);
+	for (int chunk : selection)
+	{
+		const ChunkRange& range = chunkRanges[chunk];
+		if (compact)
+		{
+			// SV_VertexID excludes the base vertex, so it is the chunk-local index the layout expects.
+			const TerrainChunkLayout& layout = chunkLayouts[chunk];
+			D3D11_MAPPED_SUBRESOURCE mappedResource;
+			deviceContext->Map(chunkBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+			ChunkBufferType* dataPtr = (ChunkBufferType*)mappedResource.pData;
+			dataPtr->originX = (uint32_t)layout.originX;
+			dataPtr->originZ = (uint32_t)layout.originZ;
+			dataPtr->lastX = (uint32_t)layout.lastX;
+			dataPtr->lastZ = (uint32_t)layout.lastZ;
+			dataPtr->step = (uint32_t)layout.step;
+			dataPtr->columns = (uint32_t)layout.columns;
+			dataPtr->rows = (uint32_t)layout.rows;
+			dataPtr->padding = 0;
+			dataPtr->skirtDepth = layout.skirtDepth;
+			dataPtr->heightScale = heightScale;
+			dataPtr->texelScale = texelScale;
+			dataPtr->padding2 = 0.0f;
+			deviceContext->Unmap(chunkBuffer, 0);
+			deviceContext->VSSetConstantBuffers(1, 1, &chunkBuffer);
+		}
+		shader->renderRange(deviceContext, range.indexCount, range.startIndex, range.baseVertex);
+	}
+}
+
+int TerrainMesh::getSelectionIndexCount(const std::vector<int>& selection) const
+{
+	int count = 0;
+	for (int chunk : selection)
+	{
+		count += chunkRanges[chunk].indexCount;
+	}
+	return count;
+}
@@ -0,0 +1,187 @@
+// Terrain normals
+// Central-difference normals for height grids, with SIMD row kernels.
+#include "TerrainNormals.h"
+#include "CpuFeatures.h"
+#include <cmath>
+
+#if defined(CPU_AVX2_KERNELS)
+#include <immintrin.h>
+#define TERRAIN_NORMALS_AVX2
+#endif
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TERRAIN_NORMALS_SSE2
+#endif
+
+// Per-row constants shared by every kernel.
+struct NormalRow
+{
+	const float* above;
+	const float* centre;
+	const float* below;
+	float invDz;
+	float* out;
+	size_t stride;
+};
+
+// Normal at column x. Scalar reference, also used for the row borders and the SIMD tail.
+static inline void normalAt(const NormalRow& row, int x, int width, float invSpacingX)
+{
+	int left = (x > 0) ? x - 1 : 0;
+	int right = (x < width - 1) ? x + 1 : width - 1;
+	float invDx = (right - left == 2) ? invSpacingX * 0.5f : invSpacingX;
+
+	float dx = (row.centre[right] - row.centre[left]) * invDx;
+	float dz = (row.below[x] - row.above[x]) * row.invDz;
+	float inv = 1.0f / sqrtf((dx * dx + dz * dz) + 1.0f);
+
+	float* n = row.out + (size_t)x * row.stride;
+	n[0] = -dx * inv;
+	n[1] = inv;
+	n[2] = -dz * inv;
+}
+
+// Store lanes of SoA results into the strided xyz output.
+static inline void scatterNormals(const NormalRow& row, int x, const float* nx, const float* ny, const float* nz, int lanes)
+{
+	for (int i = 0; i < lanes; ++i)
+	{
+		float* n = row.out + (size_t)(x + i) * row.stride;
+		n[0] = nx[i];
+		n[1] = ny[i];
+		n[2] = nz[i];
+	}
+}
+
+#if defined(TERRAIN_NORMALS_AVX2)
+CPU_TARGET_AVX2 static int normalRowAVX2(const NormalRow& row, int width, float invSpacingX)
+{
+	const __m256 invDx = _mm256_set1_ps(invSpacingX * 0.5f);
+	const __m256 invDz = _mm256_set1_ps(row.invDz);
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 signMask = _mm256_set1_ps(-0.0f);
+	alignas(32) float nx[8], ny[8], nz[8];
+
+	int x = 1;
+	for (; x + 8 <= width - 1; x += 8)
+	{
+		__m256 dx = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(row.centre + x + 1), _mm256_loadu_ps(row.centre + x - 1)), invDx);
+		__m256 dz = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(row.below + x), _mm256_loadu_ps(row.above + x)), invDz);
+		__m256 lengthSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dz, dz)), one);
+		__m256 inv = _mm256_div_ps(one, _mm256_sqrt_ps(lengthSq));
+
+		_mm256_store_ps(nx, _mm256_mul_ps(_mm256_xor_ps(dx, signMask), inv));
+		_mm256_store_ps(ny, inv);
+		_mm256_store_ps(nz, _mm256_mul_ps(_mm256_xor_ps(dz, signMask), inv));
+		scatterNormals(row, x, nx, ny, nz, 8);
+	}
+	return x;
+}
+#endif
+
+#if defined(TERRAIN_NORMALS_SSE2)
+static int normalRowSSE2(const NormalRow& row, int width, float invSpacingX, int x)
+{
+	const __m128 invDx = _mm_set1_ps(invSpacingX * 0.5f);
+	const __m128 invDz = _mm_set1_ps(row.invDz);
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	alignas(16) float nx[4], ny[4], nz[4];
+
+	for (; x + 4 <= width - 1; x += 4)
+	{
+		__m128 dx = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(row.centre + x + 1), _mm_loadu_ps(row.centre + x - 1)), invDx);
+		__m128 dz = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(row.below + x), _mm_loadu_ps(row.above + x)), invDz);
+		__m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dz, dz)), one);
+		__m128 inv = _mm_div_ps(one, _mm_sqrt_ps(lengthSq));
+
+		_mm_store_ps(nx, _mm_mul_ps(_mm_xor_ps(dx, signMask), inv));
+		_mm_store_ps(ny, inv);
+		_mm_store_ps(nz, _mm_mul_ps(_mm_xor_ps(dz, signMask), inv));
+		scatterNormals(row, x, nx, ny, nz, 4);
+	}
+	return x;
+}
+#endif
+
+static NormalRow makeRow(const float* heights, int width, int height, int y, float spacingZ, float* normals, size_t normalStride)
+{
+	int up = (y > 0) ? y - 1 : 0;
+	int down = (y < height - 1) ? y + 1 : height - 1;
+
+	NormalRow row;
+	row.above = heights + (size_t)up * width;
+	row.centre = heights + (size_t)y * width;
+	row.below = heights + (size_t)down * width;
+	row.invDz = (down == up) ? 0.0f : 1.0f / ((down - up) * spacingZ);
+	row.out = normals + (size_t)y * width * normalStride;
+	row.stride = normalStride;
+	return row;
+}
+
+void computeTerrainNormalsScalar(const float* heights, int width, int height, float spacingX, float spacingZ, float* normals, size_t normalStride)
+{
+	if (!heights || !normals || width <= 0 || height <= 0)
+		return;
+
+	float invSpacingX = (width > 1) ? 1.0f / spacingX : 0.0f;
+	for (int y = 0; y < height; ++y)
+	{
+		NormalRow row = makeRow(heights, width, height, y, spacingZ, normals, normalStride);
+		for (int x = 0; x < width; ++x)
+		{
+			normalAt(row, x, width, invSpacingX);
+		}
+	}
+}
+
+void computeTerrainNormals(const float* heights, int width, int height, float spacingX, float spacingZ, float* normals, size_t normalStride)
+{
+#if defined(TERRAIN_NORMALS_SSE2) || defined(TERRAIN_NORMALS_AVX2)
+	if (!heights || !normals || width <= 0 || height <= 0)
+		return;
+
+	float invSpacingX = (width > 1) ? 1.0f / spacingX : 0.0f;
+#if defined(TERRAIN_NORMALS_AVX2)
+	bool avx2 = useAvx2Kernels();
+#endif
+	for (int y = 0; y < height; ++y)
+	{
+		NormalRow row = makeRow(heights, width, height, y, spacingZ, normals, normalStride);
+
+		// Borders use one-sided differences, so only the interior goes through the vector kernel.
+		normalAt(row, 0, width, invSpacingX);
+		int x = 1;
+#if defined(TERRAIN_NORMALS_AVX2)
+		if (avx2)
+		{
+			x = normalRowAVX2(row, width, invSpacingX);
+		}
+#endif
+#if defined(TERRAIN_NORMALS_SSE2)
+		x = normalRowSSE2(row, width, invSpacingX, x);
+#endif
+		for (; x < width; ++x)
+		{
+			normalAt(row, x, width, invSpacingX);
+		}
+	}
+#else
+	computeTerrainNormalsScalar(heights, width, height, spacingX, spacingZ, normals, normalStride);
+#endif
+}
+
+const char* getTerrainNormalsKernelName()
+{
+#if defined(TERRAIN_NORMALS_AVX2)
+	if (useAvx2Kernels())
+	{
+		return "AVX2";
+	}
+#endif
+#if defined(TERRAIN_NORMALS_SSE2)
+	return "SSE2";
+#else
+	return "Scalar";
+#endif
+}
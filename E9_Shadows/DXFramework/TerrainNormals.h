@@ -0,0 +1,31 @@
+/**
+* \brief Platform-neutral terrain normal generation
+*
+* Derives surface normals from a grid of heights using central differences (one-sided at the borders).
+* Whole rows are processed with SSE2, or AVX2 when useAvx2Kernels() finds the CPU supports it.
+* The scalar version performs the same operations in the same order, so both paths give identical results.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _TERRAINNORMALS_H_
+#define _TERRAINNORMALS_H_
+
+#include <cstddef>
+
+/** \brief Computes unit normals for a row-major height grid
+* @param heights is width * height world-space heights
+* @param spacingX is the world distance between neighbouring columns
+* @param spacingZ is the world distance between neighbouring rows
+* @param normals receives xyz triples. Normal i is written at normals[i * normalStride]
+* @param normalStride is the distance in floats between consecutive normals (3 for packed xyz, 8 for TerrainVertex)
+*/
+void computeTerrainNormals(const float* heights, int width, int height, float spacingX, float spacingZ, float* normals, size_t normalStride);
+
+/// Reference implementation of computeTerrainNormals without SIMD.
+void computeTerrainNormalsScalar(const float* heights, int width, int height, float spacingX, float spacingZ, float* normals, size_t normalStride);
+
+/// Name of the kernel computeTerrainNormals uses on this CPU ("AVX2", "SSE2" or "Scalar").
+const char* getTerrainNormalsKernelName();
+
+#endif
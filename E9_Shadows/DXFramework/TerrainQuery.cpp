@@ -0,0 +1,374 @@
+// Terrain query
+// Bilinear height lookups and pyramid-accelerated raycasts over a height grid.
+#include "TerrainQuery.h"
+#include "MipChain.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TERRAIN_QUERY_SSE2
+#endif
+
+// Roots closer than this to a cell boundary still count, so rays never slip between neighbouring cells.
+static const float boundaryEpsilon = 1e-5f;
+
+void TerrainQuery::build(const float* unitHeights, int lcolumns, int lrows)
+{
+	heights.clear();
+	levels.clear();
+	columns = 0;
+	rows = 0;
+	if (!unitHeights || lcolumns < 2 || lrows < 2)
+		return;
+
+	columns = lcolumns;
+	rows = lrows;
+	heights.assign(unitHeights, unitHeights + (size_t)columns * rows);
+
+	// Level 0 holds the range of each cell's four corners.
+	MinMaxLevel base;
+	base.width = columns - 1;
+	base.height = rows - 1;
+	base.minHeights.resize((size_t)base.width * base.height);
+	base.maxHeights.resize(base.minHeights.size());
+	for (int j = 0; j < base.height; j++)
+	{
+		const float* row0 = heights.data() + (size_t)j * columns;
+		const float* row1 = row0 + columns;
+		for (int i = 0; i < base.width; i++)
+		{
+			size_t cell = (size_t)j * base.width + i;
+			base.minHeights[cell] = std::min(std::min(row0[i], row0[i + 1]), std::min(row1[i], row1[i + 1]));
+			base.maxHeights[cell] = std::max(std::max(row0[i], row0[i + 1]), std::max(row1[i], row1[i + 1]));
+		}
+	}
+	levels.push_back(base);
+
+	// Each further level merges 2x2 blocks of the one below, until a single block covers the grid.
+	while (levels.back().width > 1 || levels.back().height > 1)
+	{
+		const MinMaxLevel& below = levels.back();
+		MinMaxLevel level;
+		level.width = (below.width + 1) / 2;
+		level.height = (below.height + 1) / 2;
+		level.minHeights.resize((size_t)level.width * level.height);
+		level.maxHeights.resize(level.minHeights.size());
+		reduceMinMax(below.minHeights.data(), below.maxHeights.data(), below.width, below.height, level.minHeights.data(), level.maxHeights.data());
+		levels.push_back(level);
+	}
+}
+
+void TerrainQuery::setTransform(float lx, float ly, float lz, float lspacing, float lheightScale)
+{
+	originX = lx;
+	originY = ly;
+	originZ = lz;
+	spacing = (lspacing > 0.0f) ? lspacing : 1.0f;
+	heightScale = lheightScale;
+}
+
+void TerrainQuery::toGrid(float x, float z, float& gx, float& gz) const
+{
+	gx = (x - originX) / spacing;
+	gz = (z - originZ) / spacing;
+}
+
+bool TerrainQuery::contains(float x, float z) const
+{
+	float gx, gz;
+	toGrid(x, z, gx, gz);
+	return columns > 0 && gx >= 0.0f && gz >= 0.0f && gx <= (float)(columns - 1) && gz <= (float)(rows - 1);
+}
+
+// Bilinear unit height at a grid position, clamped to the grid. The SIMD path performs the same operations in the same order.
+float TerrainQuery::sampleUnit(float gx, float gz) const
+{
+	gx = std::min(std::max(gx, 0.0f), (float)(columns - 1));
+	gz = std::min(std::max(gz, 0.0f), (float)(rows - 1));
+	float ix = std::min((float)(int)gx, (float)(columns - 2));
+	float iz = std::min((float)(int)gz, (float)(rows - 2));
+	float fx = gx - ix;
+	float fz = gz - iz;
+
+	const float* row0 = heights.data() + (size_t)iz * columns + (size_t)ix;
+	const float* row1 = row0 + columns;
+	float bottom = row0[0] + (row0[1] - row0[0]) * fx;
+	float top = row1[0] + (row1[1] - row1[0]) * fx;
+	return bottom + (top - bottom) * fz;
+}
+
+float TerrainQuery::getHeight(float x, float z) const
+{
+	if (columns == 0)
+		return originY;
+
+	float gx, gz;
+	toGrid(x, z, gx, gz);
+	return originY + sampleUnit(gx, gz) * heightScale;
+}
+
+void TerrainQuery::getHeightsScalar(const float* xs, const float* zs, float* out, size_t count) const
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		out[i] = getHeight(xs[i], zs[i]);
+	}
+}
+
+void TerrainQuery::getHeights(const float* xs, const float* zs, float* out, size_t count) const
+{
+	size_t i = 0;
+#if defined(TERRAIN_QUERY_SSE2)
+	if (columns > 0)
+	{
+		const __m128 offsetX = _mm_set1_ps(originX);
+		const __m128 offsetZ = _mm_set1_ps(originZ);
+		const __m128 offsetY = _mm_set1_ps(originY);
+		const __m128 cellSize = _mm_set1_ps(spacing);
+		const __m128 scale = _mm_set1_ps(heightScale);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 lastX = _mm_set1_ps((float)(columns - 1));
+		const __m128 lastZ = _mm_set1_ps((float)(rows - 1));
+		const __m128 lastCellX = _mm_set1_ps((float)(columns - 2));
+		const __m128 lastCellZ = _mm_set1_ps((float)(rows - 2));
+		alignas(16) int cellX[4], cellZ[4];
+		alignas(16) float h00[4], h10[4], h01[4], h11[4];
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 gx = _mm_div_ps(_mm_sub_ps(_mm_loadu_ps(xs + i), offsetX), cellSize);
+			__m128 gz = _mm_div_ps(_mm_sub_ps(_mm_loadu_ps(zs + i), offsetZ), cellSize);
+			gx = _mm_min_ps(_mm_max_ps(gx, zero), lastX);
+			gz = _mm_min_ps(_mm_max_ps(gz, zero), lastZ);
+
+			// Positions are non-negative after clamping, so truncation is floor.
+			__m128 ix = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(gx)), lastCellX);
+			__m128 iz = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(gz)), lastCellZ);
+			__m128 fx = _mm_sub_ps(gx, ix);
+			__m128 fz = _mm_sub_ps(gz, iz);
+
+			_mm_store_si128((__m128i*)cellX, _mm_cvttps_epi32(ix));
+			_mm_store_si128((__m128i*)cellZ, _mm_cvttps_epi32(iz));
+			for (int lane = 0; lane < 4; lane++)
+			{
+				const float* row0 = heights.data() + (size_t)cellZ[lane] * columns + (size_t)cellX[lane];
+				const float* row1 = row0 + columns;
+				h00[lane] = row0[0];
+				h10[lane] = row0[1];
+				h01[lane] = row1[0];
+				h11[lane] = row1[1];
+			}
+
+			__m128 bottom = _mm_add_ps(_mm_load_ps(h00), _mm_mul_ps(_mm_sub_ps(_mm_load_ps(h10), _mm_load_ps(h00)), fx));
+			__m128 top = _mm_add_ps(_mm_load_ps(h01), _mm_mul_ps(_mm_sub_ps(_mm_load_ps(h11), _mm_load_ps(h01)), fx));
+			__m128 unit = _mm_add_ps(bottom, _mm_mul_ps(_mm_sub_ps(top, bottom), fz));
+			_mm_storeu_ps(out + i, _mm_add_ps(offsetY, _mm_mul_ps(unit, scale)));
+		}
+	}
+#endif
+	getHeightsScalar(xs + i, zs + i, out + i, count - i);
+}
+
+void TerrainQuery::getNormal(float x, float z, float normal[3]) const
+{
+	normal[0] = 0.0f;
+	normal[1] = 1.0f;
+	normal[2] = 0.0f;
+	if (columns == 0)
+		return;
+
+	float gx, gz;
+	toGrid(x, z, gx, gz);
+	gx = std::min(std::max(gx, 0.0f), (float)(columns - 1));
+	gz = std::min(std::max(gz, 0.0f), (float)(rows - 1));
+	int ix = std::min((int)gx, columns - 2);
+	int iz = std::min((int)gz, rows - 2);
+	float fx = gx - ix;
+	float fz = gz - iz;
+
+	// Partial derivatives of the bilinear patch, in world units.
+	const float* row0 = heights.data() + (size_t)iz * columns + ix;
+	const float* row1 = row0 + columns;
+	float twist = row0[0] - row0[1] - row1[0] + row1[1];
+	float dx = ((row0[1] - row0[0]) + twist * fz) * heightScale / spacing;
+	float dz = ((row1[0] - row0[0]) + twist * fx) * heightScale / spacing;
+
+	float length = sqrtf(dx * dx + dz * dz + 1.0f);
+	normal[0] = -dx / length;
+	normal[1] = 1.0f / length;
+	normal[2] = -dz / length;
+}
+
+// Slab test against a pyramid block. X/Z are in grid units, Y in world units.
+bool TerrainQuery::intersectBlock(int level, int blockX, int blockZ, const float origin[3], const float direction[3], float maxDistance, float& tEnter, float& tExit) const
+{
+	const MinMaxLevel& info = levels[level];
+	size_t block = (size_t)blockZ * info.width + blockX;
+	float low = originY + info.minHeights[block] * heightScale;
+	float high = originY + info.maxHeights[block] * heightScale;
+	if (low > high)
+		std::swap(low, high);
+
+	int size = 1 << level;
+	float boxMin[3] = { (float)(blockX * size), low, (float)(blockZ * size) };
+	float boxMax[3] = { (float)std::min((blockX + 1) * size, columns - 1), high, (float)std::min((blockZ + 1) * size, rows - 1) };
+
+	tEnter = 0.0f;
+	tExit = maxDistance;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if (direction[axis] == 0.0f)
+		{
+			if (origin[axis] < boxMin[axis] || origin[axis] > boxMax[axis])
+				return false;
+			continue;
+		}
+		float inv = 1.0f / direction[axis];
+		float t0 = (boxMin[axis] - origin[axis]) * inv;
+		float t1 = (boxMax[axis] - origin[axis]) * inv;
+		if (t0 > t1)
+			std::swap(t0, t1);
+		tEnter = std::max(tEnter, t0);
+		tExit = std::min(tExit, t1);
+		if (tEnter > tExit)
+			return false;
+	}
+	return true;
+}
+
+// Surface height minus ray height is quadratic across one bilinear cell. Take its first root in range.
+// The polynomial is taken from where the ray enters the cell, so its terms stay small and precise far from the grid origin.
+bool TerrainQuery::intersectCell(int cellX, int cellZ, const float origin[3], const float direction[3], float tEnter, float tExit, float& t) const
+{
+	const float* row0 = heights.data() + (size_t)cellZ * columns + cellX;
+	const float* row1 = row0 + columns;
+	float h00 = row0[0];
+	float a = row0[1] - h00;
+	float b = row1[0] - h00;
+	float c = h00 - row0[1] - row1[0] + row1[1];
+
+	float u0 = origin[0] + direction[0] * tEnter - cellX;
+	float v0 = origin[2] + direction[2] * tEnter - cellZ;
+	float y0 = origin[1] + direction[1] * tEnter;
+	float du = direction[0];
+	float dv = direction[2];
+
+	float qa = heightScale * c * du * dv;
+	float qb = heightScale * (a * du + b * dv + c * (u0 * dv + v0 * du)) - direction[1];
+	float qc = originY + heightScale * (h00 + a * u0 + b * v0 + c * u0 * v0) - y0;
+
+	// Positive means below the surface. A ray already below where it enters the cell, for example through the side of the grid, hits at once.
+	if (qc >= 0.0f)
+	{
+		t = tEnter;
+		return true;
+	}
+
+	float roots[2];
+	int rootCount = 0;
+	if (fabsf(qa) < 1e-12f)
+	{
+		if (qb != 0.0f)
+			roots[rootCount++] = -qc / qb;
+	}
+	else
+	{
+		float discriminant = qb * qb - 4.0f * qa * qc;
+		if (discriminant < 0.0f)
+			return false;
+		// Numerically stable pair: avoids cancellation when qb dominates.
+		float q = -0.5f * (qb + ((qb >= 0.0f) ? sqrtf(discriminant) : -sqrtf(discriminant)));
+		if (q != 0.0f)
+			roots[rootCount++] = qc / q;
+		roots[rootCount++] = q / qa;
+	}
+
+	float span = tExit - tEnter;
+	float tolerance = boundaryEpsilon * std::max(1.0f, span);
+	bool found = false;
+	float first = 0.0f;
+	for (int r = 0; r < rootCount; r++)
+	{
+		if (roots[r] >= -tolerance && roots[r] <= span + tolerance && (!found || roots[r] < first))
+		{
+			first = std::max(roots[r], 0.0f);
+			found = true;
+		}
+	}
+	if (found)
+	{
+		t = tEnter + first;
+	}
+	return found;
+}
+
+bool TerrainQuery::raycast(const float worldOrigin[3], const float worldDirection[3], float maxDistance, TerrainRayHit& hit) const
+{
+	if (levels.empty() || maxDistance <= 0.0f)
+		return false;
+
+	// X/Z move to grid units. t is unchanged, so distances stay in units of the caller's direction.
+	float origin[3] = { (worldOrigin[0] - originX) / spacing, worldOrigin[1], (worldOrigin[2] - originZ) / spacing };
+	float direction[3] = { worldDirection[0] / spacing, worldDirection[1], worldDirection[2] / spacing };
+
+	struct Node { int level, x, z; float tEnter, tExit; };
+	std::vector<Node> stack;
+	stack.reserve(levels.size() * 4);
+
+	int top = (int)levels.size() - 1;
+	Node root = { top, 0, 0, 0.0f, 0.0f };
+	if (!intersectBlock(top, 0, 0, origin, direction, maxDistance, root.tEnter, root.tExit))
+		return false;
+	stack.push_back(root);
+
+	float best = maxDistance;
+	bool found = false;
+	while (!stack.empty())
+	{
+		Node node = stack.back();
+		stack.pop_back();
+		if (node.tEnter > best)
+			continue;
+
+		if (node.level == 0)
+		{
+			float t;
+			if (intersectCell(node.x, node.z, origin, direction, node.tEnter, std::min(node.tExit, best), t) && t <= best)
+			{
+				best = t;
+				found = true;
+			}
+			continue;
+		}
+
+		// Push children far to near, so the nearest is visited first and later ones are usually pruned.
+		const MinMaxLevel& below = levels[node.level - 1];
+		Node children[4];
+		int childCount = 0;
+		for (int c = 0; c < 4; c++)
+		{
+			Node child = { node.level - 1, node.x * 2 + (c & 1), node.z * 2 + (c >> 1), 0.0f, 0.0f };
+			if (child.x < below.width && child.z < below.height
+				&& intersectBlock(child.level, child.x, child.z, origin, direction, best, child.tEnter, child.tExit))
+			{
+				// Insertion sort: at most four children, and std::sort on the fixed array trips -Warray-bounds.
+				int i = childCount++;
+				for (; i > 0 && children[i - 1].tEnter < child.tEnter; i--)
+					children[i] = children[i - 1];
+				children[i] = child;
+			}
+		}
+		stack.insert(stack.end(), children, children + childCount);
+	}
+
+	if (!found)
+		return false;
+
+	hit.distance = best;
+	hit.position[0] = worldOrigin[0] + worldDirection[0] * best;
+	hit.position[1] = worldOrigin[1] + worldDirection[1] * best;
+	hit.position[2] = worldOrigin[2] + worldDirection[2] * best;
+	getNormal(hit.position[0], hit.position[2], hit.normal);
+	return true;
+}
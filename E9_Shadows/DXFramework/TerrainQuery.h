@@ -0,0 +1,94 @@
+/**
+* \class Terrain Query
+*
+* \brief Platform-neutral height, normal and raycast queries against a heightmapped terrain
+*
+* Holds its own copy of a grid of unscaled heights plus a min/max pyramid over its cells.
+* Queries are in world space. setTransform places the grid the same way the terrain's world matrix and height scale do.
+* Heights are interpolated bilinearly between samples. Batched lookups use SSE2 where available.
+* Raycasts walk the pyramid from the top, skipping every node whose height range the ray passes over,
+* so a hit costs O(log n) node tests rather than a walk over every cell the ray crosses.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _TERRAINQUERY_H_
+#define _TERRAINQUERY_H_
+
+#include <cstddef>
+#include <vector>
+
+/// Result of TerrainQuery::raycast. All values are in world space.
+struct TerrainRayHit
+{
+	float distance;		///< Along the ray direction, in units of its length
+	float position[3];
+	float normal[3];
+};
+
+class TerrainQuery
+{
+public:
+	/** \brief Copies a height grid and builds the min/max pyramid
+	* @param unitHeights is columns * rows row-major samples before height scaling. At least 2 x 2
+	*/
+	void build(const float* unitHeights, int columns, int rows);
+
+	/** \brief Places the grid in world space
+	* @param originX, originY and originZ are the world position of sample (0, 0) at zero height
+	* @param spacing is the world distance between neighbouring samples
+	* @param heightScale converts unit heights to world units
+	*/
+	void setTransform(float originX, float originY, float originZ, float spacing, float heightScale);
+
+	/// True if the world X/Z position lies over the grid.
+	bool contains(float x, float z) const;
+
+	/// World height under a world X/Z position. Positions off the grid are clamped to its edge.
+	float getHeight(float x, float z) const;
+
+	/// Heights under many positions at once. Output matches getHeight exactly.
+	void getHeights(const float* xs, const float* zs, float* heights, size_t count) const;
+
+	/// Reference implementation of getHeights without SIMD.
+	void getHeightsScalar(const float* xs, const float* zs, float* heights, size_t count) const;
+
+	/// Unit surface normal of the bilinear surface under a world X/Z position.
+	void getNormal(float x, float z, float normal[3]) const;
+
+	/** \brief Finds the first point where a ray meets the terrain
+	* @param origin and direction are in world space. The direction does not need to be normalised
+	* @param maxDistance limits the hit distance, in units of the direction's length
+	* @return false if the ray misses the grid or leaves it before hitting the surface
+	*/
+	bool raycast(const float origin[3], const float direction[3], float maxDistance, TerrainRayHit& hit) const;
+
+	int getColumns() const { return columns; }
+	int getRows() const { return rows; }
+	int getLevelCount() const { return (int)levels.size(); }
+
+private:
+	/// Height range of blocks of 2^level x 2^level cells.
+	struct MinMaxLevel
+	{
+		int width, height;
+		std::vector<float> minHeights;
+		std::vector<float> maxHeights;
+	};
+
+	void toGrid(float x, float z, float& gx, float& gz) const;
+	float sampleUnit(float gx, float gz) const;
+	bool intersectBlock(int level, int blockX, int blockZ, const float origin[3], const float direction[3], float maxDistance, float& tEnter, float& tExit) const;
+	bool intersectCell(int cellX, int cellZ, const float origin[3], const float direction[3], float tEnter, float tExit, float& t) const;
+
+	std::vector<float> heights;
+	std::vector<MinMaxLevel> levels;
+	int columns = 0;		///< Samples along X
+	int rows = 0;			///< Samples along Z
+
+	float originX = 0.0f, originY = 0.0f, originZ = 0.0f;
+	float spacing = 1.0f;
+	float heightScale = 1.0f;
+};
+
+#endif
@@ -0,0 +1,136 @@
+// Terrain vertex packing
+// Octahedral normals, 16-bit heights and index-to-grid reconstruction for compact terrain vertices.
+#include "TerrainVertexPacking.h"
+#include <algorithm>
+#include <cmath>
+
+static float signNotZero(float value)
+{
+	return (value >= 0.0f) ? 1.0f : -1.0f;
+}
+
+static int16_t packSnorm16(float value)
+{
+	value = std::min(std::max(value, -1.0f), 1.0f);
+	return (int16_t)lrintf(value * 32767.0f);
+}
+
+// Matches the GPU's SNORM conversion, where -32768 and -32767 both map to -1.
+static float unpackSnorm16(int16_t value)
+{
+	return std::max(value / 32767.0f, -1.0f);
+}
+
+// Project onto the octahedron |x| + |y| + |z| = 1, keep X/Z, and fold the lower half over the diagonals.
+void packOctahedralNormal(const float normal[3], int16_t packed[2])
+{
+	float length = fabsf(normal[0]) + fabsf(normal[1]) + fabsf(normal[2]);
+	if (length <= 0.0f)
+	{
+		packed[0] = 0;
+		packed[1] = 0;
+		return;
+	}
+
+	float x = normal[0] / length;
+	float y = normal[1] / length;
+	float z = normal[2] / length;
+	if (y < 0.0f)
+	{
+		float foldedX = (1.0f - fabsf(z)) * signNotZero(x);
+		float foldedZ = (1.0f - fabsf(x)) * signNotZero(z);
+		x = foldedX;
+		z = foldedZ;
+	}
+	packed[0] = packSnorm16(x);
+	packed[1] = packSnorm16(z);
+}
+
+void unpackOctahedralNormal(const int16_t packed[2], float normal[3])
+{
+	float x = unpackSnorm16(packed[0]);
+	float z = unpackSnorm16(packed[1]);
+	float y = 1.0f - fabsf(x) - fabsf(z);
+	if (y < 0.0f)
+	{
+		float unfoldedX = (1.0f - fabsf(z)) * signNotZero(x);
+		float unfoldedZ = (1.0f - fabsf(x)) * signNotZero(z);
+		x = unfoldedX;
+		z = unfoldedZ;
+	}
+
+	float length = sqrtf(x * x + y * y + z * z);
+	normal[0] = x / length;
+	normal[1] = y / length;
+	normal[2] = z / length;
+}
+
+uint16_t packUnitHeight(float height)
+{
+	height = std::min(std::max(height, 0.0f), 1.0f);
+	return (uint16_t)lrintf(height * 65535.0f);
+}
+
+float unpackUnitHeight(uint16_t height)
+{
+	return height / 65535.0f;
+}
+
+void getCompactVertexSample(const TerrainChunkLayout& layout, uint32_t vertexIndex, int& sampleX, int& sampleZ, bool& skirt)
+{
+	int columns = layout.columns;
+	int rows = layout.rows;
+	int i, j;
+
+	uint32_t surfaceCount = (uint32_t)(columns * rows);
+	skirt = vertexIndex >= surfaceCount;
+	if (!skirt)
+	{
+		i = (int)(vertexIndex % columns);
+		j = (int)(vertexIndex / columns);
+	}
+	else
+	{
+		// Borders in buildChunkMesh order: near Z, far Z (reversed), near X (reversed), far X.
+		int k = (int)(vertexIndex - surfaceCount);
+		if (k < columns)
+		{
+			i = k;
+			j = 0;
+		}
+		else if ((k -= columns) < columns)
+		{
+			i = columns - 1 - k;
+			j = rows - 1;
+		}
+		else if ((k -= columns) < rows)
+		{
+			i = 0;
+			j = rows - 1 - k;
+		}
+		else
+		{
+			i = columns - 1;
+			j = k - rows;
+		}
+	}
+
+	sampleX = std::min(layout.originX + i * layout.step, layout.lastX);
+	sampleZ = std::min(layout.originZ + j * layout.step, layout.lastZ);
+}
+
+void decodeCompactTerrainVertex(const CompactTerrainVertex& vertex, uint32_t vertexIndex, const TerrainChunkLayout& layout,
+	float heightScale, float texelScale, TerrainVertex& out)
+{
+	int sampleX, sampleZ;
+	bool skirt;
+	getCompactVertexSample(layout, vertexIndex, sampleX, sampleZ, skirt);
+
+	float height = unpackUnitHeight(vertex.height) - (skirt ? layout.skirtDepth : 0.0f);
+	out.position[0] = (float)sampleX;
+	out.position[1] = height * heightScale;
+	out.position[2] = (float)sampleZ;
+	out.texture[0] = sampleX * texelScale;
+	out.texture[1] = sampleZ * texelScale;
+	unpackOctahedralNormal(vertex.normal, out.normal);
+}
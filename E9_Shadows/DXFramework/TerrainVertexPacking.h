@@ -0,0 +1,56 @@
+/**
+* \brief Platform-neutral compact terrain vertex format
+*
+* A compact vertex stores only what the grid cannot imply: a 16-bit height and an octahedral-packed normal.
+* X/Z position and texture coordinate are rebuilt from the vertex index and the chunk layout, in the vertex shader
+* on the GPU (shaders/terrain_compact.hlsli) and by decodeCompactTerrainVertex on the CPU. Both follow the vertex order
+* of TerrainQuadtree::buildChunkMesh: the chunk grid row-major, then the four skirt borders.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _TERRAINVERTEXPACKING_H_
+#define _TERRAINVERTEXPACKING_H_
+
+#include "TerrainGrid.h"
+#include <cstdint>
+
+/// 8 bytes per vertex, against 32 for TerrainVertex. The padding keeps every element 4-byte aligned for the input assembler.
+struct CompactTerrainVertex
+{
+	int16_t normal[2];		///< Octahedral normal, R16G16_SNORM
+	uint16_t height;		///< Unscaled height, R16_UNORM
+	uint16_t padding;
+};
+
+/// Everything needed to turn a compact vertex index back into a grid sample. Mirrors the shader's chunk constants.
+struct TerrainChunkLayout
+{
+	int originX, originZ;	///< First sample covered by the chunk
+	int lastX, lastZ;		///< Last sample, clipped to the grid edge
+	int step;				///< Sample spacing of the chunk mesh
+	int columns, rows;		///< Surface vertices along X and Z
+	float skirtDepth;		///< Unscaled drop applied to skirt vertices
+};
+
+/// Packs a unit normal into two signed 16-bit values. The +Y hemisphere, where terrain normals live, keeps the most precision.
+/// A round trip stays within 0.01 degrees of the original direction.
+void packOctahedralNormal(const float normal[3], int16_t packed[2]);
+void unpackOctahedralNormal(const int16_t packed[2], float normal[3]);
+
+/// Quantises a 0-1 height to 16 bits and back, within half a step (0.5 / 65535).
+uint16_t packUnitHeight(float height);
+float unpackUnitHeight(uint16_t height);
+
+/** \brief Finds the grid sample behind a compact vertex index
+* @param skirt is set for the skirt copies that follow the chunk surface
+*/
+void getCompactVertexSample(const TerrainChunkLayout& layout, uint32_t vertexIndex, int& sampleX, int& sampleZ, bool& skirt);
+
+/** \brief Expands a compact vertex to the full layout, exactly as the compact vertex shaders do
+* @param texelScale is 1 / (resolution - 1), the texture coordinate step per sample
+*/
+void decodeCompactTerrainVertex(const CompactTerrainVertex& vertex, uint32_t vertexIndex, const TerrainChunkLayout& layout,
+	float heightScale, float texelScale, TerrainVertex& out);
+
+#endif
@@ -0,0 +1,194 @@
+// Texture atlas
+// Packs small textures into padded, mipmapped pages with stb_rect_pack.
+#include "TextureAtlas.h"
+#include <algorithm>
+#include <cstring>
+
+// imgui_draw.cpp compiles its own private copy of the packer, so this one is private too. Being static, the
+// heuristic setter it never calls would warn as unused.
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable: 4505)
+#elif defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-function"
+#endif
+#include "imGUI/stb_rect_pack.h"
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#elif defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+// Copy a texture into its cell, extending its edge texels out through the gutter and the grid rounding.
+static void blitCell(const AtlasSource& source, unsigned char* page, int pageWidth, int cellX, int cellY, int cellWidth, int cellHeight, int gutter)
+{
+	size_t rowBytes = (size_t)source.width * 4;
+	for (int row = 0; row < cellHeight; row++)
+	{
+		int sourceRow = std::min(std::max(row - gutter, 0), source.height - 1);
+		const unsigned char* sourcePixels = source.pixels + sourceRow * rowBytes;
+		unsigned char* destination = page + ((size_t)(cellY + row) * pageWidth + cellX) * 4;
+
+		for (int column = 0; column < gutter; column++)
+		{
+			memcpy(destination + column * 4, sourcePixels, 4);
+		}
+		memcpy(destination + gutter * 4, sourcePixels, rowBytes);
+		for (int column = gutter + source.width; column < cellWidth; column++)
+		{
+			memcpy(destination + column * 4, sourcePixels + rowBytes - 4, 4);
+		}
+	}
+}
+
+// Try to pack every rect into a page. Rects keep their order and say whether they were placed.
+static bool packPage(std::vector<stbrp_rect>& rects, int width, int height, std::vector<stbrp_node>& nodes)
+{
+	stbrp_context context;
+	stbrp_init_target(&context, width, height, nodes.data(), width);
+	return stbrp_pack_rects(&context, rects.data(), (int)rects.size()) != 0;
+}
+
+bool buildTextureAtlas(const std::vector<AtlasSource>& sources, TextureAtlas& atlas, const AtlasSettings& settings)
+{
+	atlas = TextureAtlas();
+	if (settings.mipLevels < 0 || settings.mipLevels > 12 || settings.pageSize <= 0 || (settings.pageSize & (settings.pageSize - 1)) != 0)
+	{
+		return false;
+	}
+
+	// Packing works in grid units of one gutter, which also keeps every coordinate on the grid.
+	int gutter = 1 << settings.mipLevels;
+	int pageUnits = settings.pageSize / gutter;
+	if (pageUnits < 1 || pageUnits > 32768)
+	{
+		return false;
+	}
+
+	// Each cell is the texture rounded up to whole units, plus one unit of gutter each side.
+	atlas.entries.resize(sources.size());
+	std::vector<stbrp_rect> remaining;
+	for (size_t i = 0; i < sources.size(); i++)
+	{
+		const AtlasSource& source = sources[i];
+		if (!source.pixels || source.width <= 0 || source.height <= 0 || source.width > settings.maxTextureSize || source.height > settings.maxTextureSize)
+		{
+			continue;
+		}
+		stbrp_rect rect = {};
+		rect.id = (int)i;
+		rect.w = (stbrp_coord)((source.width + gutter - 1) / gutter + 2);
+		rect.h = (stbrp_coord)((source.height + gutter - 1) / gutter + 2);
+		if (rect.w <= pageUnits && rect.h <= pageUnits)
+		{
+			remaining.push_back(rect);
+		}
+	}
+
+	std::vector<stbrp_node> nodes(pageUnits);
+	while (!remaining.empty())
+	{
+		uint64_t area = 0;
+		int widest = 0, tallest = 0;
+		for (const stbrp_rect& rect : remaining)
+		{
+			area += (uint64_t)rect.w * rect.h;
+			widest = std::max(widest, (int)rect.w);
+			tallest = std::max(tallest, (int)rect.h);
+		}
+
+		// The smallest power of two page that holds everything left, widening before heightening. If even the
+		// largest page does not, it keeps what it could place and the rest go on to the next page.
+		int width = 1, height = 1;
+		for (;;)
+		{
+			bool large = (uint64_t)width * height >= area && width >= widest && height >= tallest;
+			if (large && packPage(remaining, width, height, nodes))
+			{
+				break;
+			}
+			if (width == pageUnits && height == pageUnits)
+			{
+				if (!large)
+				{
+					packPage(remaining, width, height, nodes);
+				}
+				break;
+			}
+			if (width == height)
+			{
+				width *= 2;
+			}
+			else
+			{
+				height *= 2;
+			}
+		}
+
+		// Trimmed to the cells placed. Still whole grid units, so every kept level halves exactly.
+		int usedWidth = 1, usedHeight = 1;
+		for (const stbrp_rect& rect : remaining)
+		{
+			if (rect.was_packed)
+			{
+				usedWidth = std::max(usedWidth, rect.x + rect.w);
+				usedHeight = std::max(usedHeight, rect.y + rect.h);
+			}
+		}
+
+		DecodedTexture page;
+		int pageWidth = usedWidth * gutter;
+		int pageHeight = usedHeight * gutter;
+		size_t total = 0;
+		for (int level = 0; level <= settings.mipLevels; level++)
+		{
+			page.mips.push_back({ total, pageWidth >> level, pageHeight >> level });
+			total += (size_t)(pageWidth >> level) * (pageHeight >> level) * 4;
+		}
+		page.pixels.assign(total, 0);
+
+		std::vector<stbrp_rect> unplaced;
+		for (const stbrp_rect& rect : remaining)
+		{
+			if (!rect.was_packed)
+			{
+				unplaced.push_back(rect);
+				continue;
+			}
+
+			const AtlasSource& source = sources[rect.id];
+			int cellX = rect.x * gutter;
+			int cellY = rect.y * gutter;
+			blitCell(source, page.pixels.data(), pageWidth, cellX, cellY, rect.w * gutter, rect.h * gutter, gutter);
+
+			AtlasEntry& entry = atlas.entries[rect.id];
+			entry.page = (int)atlas.pages.size();
+			entry.x = cellX + gutter;
+			entry.y = cellY + gutter;
+			entry.uvScale[0] = (float)source.width / pageWidth;
+			entry.uvScale[1] = (float)source.height / pageHeight;
+			entry.uvOffset[0] = (float)entry.x / pageWidth;
+			entry.uvOffset[1] = (float)entry.y / pageHeight;
+
+			atlas.stats.sourceTexels += (uint64_t)source.width * source.height;
+			atlas.stats.cellTexels += (uint64_t)rect.w * rect.h * gutter * gutter;
+		}
+		if (unplaced.size() == remaining.size())
+		{
+			break;
+		}
+
+		MipSettings mipSettings;
+		mipSettings.srgb = settings.srgb;
+		mipSettings.threadCount = settings.threadCount;
+		generateMipChain(page.pixels.data(), page.mips.data(), (int)page.mips.size(), mipSettings);
+
+		atlas.stats.pageTexels += (uint64_t)pageWidth * pageHeight;
+		atlas.pages.push_back(std::move(page));
+		remaining.swap(unplaced);
+	}
+	return true;
+}
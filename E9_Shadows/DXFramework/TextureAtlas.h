@@ -0,0 +1,76 @@
+/**
+* \brief Platform-neutral texture atlas builder: packs small RGBA8 textures into pages with mip-safe gutters
+*
+* Draws whose textures share a page bind one shader resource view and sampler, and only change the UV remap
+* (uv * uvScale + uvOffset) between them, so they can be batched.
+* Each texture is surrounded by a gutter of its own edge texels and placed on a grid of 2^mipLevels texels. Every
+* 2x2 box of every kept level then lies within one texture's cell, and each level keeps at least one texel of gutter,
+* so bilinear sampling at the edges never reads a neighbour. Pages only keep mipLevels levels below the top, as the
+* levels after that would mix textures, and are filtered with the box filter, whose footprint the grid accounts for.
+* With mipLevels 2 or more the grid also lines up with 4x4 blocks, so pages can be block-compressed safely.
+* Cells are packed with stb_rect_pack's skyline packer. Each page is packed at the smallest power of two size that
+* holds what is left, up to AtlasSettings::pageSize, then trimmed to the cells placed on it.
+* Draws from a page must keep their UVs within 0 to 1. The remap stands in for the sampler's addressing, so wrap and
+* mirror modes no longer apply, and a UV outside that range samples whatever is next to the texture on the page.
+* Textures that repeat across a surface must be drawn on their own.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _TEXTUREATLAS_H_
+#define _TEXTUREATLAS_H_
+
+#include "TextureDecode.h"
+#include <cstdint>
+#include <vector>
+
+struct AtlasSettings
+{
+	int pageSize = 2048;			///< Largest page width and height. Must be a power of two, and at least the grid
+	int maxTextureSize = 256;		///< Larger textures are left out, to be drawn on their own
+	int mipLevels = 3;				///< Levels below the top that sample without bleeding. Sets the gutter to 2^mipLevels texels
+	bool srgb = true;				///< As MipSettings::srgb
+	int threadCount = 1;			///< As MipSettings::threadCount
+};
+
+/// A texture to pack. RGBA8, rows tightly packed. Only read during the build.
+struct AtlasSource
+{
+	const unsigned char* pixels;
+	int width;
+	int height;
+};
+
+/// Where a texture was placed. UVs from 0 to 1 map into the page with uv * uvScale + uvOffset.
+struct AtlasEntry
+{
+	int page = -1;						///< -1 if the texture was left out
+	int x = 0;							///< Top-left texel of the texture, inside its gutter
+	int y = 0;
+	float uvScale[2] = { 1.f, 1.f };
+	float uvOffset[2] = { 0.f, 0.f };
+};
+
+/// Packing totals, for profiling.
+struct AtlasStats
+{
+	uint64_t sourceTexels = 0;		///< Top-level texels of the packed textures
+	uint64_t cellTexels = 0;		///< The same with gutters and grid rounding
+	uint64_t pageTexels = 0;		///< Top-level texels of every page
+
+	float getEfficiency() const { return pageTexels ? (float)sourceTexels / pageTexels : 0.f; }
+};
+
+struct TextureAtlas
+{
+	std::vector<DecodedTexture> pages;		///< RGBA8, mipLevels + 1 levels each
+	std::vector<AtlasEntry> entries;		///< One per source, in the same order
+	AtlasStats stats;
+};
+
+/** \brief Packs textures into as few pages as fit them
+* @return false if the settings are invalid. Textures that do not fit are left out, not treated as failures
+*/
+bool buildTextureAtlas(const std::vector<AtlasSource>& sources, TextureAtlas& atlas, const AtlasSettings& settings = AtlasSettings());
+
+#endif
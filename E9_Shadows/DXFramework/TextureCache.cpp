@@ -0,0 +1,370 @@
+// Texture cache
+// Writes pre-decoded DDS files, block-compressed or RGBA8, and reuses them while their source is unchanged.
+#include "TextureCache.h"
+#include "AssetPack.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+static const uint32_t ddsMagic = 0x20534444;			// "DDS "
+static const uint32_t textureCacheMagic = 0x43534354;	// "TCSC", in the first reserved word
+static const uint32_t textureCacheVersion = 2;			// 2 writes DX10 headers
+static const uint32_t maxTextureSize = 16384;			// D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION
+
+// DDS_HEADER and DDS_PIXELFORMAT, as laid out on disk after the magic.
+struct DdsPixelFormat
+{
+	uint32_t size;
+	uint32_t flags;
+	uint32_t fourCC;
+	uint32_t rgbBitCount;
+	uint32_t rBitMask, gBitMask, bBitMask, aBitMask;
+};
+
+struct DdsHeader
+{
+	uint32_t size;
+	uint32_t flags;
+	uint32_t height;
+	uint32_t width;
+	uint32_t pitchOrLinearSize;
+	uint32_t depth;
+	uint32_t mipMapCount;
+	uint32_t reserved1[11];		///< Cache magic, version, source size (2 words), source time (2 words)
+	DdsPixelFormat pixelFormat;
+	uint32_t caps;
+	uint32_t caps2;
+	uint32_t caps3;
+	uint32_t caps4;
+	uint32_t reserved2;
+};
+
+// DDS_HEADER_DXT10, after DdsHeader when the fourCC is "DX10". Its fields are the ones D3D11_TEXTURE2D_DESC needs
+// beyond the size and mip count.
+struct DdsHeaderDx10
+{
+	uint32_t dxgiFormat;
+	uint32_t resourceDimension;	///< 3 is D3D11_RESOURCE_DIMENSION_TEXTURE2D
+	uint32_t miscFlag;			///< 4 is a cube map
+	uint32_t arraySize;
+	uint32_t miscFlags2;
+};
+static_assert(sizeof(DdsHeader) == 124, "DDS_HEADER is 124 bytes");
+static_assert(sizeof(DdsHeaderDx10) == 20, "DDS_HEADER_DXT10 is 20 bytes");
+
+static uint32_t makeFourCC(char a, char b, char c, char d)
+{
+	return (uint32_t)(unsigned char)a | ((uint32_t)(unsigned char)b << 8) | ((uint32_t)(unsigned char)c << 16) | ((uint32_t)(unsigned char)d << 24);
+}
+
+static bool getSourceStamp(const std::string& filename, uint64_t& size, int64_t& time)
+{
+	// Packs keep the stamp their files had on disk, so caches built from the loose files stay current.
+	AssetPackEntry packed;
+	if (findPackedFile(filename, &packed))
+	{
+		size = packed.size;
+		time = packed.modifiedTime;
+		return true;
+	}
+
+	std::error_code error;
+	size = (uint64_t)std::filesystem::file_size(filename, error);
+	if (error)
+	{
+		return false;
+	}
+	time = (int64_t)std::filesystem::last_write_time(filename, error).time_since_epoch().count();
+	return !error;
+}
+
+std::string getTextureCacheFilename(const std::string& filename, bool compressed)
+{
+	return filename + (compressed ? ".dds" : ".rgba.dds");
+}
+
+static size_t getFormatLevelSize(int width, int height, uint32_t format)
+{
+	return (format == textureFormatRGBA8) ? (size_t)width * height * 4 : getCompressedSize(width, height, format);
+}
+
+uint32_t chooseBlockFormat(const DecodedTexture& decoded)
+{
+	size_t topLevelSize = decoded.mips.empty() ? 0 : (size_t)decoded.getWidth() * decoded.getHeight() * 4;
+	for (size_t i = 3; i < topLevelSize; i += 4)
+	{
+		if (decoded.pixels[i] != 255)
+		{
+			return blockFormatBC3;
+		}
+	}
+	return blockFormatBC1;
+}
+
+bool buildTextureDds(const DecodedTexture& decoded, uint32_t format, const std::string& sourceFilename, std::vector<unsigned char>& dds, int threadCount)
+{
+	bool compress = format != textureFormatRGBA8;
+	if ((compress && getBlockSize(format) == 0) || decoded.isDds() || decoded.format != textureFormatRGBA8 || decoded.mips.empty()
+		|| (compress && (decoded.getWidth() % 4 != 0 || decoded.getHeight() % 4 != 0)))
+	{
+		return false;
+	}
+
+	DdsHeader header = {};
+	header.size = sizeof(DdsHeader);
+	header.flags = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | (compress ? 0x80000 : 0x8);	// caps, height, width, pixel format, mip count, linear size or pitch
+	header.height = decoded.getHeight();
+	header.width = decoded.getWidth();
+	header.pitchOrLinearSize = compress ? (uint32_t)getCompressedSize(decoded.getWidth(), decoded.getHeight(), format) : (uint32_t)decoded.getWidth() * 4;
+	header.mipMapCount = (uint32_t)decoded.mips.size();
+	header.pixelFormat.size = sizeof(DdsPixelFormat);
+	header.pixelFormat.flags = 0x4;	// fourCC
+	header.pixelFormat.fourCC = makeFourCC('D', 'X', '1', '0');
+	header.caps = 0x1000 | ((decoded.mips.size() > 1) ? (0x8 | 0x400000) : 0);	// texture, complex and mipmap
+
+	DdsHeaderDx10 extension = {};
+	extension.dxgiFormat = format;
+	extension.resourceDimension = 3;
+	extension.arraySize = 1;
+
+	if (!sourceFilename.empty())
+	{
+		uint64_t sourceSize;
+		int64_t sourceTime;
+		if (!getSourceStamp(sourceFilename, sourceSize, sourceTime))
+		{
+			return false;
+		}
+		header.reserved1[0] = textureCacheMagic;
+		header.reserved1[1] = textureCacheVersion;
+		memcpy(&header.reserved1[2], &sourceSize, sizeof(sourceSize));
+		memcpy(&header.reserved1[4], &sourceTime, sizeof(sourceTime));
+	}
+
+	size_t offset = sizeof(ddsMagic) + sizeof(DdsHeader) + sizeof(DdsHeaderDx10);
+	size_t total = offset;
+	for (const TextureMipLevel& level : decoded.mips)
+	{
+		total += getFormatLevelSize(level.width, level.height, format);
+	}
+	dds.resize(total);
+	memcpy(dds.data(), &ddsMagic, sizeof(ddsMagic));
+	memcpy(dds.data() + sizeof(ddsMagic), &header, sizeof(header));
+	memcpy(dds.data() + sizeof(ddsMagic) + sizeof(header), &extension, sizeof(extension));
+
+	for (const TextureMipLevel& level : decoded.mips)
+	{
+		const unsigned char* pixels = decoded.getPixels() + level.offset;
+		size_t levelSize = getFormatLevelSize(level.width, level.height, format);
+		if (compress)
+		{
+			compressImage(pixels, level.width, level.height, format, dds.data() + offset, threadCount);
+		}
+		else
+		{
+			memcpy(dds.data() + offset, pixels, levelSize);
+		}
+		offset += levelSize;
+	}
+	return true;
+}
+
+bool parseDds(const unsigned char* data, size_t size, DecodedTexture& layout, size_t& dataOffset)
+{
+	uint32_t magic = 0;
+	DdsHeader header = {};
+	dataOffset = sizeof(ddsMagic) + sizeof(DdsHeader);
+	if (size < dataOffset)
+	{
+		return false;
+	}
+	memcpy(&magic, data, sizeof(magic));
+	memcpy(&header, data + sizeof(magic), sizeof(header));
+	if (magic != ddsMagic || header.size != sizeof(DdsHeader) || header.caps2 != 0 || header.width == 0 || header.height == 0
+		|| header.width > maxTextureSize || header.height > maxTextureSize)
+	{
+		return false;
+	}
+
+	uint32_t format = 0;
+	const DdsPixelFormat& pixelFormat = header.pixelFormat;
+	uint32_t fourCC = pixelFormat.fourCC;
+	if (!(pixelFormat.flags & 0x4))
+	{
+		// Uncompressed files only in RGBA byte order, which is what both writers and the GPU use.
+		bool rgba = (pixelFormat.flags & 0x41) == 0x41 && pixelFormat.rgbBitCount == 32 && pixelFormat.rBitMask == 0xff
+			&& pixelFormat.gBitMask == 0xff00 && pixelFormat.bBitMask == 0xff0000 && pixelFormat.aBitMask == 0xff000000;
+		format = rgba ? textureFormatRGBA8 : 0;
+	}
+	else if (fourCC == makeFourCC('D', 'X', 'T', '1'))
+	{
+		format = blockFormatBC1;
+	}
+	else if (fourCC == makeFourCC('D', 'X', 'T', '5'))
+	{
+		format = blockFormatBC3;
+	}
+	else if (fourCC == makeFourCC('A', 'T', 'I', '2') || fourCC == makeFourCC('B', 'C', '5', 'U'))
+	{
+		format = blockFormatBC5;
+	}
+	else if (fourCC == makeFourCC('D', 'X', '1', '0') && size - dataOffset >= sizeof(DdsHeaderDx10))
+	{
+		DdsHeaderDx10 extension;
+		memcpy(&extension, data + dataOffset, sizeof(extension));
+		dataOffset += sizeof(extension);
+		bool supported = extension.dxgiFormat == textureFormatRGBA8 || extension.dxgiFormat == blockFormatBC1
+			|| extension.dxgiFormat == blockFormatBC3 || extension.dxgiFormat == blockFormatBC5;
+		if (supported && extension.resourceDimension == 3 && extension.arraySize == 1 && !(extension.miscFlag & 0x4))
+		{
+			format = extension.dxgiFormat;
+		}
+	}
+	if (format == 0)
+	{
+		return false;
+	}
+
+	// The mip count is only meaningful with its flag, and never needs to go past 1x1.
+	int width = (int)header.width, height = (int)header.height;
+	int levels = ((header.flags & 0x20000) && header.mipMapCount > 1) ? (int)std::min<uint32_t>(header.mipMapCount, getMipLevelCount(width, height)) : 1;
+	DecodedTexture parsed;
+	parsed.format = format;
+	size_t total = 0;
+	for (int level = 0; level < levels; level++)
+	{
+		parsed.mips.push_back({ total, width, height });
+		total += getFormatLevelSize(width, height, format);
+		width = std::max(width / 2, 1);
+		height = std::max(height / 2, 1);
+	}
+	if (size - dataOffset < total)
+	{
+		return false;
+	}
+	layout = std::move(parsed);
+	return true;
+}
+
+bool unpackDds(const DecodedTexture& dds, DecodedTexture& out)
+{
+	DecodedTexture unpacked;
+	size_t dataOffset;
+	if (!parseDds(dds.ddsData.data(), dds.ddsData.size(), unpacked, dataOffset))
+	{
+		return false;
+	}
+	const unsigned char* pixels = dds.ddsData.data() + dataOffset;
+	unpacked.pixels.assign(pixels, pixels + unpacked.getPixelsSize());
+	out = std::move(unpacked);
+	return true;
+}
+
+bool isTextureCacheCurrent(const std::string& cacheFilename, const std::string& sourceFilename)
+{
+	MappedFile in;
+	uint32_t magic = 0;
+	DdsHeader header = {};
+	if (!in.open(cacheFilename) || in.getSize() < sizeof(magic) + sizeof(header))
+	{
+		return false;
+	}
+	memcpy(&magic, in.getData(), sizeof(magic));
+	memcpy(&header, in.getData() + sizeof(magic), sizeof(header));
+	if (magic != ddsMagic)
+	{
+		return false;
+	}
+
+	uint64_t sourceSize, cachedSize;
+	int64_t sourceTime, cachedTime;
+	memcpy(&cachedSize, &header.reserved1[2], sizeof(cachedSize));
+	memcpy(&cachedTime, &header.reserved1[4], sizeof(cachedTime));
+	return header.reserved1[0] == textureCacheMagic && header.reserved1[1] == textureCacheVersion
+		&& getSourceStamp(sourceFilename, sourceSize, sourceTime) && sourceSize == cachedSize && sourceTime == cachedTime;
+}
+
+// Write through a temporary file so a cache is never seen half written.
+static bool writeFile(const std::string& filename, const std::vector<unsigned char>& bytes)
+{
+	std::string tempFilename = filename + ".tmp";
+	{
+		std::ofstream out(tempFilename, std::ios::binary | std::ios::trunc);
+		if (!out || !out.write((const char*)bytes.data(), (std::streamsize)bytes.size()))
+		{
+			out.close();
+			std::error_code ignored;
+			std::filesystem::remove(tempFilename, ignored);
+			return false;
+		}
+	}
+	std::error_code error;
+	std::filesystem::rename(tempFilename, filename, error);
+	return !error;
+}
+
+bool compressTextureFile(const std::string& sourceFilename, const std::string& ddsFilename, uint32_t format, std::string& error, int threadCount)
+{
+	// BC5 holds normals or other data, which must be averaged as stored rather than as sRGB colour.
+	MipSettings mipSettings;
+	mipSettings.srgb = format != blockFormatBC5;
+	mipSettings.threadCount = threadCount;
+	DecodedTexture decoded;
+	if (!decodeTexture(sourceFilename, decoded, error, mipSettings))
+	{
+		return false;
+	}
+	if (decoded.isDds())
+	{
+		error = sourceFilename + " is already a DDS file";
+		return false;
+	}
+
+	std::vector<unsigned char> dds;
+	if (!buildTextureDds(decoded, format ? format : chooseBlockFormat(decoded), sourceFilename, dds, threadCount))
+	{
+		error = sourceFilename + ": unknown format or size not a multiple of 4";
+		return false;
+	}
+	if (!writeFile(ddsFilename, dds))
+	{
+		error = "Could not write " + ddsFilename;
+		return false;
+	}
+	return true;
+}
+
+bool loadCachedTexture(const std::string& filename, DecodedTexture& out, std::string& error, bool compress, int threadCount)
+{
+	std::string cacheFilename = getTextureCacheFilename(filename, compress);
+	if (!isDdsFilename(filename) && isTextureCacheCurrent(cacheFilename, filename))
+	{
+		return decodeTexture(cacheFilename, out, error);
+	}
+
+	MipSettings mipSettings;
+	mipSettings.threadCount = threadCount;
+	if (!decodeTexture(filename, out, error, mipSettings))
+	{
+		return false;
+	}
+	if (out.isDds() || out.mappedPixels)
+	{
+		return true;
+	}
+
+	// A failed cache write only costs the next load a decode. Sizes that cannot be block-compressed are cached as RGBA8.
+	uint32_t format = (compress && out.getWidth() % 4 == 0 && out.getHeight() % 4 == 0) ? chooseBlockFormat(out) : textureFormatRGBA8;
+	std::vector<unsigned char> dds;
+	if (buildTextureDds(out, format, filename, dds, threadCount))
+	{
+		writeFile(cacheFilename, dds);
+		if (format != textureFormatRGBA8)
+		{
+			out = DecodedTexture();
+			out.ddsData = std::move(dds);
+		}
+	}
+	return true;
+}
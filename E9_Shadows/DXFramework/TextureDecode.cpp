@@ -0,0 +1,103 @@
+// Texture decode
+// Decodes image files to RGBA8 mip chains off the main thread. stb_image's implementation lives in HeightmapCache.cpp.
+#include "TextureDecode.h"
+#include "BlockCompress.h"
+#include "TextureCache.h"
+#include "stb_image.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+
+bool isDdsFilename(const std::string& filename)
+{
+	if (filename.size() < 4)
+	{
+		return false;
+	}
+	std::string extension = filename.substr(filename.size() - 4);
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)tolower(c); });
+	return extension == ".dds";
+}
+
+size_t DecodedTexture::getLevelSize(size_t level) const
+{
+	const TextureMipLevel& mip = mips[level];
+	return (format == textureFormatRGBA8) ? (size_t)mip.width * mip.height * 4 : getCompressedSize(mip.width, mip.height, format);
+}
+
+size_t DecodedTexture::getPixelsSize() const
+{
+	return mips.empty() ? 0 : mips.back().offset + getLevelSize(mips.size() - 1);
+}
+
+size_t DecodedTexture::getRowPitch(size_t level) const
+{
+	const TextureMipLevel& mip = mips[level];
+	return (format == textureFormatRGBA8) ? (size_t)mip.width * 4 : (size_t)((mip.width + 3) / 4) * getBlockSize(format);
+}
+
+bool decodeImage(const unsigned char* data, size_t size, DecodedTexture& out, std::string& error, const MipSettings& settings)
+{
+	out = DecodedTexture();
+	int width = 0, height = 0, channels = 0;
+	unsigned char* imageData = (size <= INT32_MAX) ? stbi_load_from_memory(data, (int)size, &width, &height, &channels, 4) : nullptr;
+	if (!imageData)
+	{
+		const char* reason = stbi_failure_reason();
+		error = reason ? reason : "Image too large";
+		return false;
+	}
+
+	// Size the whole chain first so the levels are built in one allocation.
+	size_t total = 0;
+	for (int levelWidth = width, levelHeight = height; ; levelWidth = std::max(levelWidth / 2, 1), levelHeight = std::max(levelHeight / 2, 1))
+	{
+		out.mips.push_back({ total, levelWidth, levelHeight });
+		total += (size_t)levelWidth * levelHeight * 4;
+		if (!settings.generateMips || (levelWidth == 1 && levelHeight == 1))
+		{
+			break;
+		}
+	}
+
+	out.pixels.resize(total);
+	memcpy(out.pixels.data(), imageData, (size_t)width * height * 4);
+	stbi_image_free(imageData);
+
+	generateMipChain(out.pixels.data(), out.mips.data(), (int)out.mips.size(), settings);
+	return true;
+}
+
+bool decodeTexture(const std::string& filename, DecodedTexture& out, std::string& error, const MipSettings& settings)
+{
+	std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+	if (!file->open(filename) || file->getSize() == 0)
+	{
+		error = "Could not open " + filename;
+		return false;
+	}
+
+	if (isDdsFilename(filename))
+	{
+		size_t dataOffset;
+		if (parseDds(file->getData(), file->getSize(), out, dataOffset))
+		{
+			out.mappedPixels = file->getData() + dataOffset;
+			out.mappedFile = file;
+		}
+		else
+		{
+			out = DecodedTexture();
+			out.ddsData.assign(file->getData(), file->getData() + file->getSize());
+		}
+		return true;
+	}
+
+	if (!decodeImage(file->getData(), file->getSize(), out, error, settings))
+	{
+		error = filename + ": " + error;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,60 @@
+/**
+* \brief Platform-neutral texture decoding, ready for a single immutable upload
+*
+* Image files (.png, .jpg, .bmp, .tga and the rest of stb_image's formats) are decoded to RGBA8 and given a full
+* mip chain (see MipChain.h), so the main thread only has to create the texture. DDS files are already in GPU formats.
+* Those in the formats textures are created in (see parseDds) are read in place from their mapping, so loading one is
+* just the mapping and the upload. Other DDS files are passed through as raw bytes for the DDS loader.
+* Holds no Direct3D types, so decoding can run and be profiled headless.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _TEXTUREDECODE_H_
+#define _TEXTUREDECODE_H_
+
+#include "ContentHash.h"
+#include "MappedFile.h"
+#include "MipChain.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+const uint32_t textureFormatRGBA8 = 28;		///< DXGI_FORMAT_R8G8B8A8_UNORM
+
+/// Either a mip chain, in one buffer or in a mapped DDS file, or the bytes of a DDS file.
+struct DecodedTexture
+{
+	std::vector<unsigned char> pixels;		///< Every mip level tightly packed, largest first
+	std::vector<TextureMipLevel> mips;
+	uint32_t format = textureFormatRGBA8;	///< textureFormatRGBA8 or a blockFormat value from BlockCompress.h
+	std::vector<unsigned char> ddsData;		///< Whole DDS file, empty for other formats
+	std::shared_ptr<const MappedFile> mappedFile;	///< Keeps mappedPixels alive
+	const unsigned char* mappedPixels = nullptr;	///< The mip levels in place in a mapped DDS file, used instead of pixels
+	ContentKey source;						///< Contents of the file, if the loader hashed it
+
+	bool isDds() const { return !ddsData.empty(); }
+	const unsigned char* getPixels() const { return mappedPixels ? mappedPixels : pixels.data(); }
+	size_t getPixelsSize() const;				///< Bytes of every mip level
+	int getWidth() const { return mips.empty() ? 0 : mips[0].width; }
+	int getHeight() const { return mips.empty() ? 0 : mips[0].height; }
+	size_t getLevelSize(size_t level) const;	///< Bytes of one mip level in pixels
+	size_t getRowPitch(size_t level) const;		///< Bytes per row of pixels, or per row of 4x4 blocks
+};
+
+/** \brief Decodes an image file
+* Chooses the DDS path by extension, like TextureManager::loadTexture.
+* @param error receives the decoder's message on failure
+* @param settings controls the mip chain of non-DDS images
+*/
+bool decodeTexture(const std::string& filename, DecodedTexture& out, std::string& error, const MipSettings& settings = MipSettings());
+
+/// Decodes an image already in memory to RGBA8 and builds its mip chain.
+bool decodeImage(const unsigned char* data, size_t size, DecodedTexture& out, std::string& error, const MipSettings& settings = MipSettings());
+
+/// True if the filename ends in .dds, ignoring case.
+bool isDdsFilename(const std::string& filename);
+
+#endif
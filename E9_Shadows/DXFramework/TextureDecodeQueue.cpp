@@ -0,0 +1,119 @@
+// Texture decode queue
+// Worker threads decode texture files, the owning thread takes the results when it has time to upload them.
+#include "TextureDecodeQueue.h"
+#include <algorithm>
+#include <exception>
+
+TextureDecodeQueue::TextureDecodeQueue(int threadCount, Decoder ldecoder)
+{
+	decoder = ldecoder;
+	if (!decoder)
+	{
+		decoder = [](const std::string& filename, DecodedTexture& texture, std::string& error) { return decodeTexture(filename, texture, error); };
+	}
+	if (threadCount <= 0)
+	{
+		threadCount = (int)std::thread::hardware_concurrency() - 1;
+	}
+	threadCount = std::max(threadCount, 1);
+	for (int i = 0; i < threadCount; i++)
+	{
+		workers.emplace_back(&TextureDecodeQueue::workerLoop, this);
+	}
+}
+
+TextureDecodeQueue::~TextureDecodeQueue()
+{
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		stopping = true;
+		queued.clear();
+	}
+	jobAvailable.notify_all();
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+}
+
+uint32_t TextureDecodeQueue::push(const std::string& filename)
+{
+	std::lock_guard<std::mutex> lock(jobMutex);
+	TextureDecodeResult job;
+	job.id = nextId++;
+	if (nextId == 0)
+	{
+		nextId = 1;
+	}
+	job.filename = filename;
+	queued.push_back(std::move(job));
+	jobAvailable.notify_one();
+	return queued.back().id;
+}
+
+bool TextureDecodeQueue::pop(TextureDecodeResult& result)
+{
+	std::lock_guard<std::mutex> lock(jobMutex);
+	if (finished.empty())
+	{
+		return false;
+	}
+	result = std::move(finished.front());
+	finished.pop_front();
+	return true;
+}
+
+void TextureDecodeQueue::wait()
+{
+	std::unique_lock<std::mutex> lock(jobMutex);
+	jobFinished.wait(lock, [this]() { return queued.empty() && decoding == 0; });
+}
+
+int TextureDecodeQueue::getPendingCount() const
+{
+	std::lock_guard<std::mutex> lock(jobMutex);
+	return (int)(queued.size() + finished.size()) + decoding;
+}
+
+void TextureDecodeQueue::workerLoop()
+{
+	while (true)
+	{
+		TextureDecodeResult job;
+		{
+			std::unique_lock<std::mutex> lock(jobMutex);
+			jobAvailable.wait(lock, [this]() { return stopping || !queued.empty(); });
+			if (stopping)
+			{
+				return;
+			}
+			job = std::move(queued.front());
+			queued.pop_front();
+			decoding++;
+		}
+
+		try
+		{
+			job.succeeded = decoder(job.filename, job.texture, job.error);
+		}
+		catch (const std::exception& exception)
+		{
+			job.error = exception.what();
+		}
+		catch (...)
+		{
+			job.error = "Unknown decode error";
+		}
+		if (!job.succeeded && job.error.empty())
+		{
+			job.error = "Could not decode " + job.filename;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(jobMutex);
+			finished.push_back(std::move(job));
+			decoding--;
+		}
+		jobFinished.notify_all();
+	}
+}
@@ -0,0 +1,81 @@
+/**
+* \class Texture Decode Queue
+*
+* \brief Decodes texture files on a pool of worker threads
+*
+* push() queues a file and returns straight away. Workers decode files in the order they were pushed and keep the
+* results until pop() takes them on the owning thread, in the order the decodes finished. The owner creates the
+* device objects, so it can stop taking results whenever its frame budget runs out.
+* Holds no Direct3D types, so the pool can be driven and benchmarked headless.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _TEXTUREDECODEQUEUE_H_
+#define _TEXTUREDECODEQUEUE_H_
+
+#include "TextureDecode.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// A finished decode, handed out by TextureDecodeQueue::pop.
+struct TextureDecodeResult
+{
+	uint32_t id = 0;			///< Value returned by push(). Never 0
+	std::string filename;
+	bool succeeded = false;
+	DecodedTexture texture;
+	std::string error;
+};
+
+class TextureDecodeQueue
+{
+public:
+	/// Decodes one file, or returns false with an error message. Runs on a worker thread.
+	typedef std::function<bool(const std::string& filename, DecodedTexture& texture, std::string& error)> Decoder;
+
+	/** \brief Starts the worker threads
+	* @param threadCount is the number of workers. 0 uses one per hardware thread, leaving one for the main thread
+	* @param decoder defaults to decodeTexture with default mip settings
+	*/
+	TextureDecodeQueue(int threadCount = 0, Decoder decoder = nullptr);
+
+	/// Drops queued files and waits for decodes already running.
+	~TextureDecodeQueue();
+
+	/// Queues a file and returns its id.
+	uint32_t push(const std::string& filename);
+
+	/// Takes the oldest finished result. Returns false if none is ready.
+	bool pop(TextureDecodeResult& result);
+
+	/// Blocks until every pushed file has finished decoding. Results still have to be popped.
+	void wait();
+
+	/// Files queued, decoding or waiting for pop().
+	int getPendingCount() const;
+
+	int getThreadCount() const { return (int)workers.size(); }
+
+private:
+	void workerLoop();
+
+	Decoder decoder;
+	std::vector<std::thread> workers;
+	mutable std::mutex jobMutex;
+	std::condition_variable jobAvailable;
+	std::condition_variable jobFinished;
+	std::deque<TextureDecodeResult> queued;		///< Waiting for a worker, filename and id only
+	std::deque<TextureDecodeResult> finished;	///< Waiting for pop(), in completion order
+	int decoding = 0;
+	uint32_t nextId = 1;
+	bool stopping = false;
+};
+
+#endif
@@ -1,7 +1,11 @@
 // texture
-// Loads and stores a single texture.
+// Loads and stores textures by name, owning every loaded shader resource view.
 // Handles .dds, .png and .jpg (probably).
 #include "TextureManager.h"
+#include "AssetPack.h"
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
 
 
  //Attempt to load texture. If load fails use default texture.
@@ -13,16 +17,36 @@ TextureManager::TextureManager(ID3D11Device* ldevice, ID3D11DeviceContext* ldevi
 	addDefaultTexture();
 }
 
-void TextureManager::loadTexture(const wchar_t* uid, const wchar_t* filename)
+// Stream paths are narrow, so wide filenames go through the ANSI code page like the C runtime's narrow fopen.
+static std::string toNarrowPath(const wchar_t* filename)
+{
+	int length = WideCharToMultiByte(CP_ACP, 0, filename, -1, NULL, 0, NULL, NULL);
+	if (length <= 1)
+	{
+		return std::string();
+	}
+	std::string narrow(length - 1, '\0');
+	WideCharToMultiByte(CP_ACP, 0, filename, -1, &narrow[0], length, NULL, NULL);
+	return narrow;
+}
+
+// Compression changes what an image decodes to, so compressed and uncompressed loads of a file are kept apart.
+static uint64_t getTextureVariant(const std::string& filename, bool compress)
+{
+	return (compress && !isDdsFilename(filename)) ? 1 : 0;
+}
+
+TextureHandle TextureManager::loadTexture(const wchar_t* uid, const wchar_t* filename)
 {
 	HRESULT result;
+	ID3D11ShaderResourceView* texture = nullptr;
 
 	// check if file exists
 	if (!filename)
 	{
 		//filename = L"../res/DefaultDiffuse.png";
 		MessageBox(NULL, L"Texture filename does not exist", L"ERROR", MB_OK);
-		return;
+		return 0;
 	}
 	// if not set default texture
 	if (!does_file_exist(filename))
@@ -30,7 +54,7 @@ void TextureManager::loadTexture(const wchar_t* uid, const wchar_t* filename)
 		// change default texture
 		//filename = L"../res/DefaultDiffuse.png";
 		MessageBox(NULL, L"Texture filename does not exist", L"ERROR", MB_OK);
-		return;
+		return 0;
 	}
 
 	// check file extension for correct loading function.
@@ -49,52 +73,545 @@ void TextureManager::loadTexture(const wchar_t* uid, const wchar_t* filename)
 		// No extension found
 	}
 
+	// Contents already loaded under another uid or path share that texture.
+	std::string path = toNarrowPath(filename);
+	ContentKey key;
+	if (!hashFile(path, key))
+	{
+		MessageBox(NULL, L"Texture loading error", L"ERROR", MB_OK);
+		return 0;
+	}
+	key.variant = getTextureVariant(path, compressTextures);
+	TextureHandle handle = textures.find(uid);
+	dropPendingLoads(handle);
+	TextureHandle shared = shareTexture(uid, key);
+	if (shared)
+	{
+		return shared;
+	}
+
 	// Load the texture in.
-	if (extension == L"dds")
+	bool cache = (compressTextures || cacheTextures) && extension != L"dds";
+	if (streamTextures || cache)
 	{
-		result = CreateDDSTextureFromFile(device, deviceContext, filename, NULL, &texture);
+		// Decoded here, so streamed textures keep their mip chain. With caching the first load writes the cache,
+		// later ones just map it.
+		DecodedTexture decoded;
+		std::string error;
+		bool decodedFile = cache ? loadCachedTexture(path, decoded, error, compressTextures) : decodeTexture(path, decoded, error);
+		decoded.source = key;
+		handle = decodedFile ? storeTexture(uid, decoded) : 0;
+		if (!handle)
+		{
+			MessageBox(NULL, L"Texture loading error", L"ERROR", MB_OK);
+		}
+		return handle;
 	}
 	else
 	{
-		result = CreateWICTextureFromFile(device, deviceContext, filename, NULL, &texture, 0);
+		// Created from memory rather than from the file, so textures can come from a mounted asset pack.
+		MappedFile file;
+		if (!file.open(path))
+		{
+			result = E_FAIL;
+		}
+		else if (extension == L"dds")
+		{
+			result = CreateDDSTextureFromMemory(device, deviceContext, file.getData(), file.getSize(), NULL, &texture);
+		}
+		else
+		{
+			result = CreateWICTextureFromMemory(device, deviceContext, file.getData(), file.getSize(), NULL, &texture, 0);
+		}
 	}
 	
 	if (FAILED(result))
 	{
 		MessageBox(NULL, L"Texture loading error", L"ERROR", MB_OK);
+		return 0;
 	}
-	else
+	releaseContent(handle);
+	handle = textures.add(uid, texture);
+	addContent(nextContentId++, key, handle);
+	return handle;
+}
+
+TextureHandle TextureManager::addTexture(const wchar_t* uid, DecodedTexture& decoded)
+{
+	if (!uid || (decoded.mips.empty() && !decoded.isDds()))
+	{
+		return 0;
+	}
+
+	// Keyed by the bytes and their layout, so building the same pixels twice shares one texture.
+	if (decoded.source.size == 0)
+	{
+		const unsigned char* bytes = decoded.isDds() ? decoded.ddsData.data() : decoded.getPixels();
+		size_t size = decoded.isDds() ? decoded.ddsData.size() : decoded.getPixelsSize();
+		uint64_t layout[4] = { (uint64_t)decoded.getWidth(), (uint64_t)decoded.getHeight(), decoded.format, decoded.mips.size() };
+		decoded.source.hash = hashContent(bytes, size);
+		decoded.source.size = size;
+		decoded.source.variant = decoded.isDds() ? 0 : hashContent(layout, sizeof(layout));
+	}
+	dropPendingLoads(textures.find(uid));
+	TextureHandle shared = shareTexture(uid, decoded.source);
+	return shared ? shared : storeTexture(uid, decoded);
+}
+
+TextureHandle TextureManager::loadTextureAsync(const wchar_t* uid, const wchar_t* filename)
+{
+	if (!uid || !filename || !does_file_exist(filename))
+	{
+		MessageBox(NULL, L"Texture filename does not exist", L"ERROR", MB_OK);
+		return 0;
+	}
+
+	// Until the upload the name resolves to whatever it held before, or to a reference on the default texture.
+	TextureHandle handle = textures.find(uid);
+	if (!handle)
+	{
+		ID3D11ShaderResourceView* placeholder = textures.get(defaultTexture);
+		placeholder->AddRef();
+		handle = textures.add(uid, placeholder);
+	}
+
+	if (!decodeQueue)
+	{
+		// Workers already decode in parallel, so each compresses on its own thread. Files are hashed first, and
+		// contents already loaded are not decoded again but shared when the result is taken.
+		decodeQueue = new TextureDecodeQueue(0, [this](const std::string& file, DecodedTexture& texture, std::string& error)
+		{
+			bool compress = compressTextures;
+			bool cache = compress || cacheTextures;
+			ContentKey source;
+			if (!hashFile(file, source))
+			{
+				error = "Cannot open " + file;
+				return false;
+			}
+			source.variant = getTextureVariant(file, compress);
+			bool decoded = isContentLoaded(source) || (cache ? loadCachedTexture(file, texture, error, compress, 1) : decodeTexture(file, texture, error));
+			texture.source = source;
+			return decoded;
+		});
+	}
+	dropPendingLoads(handle);
+	decodeJobs[decodeQueue->push(toNarrowPath(filename))] = handle;
+	return handle;
+}
+
+int TextureManager::updateTextures(float budgetMilliseconds)
+{
+	updateResidency();
+	if (!decodeQueue)
+	{
+		return 0;
+	}
+
+	// The budget is checked before each result rather than after an upload, so re-queued decodes are counted too.
+	auto start = std::chrono::steady_clock::now();
+	int uploaded = 0;
+	int taken = 0;
+	TextureDecodeResult result;
+	while (true)
+	{
+		std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		if ((taken > 0 && elapsed.count() >= budgetMilliseconds) || !decodeQueue->pop(result))
+		{
+			break;
+		}
+		taken++;
+
+		// Results for unloaded or reloaded textures are dropped.
+		auto job = decodeJobs.find(result.id);
+		if (job != decodeJobs.end())
+		{
+			TextureHandle handle = job->second;
+			decodeJobs.erase(job);
+			const std::wstring* name = textures.getName(handle);
+			std::wstring uid = name ? *name : std::wstring();
+			bool skipped = result.texture.mips.empty() && !result.texture.isDds();
+			if (!result.succeeded || !name)
+			{
+				MessageBox(NULL, L"Texture loading error", L"ERROR", MB_OK);
+			}
+			else if (!shareTexture(uid, result.texture.source))
+			{
+				if (skipped)
+				{
+					// The worker skipped the decode, but the contents were unloaded since. Decode them after all.
+					decodeJobs[decodeQueue->push(result.filename)] = handle;
+					continue;
+				}
+				if (!storeTexture(uid, result.texture))
+				{
+					MessageBox(NULL, L"Texture loading error", L"ERROR", MB_OK);
+				}
+			}
+			uploaded++;
+		}
+	}
+	return uploaded;
+}
+
+void TextureManager::finishLoading()
+{
+	if (decodeQueue)
+	{
+		decodeQueue->wait();
+		while (decodeQueue->getPendingCount() > 0)
+		{
+			updateTextures(FLT_MAX);
+		}
+	}
+}
+
+int TextureManager::getPendingTextureCount() const
+{
+	return (int)decodeJobs.size();
+}
+
+void TextureManager::setTextureCompression(bool compress)
+{
+	compressTextures = compress;
+}
+
+void TextureManager::setTextureCaching(bool cache)
+{
+	cacheTextures = cache;
+}
+
+void TextureManager::setTextureStreaming(bool stream)
+{
+	streamTextures = stream;
+}
+
+void TextureManager::setTextureBudget(uint64_t bytes)
+{
+	ResidencySettings settings = residency.getSettings();
+	settings.budgetBytes = bytes;
+	residency.setSettings(settings);
+}
+
+bool TextureManager::isTextureLoading(TextureHandle handle) const
+{
+	for (const auto& job : decodeJobs)
+	{
+		if (job.second == handle)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void TextureManager::dropPendingLoads(TextureHandle handle)
+{
+	for (auto job = decodeJobs.begin(); job != decodeJobs.end();)
+	{
+		job = (job->second == handle) ? decodeJobs.erase(job) : std::next(job);
+	}
+}
+
+// Residency levels for a streamed chain. A block-compressed texture's top level must be a multiple of 4 texels, so
+// the levels from the first one that is not stay together as the last residency level.
+static bool getStreamLevels(const DecodedTexture& decoded, std::vector<uint64_t>& levelBytes)
+{
+	levelBytes.clear();
+	for (size_t level = 0; level < decoded.mips.size() && !decoded.isDds(); level++)
+	{
+		const TextureMipLevel& mip = decoded.mips[level];
+		bool canBeTop = decoded.format == textureFormatRGBA8 || (mip.width % 4 == 0 && mip.height % 4 == 0);
+		if (canBeTop)
+		{
+			levelBytes.push_back(decoded.getLevelSize(level));
+		}
+		else if (!levelBytes.empty())
+		{
+			levelBytes.back() += decoded.getLevelSize(level);
+		}
+		else
+		{
+			return false;
+		}
+	}
+	return levelBytes.size() > 1;
+}
+
+// Create a texture and register it under uid as new contents. With streaming on, only the tail of the mip chain is
+// created and the chain is kept for updateResidency to create finer levels from.
+TextureHandle TextureManager::storeTexture(const std::wstring& uid, DecodedTexture& decoded)
+{
+	releaseContent(textures.find(uid));
+
+	std::vector<uint64_t> levelBytes;
+	if (streamTextures)
+	{
+		DecodedTexture unpacked;
+		if (decoded.isDds() && unpackDds(decoded, unpacked))
+		{
+			unpacked.source = decoded.source;
+			decoded = std::move(unpacked);
+		}
+		getStreamLevels(decoded, levelBytes);
+	}
+	bool streamed = levelBytes.size() > 1;
+
+	uint32_t id = nextContentId++;
+	int firstMip = streamed ? residency.addTexture(id, levelBytes) : 0;
+	ID3D11ShaderResourceView* texture = createTexture(decoded, firstMip);
+	if (!texture)
+	{
+		residency.removeTexture(id);
+		return 0;
+	}
+	TextureHandle handle = textures.add(uid, texture);
+	TextureContent& content = addContent(id, decoded.source, handle);
+	if (streamed)
+	{
+		content.streamed = true;
+		content.chain = std::move(decoded);
+	}
+	return handle;
+}
+
+TextureManager::TextureContent& TextureManager::addContent(uint32_t id, const ContentKey& key, TextureHandle handle)
+{
+	TextureContent& content = contents[id];
+	content.key = key;
+	content.handles.push_back(handle);
+	handleContents[handle] = id;
+
+	std::lock_guard<std::mutex> lock(contentMutex);
+	contentIds[key] = id;
+	return content;
+}
+
+// Point uid at the texture already loaded from the same contents. Returns 0 if there is none.
+TextureHandle TextureManager::shareTexture(const std::wstring& uid, const ContentKey& key)
+{
+	// Only this thread changes contentIds, so it can read without the lock.
+	auto found = contentIds.find(key);
+	if (found == contentIds.end())
+	{
+		return 0;
+	}
+
+	uint32_t id = found->second;
+	TextureHandle handle = textures.find(uid);
+	auto current = handleContents.find(handle);
+	if (current != handleContents.end() && current->second == id)
+	{
+		return handle;
+	}
+	releaseContent(handle);
+
+	TextureContent& content = contents[id];
+	ID3D11ShaderResourceView* texture = textures.get(content.handles[0]);
+	texture->AddRef();
+	handle = textures.add(uid, texture);
+	content.handles.push_back(handle);
+	handleContents[handle] = id;
+	return handle;
+}
+
+// Take a handle out of its contents. The last one out frees the kept chain and the residency entry.
+void TextureManager::releaseContent(TextureHandle handle)
+{
+	auto found = handleContents.find(handle);
+	if (found == handleContents.end())
+	{
+		return;
+	}
+
+	uint32_t id = found->second;
+	handleContents.erase(found);
+	TextureContent& content = contents[id];
+	content.handles.erase(std::remove(content.handles.begin(), content.handles.end(), handle), content.handles.end());
+	if (!content.handles.empty())
+	{
+		return;
+	}
+
+	if (content.streamed)
+	{
+		residency.removeTexture(id);
+	}
+	{
+		std::lock_guard<std::mutex> lock(contentMutex);
+		auto key = contentIds.find(content.key);
+		if (key != contentIds.end() && key->second == id)
+		{
+			contentIds.erase(key);
+		}
+	}
+	contents.erase(id);
+}
+
+// Called by decode workers.
+bool TextureManager::isContentLoaded(const ContentKey& key)
+{
+	std::lock_guard<std::mutex> lock(contentMutex);
+	return contentIds.count(key) > 0;
+}
+
+// Apply this frame's residency plan. Each change recreates the texture from its kept chain with a new top level, so
+// evicted levels really leave video memory. A load also uploads the coarser levels again, at most a third extra.
+void TextureManager::updateResidency()
+{
+	if (residency.getTextureCount() == 0)
 	{
-		textureMap.insert(std::make_pair(const_cast<wchar_t*>(uid), texture));
+		return;
+	}
+
+	residency.update(residencyChanges);
+	for (const ResidencyChange& change : residencyChanges)
+	{
+		auto content = contents.find(change.id);
+		ID3D11ShaderResourceView* texture = (content != contents.end()) ? createTexture(content->second.chain, change.mip) : nullptr;
+		if (texture)
+		{
+			// Every handle of the contents takes a reference on the new view.
+			bool held = false;
+			for (TextureHandle handle : content->second.handles)
+			{
+				const std::wstring* uid = textures.getName(handle);
+				if (uid)
+				{
+					if (held)
+					{
+						texture->AddRef();
+					}
+					textures.add(std::wstring(*uid), texture);
+					held = true;
+				}
+			}
+			if (!held)
+			{
+				texture->Release();
+				texture = nullptr;
+			}
+		}
+		if (change.load)
+		{
+			if (texture)
+			{
+				residency.completeLoad(change.id, change.mip);
+			}
+			else
+			{
+				residency.cancelLoad(change.id);
+			}
+		}
 	}
 }
 
-// Release resource.
+// Create an immutable texture with the decoded mip levels from firstMip down, or hand DDS bytes to the DDS loader.
+// Levels mapped from a DDS file are uploaded straight from the mapping.
+ID3D11ShaderResourceView* TextureManager::createTexture(const DecodedTexture& decoded, int firstMip)
+{
+	ID3D11ShaderResourceView* texture = nullptr;
+	if (decoded.isDds())
+	{
+		HRESULT result = CreateDDSTextureFromMemory(device, decoded.ddsData.data(), decoded.ddsData.size(), NULL, &texture);
+		return SUCCEEDED(result) ? texture : nullptr;
+	}
+
+	std::vector<D3D11_SUBRESOURCE_DATA> initData(decoded.mips.size() - firstMip);
+	for (size_t level = firstMip; level < decoded.mips.size(); level++)
+	{
+		initData[level - firstMip].pSysMem = decoded.getPixels() + decoded.mips[level].offset;
+		initData[level - firstMip].SysMemPitch = (UINT)decoded.getRowPitch(level);
+		initData[level - firstMip].SysMemSlicePitch = 0;
+	}
+
+	D3D11_TEXTURE2D_DESC desc = {};
+	desc.Width = decoded.mips[firstMip].width;
+	desc.Height = decoded.mips[firstMip].height;
+	desc.MipLevels = (UINT)initData.size();
+	desc.ArraySize = 1;
+	desc.Format = (DXGI_FORMAT)decoded.format;
+	desc.SampleDesc.Count = 1;
+	desc.Usage = D3D11_USAGE_IMMUTABLE;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+	ID3D11Texture2D* resource = nullptr;
+	HRESULT result = device->CreateTexture2D(&desc, initData.data(), &resource);
+	if (FAILED(result))
+	{
+		return nullptr;
+	}
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC SRVDesc = {};
+	SRVDesc.Format = desc.Format;
+	SRVDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+	SRVDesc.Texture2D.MipLevels = desc.MipLevels;
+	result = device->CreateShaderResourceView(resource, &SRVDesc, &texture);
+	resource->Release();
+	return SUCCEEDED(result) ? texture : nullptr;
+}
+
+// Release resources. The registry releases every loaded texture.
 TextureManager::~TextureManager()
 {
-	if (texture)
+	if (decodeQueue)
+	{
+		delete decodeQueue;
+		decodeQueue = 0;
+	}
+	textures.clear();
+	if (pTexture)
 	{
-		texture->Release();
-		texture = 0;
+		pTexture->Release();
+		pTexture = 0;
 	}
 }
 
 // Return texture as a shader resource.
 ID3D11ShaderResourceView* TextureManager::getTexture(const wchar_t* uid)
 {
-	if (textureMap.find(const_cast<wchar_t*>(uid)) != textureMap.end())
+	return getTexture(uid ? textures.find(uid) : 0);
+}
+
+ID3D11ShaderResourceView* TextureManager::getTexture(TextureHandle handle, int finestMip)
+{
+	ID3D11ShaderResourceView* texture = textures.get(handle);
+	if (!texture)
 	{
-		// texture exists
-		return textureMap.at(const_cast<wchar_t*>(uid));
+		return textures.get(defaultTexture);
 	}
-	else
+	if (residency.getTextureCount() > 0)
 	{
-		return textureMap.at(L"default");
+		auto content = handleContents.find(handle);
+		if (content != handleContents.end())
+		{
+			residency.markUsed(content->second, finestMip);
+		}
+	}
+	return texture;
+}
+
+TextureHandle TextureManager::findTexture(const wchar_t* uid) const
+{
+	return uid ? textures.find(uid) : 0;
+}
+
+void TextureManager::unloadTexture(TextureHandle handle)
+{
+	if (handle != defaultTexture)
+	{
+		dropPendingLoads(handle);
+		releaseContent(handle);
+		textures.remove(handle);
 	}
 }
 
 bool TextureManager::does_file_exist(const wchar_t *fname)
 {
+	if (findPackedFile(toNarrowPath(fname)))
+	{
+		return true;
+	}
 	std::ifstream infile(fname);
 	return infile.good();
 }
@@ -138,8 +655,12 @@ void TextureManager::addDefaultTexture()
 		SRVDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
 		SRVDesc.Texture2D.MipLevels = 1;
 
+		ID3D11ShaderResourceView* texture = nullptr;
 		hr = device->CreateShaderResourceView(pTexture, &SRVDesc, &texture);
-		textureMap.insert(std::make_pair(const_cast < wchar_t*>(L"default"), texture));
+		if (SUCCEEDED(hr))
+		{
+			defaultTexture = textures.add(L"default", texture);
+		}
 	}
 	
 }
\ No newline at end of file
@@ -2,6 +2,13 @@
 // Texture
 // Loads and stores a texture ready for rendering.
 // Handles mipmap generation on load.
+// Textures live in a ResourceRegistry: load once by name, then draw by handle.
+// With compression on, images other than DDS are block-compressed into a DDS cache next to the file on first load.
+// loadTextureAsync decodes on worker threads. updateTextures creates the decoded textures within a per-frame budget.
+// With streaming on, textures start with only their coarse mips in video memory. Finer mips stream in for textures
+// that are drawn and are evicted least recently drawn first to stay within a byte budget (see TextureResidency.h).
+// Files with the same contents share one texture, whatever their uid or path. Each file is hashed before loading.
+// addTexture uploads pixels built in memory, such as the pages of a TextureAtlas.
 
 #ifndef _TEXTUREMANAGER_H_
 #define _TEXTUREMANAGER_H_
@@ -14,31 +21,104 @@
 #include <string>
 #include <fstream>
 #include <vector>
+#include <atomic>
 #include <map>
+#include <mutex>
+#include "ResourceRegistry.h"
+#include "TextureCache.h"
+#include "TextureDecodeQueue.h"
+#include "TextureResidency.h"
 //#include "Texture.h"
 
 using namespace DirectX;
 
+/// Generational handle to a loaded texture. 0 is never valid.
+typedef ResourceHandle TextureHandle;
+
 class TextureManager
 {
 public:
 	TextureManager(ID3D11Device* device, ID3D11DeviceContext* deviceContext);
 	~TextureManager();
 
-	void loadTexture(const wchar_t* uid, const wchar_t* filename);
-	ID3D11ShaderResourceView* getTexture(const wchar_t* uid);
+	TextureHandle loadTexture(const wchar_t* uid, const wchar_t* filename);	///< Replaces any texture with the same uid. Returns 0 on failure
+	TextureHandle addTexture(const wchar_t* uid, DecodedTexture& decoded);	///< Creates a texture from pixels in memory, such as an atlas page. Same rules as loadTexture
+	ID3D11ShaderResourceView* getTexture(const wchar_t* uid);				///< Lookup by name, or the default texture
+	/** \brief Array lookup for the draw loop, or the default texture. Marks streamed textures as used
+	* @param finestMip is the most detailed level the draw can use, such as the level its screen size needs. Streaming
+	* works towards the finest level asked for in a frame, so the default of 0 streams in the full chain
+	*/
+	ID3D11ShaderResourceView* getTexture(TextureHandle handle, int finestMip = 0);
+	TextureHandle findTexture(const wchar_t* uid) const;					///< Handle for a name, or 0
+	void unloadTexture(TextureHandle handle);								///< Releases the texture. The default texture stays
+	const ResourceRegistry<ID3D11ShaderResourceView>& getTextures() const { return textures; }
+
+	/** \brief Queues a texture for decoding on the worker threads
+	* The handle is valid straight away. It draws as the texture already loaded under uid, or the default texture,
+	* until updateTextures uploads the decoded image.
+	* @return the handle, or 0 if the file does not exist
+	*/
+	TextureHandle loadTextureAsync(const wchar_t* uid, const wchar_t* filename);
+	int updateTextures(float budgetMilliseconds = 2.0f);		///< Uploads decoded textures until the budget is spent, taking at least one per call. Returns the number uploaded
+	void finishLoading();									///< Blocks until every queued texture is decoded and uploaded
+	int getPendingTextureCount() const;						///< Textures queued, decoding or waiting for upload
+	bool isTextureLoading(TextureHandle handle) const;
+	void setTextureCompression(bool compress);				///< Applies to loads not yet decoding. Off by default. Implies caching
+	/** \brief Caches decoded images next to their source as RGBA8 DDS files with full mip chains
+	* Later loads map the cache and upload it, instead of decoding the image. Applies to loads not yet decoding. Off by default.
+	*/
+	void setTextureCaching(bool cache);
+
+	/** \brief Keeps the decoded mip chain of each texture loaded afterwards and streams its levels within the budget
+	* Applies to RGBA8 images and to DDS files parseDds handles, with more than one usable level. Off by default.
+	*/
+	void setTextureStreaming(bool stream);
+	void setTextureBudget(uint64_t bytes);					///< Video memory for streamed textures. 256 MB by default
+	const TextureResidency& getResidency() const { return residency; }
 
 private:
 	bool does_file_exist(const wchar_t *fileName);
 	void generateTexture(ID3D11Device* device);
 	void addDefaultTexture();
+	ID3D11ShaderResourceView* createTexture(const DecodedTexture& decoded, int firstMip = 0);
+	TextureHandle storeTexture(const std::wstring& uid, DecodedTexture& decoded);
+	TextureHandle shareTexture(const std::wstring& uid, const ContentKey& key);
+	void releaseContent(TextureHandle handle);
+	bool isContentLoaded(const ContentKey& key);
+	void updateResidency();
+	void dropPendingLoads(TextureHandle handle);
+
+	/// One file's contents and every handle loaded from it. They all hold the same shader resource view.
+	struct TextureContent
+	{
+		ContentKey key;
+		std::vector<TextureHandle> handles;
+		DecodedTexture chain;		///< Kept while streamed, to create finer levels from
+		bool streamed = false;
+	};
+	TextureContent& addContent(uint32_t id, const ContentKey& key, TextureHandle handle);
 
-	ID3D11ShaderResourceView* texture;
 	ID3D11Device* device;
 	ID3D11DeviceContext* deviceContext;
 
-	std::map<wchar_t*, ID3D11ShaderResourceView*> textureMap;
-	ID3D11Texture2D *pTexture;
+	ResourceRegistry<ID3D11ShaderResourceView> textures;
+	TextureHandle defaultTexture = 0;
+	ID3D11Texture2D *pTexture = nullptr;
+
+	std::atomic<bool> compressTextures{ false };		///< Read by decode workers
+	std::atomic<bool> cacheTextures{ false };
+	TextureDecodeQueue* decodeQueue = nullptr;		///< Created by the first asynchronous load
+	std::map<uint32_t, TextureHandle> decodeJobs;	///< Decode id to the handle it will fill. Only the latest load of a handle is kept
+
+	bool streamTextures = false;
+	TextureResidency residency;						///< Ids are content ids
+	std::vector<ResidencyChange> residencyChanges;
+
+	std::map<uint32_t, TextureContent> contents;		///< By content id
+	std::map<TextureHandle, uint32_t> handleContents;
+	std::map<ContentKey, uint32_t> contentIds;		///< Changed on this thread only, under contentMutex for the decode workers
+	std::mutex contentMutex;
+	uint32_t nextContentId = 1;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,211 @@
+// Texture residency
+// Plans mip loads and least-recently-used evictions to keep streamed textures within a memory budget.
+#include "TextureResidency.h"
+#include <algorithm>
+
+TextureResidency::TextureResidency(const ResidencySettings& lsettings)
+{
+	settings = lsettings;
+}
+
+void TextureResidency::setSettings(const ResidencySettings& lsettings)
+{
+	settings = lsettings;
+}
+
+int TextureResidency::addTexture(uint32_t id, const std::vector<uint64_t>& levelBytes)
+{
+	if (levelBytes.empty() || entries.count(id))
+	{
+		return -1;
+	}
+
+	Entry& entry = entries[id];
+	int levels = (int)levelBytes.size();
+	entry.chainBytes.assign(levels + 1, 0);
+	for (int mip = levels - 1; mip >= 0; mip--)
+	{
+		entry.chainBytes[mip] = entry.chainBytes[mip + 1] + levelBytes[mip];
+	}
+
+	// The tail is the longest run of coarse levels within tailBytes, and always includes the last level.
+	entry.tailMip = levels - 1;
+	while (entry.tailMip > 0 && entry.chainBytes[entry.tailMip - 1] <= settings.tailBytes)
+	{
+		entry.tailMip--;
+	}
+	entry.residentMip = entry.tailMip;
+	entry.wantedMip = entry.tailMip;
+	residentBytes += entry.chainBytes[entry.tailMip];
+
+	// Never drawn, so first in line for eviction.
+	entry.lruPosition = lru.insert(lru.end(), id);
+	return entry.residentMip;
+}
+
+void TextureResidency::removeTexture(uint32_t id)
+{
+	auto found = entries.find(id);
+	if (found == entries.end())
+	{
+		return;
+	}
+
+	Entry& entry = found->second;
+	residentBytes -= entry.chainBytes[entry.residentMip];
+	if (entry.loadingMip >= 0)
+	{
+		loadingBytes -= entry.getLevelBytes(entry.loadingMip);
+	}
+	lru.erase(entry.lruPosition);
+	entries.erase(found);
+}
+
+void TextureResidency::markUsed(uint32_t id, int finestMip)
+{
+	auto found = entries.find(id);
+	if (found == entries.end())
+	{
+		return;
+	}
+
+	Entry& entry = found->second;
+	finestMip = std::min(std::max(finestMip, 0), entry.tailMip);
+	entry.wantedMip = (entry.used && entry.lastUsedFrame == frame) ? std::min(entry.wantedMip, finestMip) : finestMip;
+	entry.lastUsedFrame = frame;
+	entry.used = true;
+	lru.splice(lru.begin(), lru, entry.lruPosition);
+}
+
+// Drop the finest resident level. Consecutive evictions of one texture merge into a single change.
+bool TextureResidency::evictLevel(Entry& entry, std::vector<ResidencyChange>& changes)
+{
+	if (entry.loadingMip >= 0 || entry.residentMip >= entry.tailMip)
+	{
+		return false;
+	}
+
+	uint64_t bytes = entry.getLevelBytes(entry.residentMip);
+	entry.residentMip++;
+	residentBytes -= bytes;
+	stats.evictions++;
+	stats.evictedBytes += bytes;
+
+	uint32_t id = *entry.lruPosition;
+	if (!changes.empty() && changes.back().id == id && !changes.back().load)
+	{
+		changes.back().mip = entry.residentMip;
+	}
+	else
+	{
+		changes.push_back({ id, entry.residentMip, false });
+	}
+	return true;
+}
+
+// Evict from the least recently used end until bytes more fit in the budget. Only textures last drawn before
+// olderThan are touched, unless anyAge is set. The cursor carries on from where the last call stopped.
+bool TextureResidency::makeRoom(uint64_t bytes, uint64_t olderThan, bool anyAge, std::list<uint32_t>::reverse_iterator& cursor, std::vector<ResidencyChange>& changes)
+{
+	while (residentBytes + loadingBytes + bytes > settings.budgetBytes)
+	{
+		if (cursor == lru.rend())
+		{
+			return false;
+		}
+		Entry& entry = entries.find(*cursor)->second;
+		if (!anyAge && entry.used && entry.lastUsedFrame >= olderThan)
+		{
+			return false;
+		}
+		if (!evictLevel(entry, changes))
+		{
+			++cursor;
+		}
+	}
+	return true;
+}
+
+void TextureResidency::update(std::vector<ResidencyChange>& changes)
+{
+	changes.clear();
+	auto cursor = lru.rbegin();
+
+	// A lowered budget, or tails added since the last update, may leave too much resident.
+	makeRoom(0, 0, true, cursor, changes);
+
+	// The list is in drawing order, so the walk stops at the first texture not drawn recently.
+	uint64_t plannedBytes = 0;
+	for (uint32_t id : lru)
+	{
+		Entry& entry = entries.find(id)->second;
+		if (!entry.used || frame - entry.lastUsedFrame >= settings.streamFrames)
+		{
+			break;
+		}
+		if (entry.loadingMip >= 0 || entry.residentMip <= entry.wantedMip)
+		{
+			continue;
+		}
+
+		int mip = entry.residentMip - 1;
+		uint64_t bytes = entry.getLevelBytes(mip);
+		if (plannedBytes > 0 && plannedBytes + bytes > settings.streamBytesPerFrame)
+		{
+			break;
+		}
+		if (!makeRoom(bytes, entry.lastUsedFrame, false, cursor, changes))
+		{
+			break;
+		}
+
+		entry.loadingMip = mip;
+		loadingBytes += bytes;
+		plannedBytes += bytes;
+		changes.push_back({ id, mip, true });
+	}
+	frame++;
+}
+
+void TextureResidency::completeLoad(uint32_t id, int mip)
+{
+	auto found = entries.find(id);
+	if (found == entries.end() || found->second.loadingMip != mip)
+	{
+		return;
+	}
+
+	Entry& entry = found->second;
+	uint64_t bytes = entry.getLevelBytes(mip);
+	loadingBytes -= bytes;
+	residentBytes += bytes;
+	entry.residentMip = mip;
+	entry.loadingMip = -1;
+	stats.loads++;
+	stats.loadedBytes += bytes;
+}
+
+void TextureResidency::cancelLoad(uint32_t id)
+{
+	auto found = entries.find(id);
+	if (found == entries.end() || found->second.loadingMip < 0)
+	{
+		return;
+	}
+
+	Entry& entry = found->second;
+	loadingBytes -= entry.getLevelBytes(entry.loadingMip);
+	entry.loadingMip = -1;
+}
+
+int TextureResidency::getResidentMip(uint32_t id) const
+{
+	auto found = entries.find(id);
+	return (found == entries.end()) ? -1 : found->second.residentMip;
+}
+
+bool TextureResidency::isLoading(uint32_t id) const
+{
+	auto found = entries.find(id);
+	return found != entries.end() && found->second.loadingMip >= 0;
+}
@@ -6,41 +6,59 @@
 */
 
 
+#include<cstring>
 #include<string>
 #include"TokenStream.h"
 
 
-bool isValidIdentifier( char c )
+// Ascii from ! to ~.
+static bool isValidIdentifier( unsigned char c )
 {
-    // Ascii from ! to ~.
-    if( ( int )c > 32 && ( int )c < 127 )
-        return true;
-      
-    return false;
+    return c > 32 && c < 127;
 }
 
 
-bool isValidIdentifier( char c, char* delimiters, int totalDelimiters )
+// Line characters: every identifier character plus the space.
+static bool isLineCharacter( unsigned char c )
 {
-    if( delimiters == 0 || totalDelimiters == 0 )
-        return isValidIdentifier( c );
-
-    for( int i = 0; i < totalDelimiters; i++ )
-    {
-        if( c == delimiters[i] )
-            return false;
-    }
-      
-    return true;
+    return c >= 32 && c < 127;
 }
 
 
 TokenStream::TokenStream( )
 {
+    ownsData_ = false;
+    delimitersSet_ = false;
+    defaultDelimiters_ = false;
     ResetStream( );
 }
 
 
+TokenStream::TokenStream( const TokenStream& other )
+{
+    *this = other;
+}
+
+
+// Views into an owned copy have to be rebound to this stream's copy.
+TokenStream& TokenStream::operator=( const TokenStream& other )
+{
+    if( this == &other )
+        return *this;
+
+    startIndex_ = other.startIndex_;
+    endIndex_ = other.endIndex_;
+    storage_ = other.storage_;
+    ownsData_ = other.ownsData_;
+    data_ = ownsData_ ? std::string_view( storage_ ) : other.data_;
+    memcpy( tokenChars_, other.tokenChars_, sizeof( tokenChars_ ) );
+    delimiters_ = other.delimiters_;
+    defaultDelimiters_ = other.defaultDelimiters_;
+    delimitersSet_ = other.delimitersSet_;
+    return *this;
+}
+
+
 void TokenStream::ResetStream( )
 {
     startIndex_ = endIndex_ = 0;
@@ -50,11 +68,66 @@ void TokenStream::ResetStream( )
 void TokenStream::SetTokenStream( char *data )
 {
     ResetStream( );
+    storage_ = data;
+    data_ = storage_;
+    ownsData_ = true;
+}
+
+
+void TokenStream::SetTokenStream( std::string_view data )
+{
+    ResetStream( );
+    storage_.clear( );
     data_ = data;
+    ownsData_ = false;
 }
 
 
-bool TokenStream::GetNextToken( std::string* buffer, char* delimiters, int totalDelimiters )
+void TokenStream::SetDelimiters( const char* delimiters, int totalDelimiters )
+{
+    bool useDefault = ( delimiters == 0 || totalDelimiters == 0 );
+
+    if( delimitersSet_ && useDefault == defaultDelimiters_ && ( useDefault ||
+        ( delimiters_.length( ) == ( size_t )totalDelimiters && memcmp( delimiters_.data( ), delimiters, totalDelimiters ) == 0 ) ) )
+    {
+        return;
+    }
+
+    delimitersSet_ = true;
+    defaultDelimiters_ = useDefault;
+
+    if( useDefault )
+    {
+        delimiters_.clear( );
+        for( int i = 0; i < 256; i++ )
+            tokenChars_[i] = isValidIdentifier( ( unsigned char )i );
+    }
+    else
+    {
+        delimiters_.assign( delimiters, totalDelimiters );
+        for( int i = 0; i < 256; i++ )
+            tokenChars_[i] = true;
+        for( int i = 0; i < totalDelimiters; i++ )
+            tokenChars_[( unsigned char )delimiters[i]] = false;
+    }
+}
+
+
+bool TokenStream::GetNextToken( std::string* buffer, const char* delimiters, int totalDelimiters )
+{
+    std::string_view token;
+
+    if( !GetNextToken( token, delimiters, totalDelimiters ) )
+        return false;
+
+    if( buffer != NULL )
+        buffer->assign( token.data( ), token.length( ) );
+
+    return true;
+}
+
+
+bool TokenStream::GetNextToken( std::string_view& token, const char* delimiters, int totalDelimiters )
 {
     startIndex_ = endIndex_;
 
@@ -64,42 +137,30 @@ bool TokenStream::GetNextToken( std::string* buffer, char* delimiters, int total
     if( startIndex_ >= length - 1 )
         return false;
 
-    while( startIndex_ < length && isValidIdentifier( data_[startIndex_],
-        delimiters, totalDelimiters ) == false )
+    SetDelimiters( delimiters, totalDelimiters );
+    const char* data = data_.data( );
+
+    while( startIndex_ < length && tokenChars_[( unsigned char )data[startIndex_]] == false )
     {
         startIndex_++;
     }
 
     endIndex_ = startIndex_ + 1;
 
-    if( data_[startIndex_] == '"' )
-        inString = !inString;
-
     if( startIndex_ < length )
     {
-        while( endIndex_ < length && ( isValidIdentifier( data_[endIndex_], delimiters,
-            totalDelimiters ) || inString == true ) )
+        if( data[startIndex_] == '"' )
+            inString = !inString;
+
+        while( endIndex_ < length && ( tokenChars_[( unsigned char )data[endIndex_]] || inString == true ) )
         {
-            if( data_[endIndex_] == '"' )
+            if( data[endIndex_] == '"' )
                 inString = !inString;
 
             endIndex_++;
         }
 
-        if( buffer != NULL )
-        {
-            int size = ( endIndex_ - startIndex_ );
-            int index = startIndex_;
-
-            buffer->reserve( size + 1 );
-            buffer->clear( );
-
-            for( int i = 0; i < size; i++ )
-            {
-                buffer->push_back( data_[index++] );
-            }
-        }
-
+        token = data_.substr( startIndex_, endIndex_ - startIndex_ );
         return true;
     }
 
@@ -108,15 +169,29 @@ bool TokenStream::GetNextToken( std::string* buffer, char* delimiters, int total
 
 
 bool TokenStream::MoveToNextLine( std::string* buffer )
+{
+    std::string_view line;
+
+    if( !MoveToNextLine( line ) )
+        return false;
+
+    if( buffer != NULL )
+        buffer->assign( line.data( ), line.length( ) );
+
+    return true;
+}
+
+
+bool TokenStream::MoveToNextLine( std::string_view& line )
 {
     int length = ( int )data_.length( );
 
     if( startIndex_ < length && endIndex_ < length )
     {
+        const char* data = data_.data( );
         endIndex_ = startIndex_;
 
-        while( endIndex_ < length && ( isValidIdentifier( data_[endIndex_] ) ||
-            data_[endIndex_] == ' ' ) )
+        while( endIndex_ < length && isLineCharacter( ( unsigned char )data[endIndex_] ) )
         {
             endIndex_++;
         }
@@ -127,19 +202,7 @@ bool TokenStream::MoveToNextLine( std::string* buffer )
         if( endIndex_ - startIndex_ >= length )
             return false;
 
-        if( buffer != NULL )
-        {
-            int size = ( endIndex_ - startIndex_ );
-            int index = startIndex_;
-
-            buffer->reserve( size + 1 );
-            buffer->clear( );
-
-            for( int i = 0; i < size; i++ )
-            {
-                buffer->push_back( data_[index++] );
-            }
-        }
+        line = data_.substr( startIndex_, endIndex_ - startIndex_ );
     }
     else
     {
@@ -150,4 +213,4 @@ bool TokenStream::MoveToNextLine( std::string* buffer )
     startIndex_ = endIndex_ + 1;
 
    return true;
-}
\ No newline at end of file
+}
@@ -0,0 +1,64 @@
+// Vertex weld
+// Merges exact duplicate vertices through an open-addressing hash table.
+#include "VertexWeld.h"
+#include <cstring>
+
+namespace
+{
+	const uint32_t emptySlot = 0xFFFFFFFF;
+
+	// Mixes the raw bits of every float, so -0 and 0 stay distinct just as memcmp sees them.
+	inline uint32_t hashVertex(const ObjVertex& vertex)
+	{
+		uint32_t words[sizeof(ObjVertex) / sizeof(uint32_t)];
+		memcpy(words, &vertex, sizeof(words));
+
+		uint64_t hash = 0x9E3779B97F4A7C15ull;
+		for (uint32_t word : words)
+		{
+			hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+		}
+		hash ^= hash >> 32;
+		return (uint32_t)hash;
+	}
+}
+
+void weldVertices(const std::vector<ObjVertex>& vertices, std::vector<ObjVertex>& uniqueVertices, std::vector<uint32_t>& indices)
+{
+	uniqueVertices.clear();
+	indices.resize(vertices.size());
+
+	// At most half full, which keeps probe chains short even when nothing welds.
+	size_t capacity = 16;
+	while (capacity < vertices.size() * 2)
+	{
+		capacity *= 2;
+	}
+	std::vector<uint32_t> slots(capacity, emptySlot);
+	size_t mask = capacity - 1;
+	uniqueVertices.reserve(vertices.size() / 2);
+
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		const ObjVertex& vertex = vertices[i];
+		size_t slot = hashVertex(vertex) & mask;
+		while (true)
+		{
+			uint32_t index = slots[slot];
+			if (index == emptySlot)
+			{
+				index = (uint32_t)uniqueVertices.size();
+				slots[slot] = index;
+				uniqueVertices.push_back(vertex);
+				indices[i] = index;
+				break;
+			}
+			if (memcmp(&uniqueVertices[index], &vertex, sizeof(ObjVertex)) == 0)
+			{
+				indices[i] = index;
+				break;
+			}
+			slot = (slot + 1) & mask;
+		}
+	}
+}
@@ -0,0 +1,27 @@
+/**
+* \brief Platform-neutral vertex welding
+*
+* Merges bitwise identical vertices of an unrolled triangle list and builds the index list that draws it.
+* OBJ corners sharing the same v/vt/vn triple always resolve to identical vertices, so they are welded, along with any
+* other exact duplicates. Lookups use an open-addressing hash table with linear probing that stores only vertex indices.
+* Holds no Direct3D types.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _VERTEXWELD_H_
+#define _VERTEXWELD_H_
+
+#include "ObjLoader.h"
+#include <cstdint>
+#include <vector>
+
+/** \brief Welds identical vertices
+* Output vertices keep the order of their first use, so the result is the same on every run.
+* @param vertices is the unrolled vertex list, three per triangle
+* @param uniqueVertices receives one copy of each distinct vertex
+* @param indices receives one index per input vertex into uniqueVertices
+*/
+void weldVertices(const std::vector<ObjVertex>& vertices, std::vector<ObjVertex>& uniqueVertices, std::vector<uint32_t>& indices);
+
+#endif
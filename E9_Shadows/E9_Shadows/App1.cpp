@@ -10,19 +10,25 @@
  */
 
 #include "App1.h"
-#include "PlaneMesh.h"
+#include "TerrainMesh.h"
+
+// Terrain world placement, shared by every pass and the LOD camera transform
+static const XMFLOAT3 terrainOffset(-50.f, 0.f, -10.f);
 
  // Constructor
 App1::App1()
 {
     // Initialize main pointers to nullptr
-    mesh = nullptr;
+    terrain = nullptr;
     cubeMesh = nullptr;
     sphereMesh = nullptr;
     model = nullptr;
+    modelQueue = nullptr;
     textureShader = nullptr;
     shadowShader = nullptr;
     depthShader = nullptr;
+    terrainDepthShader = nullptr;
+    terrainShadowShader = nullptr;
     light = nullptr;
     spotLight = nullptr;
     shadowMap = nullptr;
@@ -43,13 +49,17 @@ App1::App1()
 App1::~App1()
 {
     // Safe deletes/releases
-    delete mesh;
+    delete terrain;
     delete cubeMesh;
     delete sphereMesh;
+    // Models cancel their loads, so they go before the queue
     delete model;
+    delete modelQueue;
     delete textureShader;
     delete shadowShader;
     delete depthShader;
+    delete terrainDepthShader;
+    delete terrainShadowShader;
     delete light;
     delete spotLight;
     delete shadowMap;
@@ -108,12 +118,28 @@ void App1::createPostProcessRenderTarget(int width, int height)
 // Initialization
 void App1::init(HINSTANCE hinstance, HWND hwnd, int screenWidth, int screenHeight, Input* in, bool VSYNC, bool FULL_SCREEN)
 {
+    // Assets come from res.pack when one has been built (PackBuilder res.pack . res), otherwise from loose files
+    mountAssetPack("res.pack");
+
     BaseApplication::init(hinstance, hwnd, screenWidth, screenHeight, in, VSYNC, FULL_SCREEN);
 
     // Load meshes and models
-    mesh = new PlaneMesh(renderer->getDevice(), renderer->getDeviceContext(), "res/height.png", heightScale, 300);
-    model = new AModel(renderer->getDevice(), "res/teapot.obj");
-    textureMgr->loadTexture(L"brick", L"res/brick1.dds");
+    // Compact vertices: height and normal only, X/Z and UVs rebuilt from the vertex index in the terrain shaders
+    terrain = new TerrainMesh(renderer->getDevice(), renderer->getDeviceContext(), "res/height.png", heightScale, 300, 32, true);
+
+    // Query copy of the terrain heights, placed like the rendered terrain
+    terrainQuery.build(terrain->getUnitHeights().data(), terrain->getResolution(), terrain->getResolution());
+    terrainQuery.setTransform(terrainOffset.x, terrainOffset.y, terrainOffset.z, 1.0f, heightScale);
+
+    // Models import on worker threads and draw a placeholder box until they arrive
+    modelQueue = new ModelLoadQueue(loadModelArrays);
+    model = new AsyncModel(renderer->getDevice(), modelQueue, "res/teapot.obj");
+    // Images other than DDS are block-compressed and cached on first load
+    textureMgr->setTextureCompression(true);
+    // Mip chains stream in as textures are drawn, within a 256 MB budget
+    textureMgr->setTextureStreaming(true);
+    // Decodes on worker threads, drawing as the default texture until BaseApplication::frame uploads it
+    brickTexture = textureMgr->loadTextureAsync(L"brick", L"res/brick1.dds");
     cubeMesh = new CubeMesh(renderer->getDevice(), renderer->getDeviceContext());
     sphereMesh = new SphereMesh(renderer->getDevice(), renderer->getDeviceContext());
 
@@ -121,6 +147,8 @@ void App1::init(HINSTANCE hinstance, HWND hwnd, int screenWidth, int screenHeigh
     textureShader = new TextureShader(renderer->getDevice(), hwnd);
     depthShader = new DepthShader(renderer->getDevice(), hwnd);
     shadowShader = new ShadowShader(renderer->getDevice(), hwnd);
+    terrainDepthShader = new DepthShader(renderer->getDevice(), hwnd, true);
+    terrainShadowShader = new ShadowShader(renderer->getDevice(), hwnd, true);
 
     // Rasterizer state for shadow mapping
     D3D11_RASTERIZER_DESC rasterDesc = {};
@@ -169,18 +197,22 @@ void App1::init(HINSTANCE hinstance, HWND hwnd, int screenWidth, int screenHeigh
 
 bool App1::frame()
 {
+    // Swap in any models that finished importing since the last frame
+    modelQueue->update();
+
     // Animate teapot
     teapotAngle += 0.01f;
     if (teapotAngle > XM_2PI) teapotAngle -= XM_2PI;
 
-    // Heightmap live reload
+    // Heightmap scale update, rewritten in place (heightmap stays cached)
     if (heightScale != prevHeightScale) {
-        delete mesh;
-        mesh = new PlaneMesh(renderer->getDevice(), renderer->getDeviceContext(), "res/height.png", heightScale, 300);
+        terrain->setHeightScale(renderer->getDeviceContext(), heightScale);
+        terrainQuery.setTransform(terrainOffset.x, terrainOffset.y, terrainOffset.z, 1.0f, heightScale);
         prevHeightScale = heightScale;
     }
 
     if (!BaseApplication::frame()) return false;
+    updateTerrainQueries();
     if (!render()) return false;
     return true;
 }
@@ -203,11 +235,10 @@ void App1::depthPass()
     XMMATRIX lightProjectionMatrix = light->getOrthoMatrix();
     XMMATRIX worldMatrix;
 
-    // Floor
-    worldMatrix = XMMatrixTranslation(-50.f, 0.f, -10.f);
-    mesh->sendData(renderer->getDeviceContext());
-    depthShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, lightViewMatrix, lightProjectionMatrix);
-    depthShader->render(renderer->getDeviceContext(), mesh->getIndexCount());
+    // Floor, at a coarser LOD than the camera view
+    worldMatrix = XMMatrixTranslation(terrainOffset.x, terrainOffset.y, terrainOffset.z);
+    terrainDepthShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, lightViewMatrix, lightProjectionMatrix);
+    renderTerrain(terrainDepthShader, terrainPixelError * shadowLodBias);
 
     // Teapot
     XMMATRIX scaleMatrix = XMMatrixScaling(0.5f, 0.5f, 0.5f);
@@ -250,11 +281,10 @@ void App1::spotDepthPass()
     XMMATRIX spotProjMatrix = spotLightProjMatrix;
     XMMATRIX worldMatrix;
 
-    // Floor
-    worldMatrix = XMMatrixTranslation(-50.f, 0.f, -10.f);
-    mesh->sendData(renderer->getDeviceContext());
-    depthShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, spotViewMatrix, spotProjMatrix);
-    depthShader->render(renderer->getDeviceContext(), mesh->getIndexCount());
+    // Floor, at a coarser LOD than the camera view
+    worldMatrix = XMMatrixTranslation(terrainOffset.x, terrainOffset.y, terrainOffset.z);
+    terrainDepthShader->setShaderParameters(renderer->getDeviceContext(), worldMatrix, spotViewMatrix, spotProjMatrix);
+    renderTerrain(terrainDepthShader, terrainPixelError * shadowLodBias);
 
     // Teapot
     XMMATRIX scaleMatrix = XMMatrixScaling(0.5f, 0.5f, 0.5f);
@@ -286,6 +316,49 @@ void App1::spotDepthPass()
     renderer->getDeviceContext()->RSSetState(nullptr);
 }
 
+// Terrain LOD is chosen from the camera in every pass. Shadow passes pass a larger pixel error for coarser chunks.
+void App1::renderTerrain(BaseShader* shader, float pixelError)
+{
+    XMFLOAT3 eye = camera->getPosition();
+    XMFLOAT3 localEye(eye.x - terrainOffset.x, eye.y - terrainOffset.y, eye.z - terrainOffset.z);
+
+    TerrainLodSettings settings;
+    settings.viewportHeight = (float)sHeight;
+    settings.fieldOfView = (float)XM_PI / 4.0f;
+    settings.maxPixelError = pixelError;
+
+    terrain->selectLod(localEye, settings, terrainSelection);
+    terrain->sendData(renderer->getDeviceContext());
+    terrain->render(renderer->getDeviceContext(), shader, terrainSelection);
+}
+
+void App1::updateTerrainQueries()
+{
+    // Camera ground collision: stay a little above the surface while over the terrain
+    const float eyeHeight = 1.5f;
+    XMFLOAT3 eye = camera->getPosition();
+    if (cameraGroundCollision && terrainQuery.contains(eye.x, eye.z)) {
+        float ground = terrainQuery.getHeight(eye.x, eye.z);
+        if (eye.y < ground + eyeHeight) {
+            camera->setPosition(eye.x, ground + eyeHeight, eye.z);
+        }
+    }
+
+    // Cursor picking: unproject the mouse position at the near and far planes
+    camera->update();
+    XMMATRIX view = camera->getViewMatrix();
+    XMMATRIX projection = renderer->getProjectionMatrix();
+    float mouseX = (float)input->getMouseX();
+    float mouseY = (float)input->getMouseY();
+    XMVECTOR nearPoint = XMVector3Unproject(XMVectorSet(mouseX, mouseY, 0.0f, 1.0f), 0.0f, 0.0f, (float)sWidth, (float)sHeight, 0.0f, 1.0f, projection, view, XMMatrixIdentity());
+    XMVECTOR farPoint = XMVector3Unproject(XMVectorSet(mouseX, mouseY, 1.0f, 1.0f), 0.0f, 0.0f, (float)sWidth, (float)sHeight, 0.0f, 1.0f, projection, view, XMMatrixIdentity());
+
+    XMFLOAT3 rayOrigin, rayDirection;
+    XMStoreFloat3(&rayOrigin, nearPoint);
+    XMStoreFloat3(&rayDirection, XMVector3Normalize(XMVectorSubtract(farPoint, nearPoint)));
+    cursorOverTerrain = terrainQuery.raycast(&rayOrigin.x, &rayDirection.x, 1000.0f, cursorHit);
+}
+
 // Final pass: render lit scene to post-process target, then Sobel, then UI
 void App1::finalPass()
 {
@@ -305,12 +378,11 @@ void App1::finalPass()
 
     // -- Draw scene (floor, teapot, cube, sphere) as before --
     // Floor
-    worldMatrix = XMMatrixTranslation(-50.f, 0.f, -10.f);
-    mesh->sendData(renderer->getDeviceContext());
-    shadowShader->setShaderParameters(
+    worldMatrix = XMMatrixTranslation(terrainOffset.x, terrainOffset.y, terrainOffset.z);
+    terrainShadowShader->setShaderParameters(
         renderer->getDeviceContext(),
         worldMatrix, viewMatrix, projectionMatrix,
-        textureMgr->getTexture(L"brick"),
+        textureMgr->getTexture(brickTexture),
         shadowMap->getDepthMapSRV(),
         spotShadowMap->getDepthMapSRV(),
         light,
@@ -318,7 +390,8 @@ void App1::finalPass()
         cos(XMConvertToRadians(spotCutoffDegrees)),
         spotExponent
     );
-    shadowShader->render(renderer->getDeviceContext(), mesh->getIndexCount());
+    renderTerrain(terrainShadowShader, terrainPixelError);
+    terrainIndicesDrawn = terrain->getSelectionIndexCount(terrainSelection);
 
     // Teapot
     XMMATRIX scaleMatrix = XMMatrixScaling(0.5f, 0.5f, 0.5f);
@@ -329,7 +402,7 @@ void App1::finalPass()
     shadowShader->setShaderParameters(
         renderer->getDeviceContext(),
         worldMatrix, viewMatrix, projectionMatrix,
-        textureMgr->getTexture(L"brick"),
+        textureMgr->getTexture(brickTexture),
         shadowMap->getDepthMapSRV(),
         spotShadowMap->getDepthMapSRV(),
         light,
@@ -347,7 +420,7 @@ void App1::finalPass()
     shadowShader->setShaderParameters(
         renderer->getDeviceContext(),
         worldMatrix, viewMatrix, projectionMatrix,
-        textureMgr->getTexture(L"brick"),
+        textureMgr->getTexture(brickTexture),
         shadowMap->getDepthMapSRV(),
         spotShadowMap->getDepthMapSRV(),
         light,
@@ -365,7 +438,7 @@ void App1::finalPass()
     shadowShader->setShaderParameters(
         renderer->getDeviceContext(),
         worldMatrix, viewMatrix, projectionMatrix,
-        textureMgr->getTexture(L"brick"),
+        textureMgr->getTexture(brickTexture),
         shadowMap->getDepthMapSRV(),
         spotShadowMap->getDepthMapSRV(),
         light,
@@ -405,6 +478,19 @@ void App1::gui()
     ImGui::Text("FPS: %.2f", timer->getFPS());
     ImGui::Checkbox("Wireframe mode", &wireframeToggle);
     ImGui::SliderFloat("Plane Height Scale", &heightScale, 1.0f, 100.0f);
+    ImGui::SliderFloat("Terrain Pixel Error", &terrainPixelError, 0.5f, 16.0f);
+    ImGui::SliderFloat("Shadow LOD Bias", &shadowLodBias, 1.0f, 16.0f);
+    ImGui::Text("Terrain: %d chunks, %d triangles", (int)terrainSelection.size(), terrainIndicesDrawn / 3);
+    ImGui::Text("Terrain vertices: %d KB (%d bytes each)", terrain->getVertexBufferBytes() / 1024, terrain->getVertexStride());
+    ImGui::Checkbox("Camera ground collision", &cameraGroundCollision);
+    if (cursorOverTerrain)
+        ImGui::Text("Cursor on terrain: (%.1f, %.1f, %.1f)", cursorHit.position[0], cursorHit.position[1], cursorHit.position[2]);
+    else
+        ImGui::Text("Cursor on terrain: none");
+    if (model->hasFailed())
+        ImGui::Text("Teapot: failed (%s)", model->getError().c_str());
+    else
+        ImGui::Text("Teapot: %s", model->isLoaded() ? "loaded" : "loading");
 
     ImGui::Render();
     ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
@@ -45,20 +45,31 @@ protected:
 	// Render the final scene with full lighting and shadows
 	void finalPass();
 
+	// Select terrain chunks for the given pixel error and draw them with the shader's current parameters
+	void renderTerrain(BaseShader* shader, float pixelError);
+
+	// Keep the camera above the ground and find the terrain point under the mouse cursor
+	void updateTerrainQueries();
+
 	// Draw the ImGui interface and debug overlays
 	void gui();
 
 private:
 	// Scene meshes and models
-	PlaneMesh* mesh = nullptr;
+	TerrainMesh* terrain = nullptr;
 	CubeMesh* cubeMesh = nullptr;
 	SphereMesh* sphereMesh = nullptr;
-	AModel* model = nullptr;
+	AsyncModel* model = nullptr;
+	ModelLoadQueue* modelQueue = nullptr;
+	TextureHandle brickTexture = 0;
 
 	// Shaders
 	TextureShader* textureShader = nullptr;
 	ShadowShader* shadowShader = nullptr;
 	DepthShader* depthShader = nullptr;
+	// Variants for the terrain's compact vertices
+	DepthShader* terrainDepthShader = nullptr;
+	ShadowShader* terrainShadowShader = nullptr;
 
 	// Lights
 	Light* light = nullptr;
@@ -82,6 +93,18 @@ private:
 	float heightScale = 8.0f;
 	float prevHeightScale = 8.0f; 
 
+	// Terrain LOD: allowed projected error in pixels, multiplied by the bias in the shadow passes
+	float terrainPixelError = 2.0f;
+	float shadowLodBias = 4.0f;
+	std::vector<int> terrainSelection;
+	int terrainIndicesDrawn = 0;
+
+	// CPU height and raycast queries in world space, for camera ground collision and cursor picking
+	TerrainQuery terrainQuery;
+	bool cameraGroundCollision = true;
+	bool cursorOverTerrain = false;
+	TerrainRayHit cursorHit;
+
 	ID3D11RasterizerState* shadowRasterState = nullptr;
 
 	// Post-processing resources
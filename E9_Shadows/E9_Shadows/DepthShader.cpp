@@ -9,10 +9,11 @@
 #include "DepthShader.h"
 
  // Constructor: Initialize shader resources.
-DepthShader::DepthShader(ID3D11Device* device, HWND hwnd)
+DepthShader::DepthShader(ID3D11Device* device, HWND hwnd, bool compact)
     : BaseShader(device, hwnd)
 {
-    initShader(L"depth_vs.cso", L"depth_ps.cso");
+    compactTerrain = compact;
+    initShader(compactTerrain ? L"depth_terrain_vs.cso" : L"depth_vs.cso", L"depth_ps.cso");
 }
 
 // Destructor: Release DirectX resources.
@@ -32,7 +33,10 @@ void DepthShader::initShader(const wchar_t* vsFilename, const wchar_t* psFilenam
     matrixBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
     matrixBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
 
-    loadVertexShader(vsFilename);
+    if (compactTerrain)
+        loadCompactTerrainVertexShader(vsFilename);
+    else
+        loadVertexShader(vsFilename);
     loadPixelShader(psFilename);
 
     renderer->CreateBuffer(&matrixBufferDesc, nullptr, &matrixBuffer);
@@ -15,7 +15,8 @@ class DepthShader : public BaseShader
 {
 public:
     // Constructor: Initializes the shader with device and window handle.
-    DepthShader(ID3D11Device* device, HWND hwnd);
+    // compactTerrain loads the variant for TerrainMesh's compact vertices (depth_terrain_vs).
+    DepthShader(ID3D11Device* device, HWND hwnd, bool compactTerrain = false);
 
     // Destructor: Releases allocated DirectX resources.
     ~DepthShader();
@@ -31,4 +32,5 @@ private:
     void initShader(const wchar_t* vs, const wchar_t* ps);
 
     ID3D11Buffer* matrixBuffer = nullptr; // Constant buffer for transformation matrices.
+    bool compactTerrain = false;          // Vertex shader expects CompactTerrainVertex input.
 };
\ No newline at end of file
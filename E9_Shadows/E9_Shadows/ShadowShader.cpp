@@ -9,9 +9,10 @@
 #include "ShadowShader.h"
 
  // Constructor: Initialize shader and resources.
-ShadowShader::ShadowShader(ID3D11Device* device, HWND hwnd) : BaseShader(device, hwnd)
+ShadowShader::ShadowShader(ID3D11Device* device, HWND hwnd, bool compact) : BaseShader(device, hwnd)
 {
-    initShader(L"shadow_vs.cso", L"shadow_ps.cso");
+    compactTerrain = compact;
+    initShader(compactTerrain ? L"shadow_terrain_vs.cso" : L"shadow_vs.cso", L"shadow_ps.cso");
 }
 
 // Destructor: Release allocated DirectX resources.
@@ -32,7 +33,10 @@ void ShadowShader::initShader(const wchar_t* vsFilename, const wchar_t* psFilena
     D3D11_SAMPLER_DESC samplerDesc = {};
     D3D11_BUFFER_DESC lightBufferDesc = {};
 
-    loadVertexShader(vsFilename);
+    if (compactTerrain)
+        loadCompactTerrainVertexShader(vsFilename);
+    else
+        loadVertexShader(vsFilename);
     loadPixelShader(psFilename);
 
     // Matrix buffer (b0)
@@ -84,7 +88,8 @@ void ShadowShader::setShaderParameters(
     Light* dirLight,
     Light* spotLight,
     float spotCutoffDegrees,
-    float spotExponent)
+    float spotExponent,
+    const XMFLOAT4& uvTransform)
 {
     D3D11_MAPPED_SUBRESOURCE mappedResource;
     MatrixBufferType* dataPtr = nullptr;
@@ -109,6 +114,7 @@ void ShadowShader::setShaderParameters(
     dataPtr->dirLightProj = tDirLightProj;
     dataPtr->spotLightView = tSpotLightView;
     dataPtr->spotLightProj = tSpotLightProj;
+    dataPtr->uvTransform = uvTransform;
     deviceContext->Unmap(matrixBuffer, 0);
     deviceContext->VSSetConstantBuffers(0, 1, &matrixBuffer);
 
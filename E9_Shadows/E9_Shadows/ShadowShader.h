@@ -18,10 +18,13 @@ using namespace DirectX;
 class ShadowShader : public BaseShader
 {
 public:
-    ShadowShader(ID3D11Device* device, HWND hwnd);
+    // compactTerrain loads the variant for TerrainMesh's compact vertices (shadow_terrain_vs).
+    ShadowShader(ID3D11Device* device, HWND hwnd, bool compactTerrain = false);
     ~ShadowShader();
 
     // Sets shader parameters including transformation matrices, textures, shadow maps, and light info.
+    // uvTransform scales (xy) and offsets (zw) texture coordinates, to draw from a texture atlas page.
+    // Atlased meshes need texture coordinates within 0 to 1, as the page does not wrap per texture.
     void setShaderParameters(
         ID3D11DeviceContext* deviceContext,
         const XMMATRIX& world,
@@ -33,12 +36,15 @@ public:
         Light* dirLight,
         Light* spotLight,
         float spotCutoffDegrees,
-        float spotExponent
+        float spotExponent,
+        const XMFLOAT4& uvTransform = XMFLOAT4(1.f, 1.f, 0.f, 0.f)
     );
 
 private:
     void initShader(const wchar_t* vs, const wchar_t* ps);
 
+    bool compactTerrain = false;                  // Vertex shader expects CompactTerrainVertex input
+
     struct MatrixBufferType
     {
         XMMATRIX world;
@@ -48,6 +54,7 @@ private:
         XMMATRIX dirLightProj;
         XMMATRIX spotLightView;
         XMMATRIX spotLightProj;
+        XMFLOAT4 uvTransform;
     };
 
     struct LightBufferType
@@ -0,0 +1,35 @@
+/**
+ * depth_terrain_vs.hlsl
+ * ---------------------
+ * Depth vertex shader for compact terrain vertices.
+ * Rebuilds the terrain vertex from its height, normal and vertex index, then transforms it like depth_vs.
+ */
+
+#include "terrain_compact.hlsli"
+
+cbuffer MatrixBuffer : register(b0)
+{
+    matrix worldMatrix;
+    matrix viewMatrix;
+    matrix projectionMatrix;
+};
+
+struct OutputType
+{
+    float4 position : SV_POSITION;        // Projected position for rasterization.
+    float4 depthPosition : TEXCOORD0;     // Projected position for depth interpolation.
+};
+
+OutputType main(CompactTerrainInput input)
+{
+    OutputType output;
+    TerrainVertex vertex = decodeTerrainVertex(input);
+
+    // Transform the vertex to world, view, and projection space
+    float4 worldPos = mul(vertex.position, worldMatrix);
+    float4 viewPos = mul(worldPos, viewMatrix);
+    output.position = mul(viewPos, projectionMatrix);
+    output.depthPosition = output.position; // Pass projected position for depth calculation
+
+    return output;
+}
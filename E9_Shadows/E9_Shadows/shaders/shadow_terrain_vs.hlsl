@@ -0,0 +1,54 @@
+/**
+ * shadow_terrain_vs.hlsl
+ * ----------------------
+ * Shadow-mapping vertex shader for compact terrain vertices.
+ * Rebuilds the terrain vertex from its height, normal and vertex index, then produces the same outputs as shadow_vs.
+ */
+
+#include "terrain_compact.hlsli"
+
+cbuffer MatrixBuffer : register(b0)
+{
+    matrix worldMatrix;
+    matrix viewMatrix;
+    matrix projectionMatrix;
+    matrix lightViewMatrix;
+    matrix lightProjectionMatrix;
+    matrix spotLightViewMatrix;
+    matrix spotLightProjectionMatrix;
+    float4 uvTransform;     // xy scale, zw offset, for textures in an atlas
+};
+
+struct OutputType
+{
+    float4 position : SV_POSITION;
+    float2 tex : TEXCOORD0;
+    float3 normal : NORMAL;
+    float4 lightViewPos : TEXCOORD1;
+    float4 spotLightViewPos : TEXCOORD2;
+    float4 worldPos : TEXCOORD3;
+};
+
+OutputType main(CompactTerrainInput input)
+{
+    OutputType output;
+    TerrainVertex vertex = decodeTerrainVertex(input);
+
+    // Transform vertex to world, view, and projection space
+    float4 worldPos = mul(vertex.position, worldMatrix);
+    float4 viewPos = mul(worldPos, viewMatrix);
+    output.position = mul(viewPos, projectionMatrix);
+
+    // Directional light view-projection
+    float4 lightView = mul(worldPos, lightViewMatrix);
+    output.lightViewPos = mul(lightView, lightProjectionMatrix);
+
+    // Spot light view-projection
+    float4 spotView = mul(worldPos, spotLightViewMatrix);
+    output.spotLightViewPos = mul(spotView, spotLightProjectionMatrix);
+
+    output.tex = vertex.tex * uvTransform.xy + uvTransform.zw;
+    output.normal = normalize(mul(vertex.normal, (float3x3)worldMatrix));
+    output.worldPos = worldPos;
+    return output;
+}
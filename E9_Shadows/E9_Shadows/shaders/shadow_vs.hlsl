@@ -15,6 +15,7 @@ cbuffer MatrixBuffer : register(b0)
     matrix lightProjectionMatrix;
     matrix spotLightViewMatrix;
     matrix spotLightProjectionMatrix;
+    float4 uvTransform;     // xy scale, zw offset, for textures in an atlas
 };
 
 struct InputType
@@ -51,7 +52,7 @@ OutputType main(InputType input)
     float4 spotView = mul(worldPos, spotLightViewMatrix);
     output.spotLightViewPos = mul(spotView, spotLightProjectionMatrix);
 
-    output.tex = input.tex;
+    output.tex = input.tex * uvTransform.xy + uvTransform.zw;
     output.normal = normalize(mul(input.normal, (float3x3)worldMatrix));
     output.worldPos = worldPos;
     return output;
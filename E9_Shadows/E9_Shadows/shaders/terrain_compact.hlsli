@@ -0,0 +1,87 @@
+/**
+ * terrain_compact.hlsli
+ * ---------------------
+ * Shared decode for compact terrain vertices (CompactTerrainVertex in the framework).
+ * Each vertex carries only a 16-bit height and an octahedral normal. Grid position and texture coordinates
+ * are rebuilt from SV_VertexID and the current chunk's layout, matching decodeCompactTerrainVertex on the CPU.
+ */
+
+cbuffer TerrainChunkBuffer : register(b1)
+{
+    uint2 chunkOrigin;      // First sample covered by the chunk
+    uint2 chunkLast;        // Last sample, clipped to the grid edge
+    uint chunkStep;
+    uint chunkColumns;
+    uint chunkRows;
+    uint chunkPadding;
+    float skirtDepth;       // Unscaled drop for skirt vertices
+    float heightScale;
+    float texelScale;       // 1 / (resolution - 1)
+    float chunkPadding2;
+};
+
+struct CompactTerrainInput
+{
+    float2 normal : NORMAL;     // Octahedral, R16G16_SNORM
+    float height : HEIGHT;      // Unscaled, R16_UNORM
+    uint vertexId : SV_VertexID;
+};
+
+struct TerrainVertex
+{
+    float4 position;
+    float2 tex;
+    float3 normal;
+};
+
+float3 unpackOctahedralNormal(float2 packed)
+{
+    float3 n = float3(packed.x, 1.0 - abs(packed.x) - abs(packed.y), packed.y);
+    if (n.y < 0.0)
+    {
+        float2 signs = float2(n.x >= 0.0 ? 1.0 : -1.0, n.z >= 0.0 ? 1.0 : -1.0);
+        n.xz = (1.0 - abs(n.zx)) * signs;
+    }
+    return normalize(n);
+}
+
+// Vertex order follows buildChunkMesh: surface grid row-major, then the near Z, far Z, near X and far X skirts.
+TerrainVertex decodeTerrainVertex(CompactTerrainInput input)
+{
+    uint surfaceCount = chunkColumns * chunkRows;
+    bool skirt = input.vertexId >= surfaceCount;
+    uint2 cell;
+    if (!skirt)
+    {
+        cell = uint2(input.vertexId % chunkColumns, input.vertexId / chunkColumns);
+    }
+    else
+    {
+        uint k = input.vertexId - surfaceCount;
+        if (k < chunkColumns)
+        {
+            cell = uint2(k, 0);
+        }
+        else if (k < 2 * chunkColumns)
+        {
+            cell = uint2(2 * chunkColumns - 1 - k, chunkRows - 1);
+        }
+        else if (k < 2 * chunkColumns + chunkRows)
+        {
+            cell = uint2(0, 2 * chunkColumns + chunkRows - 1 - k);
+        }
+        else
+        {
+            cell = uint2(chunkColumns - 1, k - 2 * chunkColumns - chunkRows);
+        }
+    }
+
+    uint2 gridSample = min(chunkOrigin + cell * chunkStep, chunkLast);
+    float height = input.height - (skirt ? skirtDepth : 0.0);
+
+    TerrainVertex output;
+    output.position = float4((float)gridSample.x, height * heightScale, (float)gridSample.y, 1.0);
+    output.tex = float2(gridSample) * texelScale;
+    output.normal = unpackOctahedralNormal(input.normal);
+    return output;
+}
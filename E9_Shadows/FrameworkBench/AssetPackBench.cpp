@@ -0,0 +1,108 @@
+// Asset pack benchmarks
+// Startup cost of opening every res file loose against opening them from a pack, cold and warm.
+#include "FrameworkBench.h"
+#include "AssetPack.h"
+#include <cstdio>
+#include <filesystem>
+
+// Opens every file and touches every page, as a loader reading the whole file would.
+static bool openAll(const std::vector<AssetPackSource>& sources, const std::string& root, bool packed, uint64_t& checksum)
+{
+	for (const AssetPackSource& source : sources)
+	{
+		MappedFile file;
+		if (!(packed ? file.open(root + "/" + source.name) : file.openOnDisk(source.filename)))
+		{
+			return false;
+		}
+		for (size_t i = 0; i < file.getSize(); i += 4096)
+		{
+			checksum += file.getData()[i];
+		}
+	}
+	return true;
+}
+
+static void benchmarkStartup(const std::vector<AssetPackSource>& sources, const std::string& packFilename, const std::string& root)
+{
+	const int runs = 9;
+	uint64_t checksum = 0;
+	bool ok = true;
+	std::vector<bool> packedRuns = { false, true };
+	for (bool packed : packedRuns)
+	{
+		auto load = [&]()
+		{
+			if (packed)
+			{
+				ok = ok && mountAssetPack(packFilename, root);
+			}
+			ok = ok && openAll(sources, root, packed, checksum);
+			unmountAssetPacks();
+		};
+		double warm = timeMedian(runs, []() {}, load);
+		printf("  %s: warm %.1f ms", packed ? "packed" : "loose ", warm);
+		if (canDropFileCache())
+		{
+			auto dropCaches = [&]()
+			{
+				for (const AssetPackSource& source : sources)
+				{
+					dropFileCache(source.filename);
+				}
+				dropFileCache(packFilename);
+			};
+			printf(", cold %.1f ms", timeMedian(runs, dropCaches, load));
+		}
+		printf("\n");
+	}
+	if (!ok)
+	{
+		printf("  some files could not be opened\n");
+	}
+}
+
+// Builds a pack of the sources, then times opening them from it and from disk.
+static void benchmarkPack(const std::vector<AssetPackSource>& sources, const std::string& packFilename, const std::string& root)
+{
+	std::string error;
+	AssetPackStats stats;
+	double buildTime = timeMilliseconds([&]() { buildAssetPack(packFilename, sources, error, AssetPackSettings(), &stats); });
+	if (!error.empty())
+	{
+		printf("  %s\n", error.c_str());
+		return;
+	}
+	printf("  %llu files, %.1f MB stored as %.1f MB, built in %.0f ms\n", (unsigned long long)stats.files, stats.sourceBytes / 1e6,
+		stats.storedBytes / 1e6, buildTime);
+	benchmarkStartup(sources, packFilename, root);
+}
+
+FRAMEWORK_BENCHMARK(assetPackStartup)
+{
+	const std::string& root = getResourceDirectory();
+	std::vector<AssetPackSource> sources;
+	if (!listAssetPackFiles(root, root, sources) || sources.empty())
+	{
+		printf("  no res files\n");
+		return;
+	}
+	std::string directory = getBenchmarkDirectory("assetPackStartup");
+	benchmarkPack(sources, directory + "/res.pack", root);
+
+	// Many small files are where a pack saves the most opens.
+	std::vector<AssetPackSource> smallSources;
+	for (const AssetPackSource& source : sources)
+	{
+		std::error_code ignored;
+		if (std::filesystem::file_size(source.filename, ignored) < 256 * 1024)
+		{
+			smallSources.push_back(source);
+		}
+	}
+	if (!smallSources.empty())
+	{
+		printf("  Files under 256 KB only:\n");
+		benchmarkPack(smallSources, directory + "/small.pack", root);
+	}
+}
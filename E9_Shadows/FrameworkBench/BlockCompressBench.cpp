@@ -0,0 +1,51 @@
+// Block compression benchmarks
+// Throughput and decoded quality of each format on a real texture, scalar against SIMD, one thread against all of them.
+#include "FrameworkBench.h"
+#include "BlockCompress.h"
+#include "../FrameworkTests/TestBlockDecode.h"
+#include "stb_image.h"
+#include <cstdio>
+#include <thread>
+
+FRAMEWORK_BENCHMARK(blockCompressWood)
+{
+	std::string filename = getResourceDirectory() + "/wood.png";
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	unsigned char* pixels = stbi_load(filename.c_str(), &width, &height, &channels, 4);
+	if (!pixels)
+	{
+		printf("  wood.png not found, skipped\n");
+		return;
+	}
+	std::vector<unsigned char> rgba(pixels, pixels + (size_t)width * height * 4);
+	stbi_image_free(pixels);
+	double megapixels = (double)width * height / 1e6;
+	printf("  %dx%d, %s kernel, %u hardware threads\n", width, height, getBlockCompressKernelName(), std::thread::hardware_concurrency());
+
+	struct FormatCase
+	{
+		uint32_t format;
+		const char* name;
+		int firstChannel;
+		int channelCount;
+	};
+	const FormatCase formats[] = {
+		{ blockFormatBC1, "BC1", 0, 3 },
+		{ blockFormatBC3, "BC3", 0, 4 },
+		{ blockFormatBC5, "BC5", 0, 2 },
+	};
+	for (const FormatCase& format : formats)
+	{
+		std::vector<unsigned char> blocks(getCompressedSize(width, height, format.format));
+		double scalar = timeBest(3, [&]() { compressImageScalar(rgba.data(), width, height, format.format, blocks.data()); });
+		double simd = timeBest(3, [&]() { compressImage(rgba.data(), width, height, format.format, blocks.data(), 1); });
+		double threaded = timeBest(3, [&]() { compressImage(rgba.data(), width, height, format.format, blocks.data()); });
+		std::vector<unsigned char> decoded;
+		decodeBlockImage(blocks.data(), width, height, format.format, decoded);
+		double psnr = getPsnr(rgba.data(), decoded.data(), width, height, format.firstChannel, format.channelCount);
+		printf("  %s: scalar %.1f, %s %.1f, threaded %.1f MPixel/s, %.1f dB\n", format.name, megapixels * 1000.0 / scalar,
+			getBlockCompressKernelName(), megapixels * 1000.0 / simd, megapixels * 1000.0 / threaded, psnr);
+	}
+}
@@ -0,0 +1,56 @@
+// Content hash benchmarks
+// XXH64 throughput over buffers from cache-sized to larger than the caches, in one go and streamed in pieces.
+#include "FrameworkBench.h"
+#include "ContentHash.h"
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+FRAMEWORK_BENCHMARK(contentHashThroughput)
+{
+	std::mt19937 random(1);
+	std::vector<unsigned char> data(256 << 20);
+	for (size_t i = 0; i < data.size(); i += 4)
+	{
+		uint32_t value = random();
+		memcpy(&data[i], &value, sizeof(value));
+	}
+
+	// Small sizes repeat until each timing covers the same number of bytes.
+	volatile uint64_t sink = 0;
+	const size_t sizes[] = { 64, 4 << 10, 1 << 20, 256 << 20 };
+	for (size_t size : sizes)
+	{
+		size_t repeats = data.size() / size;
+		double whole = timeBest(3, [&]()
+		{
+			for (size_t i = 0; i < repeats; i++)
+			{
+				sink = sink ^ hashContent(data.data() + i * size, size);
+			}
+		});
+		double gigabytes = (double)repeats * size / (1 << 30);
+		printf("  %9d bytes: %.2f GB/s", (int)size, gigabytes * 1000.0 / whole);
+
+		// The same bytes fed to ContentHasher 4 KB at a time, plus a 3-byte piece so the stripes never line up.
+		if (size >= (1 << 20))
+		{
+			double streamed = timeBest(3, [&]()
+			{
+				for (size_t i = 0; i < repeats; i++)
+				{
+					const unsigned char* block = data.data() + i * size;
+					ContentHasher hasher;
+					hasher.update(block, 3);
+					for (size_t offset = 3; offset < size; offset += 4096)
+					{
+						hasher.update(block + offset, std::min<size_t>(4096, size - offset));
+					}
+					sink = sink ^ hasher.finish();
+				}
+			});
+			printf(", streamed %.2f GB/s", gigabytes * 1000.0 / streamed);
+		}
+		printf("\n");
+	}
+}
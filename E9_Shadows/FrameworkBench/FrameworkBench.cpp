@@ -0,0 +1,111 @@
+// Framework benchmarks
+// Times the platform-neutral framework code, running every benchmark or those whose names contain an argument.
+// Usage: FrameworkBench [--res <res directory>] [benchmark name filters...]
+// Run it from the project directory, or pass --res, so it finds the application's assets.
+// Builds on Linux with: g++ -std=c++17 -O2 -pthread -I../DXFramework -I../include *.cpp followed by the
+// ../DXFramework files in FrameworkBench.vcxproj.
+#include "FrameworkBench.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+struct RegisteredBenchmark
+{
+	const char* name;
+	BenchmarkFunction function;
+};
+
+static std::vector<RegisteredBenchmark>& getBenchmarks()
+{
+	static std::vector<RegisteredBenchmark> benchmarks;
+	return benchmarks;
+}
+
+static std::string resourceDirectory = "../E9_Shadows/res";
+
+bool registerBenchmark(const char* name, BenchmarkFunction function)
+{
+	getBenchmarks().push_back({ name, function });
+	return true;
+}
+
+const std::string& getResourceDirectory()
+{
+	return resourceDirectory;
+}
+
+std::string getBenchmarkDirectory(const char* benchmarkName)
+{
+	std::filesystem::path directory = std::filesystem::temp_directory_path() / "FrameworkBench" / benchmarkName;
+	std::error_code ignored;
+	std::filesystem::remove_all(directory, ignored);
+	std::filesystem::create_directories(directory, ignored);
+	return directory.string();
+}
+
+bool dropFileCache(const std::string& filename)
+{
+#ifdef _WIN32
+	(void)filename;
+	return false;
+#else
+	int file = open(filename.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		return false;
+	}
+	// Dirty pages are not dropped, so a file the benchmark just wrote is written back first.
+	fdatasync(file);
+	bool dropped = posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED) == 0;
+	close(file);
+	return dropped;
+#endif
+}
+
+bool canDropFileCache()
+{
+#ifdef _WIN32
+	return false;
+#else
+	return true;
+#endif
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<const char*> filters;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--res") == 0 && i + 1 < argc)
+		{
+			resourceDirectory = argv[++i];
+		}
+		else
+		{
+			filters.push_back(argv[i]);
+		}
+	}
+	if (!std::filesystem::is_directory(resourceDirectory))
+	{
+		printf("No res directory at %s, so benchmarks of the application's assets are skipped\n", resourceDirectory.c_str());
+	}
+
+	for (const RegisteredBenchmark& benchmark : getBenchmarks())
+	{
+		bool selected = filters.empty();
+		for (const char* filter : filters)
+		{
+			selected = selected || strstr(benchmark.name, filter);
+		}
+		if (selected)
+		{
+			printf("%s\n", benchmark.name);
+			benchmark.function();
+		}
+	}
+	return 0;
+}
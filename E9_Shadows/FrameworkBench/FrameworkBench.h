@@ -0,0 +1,72 @@
+/**
+* \brief Minimal benchmark registry and timing helpers for the platform-neutral framework code
+*
+* Each benchmark file defines its benchmarks with FRAMEWORK_BENCHMARK, which registers them before main runs.
+* Warm timings take the best of several runs. Cold timings drop the files from the operating system's page cache
+* first, which needs posix_fadvise, so they are skipped where it is not available.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _FRAMEWORKBENCH_H_
+#define _FRAMEWORKBENCH_H_
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+typedef void (*BenchmarkFunction)();
+
+bool registerBenchmark(const char* name, BenchmarkFunction function);
+
+#define FRAMEWORK_BENCHMARK(name) \
+	static void name(); \
+	static bool name##Registered = registerBenchmark(#name, name); \
+	static void name()
+
+/// The application's res directory, or the one given with --res.
+const std::string& getResourceDirectory();
+/// A scratch directory for one benchmark's files, under the system temporary directory.
+std::string getBenchmarkDirectory(const char* benchmarkName);
+
+/// Evicts the file's cached pages. Returns false where that is not supported.
+bool dropFileCache(const std::string& filename);
+bool canDropFileCache();
+
+/// Milliseconds taken by one call.
+template<typename Function>
+double timeMilliseconds(Function function)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	function();
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/// Fastest of several calls, in milliseconds.
+template<typename Function>
+double timeBest(int runs, Function function)
+{
+	double best = 1e30;
+	for (int i = 0; i < runs; i++)
+	{
+		best = std::min(best, timeMilliseconds(function));
+	}
+	return best;
+}
+
+/// Median of several calls, in milliseconds. prepare runs before each call, untimed.
+template<typename Prepare, typename Function>
+double timeMedian(int runs, Prepare prepare, Function function)
+{
+	std::vector<double> times;
+	for (int i = 0; i < runs; i++)
+	{
+		prepare();
+		times.push_back(timeMilliseconds(function));
+	}
+	std::sort(times.begin(), times.end());
+	return times[times.size() / 2];
+}
+
+#endif
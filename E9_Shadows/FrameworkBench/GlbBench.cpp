@@ -0,0 +1,57 @@
+// GLB benchmarks
+// Loading the res OBJ models with the OBJ parser and welder, against the same meshes written as .glb.
+#include "FrameworkBench.h"
+#include "../FrameworkTests/TestGlbWriter.h"
+#include "GlbFile.h"
+#include "VertexWeld.h"
+#include <cstdio>
+#include <cstring>
+
+FRAMEWORK_BENCHMARK(glbAgainstObj)
+{
+	const char* models[] = { "teapot", "drone", "ScaleBot" };
+	std::string directory = getBenchmarkDirectory("glbAgainstObj");
+	for (const char* model : models)
+	{
+		std::string objFilename = getResourceDirectory() + "/" + model + ".obj";
+		ObjMesh mesh;
+		std::vector<ObjVertex> unique;
+		std::vector<uint32_t> indices;
+		if (!loadObj(objFilename, mesh, false))
+		{
+			printf("  %s not found, skipped\n", objFilename.c_str());
+			continue;
+		}
+		weldVertices(mesh.vertices, unique, indices);
+
+		// The same welded mesh, stored in the layout GlbFile can use in place.
+		static_assert(sizeof(ObjVertex) == sizeof(ModelVertex), "ObjVertex must match the ModelVertex layout");
+		std::vector<ModelVertex> vertices(unique.size());
+		memcpy(vertices.data(), unique.data(), unique.size() * sizeof(ModelVertex));
+		std::string glbFilename = directory + "/" + model + ".glb";
+		if (!writeTestGlb(glbFilename, vertices, indices, TestGlbLayout::interleaved))
+		{
+			printf("  FAILED to write %s\n", glbFilename.c_str());
+			continue;
+		}
+
+		double obj = timeBest(3, [&]()
+		{
+			ObjMesh parsed;
+			loadObj(objFilename, parsed);
+			weldVertices(parsed.vertices, unique, indices);
+		});
+		std::string error;
+		double inPlace = timeBest(5, [&]() { GlbFile file; file.open(glbFilename, error, false); });
+		double converted = timeBest(5, [&]() { GlbFile file; file.open(glbFilename, error, true); });
+		double copied = timeBest(5, [&]()
+		{
+			GlbFile file;
+			file.open(glbFilename, error, true);
+			ModelArrays arrays;
+			file.copyTo(arrays);
+		});
+		printf("  %-8s %6d vertices: obj and weld %.2f ms, glb in place %.3f ms, left-handed %.3f ms, copied out %.3f ms\n", model,
+			(int)vertices.size(), obj, inPlace, converted, copied);
+	}
+}
@@ -0,0 +1,81 @@
+// Height tile benchmarks
+// Latency from a camera move to its tiles being resident, warm and cold, and resident memory against the whole heightmap.
+#include "FrameworkBench.h"
+#include "HeightTileStreamer.h"
+#include "HeightmapCache.h"
+#include <cstdio>
+#include <thread>
+
+// Moves the camera in a straight line over the map, waiting at each step for the loading thread to go idle.
+static bool sweepCamera(HeightTileStreamer& streamer, int steps, std::vector<double>& latencies, size_t& mostResident)
+{
+	const HeightTileFile& file = streamer.getFile();
+	float size = (float)(file.getWidth() - 1);
+	for (int step = 0; step < steps; step++)
+	{
+		float x = size * (0.05f + 0.9f * step / (steps - 1));
+		float z = size * (0.3f + 0.4f * step / (steps - 1));
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		std::chrono::steady_clock::time_point deadline = start + std::chrono::seconds(10);
+		streamer.update(x, z);
+		while (streamer.getPendingTileCount() > 0 || !streamer.getTile(0, (int)x / file.getTileSize(), (int)z / file.getTileSize()))
+		{
+			if (std::chrono::steady_clock::now() > deadline)
+			{
+				return false;
+			}
+			std::this_thread::yield();
+		}
+		latencies.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		mostResident = std::max(mostResident, streamer.getResidentBytes());
+	}
+	return true;
+}
+
+FRAMEWORK_BENCHMARK(heightTileStreaming)
+{
+	std::shared_ptr<const Heightmap> heightmap = HeightmapCache::load(getResourceDirectory() + "/height.png");
+	if (!heightmap)
+	{
+		printf("  height.png not found, skipped\n");
+		return;
+	}
+	std::string filename = getBenchmarkDirectory("heightTileStreaming") + "/height.htp";
+	double convert = timeMilliseconds([&]() { writeHeightTilePyramid(*heightmap, filename); });
+	printf("  %dx%d heightmap converted in %.1f ms\n", heightmap->width, heightmap->height, convert);
+
+	// The budget the app used: a few rings of 256 sample tiles.
+	const size_t budget = 4 * 1024 * 1024;
+	const int steps = 24;
+	std::vector<bool> coldRuns = { false, true };
+	for (bool cold : coldRuns)
+	{
+		if (cold && !canDropFileCache())
+		{
+			continue;
+		}
+		// Mapped pages stay cached while the file is open, so the cold run drops them before opening.
+		if (cold)
+		{
+			dropFileCache(filename);
+		}
+		HeightTileStreamer streamer;
+		std::vector<double> latencies;
+		size_t mostResident = 0;
+		if (!streamer.open(filename, budget) || !sweepCamera(streamer, steps, latencies, mostResident))
+		{
+			printf("  FAILED to stream %s\n", filename.c_str());
+			return;
+		}
+		double first = latencies[0];
+		std::sort(latencies.begin() + 1, latencies.end());
+		printf("  %s: first view %.2f ms, then median %.2f ms, worst %.2f ms per move\n", cold ? "cold" : "warm", first,
+			latencies[latencies.size() / 2], latencies.back());
+		if (!cold)
+		{
+			size_t floatBytes = heightmap->samples.size() * sizeof(float);
+			printf("  resident at most %d KB of a %d KB budget, against %d KB for the whole float heightmap\n", (int)(mostResident / 1024),
+				(int)(budget / 1024), (int)(floatBytes / 1024));
+		}
+	}
+}
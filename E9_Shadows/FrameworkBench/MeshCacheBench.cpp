@@ -0,0 +1,88 @@
+// Mesh cache benchmarks
+// Parsing and welding the res OBJ models against opening the mesh caches written from them.
+#include "FrameworkBench.h"
+#include "MeshCache.h"
+#include "VertexWeld.h"
+#include <cstdio>
+#include <filesystem>
+
+FRAMEWORK_BENCHMARK(meshCacheOpen)
+{
+	const char* models[] = { "teapot", "drone", "ScaleBot" };
+	std::string directory = getBenchmarkDirectory("meshCacheOpen");
+	for (const char* model : models)
+	{
+		// The source is copied, so its cache can sit next to it without touching res.
+		std::string objFilename = directory + "/" + model + ".obj";
+		std::string cacheFilename = objFilename + ".mshc";
+		std::error_code error;
+		std::filesystem::copy_file(getResourceDirectory() + "/" + model + ".obj", objFilename, error);
+		ObjMesh mesh;
+		if (error || !loadObj(objFilename, mesh))
+		{
+			printf("  %s not found, skipped\n", model);
+			continue;
+		}
+
+		std::vector<ObjVertex> unique;
+		std::vector<uint32_t> indices;
+		double import = timeBest(3, [&]()
+		{
+			loadObj(objFilename, mesh);
+			weldVertices(mesh.vertices, unique, indices);
+		});
+
+		// Model's loader has no import options, so its caches use no import flags.
+		MeshCacheSubmesh submesh = {};
+		submesh.indexCount = (uint32_t)indices.size();
+		MeshCacheData data;
+		data.vertices = unique.data();
+		data.vertexCount = (uint32_t)unique.size();
+		data.vertexStride = sizeof(ObjVertex);
+		data.indices = indices.data();
+		data.indexCount = (uint32_t)indices.size();
+		data.submeshes = &submesh;
+		data.submeshCount = 1;
+		bool written = false;
+		double write = timeMilliseconds([&]() { written = writeMeshCache(cacheFilename, objFilename, 0, data); });
+		MeshCacheFile cache;
+		if (!written || !cache.open(cacheFilename, objFilename, 0, sizeof(ObjVertex)))
+		{
+			printf("  FAILED to write %s\n", cacheFilename.c_str());
+			continue;
+		}
+		cache.close();
+
+		double warm = timeBest(5, [&]()
+		{
+			MeshCacheFile file;
+			file.open(cacheFilename, objFilename, 0, sizeof(ObjVertex));
+		});
+		printf("  %-8s %6d vertices: obj and weld %.2f ms, write %.2f ms, open warm %.3f ms (%.0fx)", model, (int)unique.size(),
+			import, write, warm, import / warm);
+		if (canDropFileCache())
+		{
+			// open only maps and validates. Touching every page as well is what an upload would pay.
+			auto drop = [&]() { dropFileCache(cacheFilename); dropFileCache(objFilename); };
+			double cold = timeMedian(5, drop, [&]()
+			{
+				MeshCacheFile file;
+				file.open(cacheFilename, objFilename, 0, sizeof(ObjVertex));
+			});
+			volatile unsigned char sink = 0;
+			double coldRead = timeMedian(5, drop, [&]()
+			{
+				MeshCacheFile file;
+				file.open(cacheFilename, objFilename, 0, sizeof(ObjVertex));
+				const unsigned char* bytes = (const unsigned char*)file.getVertexData();
+				size_t size = (size_t)file.getHeader().vertexCount * sizeof(ObjVertex) + file.getHeader().indexCount * sizeof(uint32_t);
+				for (size_t i = 0; i < size; i += 4096)
+				{
+					sink = sink ^ bytes[i];
+				}
+			});
+			printf(", cold %.3f ms, cold with every page read %.3f ms", cold, coldRead);
+		}
+		printf("\n");
+	}
+}
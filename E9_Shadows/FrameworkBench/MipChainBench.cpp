@@ -0,0 +1,67 @@
+// Mip chain benchmarks
+// Source pixels per second halving a 2048x2048 image with each filter and kernel, and min/max cells per second.
+#include "FrameworkBench.h"
+#include "CpuFeatures.h"
+#include "MipChain.h"
+#include <cstdio>
+#include <random>
+
+FRAMEWORK_BENCHMARK(mipChain2k)
+{
+	const int size = 2048;
+	const double megapixels = (double)size * size / 1e6;
+	std::mt19937 random(1);
+	std::vector<unsigned char> source((size_t)size * size * 4);
+	for (unsigned char& value : source)
+	{
+		value = (unsigned char)random();
+	}
+	std::vector<unsigned char> half((size_t)size * size);
+
+	const bool avx2Settings[] = { false, true };
+	for (int mode = 0; mode < 4; mode++)
+	{
+		MipSettings settings;
+		settings.srgb = (mode & 1) != 0;
+		settings.kaiser = (mode & 2) != 0;
+		double scalar = timeBest(3, [&]() { downsampleRGBA8Scalar(source.data(), size, size, half.data(), settings); });
+		printf("  %s %s: Scalar %.0f", settings.kaiser ? "Kaiser" : "box", settings.srgb ? "sRGB" : "linear", megapixels * 1000.0 / scalar);
+		for (bool avx2 : avx2Settings)
+		{
+			setAvx2KernelsEnabled(avx2);
+			if (avx2 && !useAvx2Kernels())
+			{
+				continue;
+			}
+			double simd = timeBest(3, [&]() { downsampleRGBA8(source.data(), size, size, half.data(), settings); });
+			printf(", %s %.0f", getMipChainKernelName(), megapixels * 1000.0 / simd);
+		}
+		settings.threadCount = 0;
+		double threaded = timeBest(3, [&]() { downsampleRGBA8(source.data(), size, size, half.data(), settings); });
+		printf(", threaded %.0f MPixel/s\n", megapixels * 1000.0 / threaded);
+	}
+
+	std::vector<float> minSource((size_t)size * size);
+	std::vector<float> maxSource(minSource.size());
+	for (size_t i = 0; i < minSource.size(); i++)
+	{
+		minSource[i] = (float)(random() % 1000);
+		maxSource[i] = minSource[i] + 1.0f;
+	}
+	std::vector<float> minOut(minSource.size() / 4);
+	std::vector<float> maxOut(minOut.size());
+	double scalar = timeBest(5, [&]() { reduceMinMaxScalar(minSource.data(), maxSource.data(), size, size, minOut.data(), maxOut.data()); });
+	printf("  min/max: Scalar %.0f", megapixels * 1000.0 / scalar);
+	for (bool avx2 : avx2Settings)
+	{
+		setAvx2KernelsEnabled(avx2);
+		if (avx2 && !useAvx2Kernels())
+		{
+			continue;
+		}
+		double simd = timeBest(5, [&]() { reduceMinMax(minSource.data(), maxSource.data(), size, size, minOut.data(), maxOut.data()); });
+		printf(", %s %.0f", getMipChainKernelName(), megapixels * 1000.0 / simd);
+	}
+	printf(" MCells/s\n");
+	setAvx2KernelsEnabled(true);
+}
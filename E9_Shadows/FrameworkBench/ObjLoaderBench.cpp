@@ -0,0 +1,65 @@
+// OBJ loader benchmarks
+// Megabytes of OBJ text per second loaded from the res models and from a synthetic grid of millions of faces,
+// and parsed from memory at each thread count.
+#include "FrameworkBench.h"
+#include "../FrameworkTests/TestObjWriter.h"
+#include "ObjLoader.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+static void benchmarkObjFile(const char* name, const std::string& filename)
+{
+	std::error_code error;
+	double megabytes = (double)std::filesystem::file_size(filename, error) / (1 << 20);
+	ObjMesh mesh;
+	if (error || !loadObj(filename, mesh))
+	{
+		printf("  %s not found or not parsed, skipped\n", filename.c_str());
+		return;
+	}
+	size_t triangles = mesh.vertices.size() / 3;
+
+	double warm = timeBest(3, [&]() { loadObj(filename, mesh); });
+	printf("  %-9s %7.2f MB %8d triangles: warm %.1f MB/s", name, megabytes, (int)triangles, megabytes * 1000.0 / warm);
+	if (canDropFileCache())
+	{
+		double cold = timeMedian(3, [&]() { dropFileCache(filename); }, [&]() { loadObj(filename, mesh); });
+		printf(", cold %.1f MB/s", megabytes * 1000.0 / cold);
+	}
+	printf("\n");
+}
+
+FRAMEWORK_BENCHMARK(objLoadFiles)
+{
+	const char* models[] = { "teapot", "drone", "ScaleBot" };
+	for (const char* model : models)
+	{
+		benchmarkObjFile(model, getResourceDirectory() + "/" + model + ".obj");
+	}
+
+	// 1200 x 1200 vertices written as separate triangles: almost three million faces.
+	std::string filename = getBenchmarkDirectory("objLoadFiles") + "/grid.obj";
+	{
+		std::string text = makeTestObj(1200, 1200, false);
+		std::ofstream file(filename, std::ios::binary);
+		file.write(text.data(), text.size());
+	}
+	benchmarkObjFile("grid", filename);
+	std::error_code ignored;
+	std::filesystem::remove(filename, ignored);
+}
+
+FRAMEWORK_BENCHMARK(objParseThreads)
+{
+	std::string text = makeTestObj(700, 700, true);
+	double megabytes = (double)text.size() / (1 << 20);
+	printf("  %.1f MB of quads, %u hardware threads:", megabytes, std::thread::hardware_concurrency());
+	for (unsigned threads : { 1u, 2u, 4u, 8u })
+	{
+		ObjMesh mesh;
+		double milliseconds = timeBest(3, [&]() { parseObj(text.data(), text.size(), mesh, true, threads); });
+		printf(" %u: %.1f MB/s%s", threads, megabytes * 1000.0 / milliseconds, threads < 8 ? "," : "\n");
+	}
+}
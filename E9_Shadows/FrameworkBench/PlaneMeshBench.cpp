@@ -0,0 +1,86 @@
+// Plane mesh benchmarks
+// CPU cost of a height scale change on the 300-resolution heightmapped plane: rebuilding the mesh against
+// rescaling it in place. Copies into fresh arrays stand in for the buffer uploads.
+#include "FrameworkBench.h"
+#include "HeightmapCache.h"
+#include "TerrainGrid.h"
+#include "TerrainNormals.h"
+#include <cstdio>
+#include <cstring>
+
+static const int planeResolution = 300;
+
+// What PlaneMesh::initBuffers does, then the copies CreateBuffer makes of both arrays.
+static size_t rebuildPlane(const std::string& heightmapPath, float heightScale)
+{
+	std::shared_ptr<const Heightmap> heightmap = HeightmapCache::load(heightmapPath);
+	if (!heightmap)
+	{
+		return 0;
+	}
+	HeightfieldView view = heightmap->getView(1.0f);
+	TerrainGrid grid;
+	buildTerrainGrid(planeResolution, &view, grid);
+
+	std::vector<float> unitHeights(grid.vertices.size());
+	std::vector<float> heights(grid.vertices.size());
+	for (size_t i = 0; i < grid.vertices.size(); i++)
+	{
+		unitHeights[i] = grid.vertices[i].position[1];
+		heights[i] = unitHeights[i] * heightScale;
+		grid.vertices[i].position[1] = heights[i];
+	}
+	computeTerrainNormals(heights.data(), planeResolution, planeResolution, 1.0f, 1.0f, grid.vertices[0].normal, sizeof(TerrainVertex) / sizeof(float));
+
+	std::vector<TerrainVertex> vertexBuffer(grid.vertices);
+	std::vector<unsigned char> indexBuffer(grid.getIndexCount() * grid.getIndexStride());
+	memcpy(indexBuffer.data(), grid.getIndexData(), indexBuffer.size());
+	return vertexBuffer.size() + indexBuffer.size();
+}
+
+FRAMEWORK_BENCHMARK(planeMeshHeightScale)
+{
+	std::string heightmapPath = getResourceDirectory() + "/height.png";
+	HeightmapCache::clear();
+	if (!rebuildPlane(heightmapPath, 1.0f))
+	{
+		printf("  no %s\n", heightmapPath.c_str());
+		return;
+	}
+
+	const int runs = 20;
+	float scale = 1.0f;
+	double rebuildDecode = timeBest(runs, [&]()
+	{
+		HeightmapCache::clear();
+		rebuildPlane(heightmapPath, scale += 0.01f);
+	});
+	double rebuildCached = timeBest(runs, [&]() { rebuildPlane(heightmapPath, scale += 0.01f); });
+
+	// What PlaneMesh::setHeightScale does, with a copy in place of UpdateSubresource.
+	std::shared_ptr<const Heightmap> heightmap = HeightmapCache::load(heightmapPath);
+	HeightfieldView view = heightmap->getView(1.0f);
+	TerrainGrid grid;
+	buildTerrainGrid(planeResolution, &view, grid);
+	std::vector<float> unitHeights(grid.vertices.size());
+	for (size_t i = 0; i < grid.vertices.size(); i++)
+	{
+		unitHeights[i] = grid.vertices[i].position[1];
+	}
+	std::vector<TerrainVertex> vertexBuffer(grid.vertices.size());
+	double rescale = timeBest(runs, [&]()
+	{
+		scale += 0.01f;
+		std::vector<float> heights(grid.vertices.size());
+		for (size_t i = 0; i < grid.vertices.size(); i++)
+		{
+			heights[i] = unitHeights[i] * scale;
+			grid.vertices[i].position[1] = heights[i];
+		}
+		computeTerrainNormals(heights.data(), planeResolution, planeResolution, 1.0f, 1.0f, grid.vertices[0].normal, sizeof(TerrainVertex) / sizeof(float));
+		memcpy(vertexBuffer.data(), grid.vertices.data(), vertexBuffer.size() * sizeof(TerrainVertex));
+	});
+
+	printf("  %dx%d plane, best of %d: rebuild with decode %.2f ms, rebuild from cache %.2f ms, rescale in place %.2f ms\n",
+		planeResolution, planeResolution, runs, rebuildDecode, rebuildCached, rescale);
+}
@@ -0,0 +1,38 @@
+// Terrain normals benchmarks
+// Normals of a 4096x4096 height grid with each kernel.
+#include "FrameworkBench.h"
+#include "CpuFeatures.h"
+#include "TerrainNormals.h"
+#include "TerrainGrid.h"
+#include <cmath>
+#include <cstdio>
+
+FRAMEWORK_BENCHMARK(terrainNormals4k)
+{
+	const int size = 4096;
+	std::vector<float> heights((size_t)size * size);
+	for (int y = 0; y < size; y++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			heights[(size_t)y * size + x] = 20.0f * sinf(x * 0.01f) * cosf(y * 0.013f);
+		}
+	}
+	std::vector<TerrainVertex> vertices((size_t)size * size);
+	const size_t stride = sizeof(TerrainVertex) / sizeof(float);
+
+	double scalar = timeBest(3, [&]() { computeTerrainNormalsScalar(heights.data(), size, size, 1.0f, 1.0f, vertices[0].normal, stride); });
+	printf("  Scalar: %.1f ms\n", scalar);
+	const bool avx2Settings[] = { false, true };
+	for (bool avx2 : avx2Settings)
+	{
+		setAvx2KernelsEnabled(avx2);
+		if (avx2 && !useAvx2Kernels())
+		{
+			continue;
+		}
+		double simd = timeBest(3, [&]() { computeTerrainNormals(heights.data(), size, size, 1.0f, 1.0f, vertices[0].normal, stride); });
+		printf("  %s: %.1f ms\n", getTerrainNormalsKernelName(), simd);
+	}
+	setAvx2KernelsEnabled(true);
+}
@@ -0,0 +1,79 @@
+// Terrain query benchmarks
+// Height lookups and raycasts per second over a 4096x4096 heightmap, made by doubling res/height.png.
+#include "FrameworkBench.h"
+#include "HeightmapCache.h"
+#include "TerrainQuery.h"
+#include <cstdio>
+#include <random>
+
+FRAMEWORK_BENCHMARK(terrainQuery4k)
+{
+	std::shared_ptr<const Heightmap> heightmap = HeightmapCache::load(getResourceDirectory() + "/height.png");
+	if (!heightmap)
+	{
+		printf("  height.png not found, skipped\n");
+		return;
+	}
+
+	// Nearest upsample with a little ripple, so the finest pyramid levels are not flat.
+	const int size = 4096;
+	std::vector<float> heights((size_t)size * size);
+	for (int z = 0; z < size; z++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			int sourceX = x * heightmap->width / size;
+			int sourceZ = z * heightmap->height / size;
+			heights[(size_t)z * size + x] = heightmap->samples[(size_t)sourceZ * heightmap->width + sourceX] + ((x * 7 + z * 13) % 17) * 0.001f;
+		}
+	}
+	TerrainQuery query;
+	double build = timeMilliseconds([&]() { query.build(heights.data(), size, size); });
+	query.setTransform(-50.0f, 0.0f, -10.0f, 0.25f, 80.0f);
+	printf("  built %d levels in %.1f ms\n", query.getLevelCount(), build);
+
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	const size_t count = 1 << 22;
+	std::vector<float> xs(count), zs(count), results(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		xs[i] = -60.0f + unit(random) * 1050.0f;
+		zs[i] = -20.0f + unit(random) * 1050.0f;
+	}
+	double single = timeBest(3, [&]()
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			results[i] = query.getHeight(xs[i], zs[i]);
+		}
+	});
+	double scalar = timeBest(3, [&]() { query.getHeightsScalar(xs.data(), zs.data(), results.data(), count); });
+	double batched = timeBest(3, [&]() { query.getHeights(xs.data(), zs.data(), results.data(), count); });
+	printf("  heights: getHeight %.1f M/s, getHeightsScalar %.1f M/s, getHeights %.1f M/s\n", count / single / 1000.0,
+		count / scalar / 1000.0, count / batched / 1000.0);
+
+	// Rays from above the terrain, pointing down at a slant, as cursor picking does.
+	const int rayCount = 100000;
+	std::vector<float> origins(rayCount * 3), directions(rayCount * 3);
+	for (int i = 0; i < rayCount; i++)
+	{
+		origins[i * 3 + 0] = -50.0f + unit(random) * 1024.0f;
+		origins[i * 3 + 1] = 100.0f;
+		origins[i * 3 + 2] = -10.0f + unit(random) * 1024.0f;
+		directions[i * 3 + 0] = unit(random) - 0.5f;
+		directions[i * 3 + 1] = -0.3f;
+		directions[i * 3 + 2] = unit(random) - 0.5f;
+	}
+	int hits = 0;
+	double rays = timeBest(3, [&]()
+	{
+		hits = 0;
+		for (int i = 0; i < rayCount; i++)
+		{
+			TerrainRayHit hit;
+			hits += query.raycast(&origins[i * 3], &directions[i * 3], 5000.0f, hit) ? 1 : 0;
+		}
+	});
+	printf("  raycasts: %.0f k/s, %d of %d hit\n", rayCount / rays, hits, rayCount);
+}
@@ -0,0 +1,36 @@
+// Texture atlas benchmarks
+// Build time and packing efficiency for sets of small textures at each gutter size.
+#include "FrameworkBench.h"
+#include "TextureAtlas.h"
+#include <cstdio>
+#include <random>
+
+FRAMEWORK_BENCHMARK(textureAtlasPacking)
+{
+	std::mt19937 random(7);
+	const int counts[] = { 64, 400, 1500 };
+	for (int count : counts)
+	{
+		std::vector<std::vector<unsigned char>> images(count);
+		std::vector<AtlasSource> sources(count);
+		for (int i = 0; i < count; i++)
+		{
+			int width = 8 + random() % 249;
+			int height = 8 + random() % 249;
+			images[i].assign((size_t)width * height * 4, (unsigned char)random());
+			sources[i] = { images[i].data(), width, height };
+		}
+		for (int mipLevels = 2; mipLevels <= 4; mipLevels++)
+		{
+			AtlasSettings settings;
+			settings.mipLevels = mipLevels;
+			TextureAtlas atlas;
+			double single = timeBest(3, [&]() { buildTextureAtlas(sources, atlas, settings); });
+			settings.threadCount = 0;
+			double threaded = timeBest(3, [&]() { buildTextureAtlas(sources, atlas, settings); });
+			printf("  %d textures, %d levels: %d pages, %.1f%% of page texels used (%.1f%% of cells), %.1f ms, threaded %.1f ms\n",
+				count, mipLevels, (int)atlas.pages.size(), atlas.stats.getEfficiency() * 100.0f,
+				100.0 * atlas.stats.sourceTexels / atlas.stats.cellTexels, single, threaded);
+		}
+	}
+}
@@ -0,0 +1,93 @@
+// Texture cache benchmarks
+// Load time of each res image through stb_image, through decodeTexture with its mips, and from RGBA8 and BC caches.
+#include "FrameworkBench.h"
+#include "TextureCache.h"
+#include "stb_image.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+// Reading every page once stands in for the upload, so mapped caches are paid for like the others.
+static unsigned char readAll(const DecodedTexture& texture)
+{
+	const unsigned char* pixels = texture.isDds() ? texture.ddsData.data() : texture.getPixels();
+	size_t size = texture.isDds() ? texture.ddsData.size() : texture.getPixelsSize();
+	unsigned char sum = 0;
+	for (size_t i = 0; i < size; i += 4096)
+	{
+		sum ^= pixels[i];
+	}
+	return sum;
+}
+
+FRAMEWORK_BENCHMARK(textureCacheLoad)
+{
+	// The caches are written next to their source, so the images are copied out of res first.
+	std::string directory = getBenchmarkDirectory("textureCacheLoad");
+	const char* images[] = { "wood.png", "bunny.png", "checkerboard.png", "EvilDrone_Diff.jpg" };
+	volatile unsigned char sink = 0;
+	for (const char* image : images)
+	{
+		std::string filename = directory + "/" + image;
+		std::error_code ignored;
+		if (!std::filesystem::copy_file(getResourceDirectory() + "/" + image, filename, ignored))
+		{
+			printf("  %s not found, skipped\n", image);
+			continue;
+		}
+
+		// Build both caches before timing. The RGBA8 one last, as a fresh BC cache comes back as DDS bytes.
+		DecodedTexture texture;
+		std::string error;
+		if (!loadCachedTexture(filename, texture, error, true) || !loadCachedTexture(filename, texture, error, false))
+		{
+			printf("  %s: %s\n", image, error.c_str());
+			continue;
+		}
+		std::string rgbaCache = getTextureCacheFilename(filename, false);
+		std::string bcCache = getTextureCacheFilename(filename, true);
+		bool compressed = std::filesystem::exists(bcCache);
+
+		const bool coldRuns[] = { false, true };
+		for (bool cold : coldRuns)
+		{
+			if (cold && !canDropFileCache())
+			{
+				continue;
+			}
+			int runs = cold ? 3 : 5;
+			auto drop = [&](const std::string& file) { return [&, file]() { if (cold) dropFileCache(file); }; };
+			double stb = timeMedian(runs, drop(filename), [&]()
+			{
+				std::ifstream in(filename, std::ios::binary);
+				std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+				int width, height, channels;
+				unsigned char* pixels = stbi_load_from_memory(bytes.data(), (int)bytes.size(), &width, &height, &channels, 4);
+				sink = sink ^ (pixels ? pixels[0] : 0);
+				stbi_image_free(pixels);
+			});
+			double decode = timeMedian(runs, drop(filename), [&]()
+			{
+				DecodedTexture decoded;
+				decodeTexture(filename, decoded, error);
+				sink = sink ^ readAll(decoded);
+			});
+			double rgba = timeMedian(runs, drop(rgbaCache), [&]()
+			{
+				DecodedTexture decoded;
+				loadCachedTexture(filename, decoded, error, false, 1);
+				sink = sink ^ readAll(decoded);
+			});
+			double bc = timeMedian(runs, drop(bcCache), [&]()
+			{
+				DecodedTexture decoded;
+				loadCachedTexture(filename, decoded, error, true, 1);
+				sink = sink ^ readAll(decoded);
+			});
+			printf("  %s %dx%d %s: stb_image %.2f ms, with mips %.2f ms, RGBA8 cache %.2f ms, %s cache %.2f ms\n", image,
+				texture.getWidth(), texture.getHeight(), cold ? "cold" : "warm", stb, decode, rgba, compressed ? "BC" : "no BC (RGBA8)", bc);
+		}
+	}
+}
@@ -0,0 +1,62 @@
+// Texture decode benchmarks
+// Decoding the res images with their mip chains through TextureDecodeQueue at 1, 2, 4 and 8 workers.
+#include "FrameworkBench.h"
+#include "TextureDecodeQueue.h"
+#include <cstdio>
+#include <filesystem>
+#include <thread>
+
+FRAMEWORK_BENCHMARK(textureDecodeWorkers)
+{
+	std::vector<std::string> images;
+	std::error_code error;
+	for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(getResourceDirectory(), error))
+	{
+		std::string extension = entry.path().extension().string();
+		if (extension == ".png" || extension == ".jpg")
+		{
+			images.push_back(entry.path().string());
+		}
+	}
+	if (images.empty())
+	{
+		printf("  no images in %s, skipped\n", getResourceDirectory().c_str());
+		return;
+	}
+
+	// Each image is queued several times so every worker count has enough files to share out.
+	const int copies = 4;
+	printf("  %d images x %d, %d hardware threads\n", (int)images.size(), copies, (int)std::thread::hardware_concurrency());
+	double single = 0.0;
+	const int workerCounts[] = { 1, 2, 4, 8 };
+	for (int workers : workerCounts)
+	{
+		TextureDecodeQueue queue(workers);
+		size_t bytes = 0;
+		int failed = 0;
+		double time = timeBest(3, [&]()
+		{
+			bytes = 0;
+			for (int copy = 0; copy < copies; copy++)
+			{
+				for (const std::string& image : images)
+				{
+					queue.push(image);
+				}
+			}
+			queue.wait();
+			TextureDecodeResult result;
+			while (queue.pop(result))
+			{
+				bytes += result.texture.getPixelsSize();
+				failed += result.succeeded ? 0 : 1;
+			}
+		});
+		if (workers == 1)
+		{
+			single = time;
+		}
+		printf("  %d workers: %8.2f ms, %7.1f MB of mips/s, %.2fx%s\n", workers, time, (double)bytes / (1 << 20) * 1000.0 / time,
+			single / time, failed ? ", some FAILED" : "");
+	}
+}
@@ -0,0 +1,76 @@
+// Texture residency benchmarks
+// Cost of update() replaying a camera sweep over thousands of streamed textures, and the loads and evictions it plans.
+#include "FrameworkBench.h"
+#include "TextureResidency.h"
+#include <cstdio>
+#include <random>
+
+static std::vector<uint64_t> makeLevelBytes(int size, int bytesPerPixel)
+{
+	std::vector<uint64_t> levels;
+	for (; size >= 1; size /= 2)
+	{
+		levels.push_back((uint64_t)size * size * bytesPerPixel);
+	}
+	return levels;
+}
+
+FRAMEWORK_BENCHMARK(textureResidencyTrace)
+{
+	const uint32_t textureCount = 4000;
+	const int frames = 3000;
+	const int visible = 300;
+	std::mt19937 random(1);
+	ResidencySettings settings;
+	settings.budgetBytes = 512ull << 20;
+	TextureResidency residency(settings);
+	uint64_t allBytes = 0;
+	for (uint32_t id = 1; id <= textureCount; id++)
+	{
+		std::vector<uint64_t> levels = makeLevelBytes(256 << (random() % 4), (random() & 1) ? 4 : 1);
+		for (uint64_t level : levels)
+		{
+			allBytes += level;
+		}
+		residency.addTexture(id, levels);
+	}
+
+	// The camera moves three textures a frame. Near draws want full detail, further ones coarser levels.
+	std::vector<ResidencyChange> changes;
+	std::vector<ResidencyChange> landing;
+	std::vector<double> times;
+	for (int frame = 0; frame < frames; frame++)
+	{
+		uint32_t start = (uint32_t)(frame * 3) % textureCount;
+		for (int i = 0; i < visible; i++)
+		{
+			residency.markUsed((start + i) % textureCount + 1, i * 3 / visible);
+		}
+		for (const ResidencyChange& change : landing)
+		{
+			residency.completeLoad(change.id, change.mip);
+		}
+		landing.clear();
+		times.push_back(timeMilliseconds([&]() { residency.update(changes); }));
+		for (const ResidencyChange& change : changes)
+		{
+			if (change.load)
+			{
+				landing.push_back(change);
+			}
+		}
+	}
+
+	double total = 0.0;
+	for (double time : times)
+	{
+		total += time;
+	}
+	std::sort(times.begin(), times.end());
+	const ResidencyStats& stats = residency.getStats();
+	printf("  %u textures (%.0f MB) in a %.0f MB budget, %d drawn per frame\n", textureCount, allBytes / 1048576.0,
+		settings.budgetBytes / 1048576.0, visible);
+	printf("  update: mean %.3f ms, median %.3f ms, worst %.3f ms\n", total / frames, times[times.size() / 2], times.back());
+	printf("  %llu loads (%.0f MB), %llu levels evicted (%.0f MB)\n", (unsigned long long)stats.loads, stats.loadedBytes / 1048576.0,
+		(unsigned long long)stats.evictions, stats.evictedBytes / 1048576.0);
+}
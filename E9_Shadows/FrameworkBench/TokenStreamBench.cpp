@@ -0,0 +1,51 @@
+// Token stream benchmarks
+// Tokenizing 32 MB of OBJ-like text with the original copying stream, the std::string overloads and the views.
+#include "FrameworkBench.h"
+#include "../FrameworkTests/ReferenceTokenStream.h"
+#include "TokenStream.h"
+#include <cstdio>
+#include <random>
+
+FRAMEWORK_BENCHMARK(tokenStreamObjText)
+{
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> coordinate(-10.0f, 10.0f);
+	std::string text;
+	char line[128];
+	while (text.size() < (32u << 20))
+	{
+		snprintf(line, sizeof(line), "v %f %f %f\nf %d/%d/%d %d/%d/%d %d/%d/%d\n", coordinate(random), coordinate(random), coordinate(random),
+			(int)(random() % 1000), 2, 3, 4, 5, 6, 7, 8, 9);
+		text += line;
+	}
+	const char delimiters[] = { '\n', ' ', '/' };
+	double megabytes = text.size() / (1024.0 * 1024.0);
+	size_t tokens = 0;
+
+	double reference = timeBest(3, [&]()
+	{
+		ReferenceTokenStream stream;
+		stream.SetTokenStream(text.c_str());
+		std::string token;
+		for (tokens = 0; stream.GetNextToken(&token, delimiters, 3); tokens++);
+	});
+	printf("  reference: %.0f MB/s (%d tokens)\n", megabytes / reference * 1000.0, (int)tokens);
+
+	double copying = timeBest(3, [&]()
+	{
+		TokenStream stream;
+		stream.SetTokenStream((char*)text.c_str());
+		std::string token;
+		for (tokens = 0; stream.GetNextToken(&token, delimiters, 3); tokens++);
+	});
+	printf("  std::string: %.0f MB/s (%.1fx)\n", megabytes / copying * 1000.0, reference / copying);
+
+	double viewing = timeBest(3, [&]()
+	{
+		TokenStream stream;
+		stream.SetTokenStream(std::string_view(text));
+		std::string_view token;
+		for (tokens = 0; stream.GetNextToken(token, delimiters, 3); tokens++);
+	});
+	printf("  string_view: %.0f MB/s (%.1fx)\n", megabytes / viewing * 1000.0, reference / viewing);
+}
@@ -0,0 +1,176 @@
+// Asset pack tests
+// Round trips generated files through a pack, and checks corrupt packs fail cleanly.
+#include "FrameworkTest.h"
+#include "AssetPack.h"
+#include "ContentHash.h"
+#include "Lz4Block.h"
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+// Text that compresses, noise that does not, a duplicate, an empty file and an entry of several blocks.
+static void writePackSources(const std::string& directory, std::vector<AssetPackSource>& sources, std::vector<std::vector<unsigned char>>& contents)
+{
+	std::mt19937 random(1);
+	std::string text;
+	for (int i = 0; text.size() < 300000; i++)
+	{
+		text += "v " + std::to_string(random() % 1000) + ".5 " + std::to_string(i % 97) + " 1.0\n";
+	}
+	std::vector<unsigned char> noise(70000);
+	for (unsigned char& byte : noise)
+	{
+		byte = (unsigned char)random();
+	}
+
+	contents.push_back(std::vector<unsigned char>(text.begin(), text.end()));
+	contents.push_back(noise);
+	contents.push_back(noise);
+	contents.push_back(std::vector<unsigned char>());
+	contents.push_back(std::vector<unsigned char>(text.begin(), text.begin() + 1000));
+	const char* names[] = { "models/big.obj", "textures/noise.bin", "textures/Copy.bin", "empty.txt", "models/sub/small.obj" };
+	for (size_t i = 0; i < contents.size(); i++)
+	{
+		std::string filename = directory + "/" + std::to_string(i) + ".src";
+		writeTestFile(filename, contents[i].data(), contents[i].size());
+		sources.push_back({ names[i], filename });
+	}
+}
+
+FRAMEWORK_TEST(assetPackRoundTrip)
+{
+	std::string directory = getTestDirectory("assetPackRoundTrip");
+	std::vector<AssetPackSource> sources;
+	std::vector<std::vector<unsigned char>> contents;
+	writePackSources(directory, sources, contents);
+
+	std::string packFilename = directory + "/test.pack";
+	std::string error;
+	AssetPackSettings settings;
+	settings.blockSize = 64 * 1024;
+	AssetPackStats stats;
+	CHECK(buildAssetPack(packFilename, sources, error, settings, &stats));
+	CHECK(stats.files == sources.size());
+	CHECK(stats.duplicateFiles == 1);
+	CHECK(stats.compressedFiles >= 1);
+	CHECK(stats.storedBytes < stats.sourceBytes);
+
+	AssetPack pack;
+	CHECK(pack.open(packFilename));
+	CHECK(pack.getEntryCount() == sources.size());
+	for (size_t i = 0; i < sources.size(); i++)
+	{
+		int index = pack.find(normaliseAssetPath(sources[i].name));
+		CHECK(index >= 0);
+		if (index < 0)
+		{
+			continue;
+		}
+		const AssetPackEntry& entry = pack.getEntry(index);
+		CHECK(entry.size == contents[i].size());
+		CHECK(entry.contentHash == hashContent(contents[i].data(), contents[i].size()));
+		std::vector<unsigned char> data((size_t)entry.size + 1);
+		CHECK(pack.read(index, data.data(), 2));
+		CHECK(contents[i].empty() || memcmp(data.data(), contents[i].data(), contents[i].size()) == 0);
+	}
+	CHECK(pack.getStoredData(pack.find("textures/noise.bin")) != nullptr);
+	CHECK(pack.find("missing.txt") < 0);
+	pack.close();
+
+	// Mounted, MappedFile finds the files however the path is spelt, and shares open copies.
+	CHECK(mountAssetPack(packFilename, directory));
+	MappedFile first;
+	MappedFile second;
+	CHECK(first.open(directory + "\\MODELS\\.\\x\\..\\Big.obj"));
+	CHECK(second.open(directory + "/models/big.obj"));
+	CHECK(first.getSize() == contents[0].size() && memcmp(first.getData(), contents[0].data(), contents[0].size()) == 0);
+	CHECK(first.getData() == second.getData());
+	MappedFile empty;
+	CHECK(empty.open(directory + "/empty.txt") && empty.getSize() == 0);
+	MappedFile missing;
+	CHECK(!missing.open(directory + "/models/missing.obj"));
+	unmountAssetPacks();
+	CHECK(first.getSize() == contents[0].size() && first.getData()[0] == contents[0][0]);
+}
+
+FRAMEWORK_TEST(assetPackCorruption)
+{
+	std::string directory = getTestDirectory("assetPackCorruption");
+	std::vector<AssetPackSource> sources;
+	std::vector<std::vector<unsigned char>> contents;
+	writePackSources(directory, sources, contents);
+	std::string packFilename = directory + "/test.pack";
+	std::string error;
+	AssetPackSettings settings;
+	settings.blockSize = 64 * 1024;
+	CHECK(buildAssetPack(packFilename, sources, error, settings));
+	std::vector<unsigned char> original;
+	CHECK(readTestFile(packFilename, original));
+
+	// Flip a few bits, half the time in the index and name table at the end. Every corrupt pack must fail to open,
+	// fail to read, or read back entries of the sizes it claims, without crashing.
+	std::mt19937 random(1);
+	std::string corruptFilename = directory + "/corrupt.pack";
+	int opened = 0;
+	int readFailures = 0;
+	for (int test = 0; test < 300; test++)
+	{
+		std::vector<unsigned char> corrupt = original;
+		int flips = 1 + random() % 8;
+		for (int i = 0; i < flips; i++)
+		{
+			size_t offset = (test % 2) ? corrupt.size() - 1 - random() % 1024 : random() % corrupt.size();
+			corrupt[offset] ^= (unsigned char)(1 << (random() % 8));
+		}
+		writeTestFile(corruptFilename, corrupt.data(), corrupt.size());
+
+		AssetPack pack;
+		if (!pack.open(corruptFilename))
+		{
+			continue;
+		}
+		opened++;
+		for (uint32_t i = 0; i < pack.getEntryCount(); i++)
+		{
+			// A corrupt size can still claim far more than the pack could hold. Loading one is an allocation
+			// failure, not a read, so it is left out here.
+			const AssetPackEntry& entry = pack.getEntry(i);
+			if (entry.size > 64 * original.size())
+			{
+				readFailures++;
+				continue;
+			}
+			std::vector<unsigned char> data((size_t)entry.size);
+			readFailures += pack.read(i, data.data(), 2) ? 0 : 1;
+		}
+	}
+	printf("  %d of 300 corrupt packs opened, %d entry reads failed\n", opened, readFailures);
+	CHECK(opened < 300);
+}
+
+FRAMEWORK_TEST(lz4CorruptBlocks)
+{
+	std::string text;
+	for (int i = 0; text.size() < 100000; i++)
+	{
+		text += "f " + std::to_string(i) + "/" + std::to_string(i % 13) + " " + std::to_string(i + 1) + "\n";
+	}
+	std::vector<unsigned char> compressed(getLz4Bound(text.size()));
+	size_t compressedSize = compressLz4((const unsigned char*)text.data(), text.size(), compressed.data(), compressed.size());
+	CHECK(compressedSize > 0 && compressedSize < text.size());
+	compressed.resize(compressedSize);
+
+	std::vector<unsigned char> output(text.size());
+	CHECK(decompressLz4(compressed.data(), compressed.size(), output.data(), output.size()));
+	CHECK(memcmp(output.data(), text.data(), text.size()) == 0);
+	CHECK(!decompressLz4(compressed.data(), compressed.size() - 1, output.data(), output.size()));
+	CHECK(!decompressLz4(compressed.data(), compressed.size(), output.data(), output.size() - 1));
+
+	std::mt19937 random(2);
+	for (int test = 0; test < 2000; test++)
+	{
+		std::vector<unsigned char> corrupt = compressed;
+		corrupt[random() % corrupt.size()] ^= (unsigned char)(1 << (random() % 8));
+		decompressLz4(corrupt.data(), corrupt.size(), output.data(), output.size());
+	}
+}
@@ -0,0 +1,169 @@
+// Block compression tests
+// SIMD and threaded output against the scalar reference, edge blocks, BC1 opacity and decoded quality.
+#include "FrameworkTest.h"
+#include "BlockCompress.h"
+#include "TestBlockDecode.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+static const uint32_t blockFormats[] = { blockFormatBC1, blockFormatBC3, blockFormatBC5 };
+
+// Smooth gradients and soft edges with a little noise, like a photographic texture. Alpha and green follow their own ramps.
+static std::vector<unsigned char> makeBlockImage(int width, int height, unsigned int seed)
+{
+	std::mt19937 random(seed);
+	std::vector<unsigned char> rgba((size_t)width * height * 4);
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			float base[4] = {
+				128.0f + 100.0f * sinf(x * 0.05f) * cosf(y * 0.03f),
+				128.0f + 90.0f * cosf((x + y) * 0.04f),
+				(x / 16 + y / 16) % 2 ? 200.0f : 60.0f,
+				255.0f * x / width,
+			};
+			for (int channel = 0; channel < 4; channel++)
+			{
+				float value = base[channel] + (float)(random() % 9) - 4.0f;
+				rgba[((size_t)y * width + x) * 4 + channel] = (unsigned char)std::min(std::max(value, 0.0f), 255.0f);
+			}
+		}
+	}
+	return rgba;
+}
+
+FRAMEWORK_TEST(blockCompressMatchesScalar)
+{
+	// Random noise is the worst case for the endpoint search, so any difference in rounding shows up.
+	std::mt19937 random(7);
+	std::vector<unsigned char> noise(256 * 200 * 4);
+	for (unsigned char& value : noise)
+	{
+		value = (unsigned char)random();
+	}
+	std::vector<unsigned char> smooth = makeBlockImage(256, 200, 1);
+	const std::vector<unsigned char>* images[] = { &noise, &smooth };
+	for (const std::vector<unsigned char>* image : images)
+	{
+		for (uint32_t format : blockFormats)
+		{
+			std::vector<unsigned char> expected(getCompressedSize(256, 200, format));
+			CHECK(compressImageScalar(image->data(), 256, 200, format, expected.data()));
+			const int threadCounts[] = { 0, 1, 3, 8, 64 };
+			for (int threads : threadCounts)
+			{
+				std::vector<unsigned char> blocks(expected.size());
+				CHECK(compressImage(image->data(), 256, 200, format, blocks.data(), threads));
+				CHECK(blocks == expected);
+			}
+		}
+	}
+	CHECK(!compressImage(smooth.data(), 256, 200, 0, nullptr));
+	CHECK(!compressImageScalar(smooth.data(), 0, 200, blockFormatBC1, nullptr));
+}
+
+FRAMEWORK_TEST(blockCompressEdges)
+{
+	// Images that do not fill their last blocks write exactly getCompressedSize bytes, and the padding repeats the edge.
+	for (int height = 1; height <= 9; height++)
+	{
+		for (int width = 1; width <= 9; width++)
+		{
+			std::vector<unsigned char> image = makeBlockImage(width, height, width * 16 + height);
+			for (uint32_t format : blockFormats)
+			{
+				size_t size = getCompressedSize(width, height, format);
+				CHECK(size == (size_t)((width + 3) / 4) * ((height + 3) / 4) * getBlockSize(format));
+				std::vector<unsigned char> blocks(size + 64, 0xcd);
+				CHECK(compressImage(image.data(), width, height, format, blocks.data(), 3));
+				bool untouched = true;
+				for (size_t i = size; i < blocks.size(); i++)
+				{
+					untouched = untouched && blocks[i] == 0xcd;
+				}
+				CHECK(untouched);
+				std::vector<unsigned char> scalar(size);
+				CHECK(compressImageScalar(image.data(), width, height, format, scalar.data()));
+				CHECK(memcmp(blocks.data(), scalar.data(), size) == 0);
+			}
+		}
+	}
+}
+
+FRAMEWORK_TEST(blockCompressBC1Blocks)
+{
+	// BC1 is opaque here, so the three colour mode may be used but its transparent index never.
+	// A solid block is always within one 565 step (8 levels of red and blue, 4 of green) of its colour.
+	std::mt19937 random(3);
+	int transparentBlocks = 0;
+	int worstSolidError = 0;
+	for (int i = 0; i < 100000; i++)
+	{
+		int spread = (i % 4 == 0) ? 0 : (i % 4 == 1) ? 3 : (i % 4 == 2) ? 9 : 256;
+		int base[3] = { (int)(random() % 256), (int)(random() % 256), (int)(random() % 256) };
+		unsigned char pixels[64];
+		for (int p = 0; p < 16; p++)
+		{
+			for (int channel = 0; channel < 3; channel++)
+			{
+				int value = base[channel] + (spread ? (int)(random() % spread) - spread / 2 : 0);
+				pixels[p * 4 + channel] = (unsigned char)std::min(std::max(value, 0), 255);
+			}
+			pixels[p * 4 + 3] = 255;
+		}
+		unsigned char block[8];
+		compressImage(pixels, 4, 4, blockFormatBC1, block, 1);
+		std::vector<unsigned char> decoded;
+		decodeBlockImage(block, 4, 4, blockFormatBC1, decoded);
+		for (int p = 0; p < 16; p++)
+		{
+			if (decoded[p * 4 + 3] != 255)
+			{
+				transparentBlocks++;
+				break;
+			}
+		}
+		for (int p = 0; spread == 0 && p < 16; p++)
+		{
+			for (int channel = 0; channel < 3; channel++)
+			{
+				worstSolidError = std::max(worstSolidError, abs(decoded[p * 4 + channel] - pixels[p * 4 + channel]));
+			}
+		}
+	}
+	CHECK(transparentBlocks == 0);
+	CHECK(worstSolidError <= 8);
+	printf("  largest solid block error %d\n", worstSolidError);
+}
+
+FRAMEWORK_TEST(blockCompressQuality)
+{
+	// Decoded quality on a texture-like image, well clear of what a broken endpoint fit or palette would give.
+	std::vector<unsigned char> image = makeBlockImage(256, 256, 11);
+	struct QualityCase
+	{
+		uint32_t format;
+		int firstChannel;
+		int channelCount;
+		double minimumPsnr;
+	};
+	const QualityCase cases[] = {
+		{ blockFormatBC1, 0, 3, 36.0 },
+		{ blockFormatBC3, 0, 3, 36.0 },
+		{ blockFormatBC3, 3, 1, 48.0 },
+		{ blockFormatBC5, 0, 2, 45.0 },
+	};
+	for (const QualityCase& test : cases)
+	{
+		std::vector<unsigned char> blocks(getCompressedSize(256, 256, test.format));
+		CHECK(compressImage(image.data(), 256, 256, test.format, blocks.data()));
+		std::vector<unsigned char> decoded;
+		CHECK(decodeBlockImage(blocks.data(), 256, 256, test.format, decoded));
+		double psnr = getPsnr(image.data(), decoded.data(), 256, 256, test.firstChannel, test.channelCount);
+		CHECK(psnr >= test.minimumPsnr);
+		printf("  format %u channels %d-%d: %.1f dB\n", test.format, test.firstChannel, test.firstChannel + test.channelCount - 1, psnr);
+	}
+}
@@ -0,0 +1,234 @@
+// Content hash tests
+// Checks XXH64 against reference values in one go and streamed, weak expiry in ContentCache, and heightmap sharing.
+#include "FrameworkTest.h"
+#include "ContentCache.h"
+#include "HeightmapCache.h"
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+static const uint64_t prime32 = 2654435761u;
+
+// The sanity buffer of the xxHash reference tests.
+static std::vector<unsigned char> makeSanityBuffer(size_t size)
+{
+	std::vector<unsigned char> buffer(size);
+	uint64_t generator = prime32;
+	for (unsigned char& byte : buffer)
+	{
+		byte = (unsigned char)(generator >> 56);
+		generator *= 11400714785074694797ull;
+	}
+	return buffer;
+}
+
+struct HashVector
+{
+	size_t size;
+	uint64_t seed;
+	uint64_t hash;
+};
+
+// 0, 1, 14 and 222 bytes are the published sanity checks. The others come from the reference implementation and
+// cover each tail length and whole stripes.
+static const HashVector sanityVectors[] = {
+	{ 0, 0, 0xEF46DB3751D8E999ull }, { 0, prime32, 0xAC75FDA2929B17EFull },
+	{ 1, 0, 0xE934A84ADB052768ull }, { 1, prime32, 0x5014607643A9B4C3ull },
+	{ 4, 0, 0x9136A0DCA57457EEull }, { 4, prime32, 0xCAAB286BD8E9FDB5ull },
+	{ 8, 0, 0xCDBCF538E71D1348ull }, { 8, prime32, 0xFE0C047A5353CDACull },
+	{ 14, 0, 0x8282DCC4994E35C8ull }, { 14, prime32, 0xC3BD6BF63DEB6DF0ull },
+	{ 31, 0, 0x299B39A290E6D783ull }, { 31, prime32, 0xDA673D5FEB5C1D79ull },
+	{ 32, 0, 0x18B216492BB44B70ull }, { 32, prime32, 0xB3F33BDF93ADE409ull },
+	{ 33, 0, 0x55C8DC3E578F5B59ull }, { 33, prime32, 0xE92C292F64BC3071ull },
+	{ 63, 0, 0xA9EFBE0FA0F3F4E7ull }, { 63, prime32, 0x6C911FADB05B6FC2ull },
+	{ 64, 0, 0xEF558F8ACAC2B5CDull }, { 64, prime32, 0xB5EEBA99264CC44Full },
+	{ 100, 0, 0x4BFE019CD91D9EA4ull }, { 100, prime32, 0x4853706DC9625CAEull },
+	{ 222, 0, 0xB641AE8CB691C174ull }, { 222, prime32, 0x20CB8AB7AE10C14Aull },
+	{ 1000, 0, 0x52BD1358F22E9EF7ull }, { 1000, prime32, 0x72751A2408017E26ull },
+	{ 2367, 0, 0xA82418DDEC0EA581ull }, { 2367, prime32, 0xA36A93C18052673Aull },
+};
+
+FRAMEWORK_TEST(contentHashVectors)
+{
+	std::vector<unsigned char> sanity = makeSanityBuffer(2367);
+	for (const HashVector& vector : sanityVectors)
+	{
+		CHECK(hashContent(sanity.data(), vector.size, vector.seed) == vector.hash);
+	}
+
+	// Text vectors, as xxhsum prints them.
+	struct TextVector
+	{
+		const char* text;
+		uint64_t hash;
+	};
+	const TextVector textVectors[] = {
+		{ "a", 0xD24EC4F1A98C6E5Bull },
+		{ "abc", 0x44BC2CF5AD770999ull },
+		{ "message digest", 0x066ED728FCEEB3BEull },
+		{ "abcdefghijklmnopqrstuvwxyz", 0xCFE1F278FA89835Cull },
+		{ "The quick brown fox jumps over the lazy dog", 0x0B242D361FDA71BCull },
+	};
+	for (const TextVector& vector : textVectors)
+	{
+		CHECK(hashContent(vector.text, strlen(vector.text)) == vector.hash);
+	}
+}
+
+FRAMEWORK_TEST(contentHashStreaming)
+{
+	std::vector<unsigned char> sanity = makeSanityBuffer(2367);
+
+	// Every two-piece split of every vector, so each pending-stripe length is crossed.
+	bool splitsMatch = true;
+	for (const HashVector& vector : sanityVectors)
+	{
+		for (size_t split = 0; split <= vector.size; split++)
+		{
+			ContentHasher hasher(vector.seed);
+			hasher.update(sanity.data(), split);
+			hasher.update(sanity.data() + split, vector.size - split);
+			splitsMatch = splitsMatch && hasher.finish() == vector.hash && hasher.getSize() == vector.size;
+		}
+	}
+	CHECK(splitsMatch);
+
+	// Odd piece sizes that never line up with a stripe, plus empty updates in between.
+	const size_t pieceSizes[] = { 1, 3, 7, 13, 31, 33, 65, 127 };
+	bool piecesMatch = true;
+	for (size_t pieceSize : pieceSizes)
+	{
+		for (const HashVector& vector : sanityVectors)
+		{
+			ContentHasher hasher(vector.seed);
+			for (size_t offset = 0; offset < vector.size; offset += pieceSize)
+			{
+				hasher.update(sanity.data() + offset, std::min(pieceSize, vector.size - offset));
+				hasher.update(nullptr, 0);
+			}
+			piecesMatch = piecesMatch && hasher.finish() == vector.hash;
+		}
+	}
+	CHECK(piecesMatch);
+
+	// Random splits, and finish part way through leaves the stream usable.
+	std::mt19937 random(22);
+	bool randomMatch = true;
+	for (int run = 0; run < 200; run++)
+	{
+		ContentHasher hasher;
+		size_t offset = 0;
+		while (offset < sanity.size())
+		{
+			size_t piece = std::min<size_t>(random() % 97, sanity.size() - offset);
+			hasher.update(sanity.data() + offset, piece);
+			offset += piece;
+			randomMatch = randomMatch && hasher.finish() == hashContent(sanity.data(), offset);
+		}
+		randomMatch = randomMatch && hasher.finish() == 0xA82418DDEC0EA581ull;
+	}
+	CHECK(randomMatch);
+}
+
+struct FakeAsset
+{
+	int id;
+};
+
+FRAMEWORK_TEST(contentCacheExpiry)
+{
+	ContentCache<FakeAsset> cache;
+	ContentKey key;
+	key.hash = 0x1234;
+	key.size = 10;
+	ContentKey otherVariant = key;
+	otherVariant.variant = 1;
+
+	std::shared_ptr<FakeAsset> first = std::make_shared<FakeAsset>(FakeAsset{ 1 });
+	CHECK(cache.insert(key, first) == first);
+	CHECK(cache.find(key) == first);
+	CHECK(cache.find(otherVariant) == nullptr);
+	CHECK(cache.size() == 1);
+
+	// A second decode of the same contents gets the live one back.
+	std::shared_ptr<FakeAsset> second = std::make_shared<FakeAsset>(FakeAsset{ 2 });
+	CHECK(cache.insert(key, second) == first);
+	CHECK(cache.insert(otherVariant, second) == second);
+	CHECK(cache.size() == 2);
+
+	// The cache holds no strong references: further copies keep the asset alive, the last one dropping expires it.
+	std::weak_ptr<FakeAsset> watch = first;
+	std::shared_ptr<FakeAsset> copy = first;
+	first.reset();
+	CHECK(cache.find(key) == copy);
+	copy.reset();
+	CHECK(watch.expired());
+	CHECK(cache.find(key) == nullptr);
+	CHECK(cache.size() == 1);
+
+	// An expired key takes a new asset.
+	std::shared_ptr<FakeAsset> third = std::make_shared<FakeAsset>(FakeAsset{ 3 });
+	CHECK(cache.insert(key, third) == third);
+	CHECK(cache.find(key) && cache.find(key)->id == 3);
+
+	// size forgets expired entries without being asked to find them.
+	second.reset();
+	third.reset();
+	CHECK(cache.size() == 0);
+	CHECK(cache.find(otherVariant) == nullptr);
+}
+
+// An 8-bit greyscale PGM, which stb_image reads without any compression to get in the way.
+static std::vector<unsigned char> makeHeightmapFile(int size, int seed)
+{
+	std::string header = "P5\n" + std::to_string(size) + " " + std::to_string(size) + "\n255\n";
+	std::vector<unsigned char> file(header.begin(), header.end());
+	for (int i = 0; i < size * size; i++)
+	{
+		file.push_back((unsigned char)(i * 7 + seed));
+	}
+	return file;
+}
+
+FRAMEWORK_TEST(heightmapCacheSharing)
+{
+	std::string directory = getTestDirectory("heightmapCacheSharing");
+	std::vector<unsigned char> bytes = makeHeightmapFile(16, 0);
+	std::vector<unsigned char> otherBytes = makeHeightmapFile(16, 1);
+	std::string first = directory + "/first.pgm";
+	std::string copy = directory + "/copy.pgm";
+	std::string other = directory + "/other.pgm";
+	CHECK(writeTestFile(first, bytes.data(), bytes.size()));
+	CHECK(writeTestFile(copy, bytes.data(), bytes.size()));
+	CHECK(writeTestFile(other, otherBytes.data(), otherBytes.size()));
+
+	HeightmapCache::clear();
+	std::shared_ptr<const Heightmap> a = HeightmapCache::load(first);
+	std::shared_ptr<const Heightmap> b = HeightmapCache::load(copy);
+	std::shared_ptr<const Heightmap> c = HeightmapCache::load(other);
+	CHECK(a && b && c);
+	if (!a || !b || !c)
+	{
+		return;
+	}
+
+	// Two paths with identical bytes share one decode. Different bytes do not.
+	CHECK(a == b);
+	CHECK(a != c);
+	CHECK(a->width == 16 && a->height == 16 && a->samples[1] == 7 / 255.0f);
+	CHECK(HeightmapCache::load(first) == a);
+
+	// Once every path and holder lets go, the shared entry expires and the next load decodes again.
+	std::weak_ptr<const Heightmap> watch = a;
+	HeightmapCache::release(first);
+	CHECK(HeightmapCache::load(copy) == a);
+	HeightmapCache::clear();
+	CHECK(!watch.expired());
+	a.reset();
+	b.reset();
+	CHECK(watch.expired());
+	std::shared_ptr<const Heightmap> reloaded = HeightmapCache::load(copy);
+	CHECK(reloaded && reloaded->width == 16 && reloaded->samples[1] == 7 / 255.0f);
+	CHECK(HeightmapCache::load(first) == reloaded);
+	HeightmapCache::clear();
+}
@@ -0,0 +1,44 @@
+/**
+* \brief Minimal test registry and checks for the platform-neutral framework code
+*
+* Each test file defines its tests with FRAMEWORK_TEST, which registers them before main runs. CHECK records a
+* failure with its file and line and carries on, so one run reports every broken check.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _FRAMEWORKTEST_H_
+#define _FRAMEWORKTEST_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+typedef void (*TestFunction)();
+
+bool registerTest(const char* name, TestFunction function);
+void checkFailed(const char* condition, const char* file, int line);
+
+#define FRAMEWORK_TEST(name) \
+	static void name(); \
+	static bool name##Registered = registerTest(#name, name); \
+	static void name()
+
+#define CHECK(condition) \
+	do \
+	{ \
+		if (!(condition)) \
+		{ \
+			checkFailed(#condition, __FILE__, __LINE__); \
+		} \
+	} while (0)
+
+/// The application's res directory, or the one given with --res.
+const std::string& getResourceDirectory();
+/// An empty directory for one test's files, under the system temporary directory.
+std::string getTestDirectory(const char* testName);
+
+bool writeTestFile(const std::string& filename, const void* data, size_t size);
+bool readTestFile(const std::string& filename, std::vector<unsigned char>& data);
+
+#endif
@@ -0,0 +1,123 @@
+// Framework tests
+// Runs the tests of the platform-neutral framework code, or those whose names contain one of the arguments.
+// Usage: FrameworkTests [--res <res directory>] [test name filters...]
+// Builds on Linux with: g++ -std=c++17 -O2 -pthread -I../DXFramework -I../include *.cpp followed by the
+// ../DXFramework files in FrameworkTests.vcxproj.
+#include "FrameworkTest.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+struct RegisteredTest
+{
+	const char* name;
+	TestFunction function;
+};
+
+static std::vector<RegisteredTest>& getTests()
+{
+	static std::vector<RegisteredTest> tests;
+	return tests;
+}
+
+static int failedChecks = 0;
+static std::string resourceDirectory = "../E9_Shadows/res";
+
+bool registerTest(const char* name, TestFunction function)
+{
+	getTests().push_back({ name, function });
+	return true;
+}
+
+void checkFailed(const char* condition, const char* file, int line)
+{
+	printf("  %s(%d): CHECK(%s) failed\n", file, line, condition);
+	failedChecks++;
+}
+
+const std::string& getResourceDirectory()
+{
+	return resourceDirectory;
+}
+
+std::string getTestDirectory(const char* testName)
+{
+	std::filesystem::path directory = std::filesystem::temp_directory_path() / "FrameworkTests" / testName;
+	std::error_code ignored;
+	std::filesystem::remove_all(directory, ignored);
+	std::filesystem::create_directories(directory, ignored);
+	return directory.string();
+}
+
+bool writeTestFile(const std::string& filename, const void* data, size_t size)
+{
+	std::ofstream file(filename, std::ios::binary);
+	file.write((const char*)data, size);
+	return file.good();
+}
+
+bool readTestFile(const std::string& filename, std::vector<unsigned char>& data)
+{
+	std::ifstream file(filename, std::ios::binary | std::ios::ate);
+	if (!file)
+	{
+		return false;
+	}
+	data.resize((size_t)file.tellg());
+	file.seekg(0);
+	file.read((char*)data.data(), data.size());
+	return file.good();
+}
+
+static bool isSelected(const char* name, const std::vector<const char*>& filters)
+{
+	for (const char* filter : filters)
+	{
+		if (strstr(name, filter))
+		{
+			return true;
+		}
+	}
+	return filters.empty();
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<const char*> filters;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--res") == 0 && i + 1 < argc)
+		{
+			resourceDirectory = argv[++i];
+		}
+		else
+		{
+			filters.push_back(argv[i]);
+		}
+	}
+
+	int run = 0;
+	int failed = 0;
+	for (const RegisteredTest& test : getTests())
+	{
+		if (!isSelected(test.name, filters))
+		{
+			continue;
+		}
+
+		printf("%s\n", test.name);
+		int failedBefore = failedChecks;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		test.function();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		bool passed = failedChecks == failedBefore;
+		printf("  %s in %.2f s\n", passed ? "passed" : "FAILED", seconds);
+		run++;
+		failed += passed ? 0 : 1;
+	}
+
+	printf("%d of %d tests passed\n", run - failed, run);
+	return failed > 0 || run == 0 ? 1 : 0;
+}
@@ -0,0 +1,194 @@
+// GLB tests
+// Generated files in both layouts load exactly, and thousands of damaged files are rejected or load with valid indices.
+#include "FrameworkTest.h"
+#include "GlbFile.h"
+#include "TestGlbWriter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+// A UV sphere wound counter-clockwise from outside, as glTF expects, with its own normals.
+static void makeSphere(int rings, int segments, std::vector<ModelVertex>& vertices, std::vector<uint32_t>& indices)
+{
+	for (int ring = 0; ring <= rings; ring++)
+	{
+		float v = (float)ring / rings;
+		float theta = v * 3.14159265f;
+		for (int segment = 0; segment <= segments; segment++)
+		{
+			float u = (float)segment / segments;
+			float phi = u * 6.2831853f;
+			ModelVertex vertex;
+			vertex.normal[0] = sinf(theta) * cosf(phi);
+			vertex.normal[1] = cosf(theta);
+			vertex.normal[2] = sinf(theta) * sinf(phi);
+			for (int axis = 0; axis < 3; axis++)
+			{
+				vertex.position[axis] = vertex.normal[axis] * 2.0f + (float)axis;
+			}
+			vertex.texture[0] = u;
+			vertex.texture[1] = v;
+			vertices.push_back(vertex);
+		}
+	}
+	for (int ring = 0; ring < rings; ring++)
+	{
+		for (int segment = 0; segment < segments; segment++)
+		{
+			uint32_t a = ring * (segments + 1) + segment;
+			uint32_t b = a + segments + 1;
+			uint32_t quad[6] = { a, a + 1, b, a + 1, b + 1, b };
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+	}
+}
+
+FRAMEWORK_TEST(glbInterleaved)
+{
+	std::vector<ModelVertex> vertices;
+	std::vector<uint32_t> indices;
+	makeSphere(24, 48, vertices, indices);
+	std::string filename = getTestDirectory("glbInterleaved") + "/sphere.glb";
+	CHECK(writeTestGlb(filename, vertices, indices, TestGlbLayout::interleaved));
+	CHECK(isGlbFilename(filename) && isGlbFilename("MODEL.GLB") && !isGlbFilename("model.gltf"));
+
+	// Without handedness conversion both streams are used straight from the mapping.
+	GlbFile file;
+	std::string error;
+	CHECK(file.open(filename, error, false));
+	CHECK(file.areVerticesMapped() && file.areIndicesMapped());
+	CHECK(file.getVertexCount() == vertices.size() && file.getIndexCount() == indices.size());
+	CHECK(file.getVertices() && memcmp(file.getVertices(), vertices.data(), vertices.size() * sizeof(ModelVertex)) == 0);
+	CHECK(file.getIndices() && memcmp(file.getIndices(), indices.data(), indices.size() * sizeof(uint32_t)) == 0);
+	CHECK(file.getSubmeshes().size() == 1 && file.getSubmeshes()[0].indexCount == indices.size());
+
+	// Left-handed conversion copies the vertices and negates Z, but keeps the winding and the indices in place.
+	CHECK(file.open(filename, error, true));
+	CHECK(!file.areVerticesMapped() && file.areIndicesMapped());
+	int differences = 0;
+	for (size_t i = 0; i < vertices.size() && file.getVertices(); i++)
+	{
+		const ModelVertex& converted = file.getVertices()[i];
+		const ModelVertex& original = vertices[i];
+		bool same = converted.position[0] == original.position[0] && converted.position[2] == -original.position[2]
+			&& converted.normal[2] == -original.normal[2] && converted.texture[1] == original.texture[1];
+		differences += same ? 0 : 1;
+	}
+	CHECK(differences == 0);
+	const MeshCacheSubmesh& submesh = file.getSubmeshes()[0];
+	CHECK(submesh.boundsMin[2] == -4.0f && submesh.boundsMax[2] == 0.0f && submesh.boundsMax[1] == 3.0f);
+
+	ModelArrays arrays;
+	file.copyTo(arrays);
+	file.close();
+	CHECK(arrays.vertices.size() == vertices.size() && arrays.indices == indices);
+}
+
+FRAMEWORK_TEST(glbSplit)
+{
+	std::vector<ModelVertex> vertices;
+	std::vector<uint32_t> indices;
+	makeSphere(16, 32, vertices, indices);
+	std::string filename = getTestDirectory("glbSplit") + "/sphere.glb";
+	CHECK(writeTestGlb(filename, vertices, indices, TestGlbLayout::split));
+
+	GlbFile file;
+	std::string error;
+	CHECK(file.open(filename, error, false));
+	if (!file.getVertices())
+	{
+		return;
+	}
+
+	// Two triangle primitives, one after the other. The line primitive is skipped.
+	const std::vector<MeshCacheSubmesh>& submeshes = file.getSubmeshes();
+	CHECK(submeshes.size() == 2 && file.getIndexCount() == indices.size());
+	CHECK(submeshes[0].indexStart == 0 && submeshes[1].indexStart == submeshes[0].indexCount && submeshes[1].materialIndex == 1);
+	CHECK(!file.areVerticesMapped() && !file.areIndicesMapped());
+
+	// Corner by corner: exact positions, texture coordinates within 16-bit quantisation, and generated unit normals.
+	int differences = 0;
+	float worstTexture = 0.0f;
+	double normalAgreement = 0.0;
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		CHECK(file.getIndices()[i] < file.getVertexCount());
+		const ModelVertex& loaded = file.getVertices()[file.getIndices()[i]];
+		const ModelVertex& original = vertices[indices[i]];
+		differences += memcmp(loaded.position, original.position, sizeof(loaded.position)) == 0 ? 0 : 1;
+		for (int axis = 0; axis < 2; axis++)
+		{
+			worstTexture = std::max(worstTexture, fabsf(loaded.texture[axis] - original.texture[axis]));
+		}
+		float length = sqrtf(loaded.normal[0] * loaded.normal[0] + loaded.normal[1] * loaded.normal[1] + loaded.normal[2] * loaded.normal[2]);
+		differences += fabsf(length - 1.0f) < 1e-4f ? 0 : 1;
+		normalAgreement += loaded.normal[0] * original.normal[0] + loaded.normal[1] * original.normal[1] + loaded.normal[2] * original.normal[2];
+	}
+	CHECK(differences == 0);
+	CHECK(worstTexture <= 0.5f / 65535.0f + 1e-6f);
+	CHECK(normalAgreement / indices.size() > 0.95);
+}
+
+FRAMEWORK_TEST(glbCorruption)
+{
+	std::vector<ModelVertex> vertices;
+	std::vector<uint32_t> indices;
+	makeSphere(12, 24, vertices, indices);
+	std::string directory = getTestDirectory("glbCorruption");
+	const TestGlbLayout layouts[] = { TestGlbLayout::interleaved, TestGlbLayout::split };
+	for (TestGlbLayout layout : layouts)
+	{
+		std::string filename = directory + "/sphere.glb";
+		CHECK(writeTestGlb(filename, vertices, indices, layout));
+		std::vector<unsigned char> original;
+		CHECK(readTestFile(filename, original));
+
+		// Truncations, bit flips, and JSON characters dropped into the text.
+		std::mt19937 random(1);
+		int loaded = 0, rejected = 0, badIndices = 0;
+		std::string corruptFilename = directory + "/corrupt.glb";
+		for (int attempt = 0; attempt < 1500 && !original.empty(); attempt++)
+		{
+			std::vector<unsigned char> bytes = original;
+			switch (attempt % 3)
+			{
+			case 0:
+				bytes.resize(random() % bytes.size());
+				break;
+			case 1:
+				for (int flip = 0; flip < 4; flip++)
+				{
+					bytes[random() % bytes.size()] ^= (unsigned char)(1 << (random() % 8));
+				}
+				break;
+			default:
+				bytes[20 + random() % 600] = "0123456789[]{}\",:-e"[random() % 19];
+				break;
+			}
+			writeTestFile(corruptFilename, bytes.data(), bytes.size());
+
+			GlbFile file;
+			std::string error;
+			if (!file.open(corruptFilename, error, (attempt & 1) != 0))
+			{
+				CHECK(!error.empty());
+				rejected++;
+				continue;
+			}
+			loaded++;
+			for (uint32_t i = 0; i < file.getIndexCount(); i++)
+			{
+				if (file.getIndices()[i] >= file.getVertexCount())
+				{
+					badIndices++;
+					break;
+				}
+			}
+		}
+		CHECK(badIndices == 0);
+		CHECK(rejected > 0);
+		printf("  %s: %d loaded, %d rejected\n", layout == TestGlbLayout::interleaved ? "interleaved" : "split", loaded, rejected);
+	}
+}
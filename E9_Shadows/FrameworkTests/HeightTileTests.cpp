@@ -0,0 +1,149 @@
+// Height tile tests
+// Pyramid files round trip, corrupt headers are rejected, and the streamer keeps to its budget around the camera.
+#include "FrameworkTest.h"
+#include "HeightTileStreamer.h"
+#include "HeightmapCache.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <thread>
+
+static Heightmap makeTileHeightmap(int size)
+{
+	Heightmap heightmap;
+	heightmap.width = size;
+	heightmap.height = size;
+	heightmap.samples.resize((size_t)size * size);
+	for (int z = 0; z < size; z++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			heightmap.samples[(size_t)z * size + x] = 0.5f + 0.3f * sinf(x * 0.013f) * cosf(z * 0.021f) + 0.1f * sinf((x - z) * 0.11f);
+		}
+	}
+	return heightmap;
+}
+
+// Waits for the streamer's loading thread to settle, or gives up after a few seconds.
+static bool waitForTiles(const HeightTileStreamer& streamer, int level, int tileX, int tileY)
+{
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (!streamer.getTile(level, tileX, tileY) || streamer.getPendingTileCount() > 0)
+	{
+		if (std::chrono::steady_clock::now() > deadline)
+		{
+			return false;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return true;
+}
+
+FRAMEWORK_TEST(heightTilePyramid)
+{
+	std::string filename = getTestDirectory("heightTilePyramid") + "/height.htp";
+	Heightmap heightmap = makeTileHeightmap(1025);
+	CHECK(writeHeightTilePyramid(heightmap, filename, 64));
+
+	HeightTileFile file;
+	CHECK(file.open(filename));
+	if (!file.isOpen())
+	{
+		return;
+	}
+	CHECK(file.getLevelCount() == 5);
+	CHECK(file.getLevel(4).tilesX == 1 && file.getLevel(4).tilesY == 1);
+
+	// Every level keeps every second sample of the one below, quantised to 16 bits, and tiles share their edges.
+	for (int level = 0; level < file.getLevelCount(); level++)
+	{
+		const HeightTileLevel& info = file.getLevel(level);
+		for (uint32_t tileY = 0; tileY < info.tilesY; tileY++)
+		{
+			for (uint32_t tileX = 0; tileX < info.tilesX; tileX++)
+			{
+				const uint16_t* tile = file.getTileData(level, tileX, tileY);
+				CHECK(tile != nullptr);
+				for (int j = 0; tile && j < file.getTileSamples(); j += 7)
+				{
+					for (int i = 0; i < file.getTileSamples(); i += 5)
+					{
+						int x = std::min((int)(tileX * 64 + i) << level, heightmap.width - 1);
+						int z = std::min((int)(tileY * 64 + j) << level, heightmap.height - 1);
+						float expected = heightmap.samples[(size_t)z * heightmap.width + x];
+						CHECK(fabsf(tile[j * file.getTileSamples() + i] / 65535.0f - expected) <= 0.5f / 65535.0f + 1e-6f);
+					}
+				}
+			}
+		}
+	}
+	CHECK(file.getTileData(0, 16, 0) == nullptr);
+	CHECK(file.getTileData(5, 0, 0) == nullptr);
+	file.close();
+
+	// A truncated file or a damaged header never opens.
+	std::vector<unsigned char> bytes;
+	CHECK(readTestFile(filename, bytes));
+	std::string corruptFilename = filename + ".corrupt";
+	writeTestFile(corruptFilename, bytes.data(), bytes.size() - 1);
+	CHECK(!file.open(corruptFilename));
+	const size_t headerFields[] = { 0, offsetof(HeightTileHeader, version), offsetof(HeightTileHeader, tileSize), offsetof(HeightTileHeader, levelCount) };
+	for (size_t offset : headerFields)
+	{
+		std::vector<unsigned char> corrupt = bytes;
+		corrupt[offset + 1] ^= 0x40;
+		writeTestFile(corruptFilename, corrupt.data(), corrupt.size());
+		CHECK(!file.open(corruptFilename));
+	}
+}
+
+FRAMEWORK_TEST(heightTileStreaming)
+{
+	std::string filename = getTestDirectory("heightTileStreaming") + "/height.htp";
+	Heightmap heightmap = makeTileHeightmap(1025);
+	CHECK(writeHeightTilePyramid(heightmap, filename, 64));
+
+	// Room for the 3x3 ring at every level plus a few spare tiles, far less than the whole map.
+	HeightTileStreamer streamer;
+	size_t tileBytes = 65 * 65 * sizeof(uint16_t);
+	size_t budget = tileBytes * (5 * 9 + 4);
+	CHECK(streamer.open(filename, budget));
+	if (!streamer.getFile().isOpen())
+	{
+		return;
+	}
+
+	size_t mostResident = 0;
+	for (int step = 0; step < 12; step++)
+	{
+		float x = 40.0f + step * 85.0f;
+		float z = 1000.0f - step * 80.0f;
+		streamer.update(x, z);
+		CHECK(waitForTiles(streamer, 0, (int)x / 64, (int)z / 64));
+		CHECK(streamer.getResidentBytes() <= budget);
+		mostResident = std::max(mostResident, streamer.getResidentBytes());
+
+		// Under the camera the finest level answers, bilinearly, to within the 16-bit quantisation.
+		float height = 0.0f;
+		int level = -1;
+		CHECK(streamer.sampleHeight(x + 0.25f, z + 0.5f, height, &level));
+		CHECK(level == 0);
+		int i = (int)(x + 0.25f);
+		int j = (int)(z + 0.5f);
+		const float* row0 = heightmap.samples.data() + (size_t)j * heightmap.width;
+		const float* row1 = row0 + heightmap.width;
+		float bottom = row0[i] + (row0[i + 1] - row0[i]) * 0.25f;
+		float top = row1[i] + (row1[i + 1] - row1[i]) * 0.25f;
+		CHECK(fabsf(height - (bottom + (top - bottom) * 0.5f)) < 2.0f / 65535.0f);
+
+		// Far from the camera only the coarse levels are resident, and they still answer.
+		float farX = (x < 512.0f) ? 1020.0f : 4.0f;
+		float farZ = (z < 512.0f) ? 1020.0f : 4.0f;
+		CHECK(streamer.sampleHeight(farX, farZ, height, &level));
+		CHECK(level > 0);
+	}
+	CHECK(mostResident < heightmap.samples.size() * sizeof(uint16_t) / 4);
+	streamer.close();
+	CHECK(streamer.getResidentTileCount() == 0);
+}
@@ -0,0 +1,193 @@
+// Mesh cache tests
+// Round trips streams through a cache, rejects stale and hostile caches, and lets several writers race on one cache.
+#include "FrameworkTest.h"
+#include "MeshCache.h"
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+
+struct TestVertex
+{
+	float position[3];
+	float normal[3];
+};
+
+struct TestMesh
+{
+	std::vector<TestVertex> vertices;
+	std::vector<uint32_t> indices;
+	std::vector<MeshCacheSubmesh> submeshes;
+
+	MeshCacheData getData() const
+	{
+		MeshCacheData data;
+		data.vertices = vertices.data();
+		data.vertexCount = (uint32_t)vertices.size();
+		data.vertexStride = sizeof(TestVertex);
+		data.indices = indices.data();
+		data.indexCount = (uint32_t)indices.size();
+		data.submeshes = submeshes.data();
+		data.submeshCount = (uint32_t)submeshes.size();
+		return data;
+	}
+};
+
+// A strip of quads split into two submeshes.
+static TestMesh makeTestMesh(int quads)
+{
+	TestMesh mesh;
+	for (int i = 0; i <= quads; i++)
+	{
+		mesh.vertices.push_back({ { (float)i, 0.0f, -1.0f }, { 0.0f, 1.0f, 0.0f } });
+		mesh.vertices.push_back({ { (float)i, 2.0f, 1.0f }, { 0.0f, 1.0f, 0.0f } });
+	}
+	for (uint32_t i = 0; i < (uint32_t)quads; i++)
+	{
+		uint32_t quad[6] = { i * 2, i * 2 + 1, i * 2 + 2, i * 2 + 2, i * 2 + 1, i * 2 + 3 };
+		mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+	}
+	MeshCacheSubmesh first = {};
+	first.indexCount = (uint32_t)(quads / 2) * 6;
+	MeshCacheSubmesh second = {};
+	second.indexStart = first.indexCount;
+	second.indexCount = (uint32_t)mesh.indices.size() - first.indexCount;
+	second.materialIndex = 1;
+	mesh.submeshes.push_back(first);
+	mesh.submeshes.push_back(second);
+	return mesh;
+}
+
+FRAMEWORK_TEST(meshCacheRoundTrip)
+{
+	std::string directory = getTestDirectory("meshCacheRoundTrip");
+	std::string source = directory + "/model.obj";
+	std::string cacheFilename = source + ".mshc";
+	writeTestFile(source, "v 0 0 0\n", 8);
+	TestMesh mesh = makeTestMesh(10);
+	CHECK(writeMeshCache(cacheFilename, source, 7, mesh.getData()));
+
+	MeshCacheFile cache;
+	CHECK(cache.open(cacheFilename, source, 7, sizeof(TestVertex)));
+	if (!cache.isOpen())
+	{
+		return;
+	}
+	const MeshCacheHeader& header = cache.getHeader();
+	CHECK(header.vertexCount == mesh.vertices.size() && header.indexCount == mesh.indices.size() && header.submeshCount == 2);
+	CHECK(memcmp(cache.getVertexData(), mesh.vertices.data(), mesh.vertices.size() * sizeof(TestVertex)) == 0);
+	CHECK(memcmp(cache.getIndexData(), mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t)) == 0);
+	CHECK(cache.getSubmeshes()[1].indexStart == mesh.submeshes[1].indexStart && cache.getSubmeshes()[1].materialIndex == 1);
+	CHECK(header.boundsMin[0] == 0.0f && header.boundsMax[0] == 10.0f && header.boundsMin[2] == -1.0f && header.boundsMax[1] == 2.0f);
+	CHECK((uintptr_t)cache.getVertexData() % 16 == 0 && (uintptr_t)cache.getIndexData() % 16 == 0);
+	cache.close();
+
+	float boundsMin[3], boundsMax[3];
+	CHECK(readMeshCacheBounds(cacheFilename, boundsMin, boundsMax) && boundsMax[0] == 10.0f);
+
+	// Other importer settings, another vertex layout or a changed source are all stale.
+	CHECK(!cache.open(cacheFilename, source, 8, sizeof(TestVertex)));
+	CHECK(!cache.open(cacheFilename, source, 7, sizeof(TestVertex) + 4));
+	CHECK(!cache.open(cacheFilename, directory + "/missing.obj", 7, sizeof(TestVertex)));
+	writeTestFile(source, "v 0 0 1\n", 8);
+	std::filesystem::last_write_time(source, std::filesystem::last_write_time(source) + std::chrono::seconds(5));
+	CHECK(!cache.open(cacheFilename, source, 7, sizeof(TestVertex)));
+
+	// Touching the source without changing it is forgiven, as the hash still matches.
+	CHECK(writeMeshCache(cacheFilename, source, 7, mesh.getData()));
+	std::filesystem::last_write_time(source, std::filesystem::last_write_time(source) + std::chrono::seconds(5));
+	CHECK(cache.open(cacheFilename, source, 7, sizeof(TestVertex)));
+}
+
+FRAMEWORK_TEST(meshCacheCorruption)
+{
+	std::string directory = getTestDirectory("meshCacheCorruption");
+	std::string source = directory + "/model.obj";
+	std::string cacheFilename = source + ".mshc";
+	writeTestFile(source, "v 0 0 0\n", 8);
+	TestMesh mesh = makeTestMesh(10);
+	CHECK(writeMeshCache(cacheFilename, source, 7, mesh.getData()));
+	std::vector<unsigned char> bytes;
+	CHECK(readTestFile(cacheFilename, bytes));
+	if (bytes.size() < sizeof(MeshCacheHeader))
+	{
+		return;
+	}
+	MeshCacheHeader good;
+	memcpy(&good, bytes.data(), sizeof(good));
+
+	// Each damages one field. None may open, and none may read outside the file while being checked.
+	auto corruptions = std::vector<void (*)(MeshCacheHeader&, MeshCacheSubmesh*)>
+	{
+		[](MeshCacheHeader& header, MeshCacheSubmesh*) { header.magic[0] = 'X'; },
+		[](MeshCacheHeader& header, MeshCacheSubmesh*) { header.version++; },
+		[](MeshCacheHeader& header, MeshCacheSubmesh*) { header.submeshOffset = 8; },
+		[](MeshCacheHeader& header, MeshCacheSubmesh*) { header.submeshCount = 0xffffffff; },
+		[](MeshCacheHeader& header, MeshCacheSubmesh*) { header.vertexOffset = ~(uint64_t)0 - 7; },
+		[](MeshCacheHeader& header, MeshCacheSubmesh*) { header.vertexCount = 0x80000000; },
+		[](MeshCacheHeader& header, MeshCacheSubmesh*) { header.indexOffset = ~(uint64_t)0 - 3; header.indexCount = 2; },
+		[](MeshCacheHeader& header, MeshCacheSubmesh*) { header.indexOffset += 2; },
+		[](MeshCacheHeader& header, MeshCacheSubmesh*) { header.vertexOffset += 1; },
+		[](MeshCacheHeader& header, MeshCacheSubmesh*) { header.indexCount -= 1; },
+		[](MeshCacheHeader&, MeshCacheSubmesh* submeshes) { submeshes[1].indexCount += 1; },
+		[](MeshCacheHeader&, MeshCacheSubmesh* submeshes) { submeshes[0].indexStart = 0xfffffff0; submeshes[0].indexCount = 0x20; },
+	};
+	std::string corruptFilename = directory + "/corrupt.mshc";
+	MeshCacheFile cache;
+	int opened = 0;
+	for (auto corrupt : corruptions)
+	{
+		std::vector<unsigned char> copy = bytes;
+		MeshCacheHeader header = good;
+		corrupt(header, (MeshCacheSubmesh*)(copy.data() + good.submeshOffset));
+		memcpy(copy.data(), &header, sizeof(header));
+		writeTestFile(corruptFilename, copy.data(), copy.size());
+		opened += cache.open(corruptFilename, source, 7, sizeof(TestVertex)) ? 1 : 0;
+	}
+	CHECK(opened == 0);
+
+	// Every truncation, too.
+	for (size_t size = 0; size < bytes.size(); size += 7)
+	{
+		writeTestFile(corruptFilename, bytes.data(), size);
+		opened += cache.open(corruptFilename, source, 7, sizeof(TestVertex)) ? 1 : 0;
+	}
+	CHECK(opened == 0);
+	writeTestFile(corruptFilename, bytes.data(), bytes.size());
+	CHECK(cache.open(corruptFilename, source, 7, sizeof(TestVertex)));
+}
+
+FRAMEWORK_TEST(meshCacheConcurrentWriters)
+{
+	std::string directory = getTestDirectory("meshCacheConcurrentWriters");
+	std::string source = directory + "/model.obj";
+	std::string cacheFilename = source + ".mshc";
+	writeTestFile(source, "v 0 0 0\n", 8);
+	TestMesh mesh = makeTestMesh(5000);
+
+	// Writers never share a temporary file, so every one succeeds and the survivor is whole.
+	const int writerCount = 8;
+	bool written[writerCount] = {};
+	std::vector<std::thread> writers;
+	for (int i = 0; i < writerCount; i++)
+	{
+		writers.emplace_back([&, i]() { written[i] = writeMeshCache(cacheFilename, source, 7, mesh.getData()); });
+	}
+	for (std::thread& writer : writers)
+	{
+		writer.join();
+	}
+	for (bool ok : written)
+	{
+		CHECK(ok);
+	}
+	MeshCacheFile cache;
+	CHECK(cache.open(cacheFilename, source, 7, sizeof(TestVertex)));
+	CHECK(cache.isOpen() && memcmp(cache.getIndexData(), mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t)) == 0);
+	int leftovers = 0;
+	for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory))
+	{
+		leftovers += (entry.path().extension() == ".tmp") ? 1 : 0;
+	}
+	CHECK(leftovers == 0);
+}
@@ -0,0 +1,171 @@
+// Mip chain tests
+// Downsampling and min/max reduction must match the scalar reference bit for bit, with AVX2 on and off and on any
+// number of threads. Flat images stay flat and sRGB averages in linear light.
+#include "FrameworkTest.h"
+#include "CpuFeatures.h"
+#include "MipChain.h"
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <random>
+
+// Straightforward min/max of each 2x2 block, skipping samples past the edge.
+static void reduceMinMaxReference(const std::vector<float>& minSource, const std::vector<float>& maxSource, int width, int height,
+	std::vector<float>& minOut, std::vector<float>& maxOut)
+{
+	int outWidth = (width + 1) / 2;
+	int outHeight = (height + 1) / 2;
+	minOut.assign((size_t)outWidth * outHeight, 0.0f);
+	maxOut.assign(minOut.size(), 0.0f);
+	for (int y = 0; y < outHeight; y++)
+	{
+		for (int x = 0; x < outWidth; x++)
+		{
+			float low = std::numeric_limits<float>::max();
+			float high = -low;
+			for (int corner = 0; corner < 4; corner++)
+			{
+				int sx = x * 2 + (corner & 1);
+				int sy = y * 2 + (corner >> 1);
+				if (sx < width && sy < height)
+				{
+					low = std::min(low, minSource[(size_t)sy * width + sx]);
+					high = std::max(high, maxSource[(size_t)sy * width + sx]);
+				}
+			}
+			minOut[(size_t)y * outWidth + x] = low;
+			maxOut[(size_t)y * outWidth + x] = high;
+		}
+	}
+}
+
+FRAMEWORK_TEST(mipChainMatchesScalar)
+{
+	std::mt19937 random(7);
+	const int sizes[][2] = { { 1, 1 }, { 1, 7 }, { 7, 1 }, { 2, 2 }, { 3, 5 }, { 17, 9 }, { 64, 64 }, { 255, 129 }, { 1000, 3 }, { 700, 400 } };
+	const bool avx2Settings[] = { true, false };
+	const int threadCounts[] = { 1, 3, 0 };
+	for (bool avx2 : avx2Settings)
+	{
+		setAvx2KernelsEnabled(avx2);
+		printf("  %s kernel\n", getMipChainKernelName());
+		for (const int* size : sizes)
+		{
+			int width = size[0];
+			int height = size[1];
+			std::vector<unsigned char> source((size_t)width * height * 4);
+			for (unsigned char& value : source)
+			{
+				value = (unsigned char)random();
+			}
+			int outWidth = std::max(width / 2, 1);
+			int outHeight = std::max(height / 2, 1);
+			for (int mode = 0; mode < 4; mode++)
+			{
+				MipSettings settings;
+				settings.srgb = (mode & 1) != 0;
+				settings.kaiser = (mode & 2) != 0;
+				std::vector<unsigned char> expected((size_t)outWidth * outHeight * 4);
+				downsampleRGBA8Scalar(source.data(), width, height, expected.data(), settings);
+				for (int threads : threadCounts)
+				{
+					settings.threadCount = threads;
+					std::vector<unsigned char> actual(expected.size());
+					downsampleRGBA8(source.data(), width, height, actual.data(), settings);
+					CHECK(actual == expected);
+				}
+			}
+		}
+	}
+	setAvx2KernelsEnabled(true);
+}
+
+FRAMEWORK_TEST(mipChainFilters)
+{
+	// A flat image stays exactly flat through every filter, including the Kaiser taps that reach past the edges.
+	std::vector<unsigned char> flat(33 * 17 * 4);
+	for (size_t i = 0; i < flat.size(); i++)
+	{
+		flat[i] = (unsigned char)(37 * (i & 3) + 11);
+	}
+	for (int mode = 0; mode < 4; mode++)
+	{
+		MipSettings settings;
+		settings.srgb = (mode & 1) != 0;
+		settings.kaiser = (mode & 2) != 0;
+		std::vector<unsigned char> half(16 * 8 * 4);
+		downsampleRGBA8(flat.data(), 33, 17, half.data(), settings);
+		bool unchanged = true;
+		for (size_t i = 0; i < half.size(); i++)
+		{
+			unchanged = unchanged && half[i] == flat[i & 3];
+		}
+		CHECK(unchanged);
+	}
+
+	// Black and white average to middle grey in linear light, which is 188 in sRGB. Alpha is always linear.
+	std::vector<unsigned char> checker(4 * 4 * 4);
+	for (int i = 0; i < 16; i++)
+	{
+		unsigned char value = ((i % 4 + i / 4) & 1) ? 255 : 0;
+		checker[i * 4] = checker[i * 4 + 1] = checker[i * 4 + 2] = checker[i * 4 + 3] = value;
+	}
+	std::vector<unsigned char> half(2 * 2 * 4);
+	MipSettings settings;
+	downsampleRGBA8(checker.data(), 4, 4, half.data(), settings);
+	CHECK(half[0] == 188 && half[3] == 128);
+	settings.srgb = false;
+	downsampleRGBA8(checker.data(), 4, 4, half.data(), settings);
+	CHECK(half[0] == 128);
+
+	// A whole chain of a flat image ends at a 1x1 of the same colour.
+	std::vector<TextureMipLevel> levels(getMipLevelCount(37, 10));
+	CHECK(levels.size() == 6);
+	size_t offset = 0;
+	for (size_t level = 0; level < levels.size(); level++)
+	{
+		levels[level].offset = offset;
+		levels[level].width = std::max(37 >> level, 1);
+		levels[level].height = std::max(10 >> level, 1);
+		offset += (size_t)levels[level].width * levels[level].height * 4;
+	}
+	std::vector<unsigned char> chain(offset, 0);
+	std::copy(flat.begin(), flat.begin() + 37 * 10 * 4, chain.begin());
+	generateMipChain(chain.data(), levels.data(), (int)levels.size(), MipSettings());
+	CHECK(levels.back().width == 1 && levels.back().height == 1);
+	CHECK(std::equal(chain.end() - 4, chain.end(), flat.begin()));
+}
+
+FRAMEWORK_TEST(mipChainMinMax)
+{
+	std::mt19937 random(9);
+	std::uniform_real_distribution<float> distribution(-5.0f, 5.0f);
+	const int sizes[][2] = { { 1, 1 }, { 2, 1 }, { 1, 2 }, { 3, 3 }, { 17, 5 }, { 16, 16 }, { 33, 2 }, { 255, 255 }, { 1023, 511 } };
+	const bool avx2Settings[] = { true, false };
+	for (bool avx2 : avx2Settings)
+	{
+		setAvx2KernelsEnabled(avx2);
+		for (const int* size : sizes)
+		{
+			int width = size[0];
+			int height = size[1];
+			std::vector<float> minSource((size_t)width * height);
+			std::vector<float> maxSource(minSource.size());
+			for (size_t i = 0; i < minSource.size(); i++)
+			{
+				float a = distribution(random);
+				float b = distribution(random);
+				minSource[i] = std::min(a, b);
+				maxSource[i] = std::max(a, b);
+			}
+			std::vector<float> expectedMin, expectedMax;
+			reduceMinMaxReference(minSource, maxSource, width, height, expectedMin, expectedMax);
+			std::vector<float> minOut(expectedMin.size()), maxOut(expectedMin.size());
+			reduceMinMax(minSource.data(), maxSource.data(), width, height, minOut.data(), maxOut.data());
+			CHECK(minOut == expectedMin && maxOut == expectedMax);
+			reduceMinMaxScalar(minSource.data(), maxSource.data(), width, height, minOut.data(), maxOut.data());
+			CHECK(minOut == expectedMin && maxOut == expectedMax);
+		}
+	}
+	setAvx2KernelsEnabled(true);
+}
@@ -0,0 +1,121 @@
+// Model arrays tests
+// buildModelArrays on a hand-built assimp scene: two meshes, one of them referenced by two nodes.
+#include "FrameworkTest.h"
+#include "ModelArrays.h"
+#include "assimp/scene.h"
+#include <memory>
+
+static aiFace makeFace(std::initializer_list<unsigned int> indices)
+{
+	aiFace face;
+	face.mNumIndices = (unsigned int)indices.size();
+	face.mIndices = new unsigned int[indices.size()];
+	std::copy(indices.begin(), indices.end(), face.mIndices);
+	return face;
+}
+
+static aiNode* makeNode(const char* name, aiNode* parent, std::initializer_list<unsigned int> meshes)
+{
+	aiNode* node = new aiNode(name);
+	node->mParent = parent;
+	node->mNumMeshes = (unsigned int)meshes.size();
+	node->mMeshes = new unsigned int[meshes.size()];
+	std::copy(meshes.begin(), meshes.end(), node->mMeshes);
+	return node;
+}
+
+// A textured, lit quad already triangulated, and a bare triangle plus a quad face as an importer without
+// aiProcess_Triangulate would leave them. The root draws the quad, and two children both draw the other mesh.
+static aiScene* makeScene()
+{
+	aiMesh* quad = new aiMesh();
+	quad->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+	quad->mMaterialIndex = 2;
+	quad->mNumVertices = 4;
+	quad->mVertices = new aiVector3D[4]{ { -1, 0, -2 }, { 1, 0, -2 }, { 1, 3, -2 }, { -1, 3, -2 } };
+	quad->mNormals = new aiVector3D[4]{ { 0, 0, -1 }, { 0, 0, -1 }, { 0, 0, -1 }, { 0, 0, -1 } };
+	quad->mTextureCoords[0] = new aiVector3D[4]{ { 0, 1, 0 }, { 1, 1, 0 }, { 1, 0, 0 }, { 0, 0, 0 } };
+	quad->mNumUVComponents[0] = 2;
+	quad->mNumFaces = 2;
+	quad->mFaces = new aiFace[2];
+	quad->mFaces[0] = makeFace({ 0, 1, 2 });
+	quad->mFaces[1] = makeFace({ 0, 2, 3 });
+
+	aiMesh* mixed = new aiMesh();
+	mixed->mPrimitiveTypes = aiPrimitiveType_TRIANGLE | aiPrimitiveType_POLYGON;
+	mixed->mMaterialIndex = 1;
+	mixed->mNumVertices = 5;
+	mixed->mVertices = new aiVector3D[5]{ { 5, 5, 5 }, { 6, 5, 5 }, { 5, 7, 5 }, { 4, 4, 9 }, { 5, 4, 9 } };
+	mixed->mNumFaces = 2;
+	mixed->mFaces = new aiFace[2];
+	mixed->mFaces[0] = makeFace({ 0, 1, 2 });
+	mixed->mFaces[1] = makeFace({ 1, 4, 3, 2 });
+
+	aiScene* scene = new aiScene();
+	scene->mNumMeshes = 2;
+	scene->mMeshes = new aiMesh*[2]{ quad, mixed };
+	scene->mRootNode = makeNode("root", nullptr, { 0 });
+	scene->mRootNode->mNumChildren = 2;
+	scene->mRootNode->mChildren = new aiNode*[2]{ makeNode("left", scene->mRootNode, { 1 }), makeNode("right", scene->mRootNode, { 1 }) };
+	return scene;
+}
+
+static bool sameVector(const float* values, float x, float y, float z)
+{
+	return values[0] == x && values[1] == y && values[2] == z;
+}
+
+FRAMEWORK_TEST(modelArraysInstances)
+{
+	std::unique_ptr<aiScene> scene(makeScene());
+	ModelArrays arrays;
+	CHECK(buildModelArrays(scene.get(), arrays));
+
+	// Both instances of the second mesh are copied, and every array is sized once to its total.
+	CHECK(arrays.vertices.size() == 4 + 5 + 5 && arrays.vertices.capacity() == arrays.vertices.size());
+	CHECK(arrays.indices.size() == 6 + 7 + 7 && arrays.indices.capacity() == arrays.indices.size());
+	CHECK(arrays.submeshes.size() == 3 && arrays.submeshes.capacity() == arrays.submeshes.size());
+	if (arrays.vertices.size() != 14 || arrays.indices.size() != 20 || arrays.submeshes.size() != 3)
+	{
+		return;
+	}
+
+	// Each instance's indices are offset by the vertices written before it, and faces keep their corner count.
+	const std::vector<uint32_t> indices = { 0, 1, 2, 0, 2, 3, 4, 5, 6, 5, 8, 7, 6, 9, 10, 11, 10, 13, 12, 11 };
+	CHECK(arrays.indices == indices);
+
+	CHECK(sameVector(arrays.vertices[2].position, 1, 3, -2));
+	CHECK(arrays.vertices[2].texture[0] == 1 && arrays.vertices[2].texture[1] == 0);
+	CHECK(sameVector(arrays.vertices[2].normal, 0, 0, -1));
+	bool instancesMatch = true;
+	for (int i = 0; i < 5; i++)
+	{
+		const ModelVertex& first = arrays.vertices[4 + i];
+		const ModelVertex& second = arrays.vertices[9 + i];
+		instancesMatch = instancesMatch && sameVector(first.position, second.position[0], second.position[1], second.position[2]) &&
+			sameVector(first.normal, 0, 0, 0) && first.texture[0] == 0 && first.texture[1] == 0;
+	}
+	CHECK(instancesMatch);
+	CHECK(sameVector(arrays.vertices[13].position, 5, 4, 9));
+
+	// One submesh per instance, in depth-first node order.
+	const MeshCacheSubmesh& root = arrays.submeshes[0];
+	CHECK(root.indexStart == 0 && root.indexCount == 6 && root.materialIndex == 2);
+	CHECK(sameVector(root.boundsMin, -1, 0, -2) && sameVector(root.boundsMax, 1, 3, -2));
+	for (int instance = 1; instance <= 2; instance++)
+	{
+		const MeshCacheSubmesh& submesh = arrays.submeshes[instance];
+		CHECK(submesh.indexStart == (uint32_t)(6 + 7 * (instance - 1)) && submesh.indexCount == 7 && submesh.materialIndex == 1);
+		CHECK(sameVector(submesh.boundsMin, 4, 4, 5) && sameVector(submesh.boundsMax, 6, 7, 9));
+	}
+
+	// A second build replaces the arrays rather than appending, and scenes without a root leave them empty.
+	CHECK(buildModelArrays(scene.get(), arrays));
+	CHECK(arrays.vertices.size() == 14 && arrays.indices == indices && arrays.submeshes.size() == 3);
+	aiNode* rootNode = scene->mRootNode;
+	scene->mRootNode = nullptr;
+	CHECK(!buildModelArrays(scene.get(), arrays));
+	CHECK(arrays.vertices.empty() && arrays.indices.empty() && arrays.submeshes.empty());
+	scene->mRootNode = rootNode;
+	CHECK(!buildModelArrays(nullptr, arrays));
+}
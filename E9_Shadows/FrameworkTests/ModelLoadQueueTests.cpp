@@ -0,0 +1,216 @@
+// Model load queue tests
+// Drives the queue with a mock importer and upload sink: completion order, cancellation and error delivery.
+#include "FrameworkTest.h"
+#include "ModelLoadQueue.h"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+// Imports block until their file is released, so a test decides the order they finish in.
+class GatedImporter
+{
+public:
+	void release(const std::string& filename)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		released.push_back(filename);
+		changed.notify_all();
+	}
+
+	void releaseAll()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		all = true;
+		changed.notify_all();
+	}
+
+	// "fail:", "throw:" and "crash:" files fail, others produce one triangle.
+	bool import(const std::string& filename, ModelArrays& arrays, std::string& error)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			started.push_back(filename);
+			changed.notify_all();
+			changed.wait(lock, [&]() { return all || std::find(released.begin(), released.end(), filename) != released.end(); });
+		}
+		if (filename.compare(0, 5, "fail:") == 0)
+		{
+			error = (filename == "fail:quiet") ? "" : "bad file";
+			return false;
+		}
+		if (filename.compare(0, 6, "throw:") == 0)
+		{
+			throw std::runtime_error("importer threw");
+		}
+		if (filename.compare(0, 6, "crash:") == 0)
+		{
+			throw 42;
+		}
+		arrays.vertices.resize(3);
+		arrays.indices = { 0, 1, 2 };
+		arrays.vertices[0].position[0] = (float)filename.size();
+		return true;
+	}
+
+	bool waitForStart(const std::string& filename)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		return changed.wait_for(lock, std::chrono::seconds(5),
+			[&]() { return std::find(started.begin(), started.end(), filename) != started.end(); });
+	}
+
+private:
+	std::mutex mutex;
+	std::condition_variable changed;
+	std::vector<std::string> released;
+	std::vector<std::string> started;
+	bool all = false;
+};
+
+class RecordingSink : public ModelUploadSink
+{
+public:
+	void modelLoaded(ModelHandle handle, ModelArrays& arrays) override
+	{
+		onMainThread = onMainThread && std::this_thread::get_id() == mainThread;
+		delivered.push_back(handle);
+		triangles += (int)arrays.indices.size() / 3;
+	}
+
+	void modelFailed(ModelHandle handle, const std::string& error) override
+	{
+		onMainThread = onMainThread && std::this_thread::get_id() == mainThread;
+		failed.push_back(handle);
+		errors.push_back(error);
+	}
+
+	std::thread::id mainThread = std::this_thread::get_id();
+	bool onMainThread = true;
+	std::vector<ModelHandle> delivered;
+	std::vector<ModelHandle> failed;
+	std::vector<std::string> errors;
+	int triangles = 0;
+};
+
+static ModelLoadQueue::Importer bindImporter(GatedImporter& importer)
+{
+	return [&importer](const std::string& filename, ModelArrays& arrays, std::string& error) { return importer.import(filename, arrays, error); };
+}
+
+// Calls update until the sink has seen count results in total, or a few seconds pass.
+static void deliver(ModelLoadQueue& queue, RecordingSink& sink, size_t count)
+{
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (sink.delivered.size() + sink.failed.size() < count && std::chrono::steady_clock::now() < deadline)
+	{
+		queue.update();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+FRAMEWORK_TEST(modelLoadQueueOrder)
+{
+	GatedImporter importer;
+	RecordingSink sink;
+	ModelLoadQueue queue(bindImporter(importer), 2);
+	ModelHandle slow = queue.load("slow.obj", &sink);
+	ModelHandle fast = queue.load("fast.obj", &sink);
+	CHECK(slow != 0 && fast != 0 && slow != fast);
+	CHECK(importer.waitForStart("slow.obj") && importer.waitForStart("fast.obj"));
+
+	// Nothing reaches the sink outside update(), and results arrive in the order imports finish.
+	importer.release("fast.obj");
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	CHECK(sink.delivered.empty());
+	deliver(queue, sink, 1);
+	CHECK(sink.delivered.size() == 1 && sink.delivered[0] == fast);
+	CHECK(queue.getPendingCount() == 1);
+	importer.release("slow.obj");
+	deliver(queue, sink, 2);
+	CHECK(sink.delivered.size() == 2 && sink.delivered[1] == slow);
+	CHECK(sink.triangles == 2 && sink.onMainThread);
+	CHECK(queue.getPendingCount() == 0);
+
+	// maxDeliveries spreads finished loads over several updates.
+	for (int i = 0; i < 5; i++)
+	{
+		queue.load("batch" + std::to_string(i) + ".obj", &sink);
+	}
+	importer.releaseAll();
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	int delivered = 0;
+	while (delivered < 5 && std::chrono::steady_clock::now() < deadline)
+	{
+		int count = queue.update(2);
+		CHECK(count <= 2);
+		delivered += count;
+	}
+	CHECK(delivered == 5 && sink.delivered.size() == 7);
+}
+
+FRAMEWORK_TEST(modelLoadQueueCancel)
+{
+	GatedImporter importer;
+	RecordingSink sink;
+	ModelLoadQueue queue(bindImporter(importer), 1);
+	ModelHandle running = queue.load("running.obj", &sink);
+	ModelHandle queued = queue.load("queued.obj", &sink);
+	ModelHandle finished = queue.load("finished.obj", &sink);
+	ModelHandle kept = queue.load("kept.obj", &sink);
+	CHECK(importer.waitForStart("running.obj"));
+
+	// Queued jobs go at once, a running one is discarded when its import returns.
+	CHECK(queue.cancel(queued));
+	CHECK(!queue.cancel(queued));
+	CHECK(queue.cancel(running));
+	CHECK(!queue.cancel(running));
+	importer.release("running.obj");
+	importer.release("finished.obj");
+
+	// The one worker only starts the last file once the previous import is finished and waiting for update().
+	// A finished job cancelled then never reaches its sink either.
+	CHECK(importer.waitForStart("kept.obj"));
+	CHECK(queue.getPendingCount() == 2);
+	CHECK(queue.cancel(finished));
+	importer.release("kept.obj");
+	deliver(queue, sink, 1);
+	CHECK(sink.delivered.size() == 1 && sink.delivered[0] == kept && sink.failed.empty());
+	CHECK(!queue.cancel(kept));
+	CHECK(!queue.cancel(12345));
+	CHECK(queue.getPendingCount() == 0);
+
+	// Loads still queued when the queue is destroyed are dropped without a call.
+	{
+		GatedImporter blocked;
+		RecordingSink dropped;
+		ModelLoadQueue shortLived(bindImporter(blocked), 1);
+		shortLived.load("first.obj", &dropped);
+		shortLived.load("second.obj", &dropped);
+		CHECK(blocked.waitForStart("first.obj"));
+		blocked.releaseAll();
+	}
+}
+
+FRAMEWORK_TEST(modelLoadQueueErrors)
+{
+	GatedImporter importer;
+	importer.releaseAll();
+	RecordingSink sink;
+	ModelLoadQueue queue(bindImporter(importer), 2);
+	const char* files[] = { "fail:message", "fail:quiet", "throw:exception", "crash:unknown" };
+	std::vector<ModelHandle> handles;
+	for (const char* file : files)
+	{
+		handles.push_back(queue.load(file, &sink));
+	}
+	deliver(queue, sink, 4);
+	CHECK(sink.delivered.empty() && sink.failed.size() == 4);
+	for (size_t i = 0; i < sink.failed.size(); i++)
+	{
+		size_t file = std::find(handles.begin(), handles.end(), sink.failed[i]) - handles.begin();
+		const char* expected[] = { "bad file", "Could not import fail:quiet", "importer threw", "Unknown import error" };
+		CHECK(file < handles.size() && sink.errors[i] == expected[file]);
+	}
+	CHECK(sink.onMainThread);
+	CHECK(queue.getPendingCount() == 0);
+}
@@ -0,0 +1,290 @@
+// OBJ loader tests
+// Checks corner forms, fan triangulation, negative indices across chunks, attribute defaults, every rejection
+// and identical output for any thread count.
+#include "FrameworkTest.h"
+#include "ObjLoader.h"
+#include "TestObjWriter.h"
+#include <cstdio>
+#include <cstring>
+
+static bool parseText(const std::string& text, ObjMesh& mesh, bool leftHanded = false, unsigned threadCount = 1)
+{
+	return parseObj(text.data(), text.size(), mesh, leftHanded, threadCount);
+}
+
+static bool isVertex(const ObjVertex& vertex, float x, float y, float z, float u, float v, float nx, float ny, float nz)
+{
+	return vertex.position[0] == x && vertex.position[1] == y && vertex.position[2] == z &&
+		vertex.texture[0] == u && vertex.texture[1] == v &&
+		vertex.normal[0] == nx && vertex.normal[1] == ny && vertex.normal[2] == nz;
+}
+
+// Positions are numbered through X, so a triangle can be checked by which positions it used.
+static bool isTriangle(const ObjMesh& mesh, size_t triangle, int a, int b, int c)
+{
+	if (mesh.vertices.size() < triangle * 3 + 3)
+		return false;
+	const ObjVertex* corners = &mesh.vertices[triangle * 3];
+	return corners[0].position[0] == a && corners[1].position[0] == b && corners[2].position[0] == c;
+}
+
+FRAMEWORK_TEST(objLoaderCornerForms)
+{
+	const std::string text =
+		"# corner forms\n"
+		"v 1 0 0\nv 2 0 0\nv 3 1 0\nv 4 1 1\n"
+		"vt 0.25 0.5\nvt 0.75\n"
+		"vn 0 0 1\nvn 0 1 0\n"
+		"f 1 2 3\n"
+		"f 1/1 2/2 3/1\n"
+		"f 1//2 2//1 3//2\n"
+		"f 1/2/1 2/1/2 4/2/2\n";
+	ObjMesh mesh;
+	CHECK(parseText(text, mesh));
+	CHECK(mesh.positionCount == 4 && mesh.texCoordCount == 2 && mesh.normalCount == 2);
+	CHECK(mesh.vertices.size() == 12);
+	if (mesh.vertices.size() != 12)
+		return;
+
+	// The face normal of 1 2 3 is +Z. A one-component vt gets v = 0.
+	const ObjVertex* v = mesh.vertices.data();
+	CHECK(isVertex(v[0], 1, 0, 0, 0, 0, 0, 0, 1));
+	CHECK(isVertex(v[1], 2, 0, 0, 0, 0, 0, 0, 1));
+	CHECK(isVertex(v[2], 3, 1, 0, 0, 0, 0, 0, 1));
+	CHECK(isVertex(v[3], 1, 0, 0, 0.25f, 0.5f, 0, 0, 1));
+	CHECK(isVertex(v[4], 2, 0, 0, 0.75f, 0, 0, 0, 1));
+	CHECK(isVertex(v[5], 3, 1, 0, 0.25f, 0.5f, 0, 0, 1));
+	CHECK(isVertex(v[6], 1, 0, 0, 0, 0, 0, 1, 0));
+	CHECK(isVertex(v[7], 2, 0, 0, 0, 0, 0, 0, 1));
+	CHECK(isVertex(v[8], 3, 1, 0, 0, 0, 0, 1, 0));
+	CHECK(isVertex(v[9], 1, 0, 0, 0.75f, 0, 0, 0, 1));
+	CHECK(isVertex(v[10], 2, 0, 0, 0.25f, 0.5f, 0, 1, 0));
+	CHECK(isVertex(v[11], 4, 1, 1, 0.75f, 0, 0, 1, 0));
+
+	// Left-handed output negates Z of positions and normals only.
+	CHECK(parseText(text, mesh, true));
+	CHECK(mesh.vertices.size() == 12 && isVertex(mesh.vertices[11], 4, 1, -1, 0.75f, 0, 0, 1, -0.0f));
+	CHECK(mesh.vertices.size() == 12 && isVertex(mesh.vertices[0], 1, 0, -0.0f, 0, 0, 0, 0, -1));
+
+	// Windows line endings, tabs, a leading '+', extra components and other statements are all accepted.
+	const std::string loose =
+		"o thing\r\ng group\r\ns 1\r\nusemtl stone\r\n"
+		"v\t+1 0 0 1\r\nv 2 0 0 0.5 0.5 0.5\r\nv 3 1 0\r\n"
+		"vt 0.5 0.25 0\r\n"
+		"l 1 2\r\n"
+		"f\t1/1  2/1\t3/1 # trailing comment\r\n";
+	CHECK(parseText(loose, mesh));
+	CHECK(mesh.vertices.size() == 3 && isVertex(mesh.vertices[0], 1, 0, 0, 0.5f, 0.25f, 0, 0, 1));
+}
+
+FRAMEWORK_TEST(objLoaderPolygons)
+{
+	std::string text;
+	for (int i = 1; i <= 6; i++)
+	{
+		text += "v " + std::to_string(i) + " " + std::to_string(i * i % 5) + " 0\n";
+	}
+	text += "f 1 2 3 4\nf 1 2 3 4 5 6\nf 6 5 4 3 2\n";
+
+	// Fans from the first corner: n corners make n - 2 triangles.
+	ObjMesh mesh;
+	CHECK(parseText(text, mesh));
+	CHECK(mesh.vertices.size() == (2 + 4 + 3) * 3);
+	CHECK(isTriangle(mesh, 0, 1, 2, 3));
+	CHECK(isTriangle(mesh, 1, 1, 3, 4));
+	CHECK(isTriangle(mesh, 2, 1, 2, 3));
+	CHECK(isTriangle(mesh, 3, 1, 3, 4));
+	CHECK(isTriangle(mesh, 4, 1, 4, 5));
+	CHECK(isTriangle(mesh, 5, 1, 5, 6));
+	CHECK(isTriangle(mesh, 6, 6, 5, 4));
+	CHECK(isTriangle(mesh, 7, 6, 4, 3));
+	CHECK(isTriangle(mesh, 8, 6, 3, 2));
+}
+
+FRAMEWORK_TEST(objLoaderNegativeIndices)
+{
+	// Negative indices count back from the attributes read so far, not from the end of the file.
+	const std::string text =
+		"v 1 0 0\nv 2 0 0\nv 3 0 0\n"
+		"vt 0.5 0.5\n"
+		"vn 0 1 0\n"
+		"f -3/-1/-1 -2/-1/-1 -1/-1/-1\n"
+		"v 4 0 0\n"
+		"vn 1 0 0\n"
+		"f -4//-2 -1//-1 1//2\n";
+	ObjMesh mesh;
+	CHECK(parseText(text, mesh));
+	CHECK(mesh.vertices.size() == 6);
+	CHECK(isTriangle(mesh, 0, 1, 2, 3));
+	CHECK(isTriangle(mesh, 1, 1, 4, 1));
+	CHECK(mesh.vertices.size() == 6 && isVertex(mesh.vertices[2], 3, 0, 0, 0.5f, 0.5f, 0, 1, 0));
+	CHECK(mesh.vertices.size() == 6 && isVertex(mesh.vertices[3], 1, 0, 0, 0, 0, 0, 1, 0));
+	CHECK(mesh.vertices.size() == 6 && isVertex(mesh.vertices[4], 4, 0, 0, 0, 0, 1, 0, 0));
+
+	// Blocks of four positions, each fanned as a quad, plus a triangle reaching back into the previous block.
+	// Over 2 MB, so every split between chunks lands next to a face that reaches back across it.
+	const int blocks = 40000;
+	std::string large;
+	large.reserve((size_t)blocks * 120);
+	char line[64];
+	for (int b = 0; b < blocks; b++)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			snprintf(line, sizeof(line), "v %d 0.5 %d\n", b * 4 + i + 1, b);
+			large += line;
+		}
+		large += "f -4 -3 -2 -1\n";
+		if (b > 0)
+		{
+			large += "f -8 -7 -6\n";
+		}
+	}
+	CHECK(large.size() > (2 << 20));
+
+	for (unsigned threads : { 1u, 2u, 3u })
+	{
+		CHECK(parseText(large, mesh, false, threads));
+		CHECK(mesh.positionCount == (size_t)blocks * 4);
+		CHECK(mesh.vertices.size() == ((size_t)blocks * 3 - 1) * 3);
+		bool resolved = true;
+		size_t triangle = 0;
+		for (int b = 0; b < blocks && resolved; b++)
+		{
+			int first = b * 4 + 1;
+			resolved = isTriangle(mesh, triangle++, first, first + 1, first + 2) &&
+				isTriangle(mesh, triangle++, first, first + 2, first + 3);
+			if (b > 0)
+			{
+				resolved = resolved && isTriangle(mesh, triangle++, first - 4, first - 3, first - 2);
+			}
+		}
+		CHECK(resolved);
+	}
+}
+
+FRAMEWORK_TEST(objLoaderDefaults)
+{
+	const std::string text =
+		"v 0 0 0\nv 1 0 0\nv 0 1 0\nv 0 0 1\n"
+		"vt 0.5 1\n"
+		"vn 1 0 0\n"
+		"f 1 2 3\n"
+		"f 1 3 2\n"
+		"f 1/1 2 4//1\n"
+		"f 1 2 2\n";
+	ObjMesh mesh;
+	CHECK(parseText(text, mesh));
+	CHECK(mesh.vertices.size() == 12);
+	if (mesh.vertices.size() != 12)
+		return;
+
+	// Missing texture coordinates are (0, 0). Missing normals follow the triangle's winding.
+	const ObjVertex* v = mesh.vertices.data();
+	CHECK(isVertex(v[0], 0, 0, 0, 0, 0, 0, 0, 1));
+	CHECK(isVertex(v[3], 0, 0, 0, 0, 0, 0, 0, -1));
+
+	// Only the corners without a normal take the face normal, here -Y for 1 2 4.
+	CHECK(isVertex(v[6], 0, 0, 0, 0.5f, 1, 0, -1, 0));
+	CHECK(isVertex(v[7], 1, 0, 0, 0, 0, 0, -1, 0));
+	CHECK(isVertex(v[8], 0, 0, 1, 0, 0, 1, 0, 0));
+
+	// A degenerate triangle has no face normal and gets +Y rather than NaN.
+	CHECK(isVertex(v[9], 0, 0, 0, 0, 0, 0, 1, 0));
+
+	// Left-handed output flips the face normal with the positions.
+	CHECK(parseText(text, mesh, true));
+	CHECK(mesh.vertices.size() == 12 && mesh.vertices[0].normal[2] == -1.0f);
+}
+
+FRAMEWORK_TEST(objLoaderRejects)
+{
+	const char* header = "v 0 0 0\nv 1 0 0\nv 0 1 0\nvt 0 0\nvn 0 0 1\n";
+	const char* rejected[] = {
+		// Bad indices.
+		"f 0 1 2\n",
+		"f 1 2 99999999999\n",
+		"f 1/0 2/1 3/1\n",
+		"f 1//0 2//1 3//1\n",
+		// Malformed tokens.
+		"f 1 2 x\n",
+		"f 1 2a 3\n",
+		"f 1/x 2/1 3/1\n",
+		"f 1//x 2//1 3//1\n",
+		"f 1/1/ 2/1/1 3/1/1\n",
+		"f 1 2 3.5\n",
+		"f 1 2\n",
+		"f \n",
+		"v 1 x 2\n",
+		"v 1 2\n",
+		"vt \n",
+		"vn 0 1\n",
+		// References outside the data.
+		"f 1 2 4\n",
+		"f 1/2 2/1 3/1\n",
+		"f 1//2 2//1 3//1\n",
+		"f -4 -2 -1\n",
+		"f 1/-2 2/1 3/1\n",
+		"f 1//-2 2//1 3//1\n",
+	};
+
+	for (const char* face : rejected)
+	{
+		// A failure leaves the mesh empty, counts included, even after a successful parse.
+		ObjMesh mesh;
+		CHECK(parseText(std::string(header) + "f 1 2 3\n", mesh));
+		bool parsed = parseText(std::string(header) + face, mesh);
+		if (parsed || !mesh.vertices.empty() || mesh.positionCount != 0 || mesh.texCoordCount != 0 || mesh.normalCount != 0)
+		{
+			printf("  accepted or left data for: %s", face);
+		}
+		CHECK(!parsed);
+		CHECK(mesh.vertices.empty() && mesh.positionCount == 0 && mesh.texCoordCount == 0 && mesh.normalCount == 0);
+	}
+
+	// Rejections in later chunks fail the whole parse, whether found while parsing or while resolving.
+	std::string large;
+	while (large.size() < (3 << 20))
+	{
+		large += "v 0 0 0\nv 1 0 0\nv 0 1 0\nf -3 -2 -1\n";
+	}
+	ObjMesh mesh;
+	CHECK(parseText(large, mesh, false, 4));
+	CHECK(!parseText(large + "f 1 2 x\n", mesh, false, 4));
+	CHECK(mesh.vertices.empty() && mesh.positionCount == 0);
+	CHECK(parseText(large, mesh, false, 4));
+	CHECK(!parseText(large + "f 1 2 999999999\n", mesh, false, 4));
+	CHECK(mesh.vertices.empty() && mesh.positionCount == 0);
+
+	// A file that cannot be opened leaves the mesh empty too.
+	CHECK(parseText(large, mesh, false, 4));
+	CHECK(!loadObj(getTestDirectory("objLoaderRejects") + "/missing.obj", mesh));
+	CHECK(mesh.vertices.empty() && mesh.positionCount == 0);
+}
+
+FRAMEWORK_TEST(objLoaderThreadCounts)
+{
+	// Over 7 MB, so eight threads really get eight chunks.
+	const int columns = 300, rows = 180;
+	for (bool quads : { true, false })
+	{
+		std::string text = makeTestObj(columns, rows, quads);
+		CHECK(text.size() > (7 << 20));
+
+		ObjMesh single;
+		CHECK(parseText(text, single, true, 1));
+		CHECK(single.positionCount == (size_t)columns * rows);
+		CHECK(single.vertices.size() == (size_t)(columns - 1) * (rows - 1) * 6);
+		for (unsigned threads : { 2u, 4u, 8u })
+		{
+			ObjMesh parallel;
+			CHECK(parseText(text, parallel, true, threads));
+			CHECK(parallel.positionCount == single.positionCount);
+			CHECK(parallel.texCoordCount == single.texCoordCount);
+			CHECK(parallel.normalCount == single.normalCount);
+			CHECK(parallel.vertices.size() == single.vertices.size());
+			CHECK(parallel.vertices.size() == single.vertices.size() &&
+				memcmp(parallel.vertices.data(), single.vertices.data(), single.vertices.size() * sizeof(ObjVertex)) == 0);
+		}
+	}
+}
@@ -0,0 +1,108 @@
+// Reference token stream
+// The original TokenStream logic, with its loops and per-character copies left as they were.
+#include "ReferenceTokenStream.h"
+
+static bool isPrintable(char c)
+{
+	return (int)c > 32 && (int)c < 127;
+}
+
+static bool isTokenChar(char c, const char* delimiters, int totalDelimiters)
+{
+	if (!delimiters || totalDelimiters == 0)
+	{
+		return isPrintable(c);
+	}
+	for (int i = 0; i < totalDelimiters; i++)
+	{
+		if (c == delimiters[i])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void ReferenceTokenStream::SetTokenStream(const char* data)
+{
+	startIndex = endIndex = 0;
+	text = data;
+}
+
+void ReferenceTokenStream::ResetStream()
+{
+	startIndex = endIndex = 0;
+}
+
+bool ReferenceTokenStream::GetNextToken(std::string* buffer, const char* delimiters, int totalDelimiters)
+{
+	startIndex = endIndex;
+	bool inString = false;
+	int length = (int)text.length();
+	if (startIndex >= length - 1)
+	{
+		return false;
+	}
+	while (startIndex < length && !isTokenChar(text[startIndex], delimiters, totalDelimiters))
+	{
+		startIndex++;
+	}
+	endIndex = startIndex + 1;
+	if (text[startIndex] == '"')
+	{
+		inString = !inString;
+	}
+	if (startIndex >= length)
+	{
+		return false;
+	}
+	while (endIndex < length && (isTokenChar(text[endIndex], delimiters, totalDelimiters) || inString))
+	{
+		if (text[endIndex] == '"')
+		{
+			inString = !inString;
+		}
+		endIndex++;
+	}
+	if (buffer)
+	{
+		copyRange(buffer);
+	}
+	return true;
+}
+
+bool ReferenceTokenStream::MoveToNextLine(std::string* buffer)
+{
+	int length = (int)text.length();
+	if (startIndex >= length || endIndex >= length)
+	{
+		return false;
+	}
+	endIndex = startIndex;
+	while (endIndex < length && (isPrintable(text[endIndex]) || text[endIndex] == ' '))
+	{
+		endIndex++;
+	}
+	if (endIndex - startIndex == 0 || endIndex - startIndex >= length)
+	{
+		return false;
+	}
+	if (buffer)
+	{
+		copyRange(buffer);
+	}
+	endIndex++;
+	startIndex = endIndex + 1;
+	return true;
+}
+
+void ReferenceTokenStream::copyRange(std::string* buffer) const
+{
+	int size = endIndex - startIndex;
+	buffer->reserve(size + 1);
+	buffer->clear();
+	for (int i = 0; i < size; i++)
+	{
+		buffer->push_back(text[startIndex + i]);
+	}
+}
@@ -0,0 +1,33 @@
+/**
+* \brief The original copying TokenStream, kept as the reference the current one must match
+*
+* Tokenizing rules are unchanged from Beginning DirectX 11 Game Programming (Allen Sherrod and Wendy Jones):
+* with no delimiters a token is any run of printable ASCII, and a double quote starts a string that runs over
+* delimiters until the next quote. Lines stop at the first character that is neither printable nor a space.
+* Built out of line like the original, so the benchmarks time it fairly. Tokens are still copied a character at a time.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _REFERENCETOKENSTREAM_H_
+#define _REFERENCETOKENSTREAM_H_
+
+#include <string>
+
+class ReferenceTokenStream
+{
+public:
+	void SetTokenStream(const char* data);
+	void ResetStream();
+	bool GetNextToken(std::string* buffer, const char* delimiters, int totalDelimiters);
+	bool MoveToNextLine(std::string* buffer);
+
+private:
+	void copyRange(std::string* buffer) const;
+
+	int startIndex = 0;
+	int endIndex = 0;
+	std::string text;
+};
+
+#endif
@@ -0,0 +1,185 @@
+// Resource registry tests
+// Counts Release calls on fake resources through add, replace, remove, clear and destruction, and ages handles.
+#include "FrameworkTest.h"
+#include "ResourceRegistry.h"
+#include <memory>
+
+// Stands in for a COM object. The registry must release each reference it took over exactly once.
+struct FakeResource
+{
+	int references = 1;
+	int releases = 0;
+
+	unsigned long AddRef() { return ++references; }
+	unsigned long Release()
+	{
+		releases++;
+		return --references;
+	}
+};
+
+FRAMEWORK_TEST(resourceRegistryHandles)
+{
+	FakeResource brick, grass, rock;
+	ResourceRegistry<FakeResource> registry;
+	ResourceHandle brickHandle = registry.add(L"brick", &brick);
+	ResourceHandle grassHandle = registry.add(L"grass", &grass);
+	CHECK(brickHandle != 0 && grassHandle != 0 && brickHandle != grassHandle);
+	CHECK(registry.get(brickHandle) == &brick);
+	CHECK(registry.get(0) == nullptr);
+	CHECK(registry.add(L"null", nullptr) == 0);
+	CHECK(registry.size() == 2);
+
+	// Names are compared by content, not by the address of the string that was passed in.
+	std::wstring lookup = L"gra";
+	lookup += L"ss";
+	CHECK(registry.find(lookup) == grassHandle);
+	CHECK(registry.find(std::wstring_view(L"grass stone", 5)) == grassHandle);
+	CHECK(registry.find(L"gras") == 0);
+	CHECK(registry.getName(grassHandle) && *registry.getName(grassHandle) == L"grass");
+
+	// Removing releases once and makes every copy of the handle stale, even after the slot is reused.
+	CHECK(registry.remove(brickHandle));
+	CHECK(brick.releases == 1 && brick.references == 0);
+	CHECK(registry.get(brickHandle) == nullptr);
+	CHECK(registry.getName(brickHandle) == nullptr);
+	CHECK(registry.find(L"brick") == 0);
+	CHECK(!registry.remove(brickHandle));
+	CHECK(brick.releases == 1);
+	ResourceHandle rockHandle = registry.add(L"rock", &rock);
+	CHECK((rockHandle & 0xFFFF) == (brickHandle & 0xFFFF));
+	CHECK(rockHandle != brickHandle);
+	CHECK(registry.get(brickHandle) == nullptr);
+	CHECK(registry.get(rockHandle) == &rock);
+	CHECK(registry.size() == 2);
+
+	// Handles to slots that were never used do not resolve either.
+	CHECK(registry.get((grassHandle & 0xFFFF0000) | 2) == nullptr);
+	CHECK(grass.releases == 0 && rock.releases == 0);
+}
+
+FRAMEWORK_TEST(resourceRegistryReplace)
+{
+	FakeResource first, second;
+	ResourceRegistry<FakeResource> registry;
+	ResourceHandle handle = registry.add(L"shadow map", &first);
+
+	// Replacing keeps the handle valid and releases only the old resource.
+	CHECK(registry.add(L"shadow map", &second) == handle);
+	CHECK(registry.get(handle) == &second);
+	CHECK(first.releases == 1 && second.releases == 0);
+	CHECK(registry.size() == 1);
+
+	// Adding the same resource again hands over a second reference, so the first one is dropped.
+	second.AddRef();
+	CHECK(registry.add(L"shadow map", &second) == handle);
+	CHECK(registry.get(handle) == &second);
+	CHECK(second.releases == 1 && second.references == 1);
+
+	registry.clear();
+	CHECK(second.releases == 2 && second.references == 0);
+	CHECK(registry.get(handle) == nullptr);
+	CHECK(registry.size() == 0);
+}
+
+FRAMEWORK_TEST(resourceRegistryGenerations)
+{
+	std::vector<FakeResource> resources(0x10000);
+	ResourceRegistry<FakeResource> registry;
+	ResourceHandle firstHandle = registry.add(L"slot", &resources[0]);
+
+	// Cycling one slot through every generation never produces handle 0, and the previous handle is always stale.
+	ResourceHandle previous = firstHandle;
+	bool neverZero = true;
+	bool staleAfterRemove = true;
+	ResourceHandle lastBeforeWrap = 0;
+	for (size_t i = 1; i < resources.size(); i++)
+	{
+		registry.remove(previous);
+		staleAfterRemove = staleAfterRemove && registry.get(previous) == nullptr;
+		ResourceHandle handle = registry.add(L"slot", &resources[i]);
+		neverZero = neverZero && handle != 0;
+		if ((handle >> 16) == 0xFFFF)
+		{
+			lastBeforeWrap = handle;
+		}
+		previous = handle;
+	}
+	CHECK(neverZero);
+	CHECK(staleAfterRemove);
+	CHECK(lastBeforeWrap != 0);
+
+	// 0xFFFF generations later the counter wraps past 0 back to 1, so the very first handle value comes round again.
+	CHECK(previous == firstHandle);
+	CHECK(registry.get(lastBeforeWrap) == nullptr);
+	CHECK(registry.get(previous) == &resources.back());
+
+	bool releasedOnce = true;
+	for (size_t i = 0; i + 1 < resources.size(); i++)
+	{
+		releasedOnce = releasedOnce && resources[i].releases == 1;
+	}
+	CHECK(releasedOnce);
+	CHECK(resources.back().releases == 0);
+}
+
+FRAMEWORK_TEST(resourceRegistryRelease)
+{
+	// Destruction releases every live resource exactly once and leaves removed ones alone.
+	FakeResource kept[3], removed;
+	{
+		ResourceRegistry<FakeResource> registry;
+		registry.add(L"a", &kept[0]);
+		registry.add(L"b", &kept[1]);
+		ResourceHandle removedHandle = registry.add(L"c", &removed);
+		registry.add(L"d", &kept[2]);
+		registry.remove(removedHandle);
+		CHECK(removed.releases == 1);
+	}
+	CHECK(kept[0].releases == 1 && kept[1].releases == 1 && kept[2].releases == 1);
+	CHECK(removed.releases == 1);
+
+	// clear then destruction does not release twice, and the registry is usable after clear.
+	FakeResource before, after;
+	{
+		ResourceRegistry<FakeResource> registry;
+		ResourceHandle handle = registry.add(L"before", &before);
+		registry.clear();
+		CHECK(before.releases == 1);
+		CHECK(registry.get(handle) == nullptr && registry.find(L"before") == 0);
+		ResourceHandle reused = registry.add(L"after", &after);
+		CHECK(reused != handle && registry.get(reused) == &after);
+
+		int visited = 0;
+		registry.forEach([&](ResourceHandle visitedHandle, const std::wstring& name, FakeResource* resource)
+		{
+			visited++;
+			CHECK(visitedHandle == reused && name == L"after" && resource == &after);
+		});
+		CHECK(visited == 1);
+	}
+	CHECK(before.releases == 1 && after.releases == 1);
+
+	// When every slot is taken, add refuses and leaves the caller's reference alone.
+	std::unique_ptr<FakeResource[]> many(new FakeResource[0xFFFF]);
+	FakeResource extra;
+	{
+		ResourceRegistry<FakeResource> registry;
+		bool added = true;
+		for (int i = 0; i < 0xFFFF; i++)
+		{
+			added = added && registry.add(std::to_wstring(i), &many[i]) != 0;
+		}
+		CHECK(added);
+		CHECK(registry.add(L"extra", &extra) == 0);
+		CHECK(extra.releases == 0);
+		CHECK(registry.size() == 0xFFFF);
+	}
+	bool releasedOnce = true;
+	for (int i = 0; i < 0xFFFF; i++)
+	{
+		releasedOnce = releasedOnce && many[i].releases == 1;
+	}
+	CHECK(releasedOnce);
+	CHECK(extra.releases == 0);
+}
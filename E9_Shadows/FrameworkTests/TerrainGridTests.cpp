@@ -0,0 +1,139 @@
+// Terrain grid tests
+// Counts, index width and winding of the welded grid against the original per-quad PlaneMesh layout.
+#include "FrameworkTest.h"
+#include "TerrainGrid.h"
+#include <algorithm>
+#include <cmath>
+
+// One corner of the original PlaneMesh, which wrote six unshared vertices per cell.
+struct PlaneCorner
+{
+	int x;
+	int z;
+	float u;
+	float v;
+};
+
+// The original layout: per cell, (i, j) (i+1, j+1) (i, j+1) then (i, j) (i+1, j) (i+1, j+1), texture coordinates
+// accumulated across each row.
+static std::vector<PlaneCorner> makeOriginalPlane(int resolution)
+{
+	std::vector<PlaneCorner> corners;
+	float increment = 1.0f / (resolution - 1);
+	float v = 0.0f;
+	for (int j = 0; j < resolution - 1; j++)
+	{
+		float u = 0.0f;
+		for (int i = 0; i < resolution - 1; i++)
+		{
+			corners.push_back({ i, j, u, v });
+			corners.push_back({ i + 1, j + 1, u + increment, v + increment });
+			corners.push_back({ i, j + 1, u, v + increment });
+			corners.push_back({ i, j, u, v });
+			corners.push_back({ i + 1, j, u + increment, v });
+			corners.push_back({ i + 1, j + 1, u + increment, v + increment });
+			u += increment;
+		}
+		v += increment;
+	}
+	return corners;
+}
+
+static uint32_t getGridIndex(const TerrainGrid& grid, size_t i)
+{
+	return grid.uses16BitIndices() ? grid.indices16[i] : grid.indices32[i];
+}
+
+FRAMEWORK_TEST(terrainGridCounts)
+{
+	const int resolutions[] = { 2, 3, 10, 100, 255, 256, 300 };
+	for (int resolution : resolutions)
+	{
+		TerrainGrid grid;
+		buildTerrainGrid(resolution, nullptr, grid);
+		CHECK(grid.vertices.size() == (size_t)resolution * resolution);
+		CHECK(grid.getIndexCount() == (size_t)(resolution - 1) * (resolution - 1) * 6);
+
+		// 16-bit indices exactly while every vertex fits below 0xFFFF: 255 x 255 is 65025, 256 x 256 is 65536.
+		bool sixteen = grid.vertices.size() <= 0xFFFF;
+		CHECK(grid.uses16BitIndices() == sixteen);
+		CHECK(grid.getIndexStride() == (sixteen ? 2u : 4u));
+		CHECK((sixteen ? grid.indices32.empty() : grid.indices16.empty()));
+		CHECK(grid.getIndexData() == (sixteen ? (const void*)grid.indices16.data() : (const void*)grid.indices32.data()));
+		uint32_t largest = 0;
+		for (size_t i = 0; i < grid.getIndexCount(); i++)
+		{
+			largest = std::max(largest, getGridIndex(grid, i));
+		}
+		CHECK(largest == grid.vertices.size() - 1);
+	}
+
+	// Resolutions below 2 are raised to 2, one cell.
+	TerrainGrid grid;
+	buildTerrainGrid(1, nullptr, grid);
+	CHECK(grid.vertices.size() == 4 && grid.getIndexCount() == 6);
+}
+
+FRAMEWORK_TEST(terrainGridMatchesPlaneMesh)
+{
+	// Every triangle has the corners, in the same order, of the triangle the original wrote in the same place.
+	const int resolutions[] = { 2, 7, 64 };
+	for (int resolution : resolutions)
+	{
+		TerrainGrid grid;
+		buildTerrainGrid(resolution, nullptr, grid);
+		std::vector<PlaneCorner> original = makeOriginalPlane(resolution);
+		CHECK(original.size() == grid.getIndexCount());
+		int mismatches = 0;
+		for (size_t i = 0; i < original.size() && i < grid.getIndexCount(); i++)
+		{
+			const TerrainVertex& vertex = grid.vertices[getGridIndex(grid, i)];
+			const PlaneCorner& corner = original[i];
+			bool same = vertex.position[0] == (float)corner.x && vertex.position[1] == 0.0f && vertex.position[2] == (float)corner.z
+				&& fabsf(vertex.texture[0] - corner.u) < 1e-5f && fabsf(vertex.texture[1] - corner.v) < 1e-5f
+				&& vertex.normal[0] == 0.0f && vertex.normal[1] == 1.0f && vertex.normal[2] == 0.0f;
+			mismatches += same ? 0 : 1;
+		}
+		CHECK(mismatches == 0);
+
+		// Every triangle turns the same way as the original's at the same place, and all of them the same way.
+		int windingChanges = 0;
+		for (size_t i = 0; i + 2 < original.size() && i + 2 < grid.getIndexCount(); i += 3)
+		{
+			const float* a = grid.vertices[getGridIndex(grid, i)].position;
+			const float* b = grid.vertices[getGridIndex(grid, i + 1)].position;
+			const float* c = grid.vertices[getGridIndex(grid, i + 2)].position;
+			float gridTurn = (b[2] - a[2]) * (c[0] - a[0]) - (b[0] - a[0]) * (c[2] - a[2]);
+			const PlaneCorner* corner = &original[i];
+			float originalTurn = (float)((corner[1].z - corner[0].z) * (corner[2].x - corner[0].x) - (corner[1].x - corner[0].x) * (corner[2].z - corner[0].z));
+			windingChanges += (gridTurn == originalTurn && gridTurn < 0.0f) ? 0 : 1;
+		}
+		CHECK(windingChanges == 0);
+	}
+}
+
+FRAMEWORK_TEST(terrainGridHeights)
+{
+	// Heights come from the nearest sample at each vertex's texture coordinate, times the scale.
+	std::vector<float> samples(13 * 9);
+	for (size_t i = 0; i < samples.size(); i++)
+	{
+		samples[i] = (float)(i % 17) / 16.0f;
+	}
+	HeightfieldView view;
+	view.samples = samples.data();
+	view.width = 13;
+	view.height = 9;
+	view.scale = 20.0f;
+	TerrainGrid grid;
+	buildTerrainGrid(33, &view, grid);
+	int mismatches = 0;
+	for (const TerrainVertex& vertex : grid.vertices)
+	{
+		mismatches += (vertex.position[1] == sampleHeightNearest(view, vertex.texture[0], vertex.texture[1])) ? 0 : 1;
+	}
+	CHECK(mismatches == 0);
+	CHECK(grid.vertices.back().position[1] == samples.back() * 20.0f);
+	CHECK(sampleHeightNearest(HeightfieldView(), 0.5f, 0.5f) == 0.0f);
+	CHECK(sampleHeightNearest(view, -1.0f, 2.0f) == samples[8 * 13] * 20.0f);
+}
@@ -0,0 +1,176 @@
+// Terrain LOD tests
+// Sweeps a camera over a quadtree and checks selection coverage, triangle counts and crack-free chunk edges.
+#include "FrameworkTest.h"
+#include "TerrainLod.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+static const float lodHeightScale = 40.0f;
+
+// Rolling hills with noise, so chunks have real errors at every level.
+static std::vector<float> makeLodHeights(int resolution)
+{
+	std::mt19937 random(4);
+	std::vector<float> heights((size_t)resolution * resolution);
+	for (int z = 0; z < resolution; z++)
+	{
+		for (int x = 0; x < resolution; x++)
+		{
+			float hills = 0.5f + 0.25f * sinf(x * 0.05f) * cosf(z * 0.037f) + 0.15f * sinf((x + z) * 0.21f);
+			heights[(size_t)z * resolution + x] = hills + (float)(random() % 1000) * 0.000002f;
+		}
+	}
+	return heights;
+}
+
+// Scaled surface height of a chunk at sample (gx, gz) on its border, interpolated along the border like its triangles.
+static float getEdgeHeight(const TerrainChunkLayout& layout, const std::vector<float>& heights, int resolution, int gx, int gz)
+{
+	auto interpolate = [&](int coordinate, int origin, int last, bool alongX)
+	{
+		int s0 = origin + (coordinate - origin) / layout.step * layout.step;
+		int s1 = std::min(s0 + layout.step, last);
+		float t = (s1 == s0) ? 0.0f : (float)(coordinate - s0) / (s1 - s0);
+		float h0 = alongX ? heights[(size_t)gz * resolution + s0] : heights[(size_t)s0 * resolution + gx];
+		float h1 = alongX ? heights[(size_t)gz * resolution + s1] : heights[(size_t)s1 * resolution + gx];
+		return h0 + t * (h1 - h0);
+	};
+	bool onZEdge = gz == layout.originZ || gz == layout.lastZ;
+	return onZEdge ? interpolate(gx, layout.originX, layout.lastX, true) : interpolate(gz, layout.originZ, layout.lastZ, false);
+}
+
+// Where two chunks meet, the higher edge must not float further above the lower than its own skirt reaches.
+static bool checkSeam(const TerrainQuadtree& tree, const std::vector<float>& heights, int a, int b, int gx, int gz, float& worstGap)
+{
+	TerrainChunkLayout layoutA = tree.getChunkLayout(a);
+	TerrainChunkLayout layoutB = tree.getChunkLayout(b);
+	float heightA = getEdgeHeight(layoutA, heights, tree.getResolution(), gx, gz);
+	float heightB = getEdgeHeight(layoutB, heights, tree.getResolution(), gx, gz);
+	float gap = fabsf(heightA - heightB);
+	float skirt = (heightA > heightB ? layoutA.skirtDepth : layoutB.skirtDepth) * lodHeightScale;
+	worstGap = std::max(worstGap, gap / skirt);
+	return gap <= skirt + 1e-4f;
+}
+
+static int getChunkTriangles(const TerrainChunkLayout& layout)
+{
+	int surface = (layout.columns - 1) * (layout.rows - 1) * 2;
+	int skirts = ((layout.columns - 1) + (layout.rows - 1)) * 4;
+	return surface + skirts;
+}
+
+FRAMEWORK_TEST(terrainLodCameraSweep)
+{
+	const int resolution = 257;
+	const int cells = resolution - 1;
+	std::vector<float> unitHeights = makeLodHeights(resolution);
+	std::vector<float> heights(unitHeights.size());
+	for (size_t i = 0; i < heights.size(); i++)
+	{
+		heights[i] = unitHeights[i] * lodHeightScale;
+	}
+	TerrainQuadtree tree;
+	tree.build(unitHeights.data(), resolution, 32);
+	CHECK(tree.getLevelCount() == 4);
+
+	// Errors never shrink towards the root, so a selected parent is never more accurate than its children.
+	const std::vector<TerrainChunk>& chunks = tree.getChunks();
+	for (const TerrainChunk& chunk : chunks)
+	{
+		for (int child : chunk.children)
+		{
+			CHECK(child < 0 || chunks[child].geometricError <= chunk.geometricError);
+		}
+	}
+
+	const int fullTriangles = cells * cells * 2;
+	int fewestTriangles = fullTriangles;
+	int mostTriangles = 0;
+	float worstGap = 0.0f;
+	int seamFailures = 0;
+	std::vector<int> cellOwner((size_t)cells * cells);
+	std::vector<int> selection;
+	std::vector<int> shadowSelection;
+	std::vector<float> normals(unitHeights.size() * 3, 0.0f);
+	const float cameraHeights[] = { 2.0f, 30.0f, 150.0f, 600.0f };
+	for (float cameraHeight : cameraHeights)
+	{
+		for (int step = 0; step <= 16; step++)
+		{
+			float cameraX = -20.0f + step * (cells + 40.0f) / 16;
+			float cameraZ = cells * 0.3f + step * 5.0f;
+			TerrainLodSettings settings;
+			tree.select(cameraX, lodHeightScale + cameraHeight, cameraZ, settings, lodHeightScale, selection);
+
+			// Every cell is drawn by exactly one chunk.
+			std::fill(cellOwner.begin(), cellOwner.end(), -1);
+			int triangles = 0;
+			bool covered = true;
+			for (int index : selection)
+			{
+				TerrainChunkLayout layout = tree.getChunkLayout(index);
+				for (int z = layout.originZ; z < layout.lastZ; z++)
+				{
+					for (int x = layout.originX; x < layout.lastX; x++)
+					{
+						int& owner = cellOwner[(size_t)z * cells + x];
+						covered = covered && owner < 0;
+						owner = index;
+					}
+				}
+
+				TerrainGrid mesh;
+				tree.buildChunkMesh(index, heights.data(), normals.data(), lodHeightScale, mesh);
+				CHECK((int)mesh.vertices.size() == tree.getChunkVertexCount(index));
+				CHECK((int)mesh.getIndexCount() == getChunkTriangles(layout) * 3);
+				triangles += getChunkTriangles(layout);
+			}
+			CHECK(covered);
+			CHECK(std::find(cellOwner.begin(), cellOwner.end(), -1) == cellOwner.end());
+
+			// Bounded: never more than the full grid with its skirts, and a coarser pass never draws more.
+			CHECK(triangles <= fullTriangles + (int)selection.size() * 32 * 8);
+			settings.maxPixelError *= 4.0f;
+			tree.select(cameraX, lodHeightScale + cameraHeight, cameraZ, settings, lodHeightScale, shadowSelection);
+			int shadowTriangles = 0;
+			for (int index : shadowSelection)
+			{
+				shadowTriangles += getChunkTriangles(tree.getChunkLayout(index));
+			}
+			CHECK(shadowTriangles <= triangles);
+			fewestTriangles = std::min(fewestTriangles, triangles);
+			mostTriangles = std::max(mostTriangles, triangles);
+
+			// Walk every shared edge one sample at a time.
+			for (int z = 0; z < cells; z++)
+			{
+				for (int x = 0; x < cells; x++)
+				{
+					int owner = cellOwner[(size_t)z * cells + x];
+					if (x + 1 < cells && cellOwner[(size_t)z * cells + x + 1] != owner)
+					{
+						int neighbour = cellOwner[(size_t)z * cells + x + 1];
+						seamFailures += checkSeam(tree, heights, owner, neighbour, x + 1, z, worstGap) ? 0 : 1;
+						seamFailures += checkSeam(tree, heights, owner, neighbour, x + 1, z + 1, worstGap) ? 0 : 1;
+					}
+					if (z + 1 < cells && cellOwner[(size_t)(z + 1) * cells + x] != owner)
+					{
+						int neighbour = cellOwner[(size_t)(z + 1) * cells + x];
+						seamFailures += checkSeam(tree, heights, owner, neighbour, x, z + 1, worstGap) ? 0 : 1;
+						seamFailures += checkSeam(tree, heights, owner, neighbour, x + 1, z + 1, worstGap) ? 0 : 1;
+					}
+				}
+			}
+		}
+	}
+
+	// From far enough away the root alone is enough.
+	tree.select(cells * 0.5f, 1e6f, cells * 0.5f, TerrainLodSettings(), lodHeightScale, selection);
+	CHECK(selection.size() == 1 && selection[0] == 0);
+	CHECK(seamFailures == 0);
+	CHECK(mostTriangles > fewestTriangles);
+	printf("  %d to %d triangles per view (full grid %d), largest seam gap %.0f%% of its skirt\n", fewestTriangles, mostTriangles,
+		fullTriangles, worstGap * 100.0f);
+}
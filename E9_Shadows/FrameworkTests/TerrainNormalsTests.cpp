@@ -0,0 +1,46 @@
+// Terrain normals tests
+// The SIMD kernels must match the scalar reference bit for bit, with AVX2 on and off.
+#include "FrameworkTest.h"
+#include "CpuFeatures.h"
+#include "TerrainNormals.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+static void checkNormalsMatchScalar(int width, int height, size_t stride, std::mt19937& random)
+{
+	std::vector<float> heights((size_t)width * height);
+	for (size_t i = 0; i < heights.size(); i++)
+	{
+		heights[i] = (float)(random() % 10000) * 0.01f - 50.0f;
+	}
+	std::vector<float> expected((size_t)width * height * stride, -1.0f);
+	std::vector<float> actual(expected.size(), -1.0f);
+	computeTerrainNormalsScalar(heights.data(), width, height, 0.75f, 1.5f, expected.data(), stride);
+	computeTerrainNormals(heights.data(), width, height, 0.75f, 1.5f, actual.data(), stride);
+	CHECK(memcmp(expected.data(), actual.data(), expected.size() * sizeof(float)) == 0);
+
+	// Spot check the reference is a unit normal pointing up.
+	const float* normal = expected.data() + ((size_t)(height / 2) * width + width / 2) * stride;
+	CHECK(fabsf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2] - 1.0f) < 1e-5f);
+	CHECK(normal[1] > 0.0f);
+}
+
+FRAMEWORK_TEST(terrainNormalsMatchScalar)
+{
+	std::mt19937 random(3);
+	const int sizes[][2] = { { 1, 1 }, { 2, 2 }, { 3, 7 }, { 5, 4 }, { 9, 9 }, { 17, 3 }, { 300, 300 }, { 257, 129 } };
+	const bool avx2Settings[] = { true, false };
+	for (bool avx2 : avx2Settings)
+	{
+		setAvx2KernelsEnabled(avx2);
+		printf("  %s kernel\n", getTerrainNormalsKernelName());
+		for (const int* size : sizes)
+		{
+			checkNormalsMatchScalar(size[0], size[1], 3, random);
+			checkNormalsMatchScalar(size[0], size[1], 8, random);
+		}
+	}
+	setAvx2KernelsEnabled(true);
+}
@@ -0,0 +1,109 @@
+// Terrain query tests
+// Batched heights match the scalar path, and raycasts agree with a fine march along the ray.
+#include "FrameworkTest.h"
+#include "TerrainQuery.h"
+#include <cmath>
+#include <random>
+
+static TerrainQuery makeQuery(int size)
+{
+	std::vector<float> heights((size_t)size * size);
+	for (int z = 0; z < size; z++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			heights[(size_t)z * size + x] = 0.5f + 0.3f * sinf(x * 0.031f) * cosf(z * 0.023f) + 0.05f * sinf((x + 2 * z) * 0.4f);
+		}
+	}
+	TerrainQuery query;
+	query.build(heights.data(), size, size);
+	query.setTransform(-50.0f, 2.0f, -10.0f, 0.5f, 40.0f);
+	return query;
+}
+
+FRAMEWORK_TEST(terrainQueryHeights)
+{
+	TerrainQuery query = makeQuery(257);
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> position(-70.0f, 100.0f);
+	const size_t count = 10007;
+	std::vector<float> xs(count), zs(count), expected(count), actual(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		xs[i] = position(random);
+		zs[i] = position(random) + 20.0f;
+	}
+	query.getHeightsScalar(xs.data(), zs.data(), expected.data(), count);
+	query.getHeights(xs.data(), zs.data(), actual.data(), count);
+	int mismatches = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		mismatches += (expected[i] == actual[i] && expected[i] == query.getHeight(xs[i], zs[i])) ? 0 : 1;
+	}
+	CHECK(mismatches == 0);
+
+	// Samples sit exactly on the grid.
+	CHECK(fabsf(query.getHeight(-50.0f, -10.0f) - (2.0f + 40.0f * 0.5f)) < 1e-4f);
+	CHECK(query.contains(0.0f, 0.0f) && !query.contains(-50.5f, 0.0f) && !query.contains(0.0f, 118.5f));
+}
+
+FRAMEWORK_TEST(terrainQueryRaycast)
+{
+	TerrainQuery query = makeQuery(257);
+	CHECK(query.getLevelCount() == 9);
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	int mismatches = 0;
+	int hits = 0;
+	for (int ray = 0; ray < 300; ray++)
+	{
+		float origin[3] = { -60.0f + unit(random) * 150.0f, 45.0f + unit(random) * 20.0f, -20.0f + unit(random) * 150.0f };
+		float direction[3] = { unit(random) - 0.5f, -0.05f - unit(random) * 0.5f, unit(random) - 0.5f };
+		TerrainRayHit hit;
+		bool found = query.raycast(origin, direction, 1000.0f, hit);
+
+		// March in small steps and stop where the ray first passes from above the surface to below it.
+		// A ray entering the grid's side already below the surface has not crossed it, so it does not count.
+		const float step = 0.005f;
+		float marched = -1.0f;
+		bool above = false;
+		for (float t = 0.0f; t < 1000.0f && marched < 0.0f; t += step)
+		{
+			float x = origin[0] + direction[0] * t;
+			float z = origin[2] + direction[2] * t;
+			if (!query.contains(x, z))
+			{
+				above = false;
+				continue;
+			}
+			bool below = origin[1] + direction[1] * t <= query.getHeight(x, z);
+			if (below && above)
+			{
+				marched = t;
+			}
+			above = !below;
+		}
+		if (found != (marched >= 0.0f) || (found && fabsf(hit.distance - marched) > step * 2.0f))
+		{
+			mismatches++;
+			continue;
+		}
+		if (found)
+		{
+			hits++;
+			CHECK(fabsf(hit.position[1] - query.getHeight(hit.position[0], hit.position[2])) < 1e-3f);
+			CHECK(hit.normal[1] > 0.0f);
+		}
+	}
+	CHECK(mismatches == 0);
+	CHECK(hits > 100);
+
+	// Straight up never hits, and a ray that stops short of the ground does not either.
+	float origin[3] = { 10.0f, 60.0f, 10.0f };
+	float up[3] = { 0.0f, 1.0f, 0.0f };
+	float down[3] = { 0.0f, -1.0f, 0.0f };
+	TerrainRayHit hit;
+	CHECK(!query.raycast(origin, up, 1000.0f, hit));
+	CHECK(!query.raycast(origin, down, 5.0f, hit));
+	CHECK(query.raycast(origin, down, 1000.0f, hit) && fabsf(hit.position[1] - query.getHeight(10.0f, 10.0f)) < 1e-3f);
+}
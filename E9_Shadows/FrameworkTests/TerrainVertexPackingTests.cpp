@@ -0,0 +1,179 @@
+// Terrain vertex packing tests
+// Round-trips packed normals and heights, and decodes every compact chunk vertex against the full chunk mesh.
+#include "FrameworkTest.h"
+#include "TerrainLod.h"
+#include "TerrainNormals.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+// Largest angle between a unit normal and its octahedral round trip, and largest height round trip error.
+static const float normalToleranceDegrees = 0.01f;
+static const float heightTolerance = 0.5f / 65535.0f;
+
+static float getAngleDegrees(const float a[3], const float b[3])
+{
+	float dot = a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+	float cross[3] = { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+	float sine = sqrtf(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+	return atan2f(sine, dot) * 57.2957795f;
+}
+
+FRAMEWORK_TEST(terrainPackingNormals)
+{
+	// The axes, the octahedron's folds and random directions over the whole sphere.
+	std::vector<float> normals = {
+		1, 0, 0, -1, 0, 0, 0, 1, 0, 0, -1, 0, 0, 0, 1, 0, 0, -1,
+		0.7071068f, -0.7071068f, 0, -0.7071068f, -0.7071068f, 0, 0, -0.7071068f, 0.7071068f, 0, -0.7071068f, -0.7071068f,
+		0.5773503f, -0.5773503f, 0.5773503f, -0.5773503f, -0.5773503f, -0.5773503f,
+	};
+	std::mt19937 random(6);
+	std::normal_distribution<float> gaussian;
+	for (int i = 0; i < 100000; i++)
+	{
+		float x = gaussian(random), y = gaussian(random), z = gaussian(random);
+		float length = sqrtf(x * x + y * y + z * z);
+		if (length > 1e-3f)
+		{
+			normals.insert(normals.end(), { x / length, y / length, z / length });
+		}
+	}
+
+	float worstAngle = 0.0f;
+	float worstLength = 0.0f;
+	for (size_t i = 0; i < normals.size(); i += 3)
+	{
+		int16_t packed[2];
+		float unpacked[3];
+		packOctahedralNormal(&normals[i], packed);
+		unpackOctahedralNormal(packed, unpacked);
+		worstAngle = std::max(worstAngle, getAngleDegrees(&normals[i], unpacked));
+		float length = sqrtf(unpacked[0] * unpacked[0] + unpacked[1] * unpacked[1] + unpacked[2] * unpacked[2]);
+		worstLength = std::max(worstLength, fabsf(length - 1.0f));
+
+		// Re-packing a decoded normal does not drift further, so baking twice is harmless.
+		int16_t repacked[2];
+		float again[3];
+		packOctahedralNormal(unpacked, repacked);
+		unpackOctahedralNormal(repacked, again);
+		worstAngle = std::max(worstAngle, getAngleDegrees(&normals[i], again));
+	}
+	printf("    worst normal error %.5f degrees\n", worstAngle);
+	CHECK(worstAngle <= normalToleranceDegrees);
+	CHECK(worstLength <= 1e-5f);
+
+	// A zero vector packs to straight up rather than dividing by zero.
+	const float zero[3] = { 0.0f, 0.0f, 0.0f };
+	int16_t packed[2];
+	float unpacked[3];
+	packOctahedralNormal(zero, packed);
+	unpackOctahedralNormal(packed, unpacked);
+	CHECK(packed[0] == 0 && packed[1] == 0 && unpacked[1] == 1.0f);
+}
+
+FRAMEWORK_TEST(terrainPackingHeights)
+{
+	float worstError = 0.0f;
+	for (int i = 0; i <= 1000000; i++)
+	{
+		float height = i / 1000000.0f;
+		worstError = std::max(worstError, fabsf(unpackUnitHeight(packUnitHeight(height)) - height));
+	}
+	// Half a step, plus the float rounding of the input itself.
+	CHECK(worstError <= heightTolerance + FLT_EPSILON);
+
+	// Every code survives a round trip, and the ends are exact.
+	bool exact = true;
+	for (int code = 0; code <= 65535; code++)
+	{
+		exact = exact && packUnitHeight(unpackUnitHeight((uint16_t)code)) == code;
+	}
+	CHECK(exact);
+	CHECK(unpackUnitHeight(packUnitHeight(0.0f)) == 0.0f);
+	CHECK(unpackUnitHeight(packUnitHeight(1.0f)) == 1.0f);
+
+	// Out of range heights clamp instead of wrapping.
+	CHECK(packUnitHeight(-0.25f) == 0);
+	CHECK(packUnitHeight(1.5f) == 65535);
+}
+
+FRAMEWORK_TEST(terrainPackingChunks)
+{
+	// 198 cells do not divide into the coarser steps, so the far chunks are clipped to the grid edge.
+	const int resolution = 199;
+	const float heightScale = 40.0f;
+	std::mt19937 random(7);
+	std::vector<float> unitHeights((size_t)resolution * resolution);
+	for (int z = 0; z < resolution; z++)
+	{
+		for (int x = 0; x < resolution; x++)
+		{
+			float hills = 0.5f + 0.3f * sinf(x * 0.07f) * cosf(z * 0.045f) + 0.1f * sinf((x - z) * 0.3f);
+			unitHeights[(size_t)z * resolution + x] = hills + (float)(random() % 1000) * 0.00001f;
+		}
+	}
+	std::vector<float> heights(unitHeights.size());
+	for (size_t i = 0; i < heights.size(); i++)
+	{
+		heights[i] = unitHeights[i] * heightScale;
+	}
+	std::vector<float> normals(unitHeights.size() * 3);
+	computeTerrainNormalsScalar(heights.data(), resolution, resolution, 1.0f, 1.0f, normals.data(), 3);
+
+	TerrainQuadtree tree;
+	tree.build(unitHeights.data(), resolution, 32);
+	CHECK(tree.getLevelCount() > 1);
+
+	float texelScale = 1.0f / (resolution - 1);
+	float worstHeight = 0.0f;
+	float worstNormal = 0.0f;
+	int skirtVertices = 0;
+	int clippedChunks = 0;
+	bool positionsMatch = true;
+	bool samplesMatch = true;
+	TerrainGrid full;
+	std::vector<CompactTerrainVertex> compact;
+	std::vector<uint16_t> compactIndices;
+	for (int chunk = 0; chunk < (int)tree.getChunks().size(); chunk++)
+	{
+		tree.buildChunkMesh(chunk, heights.data(), normals.data(), heightScale, full);
+		tree.buildCompactChunkMesh(chunk, unitHeights.data(), normals.data(), compact, compactIndices);
+		TerrainChunkLayout layout = tree.getChunkLayout(chunk);
+		CHECK(compact.size() == full.vertices.size());
+		CHECK((int)compact.size() == tree.getChunkVertexCount(chunk));
+		CHECK(compactIndices == full.indices16);
+		CHECK((int)compact.size() == layout.columns * layout.rows + 2 * (layout.columns + layout.rows));
+		clippedChunks += (layout.lastX - layout.originX) % layout.step != 0 || (layout.lastZ - layout.originZ) % layout.step != 0;
+
+		for (uint32_t v = 0; v < (uint32_t)compact.size(); v++)
+		{
+			const TerrainVertex& expected = full.vertices[v];
+			int sampleX, sampleZ;
+			bool skirt;
+			getCompactVertexSample(layout, v, sampleX, sampleZ, skirt);
+			samplesMatch = samplesMatch && sampleX == (int)expected.position[0] && sampleZ == (int)expected.position[2];
+			samplesMatch = samplesMatch && skirt == (v >= (uint32_t)(layout.columns * layout.rows));
+			skirtVertices += skirt;
+
+			// X/Z and texture coordinates are rebuilt from the index, so they come back exactly.
+			TerrainVertex decoded;
+			decodeCompactTerrainVertex(compact[v], v, layout, heightScale, texelScale, decoded);
+			positionsMatch = positionsMatch && decoded.position[0] == expected.position[0] && decoded.position[2] == expected.position[2];
+			positionsMatch = positionsMatch && decoded.texture[0] == expected.texture[0] && decoded.texture[1] == expected.texture[1];
+
+			// Skirts drop by the same depth, so one height tolerance covers both.
+			worstHeight = std::max(worstHeight, fabsf(decoded.position[1] - expected.position[1]));
+			worstNormal = std::max(worstNormal, getAngleDegrees(decoded.normal, expected.normal));
+		}
+	}
+	printf("    %d chunks, %d clipped, %d skirt vertices, worst height %.6f, worst normal %.5f degrees\n",
+		(int)tree.getChunks().size(), clippedChunks, skirtVertices, worstHeight, worstNormal);
+	CHECK(samplesMatch);
+	CHECK(positionsMatch);
+	CHECK(clippedChunks > 0);
+	CHECK(skirtVertices > 0);
+	CHECK(worstHeight <= heightTolerance * heightScale + 1e-5f);
+	CHECK(worstNormal <= normalToleranceDegrees);
+}
@@ -0,0 +1,152 @@
+// Test block decode
+// Reference decoders for the block formats BlockCompress writes.
+#include "TestBlockDecode.h"
+#include "BlockCompress.h"
+#include <cmath>
+
+static void expand565(uint16_t colour, int rgb[3])
+{
+	rgb[0] = ((colour >> 11) & 31) * 255 / 31;
+	rgb[1] = ((colour >> 5) & 63) * 255 / 63;
+	rgb[2] = (colour & 31) * 255 / 31;
+}
+
+// Colour block: two 565 endpoints, then 2-bit indices. c0 <= c1 selects the three colour mode with transparent black.
+static void decodeColourBlock(const unsigned char* block, unsigned char pixels[16][4])
+{
+	uint16_t c0 = (uint16_t)(block[0] | block[1] << 8);
+	uint16_t c1 = (uint16_t)(block[2] | block[3] << 8);
+	int palette[4][4];
+	expand565(c0, palette[0]);
+	expand565(c1, palette[1]);
+	palette[0][3] = palette[1][3] = palette[2][3] = palette[3][3] = 255;
+	for (int channel = 0; channel < 3; channel++)
+	{
+		int a = palette[0][channel];
+		int b = palette[1][channel];
+		if (c0 > c1)
+		{
+			palette[2][channel] = (2 * a + b + 1) / 3;
+			palette[3][channel] = (a + 2 * b + 1) / 3;
+		}
+		else
+		{
+			palette[2][channel] = (a + b + 1) / 2;
+			palette[3][channel] = 0;
+		}
+	}
+	if (c0 <= c1)
+	{
+		palette[3][3] = 0;
+	}
+	uint32_t indices = block[4] | block[5] << 8 | block[6] << 16 | (uint32_t)block[7] << 24;
+	for (int i = 0; i < 16; i++)
+	{
+		const int* colour = palette[(indices >> (2 * i)) & 3];
+		for (int channel = 0; channel < 4; channel++)
+		{
+			pixels[i][channel] = (unsigned char)colour[channel];
+		}
+	}
+}
+
+// Single channel block: two 8-bit endpoints, then 3-bit indices. e0 <= e1 selects the six value mode with 0 and 255.
+static void decodeChannelBlock(const unsigned char* block, unsigned char pixels[16][4], int channel)
+{
+	int e0 = block[0];
+	int e1 = block[1];
+	int palette[8] = { e0, e1 };
+	if (e0 > e1)
+	{
+		for (int i = 1; i < 7; i++)
+		{
+			palette[i + 1] = ((7 - i) * e0 + i * e1 + 3) / 7;
+		}
+	}
+	else
+	{
+		for (int i = 1; i < 5; i++)
+		{
+			palette[i + 1] = ((5 - i) * e0 + i * e1 + 2) / 5;
+		}
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+	uint64_t indices = 0;
+	for (int i = 0; i < 6; i++)
+	{
+		indices |= (uint64_t)block[2 + i] << (8 * i);
+	}
+	for (int i = 0; i < 16; i++)
+	{
+		pixels[i][channel] = (unsigned char)palette[(indices >> (3 * i)) & 7];
+	}
+}
+
+bool decodeBlockImage(const unsigned char* blocks, int width, int height, uint32_t format, std::vector<unsigned char>& rgba)
+{
+	size_t blockSize = getBlockSize(format);
+	if (blockSize == 0)
+	{
+		return false;
+	}
+	rgba.assign((size_t)width * height * 4, 0);
+	int blocksX = (width + 3) / 4;
+	int blocksY = (height + 3) / 4;
+	for (int by = 0; by < blocksY; by++)
+	{
+		for (int bx = 0; bx < blocksX; bx++)
+		{
+			const unsigned char* block = blocks + ((size_t)by * blocksX + bx) * blockSize;
+			unsigned char pixels[16][4];
+			if (format == blockFormatBC1)
+			{
+				decodeColourBlock(block, pixels);
+			}
+			else if (format == blockFormatBC3)
+			{
+				decodeColourBlock(block + 8, pixels);
+				decodeChannelBlock(block, pixels, 3);
+			}
+			else
+			{
+				decodeChannelBlock(block, pixels, 0);
+				decodeChannelBlock(block + 8, pixels, 1);
+				for (int i = 0; i < 16; i++)
+				{
+					pixels[i][2] = 0;
+					pixels[i][3] = 255;
+				}
+			}
+			for (int i = 0; i < 16; i++)
+			{
+				int x = bx * 4 + (i & 3);
+				int y = by * 4 + (i >> 2);
+				if (x < width && y < height)
+				{
+					for (int channel = 0; channel < 4; channel++)
+					{
+						rgba[((size_t)y * width + x) * 4 + channel] = pixels[i][channel];
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
+double getPsnr(const unsigned char* a, const unsigned char* b, int width, int height, int firstChannel, int channelCount)
+{
+	double squared = 0.0;
+	size_t pixels = (size_t)width * height;
+	for (size_t i = 0; i < pixels; i++)
+	{
+		for (int channel = firstChannel; channel < firstChannel + channelCount; channel++)
+		{
+			double difference = (double)a[i * 4 + channel] - b[i * 4 + channel];
+			squared += difference * difference;
+		}
+	}
+	double mean = squared / ((double)pixels * channelCount);
+	return (mean == 0.0) ? 99.0 : 10.0 * log10(255.0 * 255.0 / mean);
+}
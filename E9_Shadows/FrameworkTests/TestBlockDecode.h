@@ -0,0 +1,22 @@
+/**
+* \brief Reference BC1, BC3 and BC5 decoders for the block compression tests and benchmarks
+*
+* Decodes the way the Direct3D specification describes, with palette entries rounded to the nearest integer,
+* so errors measured against the source are what the GPU will show to within a step.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _TESTBLOCKDECODE_H_
+#define _TESTBLOCKDECODE_H_
+
+#include <cstdint>
+#include <vector>
+
+/// Decodes a whole image to RGBA8. BC1 alpha is 255 or 0, BC5 blue is 0 and alpha 255.
+bool decodeBlockImage(const unsigned char* blocks, int width, int height, uint32_t format, std::vector<unsigned char>& rgba);
+
+/// Peak signal to noise ratio in dB over the given channels, or 99 for identical images.
+double getPsnr(const unsigned char* a, const unsigned char* b, int width, int height, int firstChannel, int channelCount);
+
+#endif
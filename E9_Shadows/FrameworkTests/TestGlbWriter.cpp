@@ -0,0 +1,114 @@
+// Test GLB writer
+// Builds the JSON and binary chunks of a .glb by hand, in the two layouts GlbFile treats differently.
+#include "TestGlbWriter.h"
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+template<typename T>
+static size_t appendAligned(std::vector<unsigned char>& binary, const T* data, size_t count)
+{
+	binary.resize((binary.size() + 3) & ~(size_t)3);
+	size_t offset = binary.size();
+	binary.resize(offset + count * sizeof(T));
+	memcpy(binary.data() + offset, data, count * sizeof(T));
+	return offset;
+}
+
+static std::string format(const char* text, ...)
+{
+	char buffer[1024];
+	va_list arguments;
+	va_start(arguments, text);
+	vsnprintf(buffer, sizeof(buffer), text, arguments);
+	va_end(arguments);
+	return buffer;
+}
+
+bool writeTestGlb(const std::string& filename, const std::vector<ModelVertex>& vertices, const std::vector<uint32_t>& indices, TestGlbLayout layout)
+{
+	std::vector<unsigned char> binary;
+	std::string views, accessors, primitives;
+	if (layout == TestGlbLayout::interleaved)
+	{
+		size_t vertexOffset = appendAligned(binary, vertices.data(), vertices.size());
+		size_t indexOffset = appendAligned(binary, indices.data(), indices.size());
+		views = format("{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu,\"byteStride\":32},{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu}",
+			vertexOffset, vertices.size() * sizeof(ModelVertex), indexOffset, indices.size() * sizeof(uint32_t));
+		accessors = format("{\"bufferView\":0,\"componentType\":5126,\"count\":%zu,\"type\":\"VEC3\"},"
+			"{\"bufferView\":0,\"byteOffset\":12,\"componentType\":5126,\"count\":%zu,\"type\":\"VEC2\"},"
+			"{\"bufferView\":0,\"byteOffset\":20,\"componentType\":5126,\"count\":%zu,\"type\":\"VEC3\"},"
+			"{\"bufferView\":1,\"componentType\":5125,\"count\":%zu,\"type\":\"SCALAR\"}", vertices.size(), vertices.size(), vertices.size(), indices.size());
+		primitives = "{\"attributes\":{\"POSITION\":0,\"TEXCOORD_0\":1,\"NORMAL\":2},\"indices\":3,\"material\":0}";
+	}
+	else
+	{
+		// Each half of the triangles gets its own vertices, renumbered from zero.
+		size_t half = indices.size() / 6 * 3;
+		for (int part = 0; part < 2; part++)
+		{
+			size_t begin = part ? half : 0;
+			size_t end = part ? indices.size() : half;
+			std::vector<int> remap(vertices.size(), -1);
+			std::vector<float> positions;
+			std::vector<uint16_t> texCoords;
+			std::vector<uint16_t> partIndices;
+			for (size_t i = begin; i < end; i++)
+			{
+				int& local = remap[indices[i]];
+				if (local < 0)
+				{
+					local = (int)(positions.size() / 3);
+					const ModelVertex& vertex = vertices[indices[i]];
+					positions.insert(positions.end(), vertex.position, vertex.position + 3);
+					for (int axis = 0; axis < 2; axis++)
+					{
+						float t = std::min(std::max(vertex.texture[axis], 0.0f), 1.0f);
+						texCoords.push_back((uint16_t)(t * 65535.0f + 0.5f));
+					}
+				}
+				partIndices.push_back((uint16_t)local);
+			}
+			if (positions.size() / 3 > 65536)
+			{
+				return false;
+			}
+
+			size_t positionOffset = appendAligned(binary, positions.data(), positions.size());
+			size_t texCoordOffset = appendAligned(binary, texCoords.data(), texCoords.size());
+			size_t indexOffset = appendAligned(binary, partIndices.data(), partIndices.size());
+			const char* separator = part ? "," : "";
+			int view = part * 3;
+			views += format("%s{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu},{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu},"
+				"{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu}", separator, positionOffset, positions.size() * sizeof(float),
+				texCoordOffset, texCoords.size() * sizeof(uint16_t), indexOffset, partIndices.size() * sizeof(uint16_t));
+			accessors += format("%s{\"bufferView\":%d,\"componentType\":5126,\"count\":%zu,\"type\":\"VEC3\",\"min\":[-1e9,-1e9,-1e9],\"max\":[1e9,1e9,1e9]},"
+				"{\"bufferView\":%d,\"componentType\":5123,\"normalized\":true,\"count\":%zu,\"type\":\"VEC2\"},"
+				"{\"bufferView\":%d,\"componentType\":5123,\"count\":%zu,\"type\":\"SCALAR\"}", separator, view, positions.size() / 3,
+				view + 1, positions.size() / 3, view + 2, partIndices.size());
+			primitives += format("%s{\"attributes\":{\"POSITION\":%d,\"TEXCOORD_0\":%d},\"indices\":%d,\"material\":%d,\"extras\":{\"name\":\"part \\\"%d\\\"\"}}",
+				separator, view, view + 1, view + 2, part, part);
+		}
+		primitives += ",{\"attributes\":{\"POSITION\":0},\"mode\":1}";
+	}
+	binary.resize((binary.size() + 3) & ~(size_t)3);
+
+	std::string json = "{\"asset\":{\"version\":\"2.0\",\"generator\":\"FrameworkTests \\u00e9\"},\"scene\":0,\"nodes\":[{\"mesh\":0}],"
+		"\"buffers\":[{\"byteLength\":" + std::to_string(binary.size()) + "}],\"bufferViews\":[" + views + "],\"accessors\":[" + accessors
+		+ "],\"meshes\":[{\"primitives\":[" + primitives + "]}],\"materials\":[{},{}]}";
+	json.resize((json.size() + 3) & ~(size_t)3, ' ');
+
+	FILE* file = fopen(filename.c_str(), "wb");
+	if (!file)
+	{
+		return false;
+	}
+	uint32_t header[3] = { 0x46546C67, 2, (uint32_t)(12 + 8 + json.size() + 8 + binary.size()) };
+	uint32_t jsonChunk[2] = { (uint32_t)json.size(), 0x4E4F534A };
+	uint32_t binaryChunk[2] = { (uint32_t)binary.size(), 0x004E4942 };
+	bool written = fwrite(header, sizeof(header), 1, file) == 1 && fwrite(jsonChunk, sizeof(jsonChunk), 1, file) == 1
+		&& fwrite(json.data(), 1, json.size(), file) == json.size() && fwrite(binaryChunk, sizeof(binaryChunk), 1, file) == 1
+		&& fwrite(binary.data(), 1, binary.size(), file) == binary.size();
+	return fclose(file) == 0 && written;
+}
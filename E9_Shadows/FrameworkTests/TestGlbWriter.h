@@ -0,0 +1,27 @@
+/**
+* \brief Writes small binary glTF files for the GLB tests and benchmarks
+*
+* The interleaved layout stores one primitive exactly as ModelVertex with 32-bit indices, which GlbFile can use in place.
+* The split layout stores two primitives with separate position and texture coordinate views, 16-bit indices,
+* normalised 16-bit texture coordinates and no normals, plus a line primitive GlbFile must skip.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _TESTGLBWRITER_H_
+#define _TESTGLBWRITER_H_
+
+#include "ModelArrays.h"
+#include <string>
+#include <vector>
+
+enum class TestGlbLayout
+{
+	interleaved,
+	split
+};
+
+/// The split layout needs under 65536 vertices in each half of the triangles.
+bool writeTestGlb(const std::string& filename, const std::vector<ModelVertex>& vertices, const std::vector<uint32_t>& indices, TestGlbLayout layout);
+
+#endif
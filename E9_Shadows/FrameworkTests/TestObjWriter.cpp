@@ -0,0 +1,73 @@
+// Test OBJ writer
+// Formats a rippled grid as OBJ text, one row of attributes followed by the faces that close it.
+#include "TestObjWriter.h"
+#include <cmath>
+#include <cstdio>
+
+// One face corner. Every seventh cell drops the texture coordinate and every eleventh drops the normal.
+static int writeCorner(char* out, size_t size, long long index, long long total, bool negative, int cell)
+{
+	long long written = negative ? index - total - 1 : index;
+	if (cell % 77 == 0)
+		return snprintf(out, size, " %lld", written);
+	if (cell % 11 == 0)
+		return snprintf(out, size, " %lld/%lld", written, written);
+	if (cell % 7 == 0)
+		return snprintf(out, size, " %lld//%lld", written, written);
+	return snprintf(out, size, " %lld/%lld/%lld", written, written, written);
+}
+
+std::string makeTestObj(int columns, int rows, bool quads)
+{
+	std::string text;
+	text.reserve((size_t)columns * rows * (quads ? 150 : 190));
+	text += "# synthetic grid\no grid\n";
+
+	char line[256];
+	long long total = 0;
+	for (int j = 0; j < rows; j++)
+	{
+		for (int i = 0; i < columns; i++)
+		{
+			float x = i * 0.1f;
+			float z = j * 0.1f;
+			float height = 0.25f * sinf(x * 1.7f) * cosf(z * 1.3f);
+			snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn %.6f %.6f %.6f\n",
+				x, height, z, (float)i / (columns - 1), (float)j / (rows - 1),
+				-0.425f * cosf(x * 1.7f) * cosf(z * 1.3f), 1.0f, 0.325f * sinf(x * 1.7f) * sinf(z * 1.3f));
+			text += line;
+		}
+		total += columns;
+		if (j == 0)
+			continue;
+
+		bool negative = (j % 2) == 1;
+		for (int i = 0; i < columns - 1; i++)
+		{
+			long long bottomLeft = (long long)(j - 1) * columns + i + 1;
+			long long corners[4] = { bottomLeft, bottomLeft + columns, bottomLeft + columns + 1, bottomLeft + 1 };
+			int cell = j * columns + i;
+			int length = 0;
+			if (quads)
+			{
+				length += snprintf(line, sizeof(line), "f");
+				for (long long corner : corners)
+					length += writeCorner(line + length, sizeof(line) - length, corner, total, negative, cell);
+				line[length++] = '\n';
+			}
+			else
+			{
+				const int triangles[6] = { 0, 1, 2, 0, 2, 3 };
+				for (int t = 0; t < 6; t += 3)
+				{
+					length += snprintf(line + length, sizeof(line) - length, "f");
+					for (int c = 0; c < 3; c++)
+						length += writeCorner(line + length, sizeof(line) - length, corners[triangles[t + c]], total, negative, cell);
+					line[length++] = '\n';
+				}
+			}
+			text.append(line, length);
+		}
+	}
+	return text;
+}
@@ -0,0 +1,22 @@
+/**
+* \brief Writes synthetic OBJ text for the OBJ loader tests and benchmarks
+*
+* The mesh is a rippled grid written row by row: each row's positions, texture coordinates and normals, then the
+* faces joining it to the row before. Rows alternate between absolute and negative indices, and a few faces leave out
+* the texture coordinate or normal, so every corner form and index kind appears throughout the file.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _TESTOBJWRITER_H_
+#define _TESTOBJWRITER_H_
+
+#include <string>
+
+/** \brief Builds the OBJ text of a grid mesh
+* @param columns and rows are vertices along each side, at least 2
+* @param quads writes each cell as one quad rather than two triangles. Both make two triangles per cell once parsed
+*/
+std::string makeTestObj(int columns, int rows, bool quads);
+
+#endif
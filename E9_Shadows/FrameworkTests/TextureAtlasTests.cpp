@@ -0,0 +1,183 @@
+// Texture atlas tests
+// Every kept level of every page is checked for bleeding between textures, along with the UV remap and the grid.
+#include "FrameworkTest.h"
+#include "TextureAtlas.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+struct AtlasTestSet
+{
+	std::vector<std::vector<unsigned char>> images;
+	std::vector<AtlasSource> sources;
+	std::vector<uint32_t> colours;
+};
+
+// Solid textures of random colours, so any texel of a neighbour shows up. Sizes are powers of two or anything up
+// to maxSize, and texture 3 is too big to atlas.
+static AtlasTestSet makeAtlasSet(int count, bool powersOfTwo, int maxSize, unsigned int seed)
+{
+	std::mt19937 random(seed);
+	AtlasTestSet set;
+	set.images.resize(count);
+	set.sources.resize(count);
+	set.colours.resize(count);
+	for (int i = 0; i < count; i++)
+	{
+		int width = powersOfTwo ? 1 << (4 + random() % 4) : 1 + random() % maxSize;
+		int height = powersOfTwo ? width : 1 + random() % maxSize;
+		if (i == 3)
+		{
+			width = maxSize + 44;
+		}
+		set.colours[i] = (uint32_t)random() | 0xff000000u;
+		set.images[i].resize((size_t)width * height * 4);
+		for (size_t pixel = 0; pixel < (size_t)width * height; pixel++)
+		{
+			memcpy(&set.images[i][pixel * 4], &set.colours[i], 4);
+		}
+		set.sources[i] = { set.images[i].data(), width, height };
+	}
+	return set;
+}
+
+// The texels bilinear sampling can reach at each level: the texture's footprint plus one texel all round.
+static bool isBleedFree(const TextureAtlas& atlas, const AtlasTestSet& set, size_t index, int mipLevels)
+{
+	const AtlasEntry& entry = atlas.entries[index];
+	const AtlasSource& source = set.sources[index];
+	const DecodedTexture& page = atlas.pages[entry.page];
+	const unsigned char* colour = (const unsigned char*)&set.colours[index];
+	for (int level = 0; level <= mipLevels; level++)
+	{
+		const TextureMipLevel& mip = page.mips[level];
+		int x0 = (entry.x >> level) - 1;
+		int y0 = (entry.y >> level) - 1;
+		int x1 = ((entry.x + source.width + (1 << level) - 1) >> level) + 1;
+		int y1 = ((entry.y + source.height + (1 << level) - 1) >> level) + 1;
+		if (x0 < 0 || y0 < 0 || x1 > mip.width || y1 > mip.height)
+		{
+			return false;
+		}
+		for (int y = y0; y < y1; y++)
+		{
+			for (int x = x0; x < x1; x++)
+			{
+				const unsigned char* texel = &page.pixels[mip.offset + ((size_t)y * mip.width + x) * 4];
+				for (int channel = 0; channel < 4; channel++)
+				{
+					if (abs(texel[channel] - colour[channel]) > 1)
+					{
+						return false;
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
+FRAMEWORK_TEST(textureAtlasBleed)
+{
+	struct SetCase
+	{
+		int count;
+		bool powersOfTwo;
+	};
+	const SetCase cases[] = { { 64, true }, { 400, false } };
+	for (const SetCase& test : cases)
+	{
+		AtlasTestSet set = makeAtlasSet(test.count, test.powersOfTwo, 256, test.count);
+		for (int mipLevels = 1; mipLevels <= 4; mipLevels++)
+		{
+			AtlasSettings settings;
+			settings.mipLevels = mipLevels;
+			settings.threadCount = 0;
+			TextureAtlas atlas;
+			CHECK(buildTextureAtlas(set.sources, atlas, settings));
+			CHECK(atlas.entries.size() == set.sources.size());
+			int bleeding = 0;
+			int badRemaps = 0;
+			int offGrid = 0;
+			for (size_t i = 0; i < set.sources.size(); i++)
+			{
+				const AtlasEntry& entry = atlas.entries[i];
+				if (entry.page < 0)
+				{
+					continue;
+				}
+				const DecodedTexture& page = atlas.pages[entry.page];
+				CHECK(page.mips.size() == (size_t)mipLevels + 1);
+				bleeding += isBleedFree(atlas, set, i, mipLevels) ? 0 : 1;
+				offGrid += (entry.x % (1 << mipLevels) != 0 || entry.y % (1 << mipLevels) != 0) ? 1 : 0;
+
+				// UV 0 lands on the texture's first texel edge and UV 1 on its last.
+				float width = (float)page.getWidth();
+				float height = (float)page.getHeight();
+				bool remapped = fabsf(entry.uvOffset[0] * width - entry.x) < 1e-3f && fabsf(entry.uvOffset[1] * height - entry.y) < 1e-3f &&
+					fabsf(entry.uvScale[0] * width - set.sources[i].width) < 1e-3f && fabsf(entry.uvScale[1] * height - set.sources[i].height) < 1e-3f;
+				badRemaps += remapped ? 0 : 1;
+			}
+			CHECK(bleeding == 0);
+			CHECK(badRemaps == 0);
+			CHECK(offGrid == 0);
+			CHECK(atlas.entries[3].page == -1);
+			CHECK(atlas.stats.sourceTexels <= atlas.stats.cellTexels && atlas.stats.cellTexels <= atlas.stats.pageTexels);
+			if (mipLevels == 3)
+			{
+				printf("  %d textures: %d pages, %.0f%% efficient\n", test.count, (int)atlas.pages.size(), atlas.stats.getEfficiency() * 100.0f);
+			}
+		}
+	}
+}
+
+FRAMEWORK_TEST(textureAtlasContents)
+{
+	// The top level holds each texture exactly as it was given.
+	std::mt19937 random(5);
+	std::vector<std::vector<unsigned char>> images(30);
+	std::vector<AtlasSource> sources(images.size());
+	for (size_t i = 0; i < images.size(); i++)
+	{
+		int width = 1 + random() % 100;
+		int height = 1 + random() % 100;
+		images[i].resize((size_t)width * height * 4);
+		for (unsigned char& value : images[i])
+		{
+			value = (unsigned char)random();
+		}
+		sources[i] = { images[i].data(), width, height };
+	}
+	TextureAtlas atlas;
+	CHECK(buildTextureAtlas(sources, atlas));
+	for (size_t i = 0; i < sources.size(); i++)
+	{
+		const AtlasEntry& entry = atlas.entries[i];
+		CHECK(entry.page >= 0);
+		if (entry.page < 0)
+		{
+			continue;
+		}
+		const DecodedTexture& page = atlas.pages[entry.page];
+		bool same = true;
+		for (int y = 0; y < sources[i].height; y++)
+		{
+			const unsigned char* row = &page.pixels[((size_t)(entry.y + y) * page.getWidth() + entry.x) * 4];
+			same = same && memcmp(row, sources[i].pixels + (size_t)y * sources[i].width * 4, (size_t)sources[i].width * 4) == 0;
+		}
+		CHECK(same);
+	}
+
+	// Settings the grid cannot work with are refused.
+	AtlasSettings settings;
+	settings.pageSize = 1000;
+	CHECK(!buildTextureAtlas(sources, atlas, settings));
+	settings.pageSize = 4;
+	settings.mipLevels = 3;
+	CHECK(!buildTextureAtlas(sources, atlas, settings));
+	settings.pageSize = 2048;
+	settings.mipLevels = -1;
+	CHECK(!buildTextureAtlas(sources, atlas, settings));
+}
@@ -0,0 +1,214 @@
+// Texture cache tests
+// DDS files round trip through buildTextureDds and decodeTexture, and parseDds stays within any file it accepts.
+#include "FrameworkTest.h"
+#include "TextureCache.h"
+#include <cstring>
+#include <random>
+
+static const uint32_t cacheFormats[] = { textureFormatRGBA8, blockFormatBC1, blockFormatBC3, blockFormatBC5 };
+
+// Field offsets from the start of a DDS file: the magic, the 124 byte header, then the DX10 extension.
+static const size_t ddsFlagsOffset = 8;
+static const size_t ddsMipCountOffset = 28;
+static const size_t ddsPixelFlagsOffset = 80;
+static const size_t ddsFourCCOffset = 84;
+static const size_t ddsDx10Offset = 128;
+static const size_t ddsDx10Size = 20;
+
+static DecodedTexture makeCacheTexture(int width, int height, unsigned int seed)
+{
+	std::mt19937 random(seed);
+	DecodedTexture texture;
+	size_t offset = 0;
+	for (int level = 0; level < getMipLevelCount(width, height); level++)
+	{
+		int levelWidth = std::max(width >> level, 1);
+		int levelHeight = std::max(height >> level, 1);
+		texture.mips.push_back({ offset, levelWidth, levelHeight });
+		offset += (size_t)levelWidth * levelHeight * 4;
+	}
+	texture.pixels.resize(offset);
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			unsigned char* pixel = &texture.pixels[((size_t)y * width + x) * 4];
+			pixel[0] = (unsigned char)(x * 255 / width);
+			pixel[1] = (unsigned char)(y * 255 / height);
+			pixel[2] = (unsigned char)(random() % 64);
+			pixel[3] = (unsigned char)((x + y) % 2 ? 255 : 128);
+		}
+	}
+	generateMipChain(texture.pixels.data(), texture.mips.data(), (int)texture.mips.size(), MipSettings());
+	return texture;
+}
+
+static void writeField(std::vector<unsigned char>& dds, size_t offset, uint32_t value)
+{
+	memcpy(&dds[offset], &value, sizeof(value));
+}
+
+// The same file with a legacy header: the DX10 extension removed and the format in the pixel format instead.
+static std::vector<unsigned char> makeLegacyDds(const std::vector<unsigned char>& dds, uint32_t format)
+{
+	std::vector<unsigned char> legacy(dds.size() - ddsDx10Size);
+	memcpy(legacy.data(), dds.data(), ddsDx10Offset);
+	memcpy(legacy.data() + ddsDx10Offset, dds.data() + ddsDx10Offset + ddsDx10Size, legacy.size() - ddsDx10Offset);
+	if (format == textureFormatRGBA8)
+	{
+		const uint32_t fields[] = { 0x41, 0, 32, 0xff, 0xff00, 0xff0000, 0xff000000 };
+		for (size_t i = 0; i < 7; i++)
+		{
+			writeField(legacy, ddsPixelFlagsOffset + i * 4, fields[i]);
+		}
+		return legacy;
+	}
+	const char* fourCC = (format == blockFormatBC1) ? "DXT1" : (format == blockFormatBC3) ? "DXT5" : "ATI2";
+	memcpy(&legacy[ddsFourCCOffset], fourCC, 4);
+	return legacy;
+}
+
+FRAMEWORK_TEST(textureCacheRoundTrip)
+{
+	std::string directory = getTestDirectory("textureCacheRoundTrip");
+	std::string sourceFilename = directory + "/source.png";
+	const char sourceBytes[] = "stands in for an image file";
+	CHECK(writeTestFile(sourceFilename, sourceBytes, sizeof(sourceBytes)));
+	DecodedTexture texture = makeCacheTexture(64, 48, 1);
+
+	for (uint32_t format : cacheFormats)
+	{
+		std::vector<unsigned char> dds;
+		CHECK(buildTextureDds(texture, format, sourceFilename, dds, 1));
+		std::string ddsFilename = directory + "/cache" + std::to_string(format) + ".dds";
+		CHECK(writeTestFile(ddsFilename, dds.data(), dds.size()));
+		CHECK(isTextureCacheCurrent(ddsFilename, sourceFilename));
+
+		// Loading maps the file and points at the levels in place.
+		DecodedTexture loaded;
+		std::string error;
+		CHECK(decodeTexture(ddsFilename, loaded, error));
+		CHECK(loaded.mappedPixels != nullptr && loaded.format == format && loaded.mips.size() == texture.mips.size());
+		if (loaded.format != format || loaded.mips.size() != texture.mips.size())
+		{
+			continue;
+		}
+		CHECK(loaded.getPixelsSize() == dds.size() - ddsDx10Offset - ddsDx10Size);
+
+		// Each level holds the source level as it is, or as compressImage gives it.
+		bool same = true;
+		for (size_t level = 0; level < texture.mips.size(); level++)
+		{
+			const TextureMipLevel& mip = texture.mips[level];
+			std::vector<unsigned char> expected(loaded.getLevelSize(level));
+			if (format == textureFormatRGBA8)
+			{
+				memcpy(expected.data(), texture.pixels.data() + mip.offset, expected.size());
+			}
+			else
+			{
+				compressImage(texture.pixels.data() + mip.offset, mip.width, mip.height, format, expected.data(), 1);
+			}
+			same = same && loaded.mips[level].width == mip.width && loaded.mips[level].height == mip.height
+				&& memcmp(loaded.getPixels() + loaded.mips[level].offset, expected.data(), expected.size()) == 0;
+		}
+		CHECK(same);
+
+		// unpackDds copies the same levels, and a legacy header describes the same layout.
+		DecodedTexture file;
+		file.ddsData = dds;
+		DecodedTexture unpacked;
+		CHECK(unpackDds(file, unpacked));
+		CHECK(unpacked.pixels.size() == loaded.getPixelsSize() && memcmp(unpacked.pixels.data(), loaded.getPixels(), unpacked.pixels.size()) == 0);
+		std::vector<unsigned char> legacy = makeLegacyDds(dds, format);
+		DecodedTexture legacyLayout;
+		size_t dataOffset = 0;
+		CHECK(parseDds(legacy.data(), legacy.size(), legacyLayout, dataOffset));
+		CHECK(dataOffset == ddsDx10Offset && legacyLayout.format == format && legacyLayout.mips.size() == loaded.mips.size());
+	}
+
+	// A changed source makes every cache stale.
+	const char changedBytes[] = "stands in for an edited image file";
+	CHECK(writeTestFile(sourceFilename, changedBytes, sizeof(changedBytes)));
+	CHECK(!isTextureCacheCurrent(directory + "/cache28.dds", sourceFilename));
+	CHECK(!isTextureCacheCurrent(directory + "/missing.dds", sourceFilename));
+
+	// Block formats need whole blocks at the top level.
+	DecodedTexture odd = makeCacheTexture(30, 20, 2);
+	std::vector<unsigned char> dds;
+	CHECK(!buildTextureDds(odd, blockFormatBC1, std::string(), dds, 1));
+	CHECK(buildTextureDds(odd, textureFormatRGBA8, std::string(), dds, 1));
+	CHECK(!buildTextureDds(odd, 12345, std::string(), dds, 1));
+}
+
+FRAMEWORK_TEST(textureCacheParseDdsMutations)
+{
+	// Valid files of each format with each header, whole chains and single levels.
+	std::vector<std::vector<unsigned char>> files;
+	DecodedTexture texture = makeCacheTexture(64, 32, 3);
+	for (uint32_t format : cacheFormats)
+	{
+		std::vector<unsigned char> dds;
+		buildTextureDds(texture, format, std::string(), dds, 1);
+		files.push_back(dds);
+		files.push_back(makeLegacyDds(dds, format));
+		writeField(dds, ddsFlagsOffset, 0x1007);
+		files.push_back(dds);
+	}
+	for (const std::vector<unsigned char>& file : files)
+	{
+		DecodedTexture layout;
+		size_t dataOffset = 0;
+		CHECK(parseDds(file.data(), file.size(), layout, dataOffset));
+	}
+
+	// Flipped bits, boundary values in whole fields, and truncations. Anything accepted must describe levels that
+	// fit in what is there, and copying them must stay in bounds.
+	const uint32_t boundaryValues[] = { 0, 1, 2, 3, 4, 0x7fffffff, 0x80000000, 0xffffffff, 16384, 16385, 65536 };
+	std::mt19937 random(5);
+	int accepted = 0;
+	int outOfBounds = 0;
+	const int mutations = 30000;
+	for (int i = 0; i < mutations; i++)
+	{
+		DecodedTexture file;
+		file.ddsData = files[i % files.size()];
+		std::vector<unsigned char>& dds = file.ddsData;
+		size_t headerBytes = std::min(dds.size(), ddsDx10Offset + ddsDx10Size);
+		switch (i % 3)
+		{
+		case 0:
+			for (int flips = 1 + random() % 4; flips > 0; flips--)
+			{
+				dds[random() % headerBytes] ^= (unsigned char)(1 << (random() % 8));
+			}
+			break;
+		case 1:
+			writeField(dds, (random() % (headerBytes / 4)) * 4, boundaryValues[random() % 11]);
+			break;
+		default:
+			dds.resize(random() % dds.size());
+			break;
+		}
+		if (random() % 4 == 0)
+		{
+			writeField(dds, ddsMipCountOffset, 1 + random() % 20);
+		}
+
+		DecodedTexture layout;
+		size_t dataOffset = 0;
+		if (!parseDds(dds.data(), dds.size(), layout, dataOffset))
+		{
+			continue;
+		}
+		accepted++;
+		bool inBounds = dataOffset <= dds.size() && layout.getPixelsSize() <= dds.size() - dataOffset && !layout.mips.empty()
+			&& (int)layout.mips.size() <= getMipLevelCount(layout.getWidth(), layout.getHeight());
+		outOfBounds += inBounds ? 0 : 1;
+		DecodedTexture unpacked;
+		CHECK(unpackDds(file, unpacked));
+	}
+	CHECK(outOfBounds == 0);
+	CHECK(accepted > 0 && accepted < mutations);
+	printf("  %d of %d mutated files accepted, all within their size\n", accepted, mutations);
+}
@@ -0,0 +1,305 @@
+// Texture decode tests
+// decodeTexture against stb_image on the res images, and the decode queue driven by a fake decoder: order, errors and dropping queued files.
+#include "FrameworkTest.h"
+#include "TextureDecodeQueue.h"
+#include "stb_image.h"
+#include <algorithm>
+#include <functional>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+// Level 0 is the image itself, and each level after it is half the last, down to exactly 1x1.
+static void checkMipChain(const DecodedTexture& texture, int width, int height)
+{
+	CHECK(texture.getWidth() == width && texture.getHeight() == height);
+	CHECK((int)texture.mips.size() == getMipLevelCount(width, height));
+	CHECK(!texture.mips.empty() && texture.mips.back().width == 1 && texture.mips.back().height == 1);
+	bool halved = !texture.mips.empty() && texture.mips[0].offset == 0;
+	for (size_t level = 1; level < texture.mips.size() && halved; level++)
+	{
+		const TextureMipLevel& previous = texture.mips[level - 1];
+		const TextureMipLevel& mip = texture.mips[level];
+		halved = mip.width == std::max(previous.width / 2, 1) && mip.height == std::max(previous.height / 2, 1) &&
+			mip.offset == previous.offset + texture.getLevelSize(level - 1);
+	}
+	CHECK(halved);
+	CHECK(texture.pixels.size() == texture.getPixelsSize());
+}
+
+FRAMEWORK_TEST(textureDecodeResImages)
+{
+	int images = 0;
+	std::error_code error;
+	for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(getResourceDirectory(), error))
+	{
+		std::string extension = entry.path().extension().string();
+		if (extension != ".png" && extension != ".jpg")
+		{
+			continue;
+		}
+		std::string filename = entry.path().string();
+		int width = 0, height = 0, channels = 0;
+		unsigned char* expected = stbi_load(filename.c_str(), &width, &height, &channels, 4);
+		CHECK(expected != nullptr);
+		if (!expected)
+		{
+			continue;
+		}
+
+		DecodedTexture texture;
+		std::string decodeError;
+		CHECK(decodeTexture(filename, texture, decodeError));
+		CHECK(texture.format == textureFormatRGBA8 && !texture.isDds() && !texture.mappedPixels);
+		checkMipChain(texture, width, height);
+		CHECK(texture.pixels.size() >= (size_t)width * height * 4 &&
+			memcmp(texture.pixels.data(), expected, (size_t)width * height * 4) == 0);
+
+		// Without mips only level 0 is kept, and it is the same image.
+		MipSettings single;
+		single.generateMips = false;
+		DecodedTexture top;
+		CHECK(decodeTexture(filename, top, decodeError, single));
+		CHECK(top.mips.size() == 1 && top.pixels.size() == (size_t)width * height * 4 &&
+			memcmp(top.pixels.data(), expected, top.pixels.size()) == 0);
+		stbi_image_free(expected);
+		printf("    %-20s %4d x %-4d %2d levels\n", entry.path().filename().string().c_str(), width, height, (int)texture.mips.size());
+		images++;
+	}
+	if (images == 0)
+	{
+		printf("  no images in %s\n", getResourceDirectory().c_str());
+	}
+	CHECK(images > 0);
+}
+
+// An 8-bit greyscale PGM, which stb_image expands to RGBA with an opaque alpha.
+static std::vector<unsigned char> makeGreyImage(int width, int height)
+{
+	std::string header = "P5\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+	std::vector<unsigned char> file(header.begin(), header.end());
+	for (int i = 0; i < width * height; i++)
+	{
+		file.push_back((unsigned char)(i * 37));
+	}
+	return file;
+}
+
+FRAMEWORK_TEST(textureDecodeShapes)
+{
+	// Odd and lopsided sizes still end at 1x1, and each level is the previous one downsampled.
+	const int sizes[][2] = { { 1, 1 }, { 13, 5 }, { 1, 64 }, { 300, 7 } };
+	for (const auto& size : sizes)
+	{
+		std::vector<unsigned char> file = makeGreyImage(size[0], size[1]);
+		DecodedTexture texture;
+		std::string error;
+		CHECK(decodeImage(file.data(), file.size(), texture, error));
+		checkMipChain(texture, size[0], size[1]);
+		CHECK(texture.pixels[0] == 0 && texture.pixels[3] == 255);
+		CHECK(size[0] * size[1] == 1 || (texture.pixels[4] == 37 && texture.pixels[6] == 37 && texture.pixels[7] == 255));
+
+		bool downsampled = true;
+		std::vector<unsigned char> level;
+		for (size_t i = 1; i < texture.mips.size(); i++)
+		{
+			const TextureMipLevel& previous = texture.mips[i - 1];
+			level.resize(texture.getLevelSize(i));
+			downsampleRGBA8(texture.pixels.data() + previous.offset, previous.width, previous.height, level.data(), MipSettings());
+			downsampled = downsampled && memcmp(level.data(), texture.pixels.data() + texture.mips[i].offset, level.size()) == 0;
+		}
+		CHECK(downsampled);
+	}
+
+	// Failures say why and leave nothing behind.
+	DecodedTexture texture;
+	std::string error;
+	const unsigned char garbage[] = "not an image";
+	CHECK(!decodeImage(garbage, sizeof(garbage), texture, error));
+	CHECK(!error.empty() && texture.mips.empty() && texture.pixels.empty());
+	error.clear();
+	CHECK(!decodeTexture(getTestDirectory("textureDecodeShapes") + "/missing.png", texture, error));
+	CHECK(error.find("missing.png") != std::string::npos);
+}
+
+// Decodes block until their file is released, so a test decides when each one finishes. Each decoded texture is
+// 1 pixel wide and as tall as its filename is long.
+class GatedDecoder
+{
+public:
+	void release(const std::string& filename)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		released.push_back(filename);
+		changed.notify_all();
+	}
+
+	void releaseAll()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		all = true;
+		changed.notify_all();
+	}
+
+	// "fail:" and "throw:" files fail.
+	bool decode(const std::string& filename, DecodedTexture& texture, std::string& error)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			started.push_back(filename);
+			changed.notify_all();
+			changed.wait(lock, [&]() { return all || std::find(released.begin(), released.end(), filename) != released.end(); });
+		}
+		if (filename.compare(0, 5, "fail:") == 0)
+		{
+			error = (filename == "fail:quiet") ? "" : "bad file";
+			return false;
+		}
+		if (filename.compare(0, 6, "throw:") == 0)
+		{
+			throw std::runtime_error("decoder threw");
+		}
+		texture.mips.push_back({ 0, 1, (int)filename.size() });
+		return true;
+	}
+
+	bool waitForStart(const std::string& filename)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		return changed.wait_for(lock, std::chrono::seconds(5),
+			[&]() { return std::find(started.begin(), started.end(), filename) != started.end(); });
+	}
+
+	std::vector<std::string> getStarted()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return started;
+	}
+
+private:
+	std::mutex mutex;
+	std::condition_variable changed;
+	std::vector<std::string> released;
+	std::vector<std::string> started;
+	bool all = false;
+};
+
+static TextureDecodeQueue::Decoder bindDecoder(GatedDecoder& decoder)
+{
+	return [&decoder](const std::string& filename, DecodedTexture& texture, std::string& error) { return decoder.decode(filename, texture, error); };
+}
+
+// Pops until a result turns up, or a few seconds pass.
+static bool popResult(TextureDecodeQueue& queue, TextureDecodeResult& result)
+{
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (!queue.pop(result))
+	{
+		if (std::chrono::steady_clock::now() >= deadline)
+		{
+			return false;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return true;
+}
+
+FRAMEWORK_TEST(textureDecodeQueueOrder)
+{
+	// One worker decodes in push order, so results come out in push order too.
+	{
+		GatedDecoder decoder;
+		decoder.releaseAll();
+		TextureDecodeQueue queue(1, bindDecoder(decoder));
+		CHECK(queue.getThreadCount() == 1);
+		std::vector<uint32_t> ids;
+		for (int i = 0; i < 20; i++)
+		{
+			ids.push_back(queue.push("file" + std::to_string(i) + ".png"));
+		}
+		queue.wait();
+		CHECK(queue.getPendingCount() == 20);
+		bool ordered = true;
+		TextureDecodeResult result;
+		for (int i = 0; i < 20; i++)
+		{
+			std::string filename = "file" + std::to_string(i) + ".png";
+			ordered = ordered && queue.pop(result) && result.id == ids[i] && result.filename == filename && result.succeeded &&
+				result.texture.getHeight() == (int)filename.size();
+		}
+		CHECK(ordered);
+		CHECK(ids[0] != 0 && std::adjacent_find(ids.begin(), ids.end(), std::greater_equal<uint32_t>()) == ids.end());
+		CHECK(!queue.pop(result));
+		CHECK(queue.getPendingCount() == 0);
+		CHECK(decoder.getStarted().size() == 20 && decoder.getStarted().back() == "file19.png");
+	}
+
+	// With several workers, pop hands results out in the order the decodes finish.
+	GatedDecoder decoder;
+	TextureDecodeQueue queue(2, bindDecoder(decoder));
+	uint32_t slow = queue.push("slow.png");
+	uint32_t fast = queue.push("fast.png");
+	CHECK(decoder.waitForStart("slow.png") && decoder.waitForStart("fast.png"));
+	CHECK(queue.getPendingCount() == 2);
+	TextureDecodeResult result;
+	CHECK(!queue.pop(result));
+	decoder.release("fast.png");
+	CHECK(popResult(queue, result) && result.id == fast);
+	decoder.release("slow.png");
+	CHECK(popResult(queue, result) && result.id == slow);
+	CHECK(queue.getPendingCount() == 0);
+}
+
+FRAMEWORK_TEST(textureDecodeQueueErrors)
+{
+	GatedDecoder decoder;
+	decoder.releaseAll();
+	TextureDecodeQueue queue(2, bindDecoder(decoder));
+	const char* files[] = { "fail:message", "fail:quiet", "throw:exception", "good.png" };
+	const char* expected[] = { "bad file", "Could not decode fail:quiet", "decoder threw", "" };
+	std::vector<uint32_t> ids;
+	for (const char* file : files)
+	{
+		ids.push_back(queue.push(file));
+	}
+	queue.wait();
+	TextureDecodeResult result;
+	int results = 0;
+	while (queue.pop(result))
+	{
+		size_t file = std::find(ids.begin(), ids.end(), result.id) - ids.begin();
+		CHECK(file < ids.size() && result.filename == files[file] && result.error == expected[file]);
+		CHECK(result.succeeded == (file == 3));
+		results++;
+	}
+	CHECK(results == 4);
+}
+
+FRAMEWORK_TEST(textureDecodeQueueCancel)
+{
+	// Files still queued when the queue is destroyed are never decoded. The one already running is waited for.
+	GatedDecoder decoder;
+	std::thread releaser;
+	{
+		TextureDecodeQueue queue(1, bindDecoder(decoder));
+		queue.push("running.png");
+		for (int i = 0; i < 10; i++)
+		{
+			queue.push("queued" + std::to_string(i) + ".png");
+		}
+		CHECK(decoder.waitForStart("running.png"));
+		CHECK(queue.getPendingCount() == 11);
+
+		// The decode is let go only once the destructor is waiting on it.
+		releaser = std::thread([&decoder]()
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			decoder.releaseAll();
+		});
+	}
+	releaser.join();
+	std::vector<std::string> started = decoder.getStarted();
+	CHECK(started.size() == 1 && started[0] == "running.png");
+}
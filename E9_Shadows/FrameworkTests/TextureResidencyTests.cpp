@@ -0,0 +1,271 @@
+// Texture residency tests
+// Streaming order, least-recently-used eviction and the budget, checked after every update of a replayed access trace.
+#include "FrameworkTest.h"
+#include "TextureResidency.h"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+static std::vector<uint64_t> makeLevelBytes(int width, int height, int bytesPerPixel)
+{
+	std::vector<uint64_t> levels;
+	for (;;)
+	{
+		levels.push_back((uint64_t)width * height * bytesPerPixel);
+		if (width == 1 && height == 1)
+		{
+			return levels;
+		}
+		width = std::max(width / 2, 1);
+		height = std::max(height / 2, 1);
+	}
+}
+
+static uint64_t getChainBytes(const std::vector<uint64_t>& levels)
+{
+	uint64_t bytes = 0;
+	for (uint64_t level : levels)
+	{
+		bytes += level;
+	}
+	return bytes;
+}
+
+// Draws the textures every frame and completes every load straight away, for a number of frames.
+static void drawFrames(TextureResidency& residency, const std::vector<uint32_t>& ids, int frames, std::vector<ResidencyChange>& changes)
+{
+	for (int frame = 0; frame < frames; frame++)
+	{
+		for (uint32_t id : ids)
+		{
+			residency.markUsed(id);
+		}
+		residency.update(changes);
+		for (const ResidencyChange& change : changes)
+		{
+			if (change.load)
+			{
+				residency.completeLoad(change.id, change.mip);
+			}
+		}
+	}
+}
+
+FRAMEWORK_TEST(textureResidencyStreaming)
+{
+	// One texture with room to spare streams in one level per update, coarse to fine.
+	ResidencySettings settings;
+	settings.budgetBytes = 1ull << 30;
+	TextureResidency residency(settings);
+	std::vector<uint64_t> levels = makeLevelBytes(1024, 1024, 4);
+	int tailMip = residency.addTexture(1, levels);
+	CHECK(tailMip > 0);
+	CHECK(residency.getResidentBytes() <= settings.tailBytes);
+	CHECK(residency.addTexture(1, levels) == -1);
+	CHECK(residency.addTexture(2, std::vector<uint64_t>()) == -1);
+
+	std::vector<ResidencyChange> changes;
+	int expected = tailMip;
+	for (int frame = 0; frame < 20; frame++)
+	{
+		residency.markUsed(1);
+		residency.update(changes);
+		for (const ResidencyChange& change : changes)
+		{
+			CHECK(change.load && change.mip == expected - 1);
+			expected = change.mip;
+			residency.completeLoad(change.id, change.mip);
+		}
+	}
+	CHECK(residency.getResidentMip(1) == 0);
+	CHECK(residency.getResidentBytes() == getChainBytes(levels));
+
+	// Asking for a coarser level stops there. A failed load is planned again.
+	residency.addTexture(3, levels);
+	for (int frame = 0; frame < 20; frame++)
+	{
+		residency.markUsed(3, 3);
+		residency.update(changes);
+		for (const ResidencyChange& change : changes)
+		{
+			residency.completeLoad(change.id, change.mip);
+		}
+	}
+	CHECK(residency.getResidentMip(3) == 3);
+	residency.markUsed(3, 2);
+	residency.update(changes);
+	CHECK(changes.size() == 1 && residency.isLoading(3));
+	residency.cancelLoad(3);
+	CHECK(!residency.isLoading(3) && residency.getLoadingBytes() == 0);
+	residency.markUsed(3, 2);
+	residency.update(changes);
+	CHECK(changes.size() == 1 && changes[0].mip == 2);
+
+	residency.removeTexture(1);
+	residency.removeTexture(3);
+	CHECK(residency.getResidentBytes() == 0 && residency.getLoadingBytes() == 0 && residency.getTextureCount() == 0);
+}
+
+FRAMEWORK_TEST(textureResidencyEviction)
+{
+	// Room for two full chains. Three textures drawn in turn: the least recently drawn gives up its levels first.
+	std::vector<uint64_t> levels = makeLevelBytes(512, 512, 4);
+	ResidencySettings settings;
+	settings.budgetBytes = getChainBytes(levels) * 2 + settings.tailBytes * 4;
+	TextureResidency residency(settings);
+	int tailMips[4] = {};
+	for (uint32_t id = 1; id <= 3; id++)
+	{
+		tailMips[id] = residency.addTexture(id, levels);
+	}
+	std::vector<ResidencyChange> changes;
+	drawFrames(residency, { 1 }, 20, changes);
+	drawFrames(residency, { 2 }, 20, changes);
+	CHECK(residency.getResidentMip(1) == 0 && residency.getResidentMip(2) == 0);
+
+	// Streaming texture 3 in evicts only from texture 1, the least recently drawn, and keeps texture 2 whole.
+	for (int frame = 0; frame < 20; frame++)
+	{
+		residency.markUsed(3);
+		residency.update(changes);
+		for (const ResidencyChange& change : changes)
+		{
+			CHECK(change.load ? change.id == 3 : change.id == 1);
+			if (change.load)
+			{
+				residency.completeLoad(change.id, change.mip);
+			}
+		}
+		CHECK(residency.getResidentBytes() + residency.getLoadingBytes() <= settings.budgetBytes);
+	}
+	CHECK(residency.getResidentMip(3) == 0 && residency.getResidentMip(2) == 0 && residency.getResidentMip(1) > 0);
+
+	// Textures drawn together every frame do not evict each other back and forth.
+	drawFrames(residency, { 2, 3 }, 10, changes);
+	uint64_t evictions = residency.getStats().evictions;
+	for (int frame = 0; frame < 10; frame++)
+	{
+		residency.markUsed(2);
+		residency.markUsed(3);
+		residency.update(changes);
+		CHECK(changes.empty());
+	}
+	CHECK(residency.getStats().evictions == evictions);
+
+	// A lowered budget is enforced on the next update, down to the tails and no further.
+	settings.budgetBytes = 1;
+	residency.setSettings(settings);
+	residency.update(changes);
+	for (uint32_t id = 1; id <= 3; id++)
+	{
+		CHECK(residency.getResidentMip(id) == tailMips[id]);
+	}
+}
+
+// A recorded frame: the textures drawn and the finest level each draw could use.
+struct TraceFrame
+{
+	std::vector<std::pair<uint32_t, int>> draws;
+};
+
+// A camera moving along a row of textures. Near textures want full detail, further ones coarser levels, and now
+// and then the camera looks back at where it has been.
+static std::vector<TraceFrame> makeTrace(uint32_t textureCount, int frameCount, int visible, unsigned int seed)
+{
+	std::mt19937 random(seed);
+	std::vector<TraceFrame> trace(frameCount);
+	for (int frame = 0; frame < frameCount; frame++)
+	{
+		uint32_t start = (uint32_t)(frame * 3) % textureCount;
+		if (random() % 50 == 0)
+		{
+			start = (start + textureCount - visible * 2) % textureCount;
+		}
+		for (int i = 0; i < visible; i++)
+		{
+			uint32_t id = (start + i) % textureCount + 1;
+			trace[frame].draws.push_back({ id, i * 3 / visible });
+		}
+	}
+	return trace;
+}
+
+FRAMEWORK_TEST(textureResidencyTraceReplay)
+{
+	std::mt19937 random(1);
+	const uint32_t textureCount = 600;
+	ResidencySettings settings;
+	settings.budgetBytes = 96ull << 20;
+	settings.streamBytesPerFrame = 4ull << 20;
+	TextureResidency residency(settings);
+	std::vector<int> tailMips(textureCount + 1);
+	for (uint32_t id = 1; id <= textureCount; id++)
+	{
+		int size = 128 << (random() % 4);
+		tailMips[id] = residency.addTexture(id, makeLevelBytes(size, size, (random() & 1) ? 4 : 1));
+	}
+
+	std::vector<TraceFrame> trace = makeTrace(textureCount, 1500, 80, 2);
+	std::vector<uint64_t> lastUsed(textureCount + 1, 0);
+	std::vector<ResidencyChange> changes;
+	std::vector<ResidencyChange> landing;
+	int overBudget = 0;
+	int evictionsOutOfOrder = 0;
+	int evictionsOfNewer = 0;
+	int tailsEvicted = 0;
+	for (size_t frame = 0; frame < trace.size(); frame++)
+	{
+		for (const std::pair<uint32_t, int>& draw : trace[frame].draws)
+		{
+			residency.markUsed(draw.first, draw.second);
+			lastUsed[draw.first] = residency.getFrame();
+		}
+
+		// Loads land a frame after they are planned, and one in twenty fails.
+		for (size_t i = 0; i < landing.size(); i++)
+		{
+			if ((frame + i) % 20 == 0)
+			{
+				residency.cancelLoad(landing[i].id);
+			}
+			else
+			{
+				residency.completeLoad(landing[i].id, landing[i].mip);
+			}
+		}
+		landing.clear();
+
+		residency.update(changes);
+		overBudget += (residency.getResidentBytes() + residency.getLoadingBytes() > settings.budgetBytes) ? 1 : 0;
+
+		// Evictions walk from the least recently drawn end, and only take from textures drawn before the one loading.
+		uint64_t previousEviction = 0;
+		uint64_t newestEviction = 0;
+		for (const ResidencyChange& change : changes)
+		{
+			if (change.load)
+			{
+				evictionsOfNewer += (newestEviction > 0 && newestEviction >= lastUsed[change.id]) ? 1 : 0;
+				landing.push_back(change);
+				continue;
+			}
+			evictionsOutOfOrder += (lastUsed[change.id] < previousEviction) ? 1 : 0;
+			previousEviction = lastUsed[change.id];
+			newestEviction = std::max(newestEviction, lastUsed[change.id]);
+			tailsEvicted += (change.mip > tailMips[change.id]) ? 1 : 0;
+		}
+	}
+	for (uint32_t id = 1; id <= textureCount; id++)
+	{
+		tailsEvicted += (residency.getResidentMip(id) > tailMips[id]) ? 1 : 0;
+	}
+
+	CHECK(overBudget == 0);
+	CHECK(evictionsOutOfOrder == 0);
+	CHECK(evictionsOfNewer == 0);
+	CHECK(tailsEvicted == 0);
+	const ResidencyStats& stats = residency.getStats();
+	CHECK(stats.loads > 0 && stats.evictions > 0);
+	printf("  %llu loads, %llu levels evicted, %.0f of %.0f MB resident at the end\n", (unsigned long long)stats.loads,
+		(unsigned long long)stats.evictions, residency.getResidentBytes() / 1048576.0, settings.budgetBytes / 1048576.0);
+}
@@ -0,0 +1,113 @@
+// Token stream tests
+// Random text and random calls through the reference and current streams must give the same results.
+#include "FrameworkTest.h"
+#include "ReferenceTokenStream.h"
+#include "TokenStream.h"
+#include <random>
+
+FRAMEWORK_TEST(tokenStreamMatchesReference)
+{
+	// OBJ-like characters plus quotes, tabs, carriage returns and bytes outside printable ASCII.
+	const char alphabet[] = "ab v/f1.2 \n\t\"#\r-\x01\xe9";
+	const char lineDelimiters[] = { '\n', ' ' };
+	const char faceDelimiters[] = { '\n', ' ', '/' };
+	std::mt19937 random(7);
+	int mismatches = 0;
+	for (int text = 0; text < 20000; text++)
+	{
+		std::string data;
+		int length = random() % 40;
+		for (int i = 0; i < length; i++)
+		{
+			data += alphabet[random() % (sizeof(alphabet) - 1)];
+		}
+
+		ReferenceTokenStream reference;
+		reference.SetTokenStream(data.c_str());
+		TokenStream copying;
+		copying.SetTokenStream((char*)data.c_str());
+		TokenStream viewing;
+		viewing.SetTokenStream(std::string_view(data));
+		for (int step = 0; step < 30; step++)
+		{
+			std::string expected, copied;
+			std::string_view viewed;
+			bool expectedFound, copiedFound, viewedFound;
+			switch (random() % 5)
+			{
+			case 0:
+				expectedFound = reference.GetNextToken(&expected, lineDelimiters, 2);
+				copiedFound = copying.GetNextToken(&copied, lineDelimiters, 2);
+				viewedFound = viewing.GetNextToken(viewed, lineDelimiters, 2);
+				break;
+			case 1:
+				expectedFound = reference.GetNextToken(&expected, faceDelimiters, 3);
+				copiedFound = copying.GetNextToken(&copied, faceDelimiters, 3);
+				viewedFound = viewing.GetNextToken(viewed, faceDelimiters, 3);
+				break;
+			case 2:
+				expectedFound = reference.GetNextToken(&expected, nullptr, 0);
+				copiedFound = copying.GetNextToken(&copied, nullptr, 0);
+				viewedFound = viewing.GetNextToken(viewed, nullptr, 0);
+				break;
+			case 3:
+				expectedFound = reference.MoveToNextLine(&expected);
+				copiedFound = copying.MoveToNextLine(&copied);
+				viewedFound = viewing.MoveToNextLine(viewed);
+				break;
+			default:
+				// Skipping a token without a buffer must still advance the same way.
+				expectedFound = reference.GetNextToken(nullptr, nullptr, 0);
+				copiedFound = copying.GetNextToken((std::string*)nullptr, nullptr, 0);
+				viewedFound = expectedFound;
+				viewing.GetNextToken((std::string*)nullptr, nullptr, 0);
+				viewed = expected;
+				break;
+			}
+			bool same = expectedFound == copiedFound && expectedFound == viewedFound
+				&& (!expectedFound || (expected == copied && expected == viewed));
+			mismatches += same ? 0 : 1;
+
+			if (random() % 10 == 0)
+			{
+				reference.ResetStream();
+				copying.ResetStream();
+				viewing.ResetStream();
+			}
+		}
+	}
+	CHECK(mismatches == 0);
+}
+
+FRAMEWORK_TEST(tokenStreamCopies)
+{
+	// A copy of a copying stream owns its own text and carries on from the same place.
+	std::string data = "v 1 2 3\nf 1/2/3 4/5/6\n";
+	const char delimiters[] = { '\n', ' ' };
+	TokenStream original;
+	original.SetTokenStream((char*)data.c_str());
+	std::string token;
+	CHECK(original.GetNextToken(&token, delimiters, 2) && token == "v");
+	TokenStream copy(original);
+	data.assign(data.size(), 'x');
+	CHECK(copy.GetNextToken(&token, delimiters, 2) && token == "1");
+	CHECK(original.GetNextToken(&token, delimiters, 2) && token == "1");
+
+	TokenStream assigned;
+	assigned = copy;
+	std::string_view view;
+	CHECK(assigned.GetNextToken(view, delimiters, 2) && view == "2");
+
+	// Lines run on from the start of the last token, quirks included, exactly as the reference does.
+	ReferenceTokenStream reference;
+	reference.SetTokenStream("v 1 2 3\nf 1/2/3 4/5/6\n");
+	for (int i = 0; i < 3; i++)
+	{
+		reference.GetNextToken(&token, delimiters, 2);
+	}
+	for (int i = 0; i < 3; i++)
+	{
+		bool found = reference.MoveToNextLine(&token);
+		CHECK(assigned.MoveToNextLine(view) == found && (!found || view == token));
+	}
+}
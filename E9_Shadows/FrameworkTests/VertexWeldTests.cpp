@@ -0,0 +1,98 @@
+// Vertex weld tests
+// Welds every res OBJ and a generated grid, and checks the result against a std::map of the vertices' bits.
+#include "FrameworkTest.h"
+#include "TestObjWriter.h"
+#include "VertexWeld.h"
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <map>
+
+typedef std::array<uint32_t, sizeof(ObjVertex) / sizeof(uint32_t)> VertexBits;
+
+// Indices of the same welding done the slow way: one map entry per distinct bit pattern, numbered by first use.
+static size_t weldReference(const std::vector<ObjVertex>& vertices, std::vector<uint32_t>& indices)
+{
+	std::map<VertexBits, uint32_t> unique;
+	indices.resize(vertices.size());
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		VertexBits bits;
+		memcpy(bits.data(), &vertices[i], sizeof(ObjVertex));
+		indices[i] = unique.emplace(bits, (uint32_t)unique.size()).first->second;
+	}
+	return unique.size();
+}
+
+static void checkWeld(const char* name, const std::vector<ObjVertex>& vertices)
+{
+	std::vector<ObjVertex> unique;
+	std::vector<uint32_t> indices;
+	weldVertices(vertices, unique, indices);
+	CHECK(indices.size() == vertices.size());
+
+	// Every index resolves to a vertex bit for bit equal to the corner it replaced.
+	bool resolved = indices.size() == vertices.size();
+	for (size_t i = 0; i < indices.size() && resolved; i++)
+	{
+		resolved = indices[i] < unique.size() && memcmp(&unique[indices[i]], &vertices[i], sizeof(ObjVertex)) == 0;
+	}
+	CHECK(resolved);
+
+	std::vector<uint32_t> referenceIndices;
+	size_t referenceCount = weldReference(vertices, referenceIndices);
+	printf("    %-12s %8d corners, %7d unique, reference %7d\n", name, (int)vertices.size(), (int)unique.size(), (int)referenceCount);
+	CHECK(unique.size() == referenceCount);
+	CHECK(indices == referenceIndices);
+}
+
+FRAMEWORK_TEST(vertexWeldResModels)
+{
+	int models = 0;
+	std::error_code error;
+	for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(getResourceDirectory(), error))
+	{
+		if (entry.path().extension() != ".obj")
+		{
+			continue;
+		}
+		ObjMesh mesh;
+		CHECK(loadObj(entry.path().string(), mesh));
+		checkWeld(entry.path().filename().string().c_str(), mesh.vertices);
+		models++;
+	}
+	if (models == 0)
+	{
+		printf("  no OBJ files in %s\n", getResourceDirectory().c_str());
+	}
+	CHECK(models > 0);
+}
+
+FRAMEWORK_TEST(vertexWeldEdgeCases)
+{
+	// Every shared grid vertex is used by up to six corners.
+	ObjMesh grid;
+	std::string text = makeTestObj(200, 150, false);
+	CHECK(parseObj(text.data(), text.size(), grid));
+	checkWeld("grid", grid.vertices);
+
+	// Welding is bitwise: +0 and -0 stay apart, identical NaNs merge.
+	ObjVertex zero = {};
+	ObjVertex negativeZero = zero;
+	negativeZero.position[0] = -0.0f;
+	ObjVertex notANumber = zero;
+	notANumber.normal[1] = std::numeric_limits<float>::quiet_NaN();
+	std::vector<ObjVertex> vertices = { zero, negativeZero, notANumber, notANumber, zero, negativeZero };
+	checkWeld("signed zeros", vertices);
+	std::vector<ObjVertex> unique;
+	std::vector<uint32_t> indices;
+	weldVertices(vertices, unique, indices);
+	CHECK(unique.size() == 3);
+	CHECK((indices == std::vector<uint32_t>{ 0, 1, 2, 2, 0, 1 }));
+
+	// No vertices weld to nothing.
+	weldVertices({}, unique, indices);
+	CHECK(unique.empty() && indices.empty());
+}
@@ -0,0 +1,155 @@
+// Mesh cache builder
+// Command-line tool that imports models and writes their mesh caches ahead of time, so the first run loads them mapped.
+// Usage: MeshCacheBuilder [--force] [--bench] [files or directories...]
+// Caches go next to each model, where loadModelArrays looks for them. Existing caches that are still valid are kept
+// unless --force is given. --bench times a full import against loading from the cache for each model instead.
+// Links assimp on purpose. AModel only accepts caches holding exactly what its assimp import produces, so a build
+// without assimp could only write caches nothing reads. FrameworkBench's meshCacheOpen times caches without assimp.
+#include "ModelArrays.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+// Models loadModelArrays caches. .glb files are read directly and never cached.
+static bool isCachedModel(const std::filesystem::path& path)
+{
+	std::string extension = path.extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)tolower(c); });
+	return extension == ".obj" || extension == ".fbx" || extension == ".3ds" || extension == ".dae" || extension == ".ply";
+}
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static double median(std::vector<double> times)
+{
+	std::sort(times.begin(), times.end());
+	return times[times.size() / 2];
+}
+
+static bool buildCache(const std::string& filename, bool force)
+{
+	std::string cacheFilename = getModelCacheFilename(filename);
+	std::error_code ignored;
+	if (force)
+	{
+		std::filesystem::remove(cacheFilename, ignored);
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	ModelArrays arrays;
+	std::string error;
+	if (!loadModelArrays(filename, arrays, error))
+	{
+		printf("%s: %s\n", filename.c_str(), error.c_str());
+		return false;
+	}
+	double milliseconds = millisecondsSince(start);
+
+	// loadModelArrays only writes a cache when the import produced vertices.
+	MeshCacheFile cache;
+	if (!cache.open(cacheFilename, filename, modelImportFlags, sizeof(ModelVertex)))
+	{
+		printf("%s: no cache written\n", filename.c_str());
+		return false;
+	}
+	printf("%s: %d vertices, %d indices, %d submeshes in %.1f ms\n", filename.c_str(), (int)arrays.vertices.size(),
+		(int)arrays.indices.size(), (int)arrays.submeshes.size(), milliseconds);
+	return true;
+}
+
+static bool benchmarkCache(const std::string& filename)
+{
+	const int runs = 5;
+	std::string cacheFilename = getModelCacheFilename(filename);
+	std::vector<double> imports, cached, mapped;
+	for (int run = 0; run < runs; run++)
+	{
+		ModelArrays arrays;
+		std::string error;
+		std::error_code ignored;
+		std::filesystem::remove(cacheFilename, ignored);
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		if (!loadModelArrays(filename, arrays, error))
+		{
+			printf("%s: %s\n", filename.c_str(), error.c_str());
+			return false;
+		}
+		imports.push_back(millisecondsSince(start));
+
+		start = std::chrono::steady_clock::now();
+		loadModelArrays(filename, arrays, error);
+		cached.push_back(millisecondsSince(start));
+
+		// What a loader that uploads straight from the mapping would pay.
+		start = std::chrono::steady_clock::now();
+		MeshCacheFile cache;
+		if (!cache.open(cacheFilename, filename, modelImportFlags, sizeof(ModelVertex)))
+		{
+			printf("%s: no cache written\n", filename.c_str());
+			return false;
+		}
+		mapped.push_back(millisecondsSince(start));
+	}
+	double import = median(imports);
+	printf("%s: import and write %.2f ms, copy from cache %.2f ms (%.0fx), map cache %.3f ms (%.0fx)\n", filename.c_str(), import,
+		median(cached), import / median(cached), median(mapped), import / median(mapped));
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	bool force = false;
+	bool bench = false;
+	std::vector<std::string> filenames;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--force") == 0)
+		{
+			force = true;
+			continue;
+		}
+		if (strcmp(argv[i], "--bench") == 0)
+		{
+			bench = true;
+			continue;
+		}
+
+		std::error_code error;
+		if (std::filesystem::is_directory(argv[i], error))
+		{
+			for (const std::filesystem::directory_entry& entry : std::filesystem::recursive_directory_iterator(argv[i], error))
+			{
+				if (entry.is_regular_file() && isCachedModel(entry.path()))
+				{
+					filenames.push_back(entry.path().generic_string());
+				}
+			}
+		}
+		else
+		{
+			filenames.push_back(argv[i]);
+		}
+	}
+	if (filenames.empty())
+	{
+		printf("Usage: MeshCacheBuilder [--force] [--bench] [files or directories...]\n");
+		return 1;
+	}
+
+	int failures = 0;
+	for (const std::string& filename : filenames)
+	{
+		failures += (bench ? benchmarkCache(filename) : buildCache(filename, force)) ? 0 : 1;
+	}
+	if (!bench)
+	{
+		printf("%d of %d caches built\n", (int)filenames.size() - failures, (int)filenames.size());
+	}
+	return (failures > 0) ? 1 : 0;
+}
@@ -0,0 +1,77 @@
+// Pack builder
+// Command-line tool that writes an asset pack from loose files, for mountAssetPack.
+// Usage: PackBuilder <pack> <root> [files or directories under root...]
+// Names in the pack are paths relative to root, so mount the pack where root is relative to the application's
+// working directory. With no files listed, everything under root is packed.
+#include "AssetPack.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		printf("Usage: PackBuilder <pack> <root> [files or directories under root...]\n");
+		return 1;
+	}
+
+	std::string packFilename = argv[1];
+	std::string root = argv[2];
+	std::vector<AssetPackSource> sources;
+	for (int i = (argc > 3 ? 3 : 2); i < argc; i++)
+	{
+		std::error_code error;
+		if (std::filesystem::is_directory(argv[i], error))
+		{
+			if (!listAssetPackFiles(root, argv[i], sources))
+			{
+				printf("Could not list %s\n", argv[i]);
+				return 1;
+			}
+		}
+		else
+		{
+			std::filesystem::path relative = std::filesystem::relative(argv[i], root, error);
+			if (error)
+			{
+				printf("Could not find %s\n", argv[i]);
+				return 1;
+			}
+			sources.push_back({ relative.generic_string(), argv[i] });
+		}
+	}
+
+	// Never pack the pack itself, or a previous build's temporary file.
+	std::error_code ignored;
+	std::filesystem::path packPath = std::filesystem::weakly_canonical(packFilename, ignored);
+	for (size_t i = 0; i < sources.size(); )
+	{
+		std::filesystem::path sourcePath = std::filesystem::weakly_canonical(sources[i].filename, ignored);
+		if (sourcePath == packPath || sourcePath == std::filesystem::path(packPath.string() + ".tmp"))
+		{
+			sources.erase(sources.begin() + i);
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	std::string error;
+	AssetPackStats stats;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	if (!buildAssetPack(packFilename, sources, error, AssetPackSettings(), &stats))
+	{
+		printf("%s\n", error.c_str());
+		return 1;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printf("%llu files, %llu compressed, %llu duplicates\n", (unsigned long long)stats.files, (unsigned long long)stats.compressedFiles,
+		(unsigned long long)stats.duplicateFiles);
+	printf("%llu bytes stored from %llu (%.1f%%) in %.2f s\n", (unsigned long long)stats.storedBytes, (unsigned long long)stats.sourceBytes,
+		stats.sourceBytes ? 100.0 * stats.storedBytes / stats.sourceBytes : 100.0, seconds);
+	return 0;
+}
@@ -4,6 +4,10 @@
 * \brief Improved model loader, using the assimp library
 *
 * Inherits from Base Mesh, read a provided file and builds a mesh from the file data.
+* Shares the native binary glTF (.glb) path, the mesh cache (file + ".mshc") and the assimp import with AsyncModel
+* (see ModelArrays.h). A .glb or a valid cache is uploaded straight from the mapped file without copying the streams.
+* Assimp only runs when there is no valid cache, and writes one for next time.
+* Models with the same file contents share one set of buffers (see SharedMeshBuffers.h).
 *
 * \author Paul Robertson
 */
@@ -11,6 +15,8 @@
 #pragma once
 
 #include "BaseMesh.h"
+#include "ModelArrays.h"
+#include "SharedMeshBuffers.h"
 #include "assimp\Importer.hpp"      // C++ importer interface
 #include "assimp\scene.h"           // Output data structure
 #include "assimp\postprocess.h"     // Post processing flags
@@ -30,15 +36,17 @@ public:
 	AModel(ID3D11Device* device, const std::string& file);
 	~AModel();
 
+	const std::vector<MeshCacheSubmesh>& getSubmeshes() const { return submeshes; }	///< One entry per mesh instance in the scene
+
 protected:
 	void initBuffers(ID3D11Device* device);
+	void createBuffers(const void* vertexSource, const uint32_t* indexSource);
 	void importModel(const std::string& pFile);
+	void loadModel(const std::string& pFile);
 	void modelProcessing(const aiScene* scene);
 
 	void processScene(const aiScene* scene);
-	void processNode(const aiNode* node, const aiScene* scene);
-	void processMesh(const aiMesh* mesh, const aiScene* scene);
 	ID3D11Device* device;
-	std::vector<VertexType> vertices;
-	std::vector<unsigned long> indices;
+	std::vector<MeshCacheSubmesh> submeshes;
+	std::shared_ptr<SharedMeshBuffers> sharedBuffers;
 };
\ No newline at end of file
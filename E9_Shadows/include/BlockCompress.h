@@ -0,0 +1,45 @@
+/**
+* \brief Platform-neutral BC1, BC3 and BC5 block compression
+*
+* Encodes RGBA8 images into the block formats Direct3D samples natively, at a quarter (BC3, BC5) or an eighth (BC1)
+* of the memory and bandwidth of RGBA8. Colour endpoints come from the principal axis of each block and are refined
+* by least squares. Alpha and BC5 channels try both the 8-value and the 6-value (with 0 and 255) modes.
+* The palette searches run four pixels at a time with SSE2. The scalar version performs the same operations in the
+* same order, so both paths give identical blocks. Block rows are shared between threads.
+* Formats are identified by their DXGI_FORMAT values, so they can be written to DDS files and created as they are.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _BLOCKCOMPRESS_H_
+#define _BLOCKCOMPRESS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+const uint32_t blockFormatBC1 = 71;		///< DXGI_FORMAT_BC1_UNORM. Opaque RGB, 8 bytes per block
+const uint32_t blockFormatBC3 = 77;		///< DXGI_FORMAT_BC3_UNORM. RGBA, 16 bytes per block
+const uint32_t blockFormatBC5 = 83;		///< DXGI_FORMAT_BC5_UNORM. Red and green only, for normal maps. 16 bytes per block
+
+/// Bytes per 4x4 block, or 0 for unknown formats.
+size_t getBlockSize(uint32_t format);
+
+/// Bytes needed for an image. Partial blocks at the right and bottom edges count as whole blocks.
+size_t getCompressedSize(int width, int height, uint32_t format);
+
+/** \brief Compresses an RGBA8 image
+* Edge blocks repeat the last row and column.
+* @param rgba is width * height tightly packed pixels
+* @param out receives getCompressedSize(width, height, format) bytes, blocks in row-major order
+* @param threadCount is the number of threads sharing the block rows. 0 uses one per hardware thread
+* @return false for unknown formats
+*/
+bool compressImage(const unsigned char* rgba, int width, int height, uint32_t format, unsigned char* out, int threadCount = 0);
+
+/// Reference implementation of compressImage without SIMD, single-threaded.
+bool compressImageScalar(const unsigned char* rgba, int width, int height, uint32_t format, unsigned char* out);
+
+/// Name of the palette search compressImage uses in this build ("SSE2" or "Scalar").
+const char* getBlockCompressKernelName();
+
+#endif
@@ -0,0 +1,72 @@
+/**
+* \brief Platform-neutral sharing of decoded assets by content
+*
+* Maps a ContentKey to the one decoded copy of an asset. The cache only keeps weak references, so a shared asset
+* lives exactly as long as something is using it, and a later load of the same bytes after that decodes afresh.
+* Safe to use from any thread.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _CONTENTCACHE_H_
+#define _CONTENTCACHE_H_
+
+#include "ContentHash.h"
+#include <map>
+#include <memory>
+#include <mutex>
+
+template <typename Asset>
+class ContentCache
+{
+public:
+	/// The asset for a key, or nullptr if nothing with these contents is alive.
+	std::shared_ptr<Asset> find(const ContentKey& key)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto found = assets.find(key);
+		if (found == assets.end())
+		{
+			return nullptr;
+		}
+		std::shared_ptr<Asset> asset = found->second.lock();
+		if (!asset)
+		{
+			assets.erase(found);
+		}
+		return asset;
+	}
+
+	/** \brief Offers an asset for sharing
+	* If another thread stored a live asset under the key first, that one is returned and should be used instead.
+	*/
+	std::shared_ptr<Asset> insert(const ContentKey& key, const std::shared_ptr<Asset>& asset)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		std::weak_ptr<Asset>& entry = assets[key];
+		std::shared_ptr<Asset> existing = entry.lock();
+		if (existing)
+		{
+			return existing;
+		}
+		entry = asset;
+		return asset;
+	}
+
+	/// Number of assets still alive. Forgets the rest.
+	size_t size()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (auto entry = assets.begin(); entry != assets.end();)
+		{
+			entry = entry->second.expired() ? assets.erase(entry) : std::next(entry);
+		}
+		return assets.size();
+	}
+
+private:
+	std::mutex mutex;
+	std::map<ContentKey, std::weak_ptr<Asset>> assets;
+};
+
+#endif
@@ -0,0 +1,30 @@
+/**
+* \brief Platform-neutral run-time checks for choosing SIMD kernels
+*
+* The framework is compiled for baseline x64, which guarantees SSE2 and nothing wider, so the shipped build runs on
+* any x64 CPU. Wider kernels are compiled for their own instruction set with CPU_TARGET_AVX2 and are only called
+* after useAvx2Kernels() has checked the CPU and the operating system support them.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _CPUFEATURES_H_
+#define _CPUFEATURES_H_
+
+#if defined(_M_X64) || defined(__x86_64__)
+/// AVX2 kernels can be compiled here. MSVC accepts AVX2 intrinsics in any function, GCC and Clang need a target.
+#define CPU_AVX2_KERNELS
+#if defined(_MSC_VER) && !defined(__clang__)
+#define CPU_TARGET_AVX2
+#else
+#define CPU_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+/// True if the CPU and operating system support AVX2, and AVX2 kernels have not been turned off.
+bool useAvx2Kernels();
+
+/// Turns the AVX2 kernels off or back on, so tests and benchmarks can compare them with the SSE2 ones.
+void setAvx2KernelsEnabled(bool enabled);
+
+#endif
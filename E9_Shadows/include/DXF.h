@@ -11,7 +11,7 @@
 #pragma once
 // Include system level headers
 #include "System.h"
-#include "D3D.h"
+//#include "D3D.h"
 #include "BaseApplication.h"
 #include "BaseShader.h"
 //#include "TextureManager.h"
@@ -25,9 +25,14 @@
 #include "PointMesh.h"
 #include "QuadMesh.h"
 #include "SphereMesh.h"
+#include "TerrainMesh.h"
+#include "HeightTileStreamer.h"
+#include "TerrainQuery.h"
 #include "TessellationMesh.h"
 #include "TriangleMesh.h"
 #include "AModel.h"
+#include "AsyncModel.h"
+#include "AssetPack.h"
 
 // Include additional rendering headers
 #include "Light.h"
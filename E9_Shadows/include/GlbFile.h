@@ -0,0 +1,65 @@
+/**
+* \class Glb File
+*
+* \brief Loads binary glTF (.glb) meshes straight from a memory-mapped file, without assimp
+*
+* Reads every triangle primitive of every mesh in the file into one vertex and index stream with a submesh per
+* primitive. Node transforms are not applied, matching AModel. Accessors, buffer views and buffers are checked against
+* the binary chunk before anything is read. Only self-contained files are supported: buffers must live in the GLB's
+* binary chunk, and sparse accessors are rejected.
+* Where the file already holds the final layout it is used in place: indices of a single primitive stored as tightly
+* packed 32-bit values, and vertices of a single primitive interleaved exactly as ModelVertex when no handedness
+* conversion is asked for. Anything else is converted in one pass into owned arrays.
+* Holds no Direct3D types.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _GLBFILE_H_
+#define _GLBFILE_H_
+
+#include "MappedFile.h"
+#include "ModelArrays.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class GlbFile
+{
+public:
+	/** \brief Maps and validates a .glb file and builds its streams
+	* @param leftHanded negates Z of positions and normals for Direct3D. Winding is left as counter-clockwise, which the
+	* framework's rasterizer state treats as front facing, so indices are never rewritten for it
+	* @param error receives a description of the first problem found
+	*/
+	bool open(const std::string& filename, std::string& error, bool leftHanded = true);
+	void close();
+
+	const ModelVertex* getVertices() const { return vertices; }
+	uint32_t getVertexCount() const { return vertexCount; }
+	const uint32_t* getIndices() const { return indices; }
+	uint32_t getIndexCount() const { return indexCount; }
+	const std::vector<MeshCacheSubmesh>& getSubmeshes() const { return submeshes; }	///< One per primitive
+
+	/// True when the stream points into the mapped file rather than a converted copy.
+	bool areVerticesMapped() const { return vertices && vertexStorage.empty(); }
+	bool areIndicesMapped() const { return indices && indexStorage.empty(); }
+
+	/// Copies the streams out, for callers that outlive the mapping.
+	void copyTo(ModelArrays& arrays) const;
+
+private:
+	MappedFile file;
+	std::vector<ModelVertex> vertexStorage;
+	std::vector<uint32_t> indexStorage;
+	const ModelVertex* vertices = nullptr;
+	const uint32_t* indices = nullptr;
+	uint32_t vertexCount = 0;
+	uint32_t indexCount = 0;
+	std::vector<MeshCacheSubmesh> submeshes;
+};
+
+/// True if the filename ends in .glb, ignoring case.
+bool isGlbFilename(const std::string& filename);
+
+#endif
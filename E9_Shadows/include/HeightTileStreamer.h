@@ -0,0 +1,97 @@
+/**
+* \class Height Tile Streamer
+*
+* \brief Pages heightmap pyramid tiles in and out around the camera within a fixed memory budget
+*
+* Each update picks the tiles wanted around the camera at every pyramid level, coarsest first, so a low detail
+* copy of the area is always resident before the finer tiles arrive. A background thread copies wanted tiles out of
+* the mapped file. When the budget is full, the least recently wanted tile that is no longer wanted is evicted.
+* Lookups never block on file reads. They return the finest tile that is already resident.
+* Holds no Direct3D types.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _HEIGHTTILESTREAMER_H_
+#define _HEIGHTTILESTREAMER_H_
+
+#include "HeightTileFile.h"
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// A resident copy of one tile. Samples are row-major, getTileSamples() along each side.
+struct HeightTile
+{
+	int level = 0;
+	int tileX = 0;
+	int tileY = 0;
+	std::vector<uint16_t> samples;
+};
+
+class HeightTileStreamer
+{
+public:
+	HeightTileStreamer();
+	~HeightTileStreamer();
+
+	HeightTileStreamer(const HeightTileStreamer&) = delete;
+	HeightTileStreamer& operator=(const HeightTileStreamer&) = delete;
+
+	/** \brief Maps a pyramid file and starts the loading thread
+	* @param memoryBudget is the most bytes of tile samples kept resident
+	*/
+	bool open(const std::string& filename, size_t memoryBudget);
+
+	/// Stops the loading thread and drops every resident tile.
+	void close();
+
+	/** \brief Requests the tiles around a camera position
+	* @param x and z are in level 0 samples
+	* @param ringRadius is how many tiles around the camera's tile are wanted at every level
+	*/
+	void update(float x, float z, int ringRadius = 1);
+
+	/// Returns a resident tile, or nullptr if it is not loaded. Never blocks on the file.
+	std::shared_ptr<const HeightTile> getTile(int level, int tileX, int tileY) const;
+
+	/** \brief Bilinear height (0-1) from the finest resident level covering a point
+	* @param x and z are in level 0 samples
+	* @return false if no level covering the point is resident
+	*/
+	bool sampleHeight(float x, float z, float& height, int* level = nullptr) const;
+
+	const HeightTileFile& getFile() const { return file; }
+	size_t getMemoryBudget() const { return memoryBudget; }
+	size_t getResidentBytes() const;
+	int getResidentTileCount() const;
+	int getPendingTileCount() const;
+
+private:
+	struct Resident
+	{
+		std::shared_ptr<const HeightTile> tile;
+		unsigned int lastWanted;	///< Last update the tile was wanted in
+	};
+
+	static uint64_t makeKey(int level, int tileX, int tileY);
+	void loadLoop();
+	bool makeRoom();
+
+	HeightTileFile file;
+	size_t memoryBudget;
+
+	mutable std::mutex residentMutex;
+	std::condition_variable requestReady;
+	std::map<uint64_t, Resident> resident;
+	std::deque<uint64_t> requests;
+	unsigned int updateCount;
+	bool running;
+	std::thread loader;
+};
+
+#endif
@@ -0,0 +1,70 @@
+/**
+* \brief Converts an imported assimp scene into flat vertex and index arrays
+*
+* Walks the node tree once to find every mesh instance and size the arrays, then fills them without any regrowth.
+* Each mesh's indices are offset by the number of vertices written before it, so multi-mesh files index their own
+* vertices. Every mesh instance becomes one submesh with its index range, material and bounds, so parts can be
+* culled and batched separately. Depends on assimp but holds no Direct3D types.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _MODELARRAYS_H_
+#define _MODELARRAYS_H_
+
+#include "MeshCache.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct aiScene;
+
+/// Position, texture coordinate and normal. Layout compatible with BaseMesh::VertexType.
+struct ModelVertex
+{
+	float position[3];
+	float texture[2];
+	float normal[3];
+};
+
+/// Output of buildModelArrays. Indices are 32-bit and address the whole vertex array.
+struct ModelArrays
+{
+	std::vector<ModelVertex> vertices;
+	std::vector<uint32_t> indices;
+	std::vector<MeshCacheSubmesh> submeshes;
+};
+
+/** \brief Flattens every mesh reachable from the scene's root node
+* Node transforms are not applied, matching what AModel has always drawn.
+* Meshes without texture coordinates or normals get zeros in those fields.
+* @return false if the scene is null or has no root node. The arrays are left empty
+*/
+bool buildModelArrays(const aiScene* scene, ModelArrays& out);
+
+/// Assimp post-processing every model import uses. Stored in mesh caches, so changing it invalidates them.
+extern const unsigned int modelImportFlags;
+
+/// Mesh cache kept next to a model file.
+std::string getModelCacheFilename(const std::string& filename);
+
+/** \brief Maps a model file's mesh cache, if it is valid
+* The streams can then go to the GPU straight from the mapping, as AModel does.
+* @return false if the cache is missing, malformed or stale
+*/
+bool openModelCache(const std::string& filename, MeshCacheFile& cache);
+
+/** \brief Imports a model file with assimp and writes a fresh mesh cache next to it
+* Skips the .glb and cache checks, for callers that have already made them. Safe to call from any thread.
+* @param error receives the importer's message on failure
+*/
+bool importModelArrays(const std::string& filename, ModelArrays& out, std::string& error);
+
+/** \brief Loads the arrays for a model file
+* .glb files are read with GlbFile, without assimp or a cache. Other files are copied out of their mesh cache when
+* it is valid. Otherwise imports the file with importModelArrays. Safe to call from any thread.
+* @param error receives the importer's message on failure
+*/
+bool loadModelArrays(const std::string& filename, ModelArrays& out, std::string& error);
+
+#endif
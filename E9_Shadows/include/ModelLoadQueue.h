@@ -0,0 +1,103 @@
+/**
+* \class Model Load Queue
+*
+* \brief Imports model files on worker threads and hands the results back at frame boundaries
+*
+* load() returns a handle straight away and queues the file. Worker threads run the importer and keep the finished
+* arrays until update() is called on the main thread, which passes each result to the sink given at load time,
+* in the order the imports finished. Sinks are only ever called from update(), so they can create GPU resources
+* and swap them in without locking. Cancelled jobs never reach their sink. Importer failures, including exceptions,
+* are passed to the sink with an error message.
+* Holds no Direct3D types, so the queue can be driven headless with a mock sink and importer.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _MODELLOADQUEUE_H_
+#define _MODELLOADQUEUE_H_
+
+#include "ModelArrays.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// Identifies one queued load. 0 is never a valid handle.
+typedef uint32_t ModelHandle;
+
+/// Receives finished loads on the thread that calls ModelLoadQueue::update.
+class ModelUploadSink
+{
+public:
+	virtual ~ModelUploadSink() {}
+
+	/// The arrays may be moved from. They are dropped once this returns.
+	virtual void modelLoaded(ModelHandle handle, ModelArrays& arrays) = 0;
+	virtual void modelFailed(ModelHandle handle, const std::string& error) = 0;
+};
+
+class ModelLoadQueue
+{
+public:
+	/// Fills the arrays for a file, or returns false with an error message. Runs on a worker thread.
+	typedef std::function<bool(const std::string& filename, ModelArrays& arrays, std::string& error)> Importer;
+
+	/** \brief Starts the worker threads
+	* @param importer is called once per load, possibly on several threads at once
+	* @param threadCount is the number of worker threads, at least one
+	*/
+	ModelLoadQueue(Importer importer, int threadCount = 2);
+
+	/// Cancels everything still queued and waits for imports already running.
+	~ModelLoadQueue();
+
+	/// Queues a file. The sink must stay valid until the load is delivered or cancelled.
+	ModelHandle load(const std::string& filename, ModelUploadSink* sink);
+
+	/** \brief Drops a load so its sink is never called
+	* A load already being imported finishes on its worker, but the result is discarded.
+	* @return false if the handle was already delivered or never existed
+	*/
+	bool cancel(ModelHandle handle);
+
+	/** \brief Delivers finished loads to their sinks. Call once per frame on the main thread
+	* @param maxDeliveries limits uploads per call to spread them over frames. 0 delivers everything finished
+	* @return the number of sinks called
+	*/
+	int update(int maxDeliveries = 0);
+
+	/// Loads queued, importing or waiting for update().
+	int getPendingCount() const;
+
+private:
+	struct Job
+	{
+		ModelHandle handle;
+		std::string filename;
+		ModelUploadSink* sink;
+		bool cancelled = false;
+		bool succeeded = false;
+		ModelArrays arrays;
+		std::string error;
+	};
+
+	void workerLoop();
+
+	Importer importer;
+	std::vector<std::thread> workers;
+	mutable std::mutex jobMutex;
+	std::condition_variable jobAvailable;
+	std::map<ModelHandle, std::unique_ptr<Job>> jobs;	///< Every load not yet delivered or cancelled
+	std::deque<Job*> queued;							///< Waiting for a worker, in load order
+	std::vector<Job*> finished;							///< Waiting for update(), in completion order
+	ModelHandle nextHandle = 1;
+	bool stopping = false;
+};
+
+#endif
@@ -0,0 +1,50 @@
+/**
+* \brief Platform-neutral OBJ parser working directly on a memory-mapped file
+*
+* Scans the file in place without copying lines or tokens, parses numbers with std::from_chars and
+* writes each face corner straight into the final vertex layout. Holds no Direct3D types.
+* Large files are split into newline-aligned chunks parsed on separate threads. Once every chunk is done, the
+* attributes are merged in file order and each chunk resolves its own face indices against the merged arrays,
+* so the result is identical for any thread count.
+* Faces may have any number of corners and are fan triangulated as they are read. Corners may be v, v/vt, v//vn or
+* v/vt/vn, and negative indices count back from the last attribute read. Missing texture coordinates become (0, 0)
+* and missing normals become the face normal of their triangle. Other statements (o, g, s, usemtl, l, ...) are skipped.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _OBJLOADER_H_
+#define _OBJLOADER_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/// Position, texture coordinate and normal. Layout compatible with BaseMesh::VertexType.
+struct ObjVertex
+{
+	float position[3];
+	float texture[2];
+	float normal[3];
+};
+
+/// Parsed OBJ geometry, unrolled to three vertices per triangle in file order.
+struct ObjMesh
+{
+	std::vector<ObjVertex> vertices;
+	size_t positionCount = 0;
+	size_t texCoordCount = 0;
+	size_t normalCount = 0;
+};
+
+/** \brief Parses OBJ text held in memory
+* @param leftHanded negates Z of positions and normals, converting from OBJ's right-handed space for Direct3D
+* @param threadCount is the most threads to parse with, 0 for one per hardware thread. Small files use fewer
+* @return false if a face is malformed, has fewer than three corners or indexes outside the data. The mesh is left empty
+*/
+bool parseObj(const char* data, size_t size, ObjMesh& mesh, bool leftHanded = true, unsigned threadCount = 0);
+
+/// Memory-maps an OBJ file and parses it. Returns false if the file cannot be opened or parsed.
+bool loadObj(const std::string& filename, ObjMesh& mesh, bool leftHanded = true, unsigned threadCount = 0);
+
+#endif
@@ -0,0 +1,178 @@
+/**
+* \class Resource Registry
+*
+* \brief Platform-neutral owner of named, reference counted resources, addressed by generational handles
+*
+* Names are copied in once when a resource is added. Afterwards the draw loop looks resources up by handle, which
+* is a single bounds and generation check on an array. Name lookups compare string content and are kept for
+* loading code and tools.
+* A handle packs a slot index (low 16 bits) with the slot's generation (high 16 bits). Removing a resource bumps
+* the generation, so stale handles resolve to nullptr instead of a different resource. Replacing a resource under
+* an existing name keeps its handle.
+* The registry owns one reference to each resource and calls Release() on it when it is replaced, removed or
+* cleared, so any type with a COM-style Release() works, including fakes for tests.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _RESOURCEREGISTRY_H_
+#define _RESOURCEREGISTRY_H_
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Identifies a registry slot and generation. 0 is never a valid handle.
+typedef uint32_t ResourceHandle;
+
+template <typename Resource>
+class ResourceRegistry
+{
+public:
+	ResourceRegistry() {}
+	~ResourceRegistry() { clear(); }
+
+	ResourceRegistry(const ResourceRegistry&) = delete;
+	ResourceRegistry& operator=(const ResourceRegistry&) = delete;
+
+	/** \brief Stores a resource under a name, taking over the caller's reference
+	* If the name is already registered the old resource is released and the existing handle is returned.
+	* @return the handle, or 0 if the resource is null or every slot is in use
+	*/
+	ResourceHandle add(std::wstring_view name, Resource* resource)
+	{
+		if (!resource)
+		{
+			return 0;
+		}
+
+		auto existing = names.find(name);
+		if (existing != names.end())
+		{
+			// Releasing first also drops the duplicate reference when the same resource is added again.
+			Slot& slot = slots[existing->second];
+			slot.resource->Release();
+			slot.resource = resource;
+			return makeHandle(existing->second, slot.generation);
+		}
+
+		uint32_t index;
+		if (!freeSlots.empty())
+		{
+			index = freeSlots.back();
+			freeSlots.pop_back();
+		}
+		else if (slots.size() < maxSlots)
+		{
+			index = (uint32_t)slots.size();
+			slots.emplace_back();
+		}
+		else
+		{
+			return 0;
+		}
+
+		Slot& slot = slots[index];
+		slot.resource = resource;
+		slot.name = &names.emplace(std::wstring(name), index).first->first;
+		count++;
+		return makeHandle(index, slot.generation);
+	}
+
+	/// Resource for a handle, or nullptr if the handle is 0 or stale.
+	Resource* get(ResourceHandle handle) const
+	{
+		uint32_t index = handle & 0xFFFF;
+		if (index >= slots.size() || slots[index].generation != (handle >> 16) || !slots[index].resource)
+		{
+			return nullptr;
+		}
+		return slots[index].resource;
+	}
+
+	/// Handle for a name, compared by content, or 0 if nothing is registered under it.
+	ResourceHandle find(std::wstring_view name) const
+	{
+		auto found = names.find(name);
+		if (found == names.end())
+		{
+			return 0;
+		}
+		return makeHandle(found->second, slots[found->second].generation);
+	}
+
+	/// Name a live handle was registered under, or nullptr.
+	const std::wstring* getName(ResourceHandle handle) const
+	{
+		return get(handle) ? slots[handle & 0xFFFF].name : nullptr;
+	}
+
+	/// Releases the resource and invalidates every copy of the handle. Returns false for stale handles.
+	bool remove(ResourceHandle handle)
+	{
+		if (!get(handle))
+		{
+			return false;
+		}
+
+		uint32_t index = handle & 0xFFFF;
+		Slot& slot = slots[index];
+		slot.resource->Release();
+		slot.resource = nullptr;
+		names.erase(*slot.name);
+		slot.name = nullptr;
+		// Generation 0 is skipped so that no live handle is ever 0.
+		slot.generation = (slot.generation == 0xFFFF) ? 1 : slot.generation + 1;
+		freeSlots.push_back(index);
+		count--;
+		return true;
+	}
+
+	/// Releases every resource. Handles given out before are stale afterwards.
+	void clear()
+	{
+		for (uint32_t index = 0; index < slots.size(); index++)
+		{
+			if (slots[index].resource)
+			{
+				remove(makeHandle(index, slots[index].generation));
+			}
+		}
+	}
+
+	/// Calls visit(handle, name, resource) for every live entry, in slot order.
+	void forEach(const std::function<void(ResourceHandle, const std::wstring&, Resource*)>& visit) const
+	{
+		for (uint32_t index = 0; index < slots.size(); index++)
+		{
+			if (slots[index].resource)
+			{
+				visit(makeHandle(index, slots[index].generation), *slots[index].name, slots[index].resource);
+			}
+		}
+	}
+
+	size_t size() const { return count; }
+
+private:
+	struct Slot
+	{
+		Resource* resource = nullptr;
+		const std::wstring* name = nullptr;		///< Key in names, stable while the entry lives
+		uint32_t generation = 1;
+	};
+
+	static const uint32_t maxSlots = 0xFFFF;
+
+	static ResourceHandle makeHandle(uint32_t index, uint32_t generation) { return (generation << 16) | index; }
+
+	std::vector<Slot> slots;
+	std::vector<uint32_t> freeSlots;
+	std::map<std::wstring, uint32_t, std::less<>> names;
+	size_t count = 0;
+};
+
+#endif
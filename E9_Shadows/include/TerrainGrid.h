@@ -0,0 +1,60 @@
+/**
+* \brief Platform-neutral terrain grid generation
+*
+* Builds a welded resolution x resolution grid of shared vertices and a triangle list indexing them.
+* Holds no Direct3D types so the generation can be built and profiled outside of the framework.
+* TerrainVertex matches the memory layout of BaseMesh::VertexType, so the arrays can be uploaded directly.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _TERRAINGRID_H_
+#define _TERRAINGRID_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// Position, texture coordinate and normal. Layout compatible with BaseMesh::VertexType.
+struct TerrainVertex
+{
+	float position[3];
+	float texture[2];
+	float normal[3];
+};
+
+/// Non-owning view of a row-major grid of normalised (0-1) height samples.
+struct HeightfieldView
+{
+	const float* samples = nullptr;
+	int width = 0;
+	int height = 0;
+	float scale = 1.0f;		///< Multiplier applied to every sample
+};
+
+/// Output of buildTerrainGrid. Only one of the index lists is filled, depending on vertex count.
+struct TerrainGrid
+{
+	std::vector<TerrainVertex> vertices;
+	std::vector<uint16_t> indices16;
+	std::vector<uint32_t> indices32;
+
+	bool uses16BitIndices() const { return !indices16.empty(); }
+	size_t getIndexCount() const { return uses16BitIndices() ? indices16.size() : indices32.size(); }
+	size_t getIndexStride() const { return uses16BitIndices() ? sizeof(uint16_t) : sizeof(uint32_t); }
+	const void* getIndexData() const;
+};
+
+/** \brief Builds a welded, indexed grid
+* Vertices are placed one unit apart on the XZ plane, from (0,0) to (resolution - 1, resolution - 1).
+* Winding and texture coordinates match the original per-quad PlaneMesh layout.
+* @param resolution is the number of vertices along each side (minimum 2)
+* @param heights is an optional heightfield, sampled nearest-neighbour across the grid. Pass nullptr for a flat plane.
+* @param out receives the vertex and index arrays
+*/
+void buildTerrainGrid(int resolution, const HeightfieldView* heights, TerrainGrid& out);
+
+/// Nearest-neighbour height lookup at normalised (u, v), including the view's scale.
+float sampleHeightNearest(const HeightfieldView& heights, float u, float v);
+
+#endif
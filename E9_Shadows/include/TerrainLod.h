@@ -0,0 +1,101 @@
+/**
+* \class Terrain Quadtree
+*
+* \brief Platform-neutral chunked level of detail for heightmapped terrain
+*
+* Splits a square grid of heights into a quadtree of chunks. Every chunk mesh has the same number of cells,
+* so a node one level up covers four times the area at half the sample density.
+* Each chunk stores the largest height error its mesh makes against the full resolution grid.
+* Selection walks the tree from the root and stops at the first chunk whose error, projected to the screen
+* from the camera, is below the allowed pixel error. Chunks carry skirts to hide cracks between neighbouring LODs.
+* Heights are stored unscaled (0-1), so changing the height scale never requires a rebuild.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _TERRAINLOD_H_
+#define _TERRAINLOD_H_
+
+#include "TerrainGrid.h"
+#include "TerrainVertexPacking.h"
+#include <vector>
+
+/// One quadtree node. Coordinates are in grid samples, heights and errors are unscaled.
+struct TerrainChunk
+{
+	int x, z;				///< First sample covered by the chunk
+	int size;				///< Cells covered along each side, before clipping to the grid edge
+	int step;				///< Sample spacing of the chunk mesh
+	int level;				///< 0 for leaves, increasing towards the root
+	float minHeight, maxHeight;
+	float geometricError;	///< Largest height difference between the chunk mesh and the full grid
+	int children[4];		///< Child chunk indices, -1 where there is no child
+};
+
+/// Camera and quality parameters used by TerrainQuadtree::select.
+struct TerrainLodSettings
+{
+	float viewportHeight = 720.0f;		///< Render target height in pixels
+	float fieldOfView = 0.785398f;		///< Vertical field of view in radians
+	float maxPixelError = 2.0f;			///< Largest allowed projected error. Raise for coarser passes such as shadow maps
+};
+
+class TerrainQuadtree
+{
+public:
+	/** \brief Builds the quadtree over a square grid of unscaled heights
+	* @param unitHeights is resolution * resolution row-major samples. Must outlive the quadtree
+	* @param resolution is the number of samples along each side
+	* @param leafCells is the number of cells along each side of every chunk mesh
+	*/
+	void build(const float* unitHeights, int resolution, int leafCells = 32);
+
+	/** \brief Selects the chunks to draw for a camera
+	* Camera position is in terrain space: one unit per grid sample, Y in world units.
+	* @param heightScale converts the stored unit heights and errors to world units
+	* @param selection receives chunk indices covering the whole terrain exactly once
+	*/
+	void select(float cameraX, float cameraY, float cameraZ, const TerrainLodSettings& settings, float heightScale, std::vector<int>& selection) const;
+
+	/** \brief Builds the mesh of one chunk, with skirts
+	* Vertices are the chunk's grid in row-major order followed by one skirt vertex per border vertex.
+	* Indices are local to the chunk and always 16-bit.
+	* @param heights is the scaled resolution * resolution height grid
+	* @param normals is one packed xyz normal per grid sample
+	* @param heightScale is the scale that was applied to heights, used to size the skirts
+	*/
+	void buildChunkMesh(int chunkIndex, const float* heights, const float* normals, float heightScale, TerrainGrid& out) const;
+
+	/** \brief Builds the compact mesh of one chunk
+	* Same vertex order and indices as buildChunkMesh, but each vertex only carries its height and normal.
+	* Skirt vertices store their edge height. The drop is applied from the chunk layout when decoding.
+	* @param unitHeights is the unscaled resolution * resolution height grid
+	* @param normals is one packed xyz normal per grid sample
+	*/
+	void buildCompactChunkMesh(int chunkIndex, const float* unitHeights, const float* normals, std::vector<CompactTerrainVertex>& vertices, std::vector<uint16_t>& indices) const;
+
+	/// Layout used to rebuild positions and texture coordinates of a chunk's compact vertices.
+	TerrainChunkLayout getChunkLayout(int chunkIndex) const;
+
+	/// Number of vertices buildChunkMesh produces for a chunk.
+	int getChunkVertexCount(int chunkIndex) const;
+
+	const std::vector<TerrainChunk>& getChunks() const { return chunks; }
+	int getResolution() const { return resolution; }
+	int getLeafCells() const { return leafCells; }
+	int getLevelCount() const { return levelCount; }
+
+private:
+	int buildNode(int x, int z, int size, int level);
+	void getChunkSamples(const TerrainChunk& chunk, std::vector<int>& xs, std::vector<int>& zs) const;
+	float measureError(const TerrainChunk& chunk) const;
+	float getSkirtDepth(const TerrainChunk& chunk) const;
+
+	const float* heights = nullptr;
+	int resolution = 0;
+	int leafCells = 32;
+	int levelCount = 0;
+	std::vector<TerrainChunk> chunks;
+};
+
+#endif
@@ -0,0 +1,104 @@
+/**
+* \class Terrain Mesh
+*
+* \brief Quadtree-chunked heightmap terrain with continuous level of detail
+*
+* Built from the same cached heightmap and nearest-neighbour sampling as PlaneMesh, so a TerrainMesh of a
+* given resolution covers the same area and heights as the equivalent PlaneMesh.
+* Every chunk of every level is uploaded once into a shared vertex and 16-bit index buffer.
+* Each pass selects the chunks to draw from its own viewpoint and pixel error, so shadow passes can use coarser chunks.
+* In compact mode each vertex is a CompactTerrainVertex and must be drawn with a shader loaded through
+* BaseShader::loadCompactTerrainVertexShader. render() then sets each chunk's layout in vertex shader constant buffer b1.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _TERRAINMESH_H_
+#define _TERRAINMESH_H_
+
+#include "BaseMesh.h"
+#include "BaseShader.h"
+#include "HeightmapCache.h"
+#include "TerrainLod.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+class TerrainMesh : public BaseMesh
+{
+public:
+	/** \brief Loads the heightmap and builds every chunk
+	* @param heightmapPath is the heightmap image, shared through HeightmapCache
+	* @param heightScale is the world height of a full-white sample
+	* @param resolution is the number of samples along each side, as for PlaneMesh
+	* @param leafCells is the number of cells along each side of a chunk
+	* @param compactVertices stores 8-byte CompactTerrainVertex instead of the full vertex layout
+	*/
+	TerrainMesh(ID3D11Device* device, ID3D11DeviceContext* deviceContext, const std::string& heightmapPath, float heightScale, int resolution = 300, int leafCells = 32, bool compactVertices = false);
+	~TerrainMesh();
+
+	/// Binds the shared chunk buffers. Call before render().
+	void sendData(ID3D11DeviceContext* deviceContext, D3D_PRIMITIVE_TOPOLOGY top = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST) override;
+
+	/** \brief Chooses the chunks to draw
+	* @param cameraPosition is the viewpoint in the terrain's local space (before the world matrix)
+	* @param settings controls the allowed projected error
+	* @param selection receives the chunk indices, reused between frames to avoid allocation
+	*/
+	void selectLod(const XMFLOAT3& cameraPosition, const TerrainLodSettings& settings, std::vector<int>& selection) const;
+
+	/// Draws the selected chunks with the given shader. Shader parameters must already be set.
+	void render(ID3D11DeviceContext* deviceContext, BaseShader* shader, const std::vector<int>& selection);
+
+	/// Total indices of the selected chunks, for statistics.
+	int getSelectionIndexCount(const std::vector<int>& selection) const;
+
+	/// Rescales heights, normals and skirts in place. No decoding, rebuild or reallocation.
+	void setHeightScale(ID3D11DeviceContext* deviceContext, float scale);
+	float getHeightScale() const { return heightScale; }
+
+	const TerrainQuadtree& getQuadtree() const { return quadtree; }
+	const std::vector<float>& getUnitHeights() const { return unitHeights; }	///< resolution * resolution samples before scaling
+	int getResolution() const { return resolution; }
+	bool usesCompactVertices() const { return compact; }
+	int getVertexStride() const { return compact ? (int)sizeof(CompactTerrainVertex) : (int)sizeof(VertexType); }
+	int getVertexBufferBytes() const { return vertexCount * getVertexStride(); }
+
+protected:
+	void initBuffers(ID3D11Device* device) override;
+	void computeScaledField(std::vector<float>& heights, std::vector<float>& normals) const;
+	void buildVertices();
+
+	/// Per-chunk constants for the compact vertex shaders. Matches TerrainChunkBuffer in terrain_compact.hlsli.
+	struct ChunkBufferType
+	{
+		uint32_t originX, originZ, lastX, lastZ;
+		uint32_t step, columns, rows, padding;
+		float skirtDepth, heightScale, texelScale, padding2;
+	};
+
+	/// Location of one chunk inside the shared buffers.
+	struct ChunkRange
+	{
+		int startIndex;
+		int indexCount;
+		int baseVertex;
+	};
+
+	std::shared_ptr<const Heightmap> heightmap;
+	float heightScale;
+	int resolution;
+	int leafCells;
+
+	std::vector<float> unitHeights;			///< resolution * resolution samples before scaling
+	TerrainQuadtree quadtree;
+	std::vector<ChunkRange> chunkRanges;
+	std::vector<TerrainVertex> vertices;	///< CPU copy of the vertex buffer, used for in-place updates
+
+	bool compact;
+	std::vector<CompactTerrainVertex> compactVertices;	///< CPU copy of the vertex buffer in compact mode
+	std::vector<TerrainChunkLayout> chunkLayouts;
+	ID3D11Buffer* chunkBuffer;
+};
+
+#endif
@@ -0,0 +1,68 @@
+/**
+* \brief Platform-neutral pre-decoded texture caching
+*
+* Stores decoded images, mip chain included, as standard DDS files, so later loads skip the image decoder. Pixels are
+* compressed to BC1, BC3 or BC5, or kept as RGBA8. Files are written with the DX10 header, which holds the width,
+* height, mip count, array size and DXGI format that D3D11_TEXTURE2D_DESC takes, and the levels follow tightly packed
+* in the layout D3D11_SUBRESOURCE_DATA expects. decodeTexture maps them and points at the levels in place, so a
+* cached load is the mapping and the upload. They load through the DDS texture loader like any other DDS asset too.
+* On-load caches sit next to their source as <file>.dds when compressed, or <file>.rgba.dds when not. The source
+* file's size and modification time are stamped into the DDS header's reserved words, and a cache whose stamp no
+* longer matches is rebuilt. The stamp is invisible to DDS readers.
+* BC formats need the top level to be a multiple of 4 texels in each direction, so other sizes are cached as RGBA8.
+* Holds no Direct3D types.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _TEXTURECACHE_H_
+#define _TEXTURECACHE_H_
+
+#include "BlockCompress.h"
+#include "TextureDecode.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// Cache kept next to an image file.
+std::string getTextureCacheFilename(const std::string& filename, bool compressed = true);
+
+/// BC3 if any pixel of the top level is not fully opaque, otherwise BC1.
+uint32_t chooseBlockFormat(const DecodedTexture& decoded);
+
+/** \brief Stores every mip level of an RGBA8 texture in a DDS file image with a DX10 header
+* @param format is a blockFormat value, or textureFormatRGBA8 to store the levels as they are
+* @param sourceFilename is stamped into the header for cache checks. Pass an empty string for no stamp
+* @param threadCount is passed to compressImage
+* @return false if the format is unknown, or block-compressed and the top level is not a multiple of 4 texels
+*/
+bool buildTextureDds(const DecodedTexture& decoded, uint32_t format, const std::string& sourceFilename, std::vector<unsigned char>& dds, int threadCount = 0);
+
+/** \brief Reads the layout of a DDS file image without copying it
+* Handles 2D textures in RGBA8, BC1, BC3 and BC5, with legacy or DX10 headers, which includes every file
+* buildTextureDds writes. Cube maps, arrays, volumes and other formats return false and are left to the DDS loader.
+* @param layout receives the format and mip levels, with offsets from dataOffset
+* @param dataOffset receives where the first level starts. Every level is checked to be within size
+*/
+bool parseDds(const unsigned char* data, size_t size, DecodedTexture& layout, size_t& dataOffset);
+
+/// Copies the levels of a DDS file image in memory into a DecodedTexture. Handles what parseDds does.
+bool unpackDds(const DecodedTexture& dds, DecodedTexture& out);
+
+/// True if the cache exists and was built from the source file as it is now.
+bool isTextureCacheCurrent(const std::string& cacheFilename, const std::string& sourceFilename);
+
+/** \brief Offline conversion of one image file
+* @param format is a blockFormat value, textureFormatRGBA8 for no compression, or 0 to choose BC1 or BC3 from the
+* alpha channel. BC5 mips are filtered without sRGB conversion
+*/
+bool compressTextureFile(const std::string& sourceFilename, const std::string& ddsFilename, uint32_t format, std::string& error, int threadCount = 0);
+
+/** \brief Decodes a texture for upload, preferring its cache
+* DDS files are returned as decodeTexture gives them. Other images come from a current cache, or are decoded and
+* written to the cache, block-compressed if compress is set and their size allows.
+* @param threadCount is passed to compressImage and the mip generator. Use 1 on worker threads that already decode in parallel
+*/
+bool loadCachedTexture(const std::string& filename, DecodedTexture& out, std::string& error, bool compress, int threadCount = 0);
+
+#endif
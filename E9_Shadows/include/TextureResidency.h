@@ -0,0 +1,116 @@
+/**
+* \brief Platform-neutral texture residency policy: memory budget, least-recently-used eviction and mip streaming
+*
+* Tracks which part of each texture's mip chain is resident and the last frame the texture was drawn. A new texture
+* starts with only its coarse tail resident. Each update() then plans the changes for one frame:
+* - textures drawn recently stream in one finer level each, coarse to fine, most recently drawn first, up to a byte
+*   limit per frame so uploads stay spread out
+* - when a load would go over the budget, the finest levels of textures drawn less recently than the one loading
+*   are evicted to make room. If that is not enough, loading stops until next frame
+* - if the budget is lowered below what is resident, least recently drawn detail is evicted until it fits
+* The tail (the coarsest levels up to ResidencySettings::tailBytes) is never evicted, so every texture always has
+* something to draw.
+* Holds no Direct3D types. The owner applies each change and reports finished loads back, so loads can complete
+* frames later, and the whole policy can be driven by a recorded or simulated access trace.
+*
+* \author Paul Robertson
+*/
+
+#ifndef _TEXTURERESIDENCY_H_
+#define _TEXTURERESIDENCY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+struct ResidencySettings
+{
+	uint64_t budgetBytes = 256ull << 20;			///< Resident and loading bytes of every registered texture together
+	uint64_t streamBytesPerFrame = 16ull << 20;		///< New load bytes planned per update. At least one load is always allowed
+	uint64_t tailBytes = 64 * 1024;					///< Coarsest levels that fit in this many bytes are never evicted
+	uint32_t streamFrames = 30;						///< Textures not drawn for this many frames stop streaming in
+};
+
+/// One planned change. The texture's resident chain becomes levels mip and coarser.
+struct ResidencyChange
+{
+	uint32_t id;
+	int mip;
+	bool load;		///< Load level mip and report it with completeLoad, otherwise evict every level finer than mip
+};
+
+/// Running totals, for profiling.
+struct ResidencyStats
+{
+	uint64_t loads = 0;
+	uint64_t evictions = 0;			///< Levels evicted
+	uint64_t loadedBytes = 0;
+	uint64_t evictedBytes = 0;
+};
+
+class TextureResidency
+{
+public:
+	TextureResidency(const ResidencySettings& settings = ResidencySettings());
+
+	void setSettings(const ResidencySettings& settings);	///< A lower budget is enforced by the next update
+	const ResidencySettings& getSettings() const { return settings; }
+
+	/** \brief Registers a texture with only its tail resident
+	* @param levelBytes is the size of each mip level, largest first
+	* @return the first resident level, or -1 if the id is already registered or there are no levels
+	*/
+	int addTexture(uint32_t id, const std::vector<uint64_t>& levelBytes);
+	void removeTexture(uint32_t id);	///< Forgets the texture, including any load in progress
+
+	/** \brief Records that the texture is drawn this frame
+	* @param finestMip is the most detailed level the draw can use. The finest requested during a frame is kept
+	*/
+	void markUsed(uint32_t id, int finestMip = 0);
+
+	/** \brief Plans this frame's evictions and loads, then advances the frame
+	* Evictions are counted as done straight away. Loads hold their bytes until completeLoad or cancelLoad.
+	*/
+	void update(std::vector<ResidencyChange>& changes);
+
+	void completeLoad(uint32_t id, int mip);	///< A planned load finished. Ignored if the texture or plan changed
+	void cancelLoad(uint32_t id);				///< A planned load failed. It is planned again on a later frame
+
+	int getResidentMip(uint32_t id) const;		///< First resident level, or -1 if not registered
+	bool isLoading(uint32_t id) const;
+	uint64_t getResidentBytes() const { return residentBytes; }
+	uint64_t getLoadingBytes() const { return loadingBytes; }
+	size_t getTextureCount() const { return entries.size(); }
+	uint64_t getFrame() const { return frame; }
+	const ResidencyStats& getStats() const { return stats; }
+
+private:
+	struct Entry
+	{
+		std::vector<uint64_t> chainBytes;	///< chainBytes[mip] is the size of levels mip and coarser
+		int tailMip;
+		int residentMip;
+		int loadingMip = -1;				///< Level being loaded, or -1
+		int wantedMip = 0;
+		uint64_t lastUsedFrame = 0;
+		bool used = false;					///< Drawn at least once
+		std::list<uint32_t>::iterator lruPosition;
+
+		uint64_t getLevelBytes(int mip) const { return chainBytes[mip] - chainBytes[mip + 1]; }
+	};
+
+	bool evictLevel(Entry& entry, std::vector<ResidencyChange>& changes);
+	bool makeRoom(uint64_t bytes, uint64_t olderThan, bool anyAge, std::list<uint32_t>::reverse_iterator& cursor, std::vector<ResidencyChange>& changes);
+
+	ResidencySettings settings;
+	std::unordered_map<uint32_t, Entry> entries;
+	std::list<uint32_t> lru;		///< Most recently drawn first
+	uint64_t frame = 1;
+	uint64_t residentBytes = 0;
+	uint64_t loadingBytes = 0;
+	ResidencyStats stats;
+};
+
+#endif
@@ -3,27 +3,49 @@
     By Allen Sherrod and Wendy Jones
 
     TokenStream - Used to return blocks of text in a file.
+
+    Tokens and lines are returned as views into the text, so tokenizing allocates nothing.
+    Delimiters are classified through a 256-entry table, rebuilt only when the delimiter set changes.
+    The std::string overloads behave exactly as the original copying implementation.
 */
 
 
 #ifndef _TOKEN_STREAM_H_
 #define _TOKEN_STREAM_H_
 #include <string>
+#include <string_view>
 
 class TokenStream
 {
    public:
       TokenStream( );
+      TokenStream( const TokenStream& other );
+      TokenStream& operator=( const TokenStream& other );
 
       void ResetStream( );
 
+      // Copies the text, so the caller may free it straight away.
       void SetTokenStream( char* data );
-      bool GetNextToken( std::string* buffer, char* delimiters, int totalDelimiters );
+      // Tokenizes the text in place. It must outlive the stream and any views returned from it.
+      void SetTokenStream( std::string_view data );
+
+      bool GetNextToken( std::string* buffer, const char* delimiters, int totalDelimiters );
+      bool GetNextToken( std::string_view& token, const char* delimiters, int totalDelimiters );
       bool MoveToNextLine( std::string *buffer );
+      bool MoveToNextLine( std::string_view& line );
 
    private:
+      void SetDelimiters( const char* delimiters, int totalDelimiters );
+
       int startIndex_, endIndex_;
-      std::string data_;
+      std::string storage_;           // Owned copy when set from char*
+      std::string_view data_;
+      bool ownsData_;
+
+      bool tokenChars_[256];          // True for characters that are part of a token under delimiters_
+      std::string delimiters_;
+      bool defaultDelimiters_;
+      bool delimitersSet_;
 };
 
-#endif
\ No newline at end of file
+#endif